@@ -259,6 +259,25 @@ math_quat_integrate_velocity(const struct xrt_quat *quat,
                              float dt,
                              struct xrt_quat *result);
 
+/*!
+ * Integrate @p count angular velocity vectors (exponential map) and apply
+ * them to the matching quaternions, all of them in one go so the work can be
+ * vectorized across the quaternions.
+ *
+ * Gives the same results as calling @ref math_quat_integrate_velocity on each
+ * of them. @p results may be the same array as @p quats.
+ *
+ * @relates xrt_quat
+ * @see xrt_vec3
+ * @ingroup aux_math
+ */
+void
+math_quat_integrate_velocity_batch(const struct xrt_quat *quats,
+                                   const struct xrt_vec3 *ang_vels,
+                                   uint32_t count,
+                                   float dt,
+                                   struct xrt_quat *results);
+
 /*!
  * Compute an angular velocity vector (exponential map format) by taking the
  * finite difference of two quaternions.
@@ -15,18 +15,267 @@
 
 /*
  *
- * Filter fifo vec3_f32.
+ * Ring, shared by both fifos.
+ *
+ * Samples are identified by a sequence number that counts up with every
+ * push, the sample with sequence number s lives at index (s & mask). The
+ * capacity is a power of two with room for at least one sample more than the
+ * window of num samples, the sample just before the window is needed to take
+ * the difference of two running sums. Because samples are pushed in time
+ * order the timestamps are sorted by sequence number, so the samples between
+ * two timepoints can be found by bisecting.
+ *
+ * Every sample also stores the running sums of all samples up to and
+ * including it, this turns the sum over any range into a single subtraction.
+ * To keep the sums from growing without bounds, and losing precision, they
+ * are rebased every time the ring wraps around.
  *
  */
 
-struct m_ff_vec3_f32
+struct ff_ring
 {
+	//! Number of samples in the window, as given at alloc time.
 	size_t num;
-	size_t latest;
-	struct xrt_vec3 *samples;
+
+	//! Capacity minus one, capacity is a power of two.
+	size_t mask;
+
+	//! Total number of samples, including the initial ones at timepoint zero.
+	uint64_t count;
+
 	uint64_t *timestamps_ns;
 };
 
+/*!
+ * A range of sequence numbers, [first, last].
+ */
+struct ff_range
+{
+	uint64_t first;
+	uint64_t last;
+};
+
+static void
+ring_init(struct ff_ring *r, size_t num)
+{
+	size_t capacity = 1;
+	while (capacity < num + 1) {
+		capacity <<= 1;
+	}
+
+	r->timestamps_ns = U_TYPED_ARRAY_CALLOC(uint64_t, capacity);
+	r->num = num;
+	r->mask = capacity - 1;
+
+	// The fifo starts out filled with num samples at timepoint zero.
+	r->count = num;
+}
+
+static void
+ring_destroy(struct ff_ring *r)
+{
+	if (r->timestamps_ns != NULL) {
+		free(r->timestamps_ns);
+		r->timestamps_ns = NULL;
+	}
+
+	r->num = 0;
+	r->mask = 0;
+	r->count = 0;
+}
+
+static inline size_t
+ring_capacity(const struct ff_ring *r)
+{
+	return r->mask + 1;
+}
+
+static inline size_t
+ring_index(const struct ff_ring *r, uint64_t seq)
+{
+	return (size_t)(seq & r->mask);
+}
+
+static inline uint64_t
+ring_ts(const struct ff_ring *r, uint64_t seq)
+{
+	return r->timestamps_ns[ring_index(r, seq)];
+}
+
+/*!
+ * Index to write the next sample to, also checks the time order.
+ */
+static inline size_t
+ring_push(struct ff_ring *r, uint64_t timestamp_ns)
+{
+	assert(ring_ts(r, r->count - 1) <= timestamp_ns);
+
+	size_t i = ring_index(r, r->count);
+	r->timestamps_ns[i] = timestamp_ns;
+
+	return i;
+}
+
+/*!
+ * Returns true when the sums should be rebased, called after a push.
+ */
+static inline bool
+ring_advance(struct ff_ring *r)
+{
+	r->count++;
+	return ring_index(r, r->count) == 0;
+}
+
+/*!
+ * Bisect for the samples in the window with timestamps in [start_ns, stop_ns],
+ * returns false if there are none.
+ */
+static bool
+ring_find(const struct ff_ring *r, uint64_t start_ns, uint64_t stop_ns, struct ff_range *out_range)
+{
+	if (start_ns > stop_ns || r->num == 0) {
+		return false;
+	}
+
+	uint64_t oldest = r->count - r->num;
+
+	// First sample with a timestamp >= start_ns.
+	uint64_t lo = oldest;
+	uint64_t hi = r->count;
+	while (lo < hi) {
+		uint64_t mid = lo + (hi - lo) / 2;
+		if (ring_ts(r, mid) < start_ns) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	uint64_t first = lo;
+
+	// One past the last sample with a timestamp <= stop_ns.
+	lo = first;
+	hi = r->count;
+	while (lo < hi) {
+		uint64_t mid = lo + (hi - lo) / 2;
+		if (ring_ts(r, mid) <= stop_ns) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	if (lo == first) {
+		return false;
+	}
+
+	out_range->first = first;
+	out_range->last = lo - 1;
+
+	return true;
+}
+
+/*!
+ * Splits a range into at most two contiguous runs of indices, returns the
+ * number of runs.
+ */
+static int
+ring_runs(const struct ff_ring *r, const struct ff_range *range, size_t out_start[2], size_t out_len[2])
+{
+	size_t start = ring_index(r, range->first);
+	size_t len = (size_t)(range->last - range->first + 1);
+	size_t to_end = ring_capacity(r) - start;
+
+	out_start[0] = start;
+	if (len <= to_end) {
+		out_len[0] = len;
+		return 1;
+	}
+
+	out_len[0] = to_end;
+	out_start[1] = 0;
+	out_len[1] = len - to_end;
+	return 2;
+}
+
+/*!
+ * Sums the floats using double precision, four independent lanes let the
+ * compiler vectorize the loop without reassociating the adds.
+ */
+static inline double
+sum_f32(const float *v, size_t n)
+{
+	double lane[4] = {0, 0, 0, 0};
+	size_t i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		lane[0] += v[i + 0];
+		lane[1] += v[i + 1];
+		lane[2] += v[i + 2];
+		lane[3] += v[i + 3];
+	}
+	for (; i < n; i++) {
+		lane[0] += v[i];
+	}
+
+	return (lane[0] + lane[1]) + (lane[2] + lane[3]);
+}
+
+//! @copydoc sum_f32
+static inline double
+sum_f64(const double *v, size_t n)
+{
+	double lane[4] = {0, 0, 0, 0};
+	size_t i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		lane[0] += v[i + 0];
+		lane[1] += v[i + 1];
+		lane[2] += v[i + 2];
+		lane[3] += v[i + 3];
+	}
+	for (; i < n; i++) {
+		lane[0] += v[i];
+	}
+
+	return (lane[0] + lane[1]) + (lane[2] + lane[3]);
+}
+
+
+/*
+ *
+ * Filter fifo vec3_f32.
+ *
+ */
+
+//! Number of running sums, x, y, z followed by the second moments.
+#define VEC3_NUM_SUMS 9
+
+enum vec3_sum
+{
+	SUM_X,
+	SUM_Y,
+	SUM_Z,
+	SUM_XX,
+	SUM_XY,
+	SUM_XZ,
+	SUM_YY,
+	SUM_YZ,
+	SUM_ZZ,
+};
+
+struct m_ff_vec3_f32
+{
+	struct ff_ring ring;
+
+	//! Sample components, one array each.
+	float *x;
+	float *y;
+	float *z;
+
+	//! Running sums, see @ref vec3_sum.
+	double *sums[VEC3_NUM_SUMS];
+};
+
 
 /*
  *
@@ -37,27 +286,61 @@ struct m_ff_vec3_f32
 static void
 vec3_f32_init(struct m_ff_vec3_f32 *ff, size_t num)
 {
-	ff->samples = U_TYPED_ARRAY_CALLOC(struct xrt_vec3, num);
-	ff->timestamps_ns = U_TYPED_ARRAY_CALLOC(uint64_t, num);
-	ff->num = num;
-	ff->latest = 0;
+	ring_init(&ff->ring, num);
+
+	size_t capacity = ring_capacity(&ff->ring);
+	ff->x = U_TYPED_ARRAY_CALLOC(float, capacity);
+	ff->y = U_TYPED_ARRAY_CALLOC(float, capacity);
+	ff->z = U_TYPED_ARRAY_CALLOC(float, capacity);
+
+	for (int i = 0; i < VEC3_NUM_SUMS; i++) {
+		ff->sums[i] = U_TYPED_ARRAY_CALLOC(double, capacity);
+	}
 }
 
 static void
 vec3_f32_destroy(struct m_ff_vec3_f32 *ff)
 {
-	if (ff->samples != NULL) {
-		free(ff->samples);
-		ff->samples = NULL;
+	free(ff->x);
+	free(ff->y);
+	free(ff->z);
+	ff->x = NULL;
+	ff->y = NULL;
+	ff->z = NULL;
+
+	for (int i = 0; i < VEC3_NUM_SUMS; i++) {
+		free(ff->sums[i]);
+		ff->sums[i] = NULL;
+	}
+
+	ring_destroy(&ff->ring);
+}
+
+static void
+vec3_f32_rebase(struct m_ff_vec3_f32 *ff)
+{
+	// Oldest sum still used, the one just before the window.
+	size_t base = ring_index(&ff->ring, ff->ring.count - ff->ring.num - 1);
+	size_t capacity = ring_capacity(&ff->ring);
+
+	for (int s = 0; s < VEC3_NUM_SUMS; s++) {
+		double *sums = ff->sums[s];
+		double b = sums[base];
+		for (size_t i = 0; i < capacity; i++) {
+			sums[i] -= b;
+		}
 	}
+}
 
-	if (ff->timestamps_ns != NULL) {
-		free(ff->timestamps_ns);
-		ff->timestamps_ns = NULL;
+static inline double
+vec3_f32_range_sum(const struct m_ff_vec3_f32 *ff, enum vec3_sum s, const struct ff_range *range)
+{
+	double before = 0.0;
+	if (range->first > 0) {
+		before = ff->sums[s][ring_index(&ff->ring, range->first - 1)];
 	}
 
-	ff->num = 0;
-	ff->latest = 0;
+	return ff->sums[s][ring_index(&ff->ring, range->last)] - before;
 }
 
 
@@ -91,32 +374,50 @@ m_ff_vec3_f32_free(struct m_ff_vec3_f32 **ff_ptr)
 size_t
 m_ff_vec3_f32_get_num(struct m_ff_vec3_f32 *ff)
 {
-	return ff->num;
+	return ff->ring.num;
 }
 
 void
 m_ff_vec3_f32_push(struct m_ff_vec3_f32 *ff, const struct xrt_vec3 *sample, uint64_t timestamp_ns)
 {
-	assert(ff->timestamps_ns[ff->latest] <= timestamp_ns);
-
-	// We write samples backwards in the queue.
-	size_t i = ff->latest == 0 ? ff->num - 1 : --ff->latest;
-	ff->latest = i;
-
-	ff->samples[i] = *sample;
-	ff->timestamps_ns[i] = timestamp_ns;
+	size_t prev = ring_index(&ff->ring, ff->ring.count - 1);
+	size_t i = ring_push(&ff->ring, timestamp_ns);
+
+	double x = sample->x;
+	double y = sample->y;
+	double z = sample->z;
+
+	ff->x[i] = sample->x;
+	ff->y[i] = sample->y;
+	ff->z[i] = sample->z;
+
+	ff->sums[SUM_X][i] = ff->sums[SUM_X][prev] + x;
+	ff->sums[SUM_Y][i] = ff->sums[SUM_Y][prev] + y;
+	ff->sums[SUM_Z][i] = ff->sums[SUM_Z][prev] + z;
+	ff->sums[SUM_XX][i] = ff->sums[SUM_XX][prev] + x * x;
+	ff->sums[SUM_XY][i] = ff->sums[SUM_XY][prev] + x * y;
+	ff->sums[SUM_XZ][i] = ff->sums[SUM_XZ][prev] + x * z;
+	ff->sums[SUM_YY][i] = ff->sums[SUM_YY][prev] + y * y;
+	ff->sums[SUM_YZ][i] = ff->sums[SUM_YZ][prev] + y * z;
+	ff->sums[SUM_ZZ][i] = ff->sums[SUM_ZZ][prev] + z * z;
+
+	if (ring_advance(&ff->ring)) {
+		vec3_f32_rebase(ff);
+	}
 }
 
 bool
 m_ff_vec3_f32_get(struct m_ff_vec3_f32 *ff, size_t num, struct xrt_vec3 *out_sample, uint64_t *out_timestamp_ns)
 {
-	if (num >= ff->num) {
+	if (num >= ff->ring.num) {
 		return false;
 	}
 
-	size_t pos = (ff->latest + num) % ff->num;
-	*out_sample = ff->samples[pos];
-	*out_timestamp_ns = ff->timestamps_ns[pos];
+	size_t pos = ring_index(&ff->ring, ff->ring.count - 1 - num);
+	out_sample->x = ff->x[pos];
+	out_sample->y = ff->y[pos];
+	out_sample->z = ff->z[pos];
+	*out_timestamp_ns = ff->ring.timestamps_ns[pos];
 
 	return true;
 }
@@ -124,50 +425,85 @@ m_ff_vec3_f32_get(struct m_ff_vec3_f32 *ff, size_t num, struct xrt_vec3 *out_sam
 size_t
 m_ff_vec3_f32_filter(struct m_ff_vec3_f32 *ff, uint64_t start_ns, uint64_t stop_ns, struct xrt_vec3 *out_average)
 {
-	size_t num_sampled = 0;
-	size_t count = 0;
+	struct ff_range range;
+	if (!ring_find(&ff->ring, start_ns, stop_ns, &range)) {
+		out_average->x = 0.0f;
+		out_average->y = 0.0f;
+		out_average->z = 0.0f;
+		return 0;
+	}
+
+	size_t start[2];
+	size_t len[2];
+	int num_runs = ring_runs(&ff->ring, &range, start, len);
+
 	// Use double precision internally.
 	double x = 0, y = 0, z = 0;
-
-	// Error, skip averaging.
-	if (start_ns > stop_ns) {
-		count = ff->num;
+	size_t num_sampled = 0;
+	for (int r = 0; r < num_runs; r++) {
+		x += sum_f32(ff->x + start[r], len[r]);
+		y += sum_f32(ff->y + start[r], len[r]);
+		z += sum_f32(ff->z + start[r], len[r]);
+		num_sampled += len[r];
 	}
 
-	while (count < ff->num) {
-		size_t pos = (ff->latest + count) % ff->num;
-
-		// We have not yet reached where to start.
-		if (ff->timestamps_ns[pos] > stop_ns) {
-			count++;
-			continue;
-		}
+	out_average->x = (float)(x / num_sampled);
+	out_average->y = (float)(y / num_sampled);
+	out_average->z = (float)(z / num_sampled);
 
-		// If the sample is before the start we have reach the end.
-		if (ff->timestamps_ns[pos] < start_ns) {
-			count++;
-			break;
-		}
+	return num_sampled;
+}
 
-		x += ff->samples[pos].x;
-		y += ff->samples[pos].y;
-		z += ff->samples[pos].z;
-		num_sampled++;
-		count++;
-	}
+size_t
+m_ff_vec3_f32_stats(struct m_ff_vec3_f32 *ff,
+                    uint64_t start_ns,
+                    uint64_t stop_ns,
+                    struct xrt_vec3 *out_mean,
+                    struct xrt_matrix_3x3 *out_covariance)
+{
+	U_ZERO(out_mean);
+	U_ZERO(out_covariance);
 
-	// Avoid division by zero.
-	if (num_sampled > 0) {
-		x /= num_sampled;
-		y /= num_sampled;
-		z /= num_sampled;
+	struct ff_range range;
+	if (!ring_find(&ff->ring, start_ns, stop_ns, &range)) {
+		return 0;
 	}
 
-	out_average->x = (float)x;
-	out_average->y = (float)y;
-	out_average->z = (float)z;
-
-	return num_sampled;
+	double n = (double)(range.last - range.first + 1);
+	double m[3] = {
+	    vec3_f32_range_sum(ff, SUM_X, &range) / n,
+	    vec3_f32_range_sum(ff, SUM_Y, &range) / n,
+	    vec3_f32_range_sum(ff, SUM_Z, &range) / n,
+	};
+
+	double xx = vec3_f32_range_sum(ff, SUM_XX, &range) / n - m[0] * m[0];
+	double xy = vec3_f32_range_sum(ff, SUM_XY, &range) / n - m[0] * m[1];
+	double xz = vec3_f32_range_sum(ff, SUM_XZ, &range) / n - m[0] * m[2];
+	double yy = vec3_f32_range_sum(ff, SUM_YY, &range) / n - m[1] * m[1];
+	double yz = vec3_f32_range_sum(ff, SUM_YZ, &range) / n - m[1] * m[2];
+	double zz = vec3_f32_range_sum(ff, SUM_ZZ, &range) / n - m[2] * m[2];
+
+	// Rounding can make a zero variance slightly negative.
+	xx = xx < 0.0 ? 0.0 : xx;
+	yy = yy < 0.0 ? 0.0 : yy;
+	zz = zz < 0.0 ? 0.0 : zz;
+
+	out_mean->x = (float)m[0];
+	out_mean->y = (float)m[1];
+	out_mean->z = (float)m[2];
+
+	float *v = out_covariance->v;
+	v[0] = (float)xx;
+	v[1] = (float)xy;
+	v[2] = (float)xz;
+	v[3] = (float)xy;
+	v[4] = (float)yy;
+	v[5] = (float)yz;
+	v[6] = (float)xz;
+	v[7] = (float)yz;
+	v[8] = (float)zz;
+
+	return (size_t)n;
 }
 
 
@@ -179,10 +515,13 @@ m_ff_vec3_f32_filter(struct m_ff_vec3_f32 *ff, uint64_t start_ns, uint64_t stop_
 
 struct m_ff_f64
 {
-	size_t num;
-	size_t latest;
+	struct ff_ring ring;
+
 	double *samples;
-	uint64_t *timestamps_ns;
+
+	//! Running sum of the samples and of their squares.
+	double *sums;
+	double *sums_sq;
 };
 
 
@@ -195,27 +534,51 @@ struct m_ff_f64
 static void
 ff_f64_init(struct m_ff_f64 *ff, size_t num)
 {
-	ff->samples = U_TYPED_ARRAY_CALLOC(double, num);
-	ff->timestamps_ns = U_TYPED_ARRAY_CALLOC(uint64_t, num);
-	ff->num = num;
-	ff->latest = 0;
+	ring_init(&ff->ring, num);
+
+	size_t capacity = ring_capacity(&ff->ring);
+	ff->samples = U_TYPED_ARRAY_CALLOC(double, capacity);
+	ff->sums = U_TYPED_ARRAY_CALLOC(double, capacity);
+	ff->sums_sq = U_TYPED_ARRAY_CALLOC(double, capacity);
 }
 
 static void
 ff_f64_destroy(struct m_ff_f64 *ff)
 {
-	if (ff->samples != NULL) {
-		free(ff->samples);
-		ff->samples = NULL;
+	free(ff->samples);
+	free(ff->sums);
+	free(ff->sums_sq);
+	ff->samples = NULL;
+	ff->sums = NULL;
+	ff->sums_sq = NULL;
+
+	ring_destroy(&ff->ring);
+}
+
+static void
+ff_f64_rebase(struct m_ff_f64 *ff)
+{
+	// Oldest sum still used, the one just before the window.
+	size_t base = ring_index(&ff->ring, ff->ring.count - ff->ring.num - 1);
+	size_t capacity = ring_capacity(&ff->ring);
+
+	double b = ff->sums[base];
+	double b_sq = ff->sums_sq[base];
+	for (size_t i = 0; i < capacity; i++) {
+		ff->sums[i] -= b;
+		ff->sums_sq[i] -= b_sq;
 	}
+}
 
-	if (ff->timestamps_ns != NULL) {
-		free(ff->timestamps_ns);
-		ff->timestamps_ns = NULL;
+static inline double
+ff_f64_range_sum(const struct m_ff_f64 *ff, const double *sums, const struct ff_range *range)
+{
+	double before = 0.0;
+	if (range->first > 0) {
+		before = sums[ring_index(&ff->ring, range->first - 1)];
 	}
 
-	ff->num = 0;
-	ff->latest = 0;
+	return sums[ring_index(&ff->ring, range->last)] - before;
 }
 
 
@@ -249,32 +612,35 @@ m_ff_f64_free(struct m_ff_f64 **ff_ptr)
 size_t
 m_ff_f64_get_num(struct m_ff_f64 *ff)
 {
-	return ff->num;
+	return ff->ring.num;
 }
 
 void
 m_ff_f64_push(struct m_ff_f64 *ff, const double *sample, uint64_t timestamp_ns)
 {
-	assert(ff->timestamps_ns[ff->latest] <= timestamp_ns);
+	size_t prev = ring_index(&ff->ring, ff->ring.count - 1);
+	size_t i = ring_push(&ff->ring, timestamp_ns);
 
-	// We write samples backwards in the queue.
-	size_t i = ff->latest == 0 ? ff->num - 1 : --ff->latest;
-	ff->latest = i;
+	double v = *sample;
+	ff->samples[i] = v;
+	ff->sums[i] = ff->sums[prev] + v;
+	ff->sums_sq[i] = ff->sums_sq[prev] + v * v;
 
-	ff->samples[i] = *sample;
-	ff->timestamps_ns[i] = timestamp_ns;
+	if (ring_advance(&ff->ring)) {
+		ff_f64_rebase(ff);
+	}
 }
 
 bool
 m_ff_f64_get(struct m_ff_f64 *ff, size_t num, double *out_sample, uint64_t *out_timestamp_ns)
 {
-	if (num >= ff->num) {
+	if (num >= ff->ring.num) {
 		return false;
 	}
 
-	size_t pos = (ff->latest + num) % ff->num;
+	size_t pos = ring_index(&ff->ring, ff->ring.count - 1 - num);
 	*out_sample = ff->samples[pos];
-	*out_timestamp_ns = ff->timestamps_ns[pos];
+	*out_timestamp_ns = ff->ring.timestamps_ns[pos];
 
 	return true;
 }
@@ -282,41 +648,46 @@ m_ff_f64_get(struct m_ff_f64 *ff, size_t num, double *out_sample, uint64_t *out_
 size_t
 m_ff_f64_filter(struct m_ff_f64 *ff, uint64_t start_ns, uint64_t stop_ns, double *out_average)
 {
-	size_t num_sampled = 0;
-	size_t count = 0;
-	double val = 0;
+	struct ff_range range;
+	if (!ring_find(&ff->ring, start_ns, stop_ns, &range)) {
+		*out_average = 0.0;
+		return 0;
+	}
+
+	size_t start[2];
+	size_t len[2];
+	int num_runs = ring_runs(&ff->ring, &range, start, len);
 
-	// Error, skip averaging.
-	if (start_ns > stop_ns) {
-		count = ff->num;
+	double val = 0;
+	size_t num_sampled = 0;
+	for (int r = 0; r < num_runs; r++) {
+		val += sum_f64(ff->samples + start[r], len[r]);
+		num_sampled += len[r];
 	}
 
-	while (count < ff->num) {
-		size_t pos = (ff->latest + count) % ff->num;
+	*out_average = val / num_sampled;
 
-		// We have not yet reached where to start.
-		if (ff->timestamps_ns[pos] > stop_ns) {
-			count++;
-			continue;
-		}
+	return num_sampled;
+}
 
-		// If the sample is before the start we have reach the end.
-		if (ff->timestamps_ns[pos] < start_ns) {
-			count++;
-			break;
-		}
+size_t
+m_ff_f64_stats(struct m_ff_f64 *ff, uint64_t start_ns, uint64_t stop_ns, double *out_mean, double *out_variance)
+{
+	*out_mean = 0.0;
+	*out_variance = 0.0;
 
-		val += ff->samples[pos];
-		num_sampled++;
-		count++;
+	struct ff_range range;
+	if (!ring_find(&ff->ring, start_ns, stop_ns, &range)) {
+		return 0;
 	}
 
-	// Avoid division by zero.
-	if (num_sampled > 0) {
-		val /= num_sampled;
-	}
+	double n = (double)(range.last - range.first + 1);
+	double mean = ff_f64_range_sum(ff, ff->sums, &range) / n;
+	double variance = ff_f64_range_sum(ff, ff->sums_sq, &range) / n - mean * mean;
 
-	*out_average = val;
+	*out_mean = mean;
+	// Rounding can make a zero variance slightly negative.
+	*out_variance = variance < 0.0 ? 0.0 : variance;
 
-	return num_sampled;
+	return (size_t)n;
 }
@@ -67,6 +67,27 @@ m_ff_vec3_f32_get(struct m_ff_vec3_f32 *ff, size_t num, struct xrt_vec3 *out_sam
 size_t
 m_ff_vec3_f32_filter(struct m_ff_vec3_f32 *ff, uint64_t start_ns, uint64_t stop_ns, struct xrt_vec3 *out_average);
 
+/*!
+ * Mean and covariance of all samples in the fifo between the two timepoints,
+ * takes the same time no matter how many samples are in the range. Returns
+ * the number of samples, if no samples was found returns 0 and sets the
+ * outputs to all zeros.
+ *
+ * @param ff             Filter fifo to search in.
+ * @param start_ns       Timepoint furthest in the past, to start searching
+ *                       for samples.
+ * @param stop_ns        Timepoint closest in the past, or now, to stop
+ *                       searching for samples.
+ * @param out_mean       Mean of all samples in the given timeframe.
+ * @param out_covariance Population covariance of the samples, row major.
+ */
+size_t
+m_ff_vec3_f32_stats(struct m_ff_vec3_f32 *ff,
+                    uint64_t start_ns,
+                    uint64_t stop_ns,
+                    struct xrt_vec3 *out_mean,
+                    struct xrt_matrix_3x3 *out_covariance);
+
 /*!
  * Allocates a filter fifo tracking @p num samples and fills it with @p num
  * samples at timepoint zero.
@@ -115,6 +136,23 @@ m_ff_f64_get(struct m_ff_f64 *ff, size_t num, double *out_sample, uint64_t *out_
 size_t
 m_ff_f64_filter(struct m_ff_f64 *ff, uint64_t start_ns, uint64_t stop_ns, double *out_average);
 
+/*!
+ * Mean and variance of all samples in the fifo between the two timepoints,
+ * takes the same time no matter how many samples are in the range. Returns
+ * the number of samples, if no samples was found returns 0 and sets the
+ * outputs to zero.
+ *
+ * @param ff           Filter fifo to search in.
+ * @param start_ns     Timepoint furthest in the past, to start searching for
+ *                     samples.
+ * @param stop_ns      Timepoint closest in the past, or now, to stop searching
+ *                     for samples.
+ * @param out_mean     Mean of all samples in the given timeframe.
+ * @param out_variance Population variance of the samples.
+ */
+size_t
+m_ff_f64_stats(struct m_ff_f64 *ff, uint64_t start_ns, uint64_t stop_ns, double *out_mean, double *out_variance);
+
 
 #ifdef __cplusplus
 }
@@ -158,5 +196,11 @@ public:
 	{
 		return m_ff_vec3_f32_filter(ff, start_ns, stop_ns, out_average);
 	}
+
+	inline size_t
+	stats(uint64_t start_ns, uint64_t stop_ns, struct xrt_vec3 *out_mean, struct xrt_matrix_3x3 *out_covariance)
+	{
+		return m_ff_vec3_f32_stats(ff, start_ns, stop_ns, out_mean, out_covariance);
+	}
 };
 #endif
@@ -73,6 +73,7 @@ m_imu_3dof_add_vars(struct m_imu_3dof *f, void *root, const char *prefix)
 
 static void
 gravity_correction(struct m_imu_3dof *f,
+                   struct xrt_quat *rot,
                    uint64_t timestamp_ns,
                    const struct xrt_vec3 *accel,
                    const struct xrt_vec3 *gyro,
@@ -166,38 +167,33 @@ gravity_correction(struct m_imu_3dof *f,
 		// Perform the correction.
 		struct xrt_quat corr_quat, old_orient;
 		math_quat_from_angle_vector(correction_radians, &f->grav.error_axis, &corr_quat);
-		old_orient = f->rot;
-		math_quat_rotate(&corr_quat, &old_orient, &f->rot);
+		old_orient = *rot;
+		math_quat_rotate(&corr_quat, &old_orient, rot);
 	}
 }
 
-void
-m_imu_3dof_update(struct m_imu_3dof *f,
-                  uint64_t timestamp_ns,
-                  const struct xrt_vec3 *accel,
-                  const struct xrt_vec3 *gyro)
+/*!
+ * Does the work for one sample, the rotation and last timestamp are passed in
+ * so that a batch can keep them in locals instead of going through @p f.
+ */
+static inline void
+update_one(struct m_imu_3dof *f,
+           struct xrt_quat *rot,
+           uint64_t *last_timestamp_ns,
+           uint64_t timestamp_ns,
+           const struct xrt_vec3 *accel,
+           const struct xrt_vec3 *gyro)
 {
-	//! Skip the first sample.
-	if (f->state == M_IMU_3DOF_STATE_START) {
-		f->state = M_IMU_3DOF_STATE_RUNNING;
-		f->last.timestamp_ns = timestamp_ns;
-		return;
-	}
-
 	// This code assumes all timestamps makes some forward progress.
-	assert(timestamp_ns >= f->last.timestamp_ns);
-
-	f->last.gyro = *gyro;
-	f->last.accel = *accel;
+	assert(timestamp_ns >= *last_timestamp_ns);
 
 	struct xrt_vec3 world_accel = {0};
-	math_quat_rotate_vec3(&f->rot, accel, &world_accel);
+	math_quat_rotate_vec3(rot, accel, &world_accel);
 
-	uint64_t diff = timestamp_ns - f->last.timestamp_ns;
+	uint64_t diff = timestamp_ns - *last_timestamp_ns;
 	double dt = (double)diff / DUR_1S_IN_NS;
 
-	f->last.delta_ms = dt * 1000.0;
-	f->last.timestamp_ns = timestamp_ns;
+	*last_timestamp_ns = timestamp_ns;
 
 	m_ff_vec3_f32_push(f->word_accel_ff, &world_accel, timestamp_ns);
 	m_ff_vec3_f32_push(f->gyro_ff, gyro, timestamp_ns);
@@ -206,7 +202,7 @@ m_imu_3dof_update(struct m_imu_3dof *f,
 
 	if (gyro_length > 0.0001f) {
 #if 0
-		math_quat_integrate_velocity(&f->rot, gyro, dt, &f->rot);
+		math_quat_integrate_velocity(rot, gyro, dt, rot);
 #else
 		struct xrt_vec3 rot_axis = {
 		    gyro->x / gyro_length,
@@ -219,16 +215,77 @@ m_imu_3dof_update(struct m_imu_3dof *f,
 		struct xrt_quat delta_orient;
 		math_quat_from_angle_vector(rot_angle, &rot_axis, &delta_orient);
 
-		math_quat_rotate(&f->rot, &delta_orient, &f->rot);
+		math_quat_rotate(rot, &delta_orient, rot);
 #endif
 	}
 
 	// Gravity correction.
-	gravity_correction(f, timestamp_ns, accel, gyro, dt, gyro_length);
+	gravity_correction(f, rot, timestamp_ns, accel, gyro, dt, gyro_length);
 
 	/*
 	 * Mitigate drift due to floating point
 	 * inprecision with quat multiplication.
 	 */
-	math_quat_normalize(&f->rot);
+	math_quat_normalize(rot);
+}
+
+void
+m_imu_3dof_update(struct m_imu_3dof *f,
+                  uint64_t timestamp_ns,
+                  const struct xrt_vec3 *accel,
+                  const struct xrt_vec3 *gyro)
+{
+	//! Skip the first sample.
+	if (f->state == M_IMU_3DOF_STATE_START) {
+		f->state = M_IMU_3DOF_STATE_RUNNING;
+		f->last.timestamp_ns = timestamp_ns;
+		return;
+	}
+
+	uint64_t last_timestamp_ns = f->last.timestamp_ns;
+
+	f->last.gyro = *gyro;
+	f->last.accel = *accel;
+
+	update_one(f, &f->rot, &f->last.timestamp_ns, timestamp_ns, accel, gyro);
+
+	f->last.delta_ms = (double)(timestamp_ns - last_timestamp_ns) / DUR_1S_IN_NS * 1000.0;
+}
+
+void
+m_imu_3dof_update_batch(struct m_imu_3dof *f, const struct xrt_tracking_timed_sample *samples, uint32_t count)
+{
+	uint32_t i = 0;
+
+	if (count == 0) {
+		return;
+	}
+
+	//! Skip the first sample.
+	if (f->state == M_IMU_3DOF_STATE_START) {
+		f->state = M_IMU_3DOF_STATE_RUNNING;
+		f->last.timestamp_ns = samples[0].timestamp_ns;
+		i = 1;
+	}
+
+	if (i >= count) {
+		return;
+	}
+
+	struct xrt_quat rot = f->rot;
+	uint64_t last_timestamp_ns = f->last.timestamp_ns;
+	uint64_t prev_timestamp_ns = last_timestamp_ns;
+
+	for (; i < count; i++) {
+		prev_timestamp_ns = last_timestamp_ns;
+		update_one(f, &rot, &last_timestamp_ns, samples[i].timestamp_ns, &samples[i].sample.accel_m_s2,
+		           &samples[i].sample.gyro_rad_secs);
+	}
+
+	// Only the state after the last sample is visible.
+	f->rot = rot;
+	f->last.timestamp_ns = last_timestamp_ns;
+	f->last.gyro = samples[count - 1].sample.gyro_rad_secs;
+	f->last.accel = samples[count - 1].sample.accel_m_s2;
+	f->last.delta_ms = (double)(last_timestamp_ns - prev_timestamp_ns) / DUR_1S_IN_NS * 1000.0;
 }
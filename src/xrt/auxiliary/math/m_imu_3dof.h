@@ -12,6 +12,7 @@
 #pragma once
 
 #include "xrt/xrt_defines.h"
+#include "xrt/xrt_tracking.h"
 
 
 #ifdef __cplusplus
@@ -75,6 +76,13 @@ m_imu_3dof_update(struct m_imu_3dof *f,
                   const struct xrt_vec3 *accel,
                   const struct xrt_vec3 *gyro);
 
+/*!
+ * Same as calling @ref m_imu_3dof_update for each sample in order, but only
+ * writes the state back once all samples have been processed.
+ */
+void
+m_imu_3dof_update_batch(struct m_imu_3dof *f, const struct xrt_tracking_timed_sample *samples, uint32_t count);
+
 
 #ifdef __cplusplus
 }
@@ -11,6 +11,12 @@
 #include "m_vec3.h"
 #include "m_predict.h"
 
+#include <assert.h>
+
+
+//! Relations integrated together by @ref m_predict_relations.
+#define PREDICT_CHUNK_SIZE 16
+
 
 static void
 do_orientation(const struct xrt_space_relation *rel,
@@ -111,3 +117,78 @@ m_predict_relation(const struct xrt_space_relation *rel, double delta_s, struct
 
 	out_rel->relation_flags = flags;
 }
+
+void
+m_predict_relations(const struct xrt_space_relation *rels,
+                    uint32_t count,
+                    double delta_s,
+                    struct xrt_space_relation *out_rels)
+{
+	assert(count == 0 || rels != NULL);
+	assert(count == 0 || out_rels != NULL);
+
+	if (delta_s == 0) {
+		for (uint32_t i = 0; i < count; i++) {
+			m_predict_relation(&rels[i], delta_s, &out_rels[i]);
+		}
+		return;
+	}
+
+	struct xrt_quat quats[PREDICT_CHUNK_SIZE];
+	struct xrt_vec3 accums[PREDICT_CHUNK_SIZE];
+	uint32_t indices[PREDICT_CHUNK_SIZE];
+
+	for (uint32_t base = 0; base < count; base += PREDICT_CHUNK_SIZE) {
+		uint32_t end = count - base < PREDICT_CHUNK_SIZE ? count : base + PREDICT_CHUNK_SIZE;
+		uint32_t num = 0;
+
+		// Gather the ones with an orientation, the rest go through do_orientation.
+		for (uint32_t i = base; i < end; i++) {
+			const struct xrt_space_relation *rel = &rels[i];
+			enum xrt_space_relation_flags flags = rel->relation_flags;
+
+			if ((flags & XRT_SPACE_RELATION_ORIENTATION_VALID_BIT) == 0) {
+				do_orientation(rel, flags, delta_s, &out_rels[i]);
+				continue;
+			}
+
+			struct xrt_vec3 accum = {0};
+			if ((flags & XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT) != 0) {
+				// Same as do_orientation, in body space for the integration.
+				struct xrt_quat orientation_inv;
+				math_quat_invert(&rel->pose.orientation, &orientation_inv);
+				math_quat_rotate_derivative(&orientation_inv, &rel->angular_velocity, &accum);
+			}
+
+			quats[num] = rel->pose.orientation;
+			accums[num] = accum;
+			indices[num] = i;
+			num++;
+		}
+
+		if (num > 0) {
+			math_quat_integrate_velocity_batch(quats, accums, num, (float)delta_s, quats);
+		}
+
+		for (uint32_t k = 0; k < num; k++) {
+			struct xrt_space_relation *out_rel = &out_rels[indices[k]];
+			bool valid_angular_velocity =
+			    (rels[indices[k]].relation_flags & XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT) != 0;
+
+			out_rel->pose.orientation = quats[k];
+
+			// Back to base space with the predicted orientation, like do_orientation.
+			if (valid_angular_velocity) {
+				math_quat_rotate_derivative(&quats[k], &accums[k], &out_rel->angular_velocity);
+			}
+		}
+
+		for (uint32_t i = base; i < end; i++) {
+			enum xrt_space_relation_flags flags = rels[i].relation_flags;
+
+			do_position(&rels[i], flags, delta_s, &out_rels[i]);
+
+			out_rels[i].relation_flags = flags;
+		}
+	}
+}
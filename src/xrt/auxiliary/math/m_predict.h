@@ -12,6 +12,11 @@
 #include "xrt/xrt_defines.h"
 
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
 /*!
  * Using the given @p xrt_space_relation predicts a new @p xrt_space_relation
  * @p delta_s into the future.
@@ -23,3 +28,23 @@
  */
 void
 m_predict_relation(const struct xrt_space_relation *rel, double delta_s, struct xrt_space_relation *out_rel);
+
+/*!
+ * Predicts @p count relations @p delta_s into the future in one call, the
+ * result is the same as calling @ref m_predict_relation on each of them but
+ * the orientations are integrated together so the work can be vectorized.
+ *
+ * @p out_rels may be the same array as @p rels.
+ *
+ * @ingroup aux_math
+ */
+void
+m_predict_relations(const struct xrt_space_relation *rels,
+                    uint32_t count,
+                    double delta_s,
+                    struct xrt_space_relation *out_rels);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -17,6 +17,7 @@
 #include <Eigen/Geometry>
 
 #include <assert.h>
+#include <algorithm>
 
 
 // anonymous namespace for internal types
@@ -147,6 +148,63 @@ math_quat_integrate_velocity(const struct xrt_quat *quat,
 	map_quat(*result) = q * incremental_rotation;
 }
 
+extern "C" void
+math_quat_integrate_velocity_batch(const struct xrt_quat *quats,
+                                   const struct xrt_vec3 *ang_vels,
+                                   uint32_t count,
+                                   const float dt,
+                                   struct xrt_quat *results)
+{
+	assert(count == 0 || quats != NULL);
+	assert(count == 0 || ang_vels != NULL);
+	assert(count == 0 || results != NULL);
+	assert(dt != 0);
+
+	// Fixed max size keeps the arrays on the stack.
+	constexpr uint32_t chunk_size = 16;
+	using Row = Eigen::Array<float, 1, Eigen::Dynamic, Eigen::RowMajor, 1, chunk_size>;
+	using Quats = Eigen::Map<const Eigen::Array<float, 4, Eigen::Dynamic>>;
+	using Vecs = Eigen::Map<const Eigen::Array<float, 3, Eigen::Dynamic>>;
+
+	const float eps = FourthRootMachineEps<float>::get();
+	const float half_dt = dt * 0.5f;
+
+	for (uint32_t base = 0; base < count; base += chunk_size) {
+		uint32_t n = std::min(count - base, chunk_size);
+		Quats q(&quats[base].x, 4, n);
+		Vecs w(&ang_vels[base].x, 3, n);
+
+		// Same as quat_exp, but one lane per quaternion.
+		Row vx = w.row(0) * half_dt;
+		Row vy = w.row(1) * half_dt;
+		Row vz = w.row(2) * half_dt;
+		Row theta = (vx * vx + vy * vy + vz * vz).sqrt();
+		Row s = (theta < eps).select(1.f - theta * theta / 6.f, theta.sin() / theta);
+		Row ex = s * vx;
+		Row ey = s * vy;
+		Row ez = s * vz;
+		Row ew = theta.cos();
+
+		Row inv_norm = (ex * ex + ey * ey + ez * ez + ew * ew).rsqrt();
+		ex *= inv_norm;
+		ey *= inv_norm;
+		ez *= inv_norm;
+		ew *= inv_norm;
+
+		// q * e, everything is read before writing so results may alias quats.
+		Row qx = q.row(0);
+		Row qy = q.row(1);
+		Row qz = q.row(2);
+		Row qw = q.row(3);
+
+		Eigen::Map<Eigen::Array<float, 4, Eigen::Dynamic>> r(&results[base].x, 4, n);
+		r.row(0) = qw * ex + qx * ew + qy * ez - qz * ey;
+		r.row(1) = qw * ey - qx * ez + qy * ew + qz * ex;
+		r.row(2) = qw * ez + qx * ey - qy * ex + qz * ew;
+		r.row(3) = qw * ew - qx * ex - qy * ey - qz * ez;
+	}
+}
+
 extern "C" void
 math_quat_finite_difference(const struct xrt_quat *quat0,
                             const struct xrt_quat *quat1,
@@ -79,14 +79,19 @@ dump_graph(const struct xrt_space_graph *xsg)
  */
 
 static bool
-has_step_with_no_pose(const struct xrt_space_graph *xsg)
+has_no_pose(const struct xrt_space_relation *r)
 {
 	const enum xrt_space_relation_flags pose_flags = (enum xrt_space_relation_flags)(
 	    XRT_SPACE_RELATION_POSITION_VALID_BIT | XRT_SPACE_RELATION_ORIENTATION_VALID_BIT);
 
+	return (r->relation_flags & pose_flags) == 0;
+}
+
+static bool
+has_step_with_no_pose(const struct xrt_space_graph *xsg)
+{
 	for (uint32_t i = 0; i < xsg->num_steps; i++) {
-		const struct xrt_space_relation *r = &xsg->steps[i];
-		if ((r->relation_flags & pose_flags) == 0) {
+		if (has_no_pose(&xsg->steps[i])) {
 			return true;
 		}
 	}
@@ -274,6 +279,28 @@ apply_relation(const struct xrt_space_relation *a,
 }
 
 
+/*!
+ * Folds @p num_steps steps into one relation, returns false if there are no
+ * steps to fold.
+ */
+static bool
+fold_steps(const struct xrt_space_relation *steps, uint32_t num_steps, struct xrt_space_relation *out_relation)
+{
+	if (num_steps == 0) {
+		return false;
+	}
+
+	struct xrt_space_relation r = steps[0];
+	for (uint32_t i = 1; i < num_steps; i++) {
+		apply_relation(&r, &steps[i], &r);
+	}
+
+	*out_relation = r;
+
+	return true;
+}
+
+
 /*
  *
  * Exported functions.
@@ -306,3 +333,54 @@ m_space_graph_resolve(const struct xrt_space_graph *xsg, struct xrt_space_relati
 
 	*out_relation = r;
 }
+
+void
+m_space_graph_compile(const struct xrt_space_graph *xsg,
+                      uint32_t dynamic_step,
+                      struct m_space_graph_compiled *out_compiled)
+{
+	U_ZERO(out_compiled);
+
+	if (dynamic_step >= xsg->num_steps) {
+		return;
+	}
+
+	for (uint32_t i = 0; i < xsg->num_steps; i++) {
+		if (i != dynamic_step && has_no_pose(&xsg->steps[i])) {
+			return;
+		}
+	}
+
+	const struct xrt_space_relation *pre = &xsg->steps[0];
+	const struct xrt_space_relation *post = &xsg->steps[dynamic_step + 1];
+
+	out_compiled->has_pre = fold_steps(pre, dynamic_step, &out_compiled->pre);
+	out_compiled->has_post = fold_steps(post, xsg->num_steps - dynamic_step - 1, &out_compiled->post);
+	out_compiled->valid = true;
+}
+
+void
+m_space_graph_compiled_resolve(const struct m_space_graph_compiled *compiled,
+                               const struct xrt_space_relation *dynamic,
+                               struct xrt_space_relation *out_relation)
+{
+	if (!compiled->valid || has_no_pose(dynamic)) {
+		U_ZERO(out_relation);
+		return;
+	}
+
+	struct xrt_space_relation r = *dynamic;
+
+	if (compiled->has_pre) {
+		apply_relation(&compiled->pre, &r, &r);
+	}
+
+	if (compiled->has_post) {
+		apply_relation(&r, &compiled->post, &r);
+	}
+
+	// Ensure no errors has crept in.
+	math_quat_normalize(&r.pose.orientation);
+
+	*out_relation = r;
+}
@@ -168,6 +168,50 @@ m_space_graph_add_inverted_pose_if_not_identity(struct xrt_space_graph *xsg, con
 void
 m_space_graph_resolve(const struct xrt_space_graph *xsg, struct xrt_space_relation *out_relation);
 
+/*!
+ * A @ref xrt_space_graph with one dynamic step, typically a tracked device
+ * pose, where all of the other steps are folded into at most two constant
+ * relations, one on each side of the dynamic step. Create it with
+ * @ref m_space_graph_compile when the static parts of the graph change and
+ * use @ref m_space_graph_compiled_resolve for each new dynamic relation.
+ *
+ * Only worth it for deeper graphs: with a single static step there is
+ * nothing to fold, and @ref m_space_graph_resolve is as fast or faster.
+ */
+struct m_space_graph_compiled
+{
+	//! All of the static steps before the dynamic step, folded.
+	struct xrt_space_relation pre;
+
+	//! All of the static steps after the dynamic step, folded.
+	struct xrt_space_relation post;
+
+	bool has_pre;
+	bool has_post;
+
+	//! False if a static step has no pose, resolving then always fails.
+	bool valid;
+};
+
+/*!
+ * Folds all steps of @p xsg except @p dynamic_step into a
+ * @ref m_space_graph_compiled, the content of @p dynamic_step is ignored and
+ * can be anything.
+ */
+void
+m_space_graph_compile(const struct xrt_space_graph *xsg,
+                      uint32_t dynamic_step,
+                      struct m_space_graph_compiled *out_compiled);
+
+/*!
+ * Resolves a compiled graph with @p dynamic as the dynamic step, gives the
+ * same result as @ref m_space_graph_resolve on the full graph.
+ */
+void
+m_space_graph_compiled_resolve(const struct m_space_graph_compiled *compiled,
+                               const struct xrt_space_relation *dynamic,
+                               struct xrt_space_relation *out_relation);
+
 /*!
  * @}
  */
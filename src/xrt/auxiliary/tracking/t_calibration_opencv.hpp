@@ -137,7 +137,12 @@ struct StereoCameraCalibrationWrapper
 
 
 /*!
- * @brief An x,y pair of matrices for the remap() function.
+ * @brief A pair of fixed point maps for the remap() function, @p remap_x is
+ * the CV_16SC2 map of whole pixel coordinates and @p remap_y the CV_16UC1
+ * interpolation table, as made by cv::convertMaps.
+ *
+ * Half the size of a pair of float maps, and what cv::remap converts float
+ * maps to for every call anyway.
  *
  * @see calibration_get_undistort_map
  */
@@ -151,6 +156,10 @@ struct RemapPair
  * @brief Prepare undistortion/normalization remap structures for a rectilinear
  * or fisheye image.
  *
+ * The maps are cached in @ref u_file_get_cache_dir keyed on a hash of all of
+ * the arguments, so only the first tracker created for a calibration pays for
+ * computing them. Set `T_RECTIFICATION_CACHE=false` to always compute them.
+ *
  * @param calib A single camera calibration structure.
  * @param rectify_transform_optional A rectification transform to apply, if
  * desired.
@@ -162,6 +171,47 @@ calibration_get_undistort_map(t_camera_calibration &calib,
                               cv::InputArray rectify_transform_optional = cv::noArray(),
                               cv::Mat new_camera_matrix_optional = cv::Mat());
 
+/*!
+ * @brief Rounds the maps of a @ref RemapPair to whole pixels, for use with
+ * cv::INTER_NEAREST which otherwise truncates the coordinates.
+ *
+ * @return A CV_16SC2 map to give to cv::remap without a second map.
+ */
+cv::Mat
+calibration_get_nearest_map(const RemapPair &pair);
+
+/*!
+ * @brief Get the part of a raw image of @p size that cv::remap reads when
+ * remapping the part @p roi of a map from @ref calibration_get_nearest_map.
+ *
+ * @return The bounding box of the map coordinates, clamped to the image.
+ */
+cv::Rect
+calibration_get_nearest_map_source(const cv::Mat &map, const cv::Rect &roi, const cv::Size &size);
+
+/*!
+ * @brief Undistort (and optionally rectify) a sparse set of points from a raw
+ * rectilinear or fisheye image.
+ *
+ * Given the same arguments the points end up where they would be found in an
+ * image remapped with the maps from @ref calibration_get_undistort_map, but
+ * without having to remap the whole image.
+ *
+ * @param calib A single camera calibration structure.
+ * @param points Points in raw (distorted) pixel coordinates.
+ * @param[out] out_points Undistorted points, same order as @p points.
+ * @param rectify_transform_optional A rectification transform to apply, if
+ * desired.
+ * @param new_camera_matrix_optional Unlike OpenCV, the default/empty matrix
+ * here uses the input camera matrix as your output camera matrix.
+ */
+void
+calibration_undistort_points(t_camera_calibration &calib,
+                             const std::vector<cv::Point2f> &points,
+                             std::vector<cv::Point2f> &out_points,
+                             cv::InputArray rectify_transform_optional = cv::noArray(),
+                             cv::Mat new_camera_matrix_optional = cv::Mat());
+
 /*!
  * @brief Rectification, rotation, projection data for a single view in a stereo
  * pair.
@@ -9,10 +9,25 @@
  * @ingroup aux_tracking
  */
 
+#include "xrt/xrt_config_os.h"
+
 #include "tracking/t_calibration_opencv.hpp"
 #include "util/u_misc.h"
+#include "util/u_file.h"
+#include "util/u_debug.h"
 #include "util/u_logging.h"
 
+#include <string.h>
+#include <inttypes.h>
+
+#ifdef XRT_OS_UNIX
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+DEBUG_GET_ONCE_BOOL_OPTION(rectification_cache, "T_RECTIFICATION_CACHE", true)
+
 /*
  *
  * Pre-declar functions.
@@ -26,6 +41,200 @@ static bool
 write_cv_mat(FILE *f, cv::Mat *m);
 
 
+/*
+ *
+ * Rectification map cache.
+ *
+ */
+
+//! Bump when the content of the maps changes for the same input.
+#define REMAP_CACHE_VERSION 1
+
+/*!
+ * Header of a cached @ref RemapPair, followed by the CV_16SC2 map and then
+ * the CV_16UC1 interpolation table, both without any padding.
+ */
+struct RemapCacheHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t width;
+	uint32_t height;
+	uint32_t _pad;
+	uint64_t hash;
+};
+
+static const char remap_cache_magic[8] = {'X', 'R', 'T', 'R', 'M', 'A', 'P', '\0'};
+
+static void
+hash_bytes(uint64_t &hash, const void *data, size_t size)
+{
+	// FNV-1a, only used to name and check cache files.
+	const uint8_t *bytes = (const uint8_t *)data;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= UINT64_C(0x100000001b3);
+	}
+}
+
+static void
+hash_mat(uint64_t &hash, cv::InputArray arr)
+{
+	cv::Mat mat;
+	if (!arr.empty()) {
+		arr.getMat().convertTo(mat, CV_64F);
+	}
+
+	int32_t dims[2] = {mat.rows, mat.cols};
+	hash_bytes(hash, dims, sizeof(dims));
+
+	for (int row = 0; row < mat.rows; row++) {
+		hash_bytes(hash, mat.ptr<double>(row), mat.cols * sizeof(double));
+	}
+}
+
+/*!
+ * Hash everything that goes into the maps, field by field so that padding
+ * never ends up in the hash.
+ */
+static uint64_t
+hash_undistort_map(const t_camera_calibration &calib, cv::InputArray rectify, cv::InputArray new_camera)
+{
+	uint64_t hash = UINT64_C(0xcbf29ce484222325);
+	uint32_t header[3] = {
+	    REMAP_CACHE_VERSION,
+	    (uint32_t)calib.image_size_pixels.w,
+	    (uint32_t)calib.image_size_pixels.h,
+	};
+	uint8_t use_fisheye = calib.use_fisheye ? 1 : 0;
+
+	hash_bytes(hash, header, sizeof(header));
+	hash_bytes(hash, CV_VERSION, sizeof(CV_VERSION));
+	hash_bytes(hash, calib.intrinsics, sizeof(calib.intrinsics));
+	hash_bytes(hash, calib.distortion, sizeof(calib.distortion));
+	hash_bytes(hash, calib.distortion_fisheye, sizeof(calib.distortion_fisheye));
+	hash_bytes(hash, &use_fisheye, sizeof(use_fisheye));
+	hash_mat(hash, rectify);
+	hash_mat(hash, new_camera);
+
+	return hash;
+}
+
+static void
+get_remap_cache_filename(uint64_t hash, char *out_filename, size_t size)
+{
+	snprintf(out_filename, size, "rectify_%016" PRIx64 ".map", hash);
+}
+
+static bool
+remap_cache_check_header(const RemapCacheHeader &header, uint64_t hash, const cv::Size &size)
+{
+	return memcmp(header.magic, remap_cache_magic, sizeof(header.magic)) == 0 && //
+	       header.version == REMAP_CACHE_VERSION &&                               //
+	       header.width == (uint32_t)size.width &&                                //
+	       header.height == (uint32_t)size.height &&                              //
+	       header.hash == hash;
+}
+
+static bool
+remap_cache_load(uint64_t hash, const cv::Size &size, RemapPair &out)
+{
+	char filename[64];
+	get_remap_cache_filename(hash, filename, sizeof(filename));
+
+	FILE *file = u_file_open_file_in_cache_dir(filename, "rb");
+	if (file == NULL) {
+		return false;
+	}
+
+	size_t num_pixels = (size_t)size.width * (size_t)size.height;
+	size_t file_size = sizeof(RemapCacheHeader) + num_pixels * (2 * sizeof(int16_t) + sizeof(uint16_t));
+	bool ret = false;
+
+#ifdef XRT_OS_UNIX
+	// Map the file and copy straight out of the page cache.
+	struct stat st;
+	void *ptr = MAP_FAILED;
+	if (fstat(fileno(file), &st) == 0 && (size_t)st.st_size == file_size) {
+		ptr = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+	}
+	fclose(file);
+
+	if (ptr == MAP_FAILED) {
+		return false;
+	}
+
+	const RemapCacheHeader *header = (const RemapCacheHeader *)ptr;
+	if (remap_cache_check_header(*header, hash, size)) {
+		uint8_t *data = (uint8_t *)ptr + sizeof(RemapCacheHeader);
+		cv::Mat(size, CV_16SC2, data).copyTo(out.remap_x);
+		cv::Mat(size, CV_16UC1, data + num_pixels * 2 * sizeof(int16_t)).copyTo(out.remap_y);
+		ret = true;
+	}
+
+	munmap(ptr, file_size);
+#else
+	RemapCacheHeader header = {};
+	if (fread(&header, sizeof(header), 1, file) == 1 && remap_cache_check_header(header, hash, size)) {
+		out.remap_x.create(size, CV_16SC2);
+		out.remap_y.create(size, CV_16UC1);
+		ret = fread(out.remap_x.data, 2 * sizeof(int16_t), num_pixels, file) == num_pixels &&
+		      fread(out.remap_y.data, sizeof(uint16_t), num_pixels, file) == num_pixels;
+	}
+	fclose(file);
+	(void)file_size;
+#endif
+
+	return ret;
+}
+
+static void
+remap_cache_store(uint64_t hash, const RemapPair &pair)
+{
+	char filename[64];
+	char tmp_filename[80];
+	get_remap_cache_filename(hash, filename, sizeof(filename));
+	snprintf(tmp_filename, sizeof(tmp_filename), "%s.tmp", filename);
+
+	FILE *file = u_file_open_file_in_cache_dir(tmp_filename, "wb");
+	if (file == NULL) {
+		U_LOG_D("Could not open rectification cache file '%s'", tmp_filename);
+		return;
+	}
+
+	RemapCacheHeader header = {};
+	memcpy(header.magic, remap_cache_magic, sizeof(header.magic));
+	header.version = REMAP_CACHE_VERSION;
+	header.width = (uint32_t)pair.remap_x.cols;
+	header.height = (uint32_t)pair.remap_x.rows;
+	header.hash = hash;
+
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	for (int row = 0; ok && row < pair.remap_x.rows; row++) {
+		ok = fwrite(pair.remap_x.ptr(row), 2 * sizeof(int16_t), pair.remap_x.cols, file) ==
+		     (size_t)pair.remap_x.cols;
+	}
+	for (int row = 0; ok && row < pair.remap_y.rows; row++) {
+		ok = fwrite(pair.remap_y.ptr(row), sizeof(uint16_t), pair.remap_y.cols, file) ==
+		     (size_t)pair.remap_y.cols;
+	}
+	ok = fclose(file) == 0 && ok;
+
+	char tmp_path[1024];
+	char path[1024];
+	if (u_file_get_path_in_cache_dir(tmp_filename, tmp_path, sizeof(tmp_path)) <= 0 ||
+	    u_file_get_path_in_cache_dir(filename, path, sizeof(path)) <= 0) {
+		return;
+	}
+
+	// Rename so that readers never see a half written file.
+	if (!ok || rename(tmp_path, path) != 0) {
+		U_LOG_D("Could not write rectification cache file '%s'", path);
+		remove(tmp_path);
+	}
+}
+
+
 /*
  *
  * Refine and create functions.
@@ -47,13 +256,22 @@ calibration_get_undistort_map(t_camera_calibration &calib,
 	//              calibration for does not match what was saved
 	cv::Size image_size(calib.image_size_pixels.w, calib.image_size_pixels.h);
 
+	bool use_cache = debug_get_bool_option_rectification_cache();
+	uint64_t hash = 0;
+	if (use_cache) {
+		hash = hash_undistort_map(calib, rectify_transform_optional, new_camera_matrix_optional);
+		if (remap_cache_load(hash, image_size, ret)) {
+			return ret;
+		}
+	}
+
 	if (calib.use_fisheye) {
 		cv::fisheye::initUndistortRectifyMap(wrap.intrinsics_mat,         // cameraMatrix
 		                                     wrap.distortion_fisheye_mat, // distCoeffs
 		                                     rectify_transform_optional,  // R
 		                                     new_camera_matrix_optional,  // newCameraMatrix
 		                                     image_size,                  // size
-		                                     CV_32FC1,                    // m1type
+		                                     CV_16SC2,                    // m1type
 		                                     ret.remap_x,                 // map1
 		                                     ret.remap_y);                // map2
 	} else {
@@ -62,14 +280,109 @@ calibration_get_undistort_map(t_camera_calibration &calib,
 		                            rectify_transform_optional, // R
 		                            new_camera_matrix_optional, // newCameraMatrix
 		                            image_size,                 // size
-		                            CV_32FC1,                   // m1type
+		                            CV_16SC2,                   // m1type
 		                            ret.remap_x,                // map1
 		                            ret.remap_y);               // map2
 	}
 
+	if (use_cache) {
+		remap_cache_store(hash, ret);
+	}
+
+	return ret;
+}
+
+cv::Mat
+calibration_get_nearest_map(const RemapPair &pair)
+{
+	assert(pair.remap_x.type() == CV_16SC2);
+	assert(pair.remap_y.type() == CV_16UC1);
+	assert(pair.remap_x.size() == pair.remap_y.size());
+
+	// The table index is the fraction in 1/INTER_TAB_SIZE steps, y major.
+	const int half = cv::INTER_TAB_SIZE / 2;
+	cv::Mat ret(pair.remap_x.size(), CV_16SC2);
+
+	for (int row = 0; row < ret.rows; row++) {
+		const cv::Vec2s *xy = pair.remap_x.ptr<cv::Vec2s>(row);
+		const uint16_t *frac = pair.remap_y.ptr<uint16_t>(row);
+		cv::Vec2s *out = ret.ptr<cv::Vec2s>(row);
+
+		for (int col = 0; col < ret.cols; col++) {
+			int fx = frac[col] & (cv::INTER_TAB_SIZE - 1);
+			int fy = frac[col] / cv::INTER_TAB_SIZE;
+			out[col][0] = cv::saturate_cast<int16_t>(xy[col][0] + (fx >= half ? 1 : 0));
+			out[col][1] = cv::saturate_cast<int16_t>(xy[col][1] + (fy >= half ? 1 : 0));
+		}
+	}
+
 	return ret;
 }
 
+cv::Rect
+calibration_get_nearest_map_source(const cv::Mat &map, const cv::Rect &roi, const cv::Size &size)
+{
+	assert(map.type() == CV_16SC2);
+
+	cv::Rect full(cv::Point(0, 0), size);
+	if (roi.empty()) {
+		return cv::Rect();
+	}
+
+	int min_x = INT16_MAX;
+	int min_y = INT16_MAX;
+	int max_x = INT16_MIN;
+	int max_y = INT16_MIN;
+
+	for (int row = roi.y; row < roi.y + roi.height; row++) {
+		const cv::Vec2s *xy = map.ptr<cv::Vec2s>(row) + roi.x;
+
+		for (int col = 0; col < roi.width; col++) {
+			min_x = std::min<int>(min_x, xy[col][0]);
+			max_x = std::max<int>(max_x, xy[col][0]);
+			min_y = std::min<int>(min_y, xy[col][1]);
+			max_y = std::max<int>(max_y, xy[col][1]);
+		}
+	}
+
+	// The coordinates are whole pixels, include the last ones.
+	return cv::Rect(cv::Point(min_x, min_y), cv::Point(max_x + 1, max_y + 1)) & full;
+}
+
+void
+calibration_undistort_points(t_camera_calibration &calib,
+                             const std::vector<cv::Point2f> &points,
+                             std::vector<cv::Point2f> &out_points,
+                             cv::InputArray rectify_transform_optional,
+                             cv::Mat new_camera_matrix_optional)
+{
+	out_points.clear();
+	if (points.empty()) {
+		return;
+	}
+
+	CameraCalibrationWrapper wrap(calib);
+	if (new_camera_matrix_optional.empty()) {
+		new_camera_matrix_optional = wrap.intrinsics_mat;
+	}
+
+	if (calib.use_fisheye) {
+		cv::fisheye::undistortPoints(points,                      // distorted
+		                             out_points,                  // undistorted
+		                             wrap.intrinsics_mat,         // K
+		                             wrap.distortion_fisheye_mat, // D
+		                             rectify_transform_optional,  // R
+		                             new_camera_matrix_optional); // P
+	} else {
+		cv::undistortPoints(points,                      // src
+		                    out_points,                  // dst
+		                    wrap.intrinsics_mat,         // cameraMatrix
+		                    wrap.distortion_mat,         // distCoeffs
+		                    rectify_transform_optional,  // R
+		                    new_camera_matrix_optional); // P
+	}
+}
+
 StereoRectificationMaps::StereoRectificationMaps(t_stereo_camera_calibration *data)
 {
 	assert(data != NULL);
@@ -0,0 +1,179 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Small helper struct that processes the two views of a stereo frame
+ *         at the same time.
+ * @author Collabora, Ltd.
+ * @ingroup aux_tracking
+ */
+
+#pragma once
+
+#ifndef __cplusplus
+#error "This header is C++-only."
+#endif
+
+#include "os/os_time.h"
+#include "os/os_threading.h"
+
+#include "util/u_var.h"
+#include "util/u_time.h"
+
+#include <functional>
+
+
+/*!
+ * Runs the per view processing of a stereo tracker, the first view on the
+ * calling thread and the second one on a persistent worker thread. Per view
+ * and total processing times are recorded so the gain can be measured, the
+ * parallel processing can be turned off from the debug UI to compare.
+ */
+struct HelperViewWorker
+{
+public:
+	//! Thread and lock helper of the worker.
+	struct os_thread_helper oth = {};
+
+	//! Job for the second view, protected by the lock.
+	const std::function<void(int)> *job = {};
+
+	//! Process the views in parallel, otherwise in sequence.
+	bool parallel = true;
+
+	//! Time spent on each view for the last frame.
+	float view_ms[2] = {};
+
+	//! Time from start to both views being done for the last frame.
+	float total_ms = 0.0f;
+
+	//! Number of calls to @ref run, with the sum and max of their times.
+	uint64_t runs = 0;
+	double sum_ms = 0.0;
+	float max_ms = 0.0f;
+
+
+public:
+	HelperViewWorker()
+	{
+		os_thread_helper_init(&oth);
+	}
+
+	~HelperViewWorker()
+	{
+		os_thread_helper_destroy(&oth);
+	}
+
+	HelperViewWorker(const HelperViewWorker &) = delete;
+	HelperViewWorker &
+	operator=(const HelperViewWorker &) = delete;
+
+	int
+	start()
+	{
+		return os_thread_helper_start(&oth, run_func, this);
+	}
+
+	/*!
+	 * Must not be called while @ref run is in progress, stop the thread
+	 * calling it first.
+	 */
+	void
+	stop()
+	{
+		os_thread_helper_stop(&oth);
+	}
+
+	void
+	add_vars(void *root)
+	{
+		u_var_add_bool(root, &parallel, "Parallel views");
+		u_var_add_ro_f32(root, &view_ms[0], "View 0 (ms)");
+		u_var_add_ro_f32(root, &view_ms[1], "View 1 (ms)");
+		u_var_add_ro_f32(root, &total_ms, "Views total (ms)");
+		u_var_add_ro_u64(root, &runs, "Views runs");
+		u_var_add_ro_f64(root, &sum_ms, "Views sum (ms)");
+		u_var_add_ro_f32(root, &max_ms, "Views max (ms)");
+	}
+
+	/*!
+	 * Calls @p func with the view index for both views and returns when
+	 * both are done, the two calls must not touch the same state. Falls
+	 * back to running both on the calling thread if the worker isn't
+	 * running.
+	 */
+	void
+	run(const std::function<void(int)> &func)
+	{
+		uint64_t start_ns = os_monotonic_get_ns();
+
+		os_thread_helper_lock(&oth);
+		bool use_worker = parallel && os_thread_helper_is_running_locked(&oth);
+		if (use_worker) {
+			job = &func;
+			os_thread_helper_signal_locked(&oth);
+		}
+		os_thread_helper_unlock(&oth);
+
+		timed(func, 0);
+
+		if (use_worker) {
+			os_thread_helper_lock(&oth);
+			while (job != NULL) {
+				os_thread_helper_wait_locked(&oth);
+			}
+			os_thread_helper_unlock(&oth);
+		} else {
+			timed(func, 1);
+		}
+
+		total_ms = (float)time_ns_to_s(os_monotonic_get_ns() - start_ns) * 1000.f;
+
+		runs++;
+		sum_ms += total_ms;
+		max_ms = total_ms > max_ms ? total_ms : max_ms;
+	}
+
+
+private:
+	void
+	timed(const std::function<void(int)> &func, int view)
+	{
+		uint64_t start_ns = os_monotonic_get_ns();
+		func(view);
+		view_ms[view] = (float)time_ns_to_s(os_monotonic_get_ns() - start_ns) * 1000.f;
+	}
+
+	void
+	worker()
+	{
+		os_thread_helper_lock(&oth);
+
+		while (os_thread_helper_is_running_locked(&oth)) {
+			if (job == NULL) {
+				os_thread_helper_wait_locked(&oth);
+				continue;
+			}
+
+			const std::function<void(int)> *func = job;
+
+			// Do the work without holding the lock.
+			os_thread_helper_unlock(&oth);
+			timed(*func, 1);
+			os_thread_helper_lock(&oth);
+
+			// Tell the caller that the view is done.
+			job = NULL;
+			os_thread_helper_signal_locked(&oth);
+		}
+
+		os_thread_helper_unlock(&oth);
+	}
+
+	static void *
+	run_func(void *ptr)
+	{
+		static_cast<HelperViewWorker *>(ptr)->worker();
+		return NULL;
+	}
+};
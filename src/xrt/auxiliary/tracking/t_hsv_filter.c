@@ -7,6 +7,8 @@
  * @ingroup aux_tracking
  */
 
+#include "xrt/xrt_config_have.h"
+
 #include "util/u_var.h"
 #include "util/u_misc.h"
 #include "util/u_debug.h"
@@ -16,8 +18,21 @@
 #include "tracking/t_tracking.h"
 
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 
+#ifdef XRT_HAVE_JPEG
+#include <setjmp.h>
+#include "jpeglib.h"
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define T_HSV_FILTER_HAVE_X86
+#include <immintrin.h>
+
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
 
 #define MOD_180(v) ((uint32_t)(v) % 180)
 
@@ -122,6 +137,23 @@ t_hsv_build_optimized_table(struct t_hsv_filter_params *params, struct t_hsv_fil
 
 #define NUM_CHANNELS 4
 
+/*!
+ * Max number of scanlines libjpeg gives us at once, it says at most 4.
+ */
+#define MAX_JPEG_ROWS 4
+
+#ifdef XRT_HAVE_JPEG
+/*!
+ * Error manager that jumps back into the decode function instead of exiting.
+ */
+struct t_hsv_filter_jpeg_error_mgr
+{
+	struct jpeg_error_mgr base;
+
+	jmp_buf jump;
+};
+#endif
+
 /*!
  * An @ref xrt_frame_sink that splits the input based on hue.
  * @implements xrt_frame_sink
@@ -143,10 +175,33 @@ struct t_hsv_filter
 	struct xrt_frame *frame2;
 	struct xrt_frame *frame3;
 
-	struct t_hsv_filter_optimized_table table;
+	/*!
+	 * The AVX2 gather loads a whole 32-bit word at each byte index, so
+	 * looking up the last entry reads three bytes past the table, the
+	 * union makes the storage big enough to cover that.
+	 */
+	union {
+		struct t_hsv_filter_optimized_table table;
+		uint8_t gather_bytes[sizeof(struct t_hsv_filter_optimized_table) + sizeof(int32_t) - 1];
+	} lut;
+
+	enum t_hsv_filter_output output;
+
+	//! Use the AVX2 gather classifier for packed output.
+	bool use_avx2;
+
+#ifdef XRT_HAVE_JPEG
+	//! Used to decode MJPEG frames a few rows at the time.
+	struct jpeg_decompress_struct cinfo;
+	struct t_hsv_filter_jpeg_error_mgr jerr;
+
+	//! Holds the decoded YUV rows, never a full frame.
+	uint8_t *jpeg_rows;
+	size_t jpeg_rows_size;
+#endif
 };
 
-static void
+static inline void
 process_sample(struct t_hsv_filter *f,
                uint8_t y,
                uint8_t cb,
@@ -156,7 +211,7 @@ process_sample(struct t_hsv_filter *f,
                uint8_t *dst2,
                uint8_t *dst3)
 {
-	uint8_t bits = t_hsv_filter_sample(&f->table, y, cb, cr);
+	uint8_t bits = t_hsv_filter_sample(&f->lut.table, y, cb, cr);
 	uint8_t v0 = (bits & (1 << 0)) ? 0xff : 0x00;
 	uint8_t v1 = (bits & (1 << 1)) ? 0xff : 0x00;
 	uint8_t v2 = (bits & (1 << 2)) ? 0xff : 0x00;
@@ -168,93 +223,383 @@ process_sample(struct t_hsv_filter *f,
 	*dst3 = v3;
 }
 
+/*!
+ * Classify one row of YUV888 pixels, writes the row @p row of the masks.
+ */
+static inline void
+process_row_yuv(struct t_hsv_filter *f, const uint8_t *src, uint32_t row, uint32_t width)
+{
+	uint8_t *dst0 = f->frame0->data + row * f->frame0->stride;
+	uint8_t *dst1 = f->frame1->data + row * f->frame1->stride;
+	uint8_t *dst2 = f->frame2->data + row * f->frame2->stride;
+	uint8_t *dst3 = f->frame3->data + row * f->frame3->stride;
+
+	for (uint32_t x = 0; x < width; x += 1) {
+		uint8_t y = src[0];
+		uint8_t cb = src[1];
+		uint8_t cr = src[2];
+		src += 3;
+
+		process_sample(f, y, cb, cr, dst0, dst1, dst2, dst3);
+		dst0 += 1;
+		dst1 += 1;
+		dst2 += 1;
+		dst3 += 1;
+	}
+}
+
+/*!
+ * Classify one row of packed 4:2:2 pixels, the offsets are the position of
+ * each component in the four byte macro pixel so this handles both YUYV and
+ * UYVY. Writes the row @p row of the masks.
+ */
+static inline void
+process_row_422(struct t_hsv_filter *f,
+                const uint8_t *src,
+                uint32_t row,
+                uint32_t width,
+                const int y1_off,
+                const int cb_off,
+                const int y2_off,
+                const int cr_off)
+{
+	uint8_t *dst0 = f->frame0->data + row * f->frame0->stride;
+	uint8_t *dst1 = f->frame1->data + row * f->frame1->stride;
+	uint8_t *dst2 = f->frame2->data + row * f->frame2->stride;
+	uint8_t *dst3 = f->frame3->data + row * f->frame3->stride;
+
+	for (uint32_t x = 0; x < width; x += 2) {
+		uint8_t y1 = src[y1_off];
+		uint8_t cb = src[cb_off];
+		uint8_t y2 = src[y2_off];
+		uint8_t cr = src[cr_off];
+		src += 4;
+
+		uint8_t bits0 = t_hsv_filter_sample(&f->lut.table, y1, cb, cr);
+		uint8_t bits1 = t_hsv_filter_sample(&f->lut.table, y2, cb, cr);
+
+		uint8_t v0 = (bits0 & (1 << 0)) ? 0xff : 0x00;
+		uint8_t v1 = (bits0 & (1 << 1)) ? 0xff : 0x00;
+		uint8_t v2 = (bits0 & (1 << 2)) ? 0xff : 0x00;
+		uint8_t v3 = (bits0 & (1 << 3)) ? 0xff : 0x00;
+		uint8_t v4 = (bits1 & (1 << 0)) ? 0xff : 0x00;
+		uint8_t v5 = (bits1 & (1 << 1)) ? 0xff : 0x00;
+		uint8_t v6 = (bits1 & (1 << 2)) ? 0xff : 0x00;
+		uint8_t v7 = (bits1 & (1 << 3)) ? 0xff : 0x00;
+
+		*(uint16_t *)dst0 = v0 | v4 << 8;
+		*(uint16_t *)dst1 = v1 | v5 << 8;
+		*(uint16_t *)dst2 = v2 | v6 << 8;
+		*(uint16_t *)dst3 = v3 | v7 << 8;
+
+		dst0 += 2;
+		dst1 += 2;
+		dst2 += 2;
+		dst3 += 2;
+	}
+}
+
+static inline void
+fetch_pixel(const uint8_t *src, uint32_t x, enum xrt_format format, uint8_t *y, uint8_t *cb, uint8_t *cr)
+{
+	// Start of the four byte macro pixel for the 4:2:2 formats.
+	uint32_t m = (x & ~1u) * 2;
+
+	switch (format) {
+	case XRT_FORMAT_YUYV422:
+		*y = src[x * 2];
+		*cb = src[m + 1];
+		*cr = src[m + 3];
+		break;
+	case XRT_FORMAT_UYVY422:
+		*y = src[x * 2 + 1];
+		*cb = src[m + 0];
+		*cr = src[m + 2];
+		break;
+	default:
+		*y = src[x * 3 + 0];
+		*cb = src[x * 3 + 1];
+		*cr = src[x * 3 + 2];
+		break;
+	}
+}
+
+#ifdef T_HSV_FILTER_HAVE_X86
+/*!
+ * Classifies eight pixels at the time, builds the table indices with shuffles
+ * and looks them up with a gather, then moves each channel bit into the sign
+ * bit to get one byte per channel out of movemask. Returns the number of
+ * pixels done, always a multiple of eight.
+ */
+TARGET_AVX2 static uint32_t
+process_row_packed_avx2(struct t_hsv_filter *f,
+                        const uint8_t *src,
+                        uint32_t width,
+                        enum xrt_format format,
+                        uint8_t *dst0,
+                        uint8_t *dst1,
+                        uint8_t *dst2,
+                        uint8_t *dst3)
+{
+	const int *table = (const int *)f->lut.gather_bytes;
+	const __m256i mask_f8 = _mm256_set1_epi32(0xf8);
+
+	// clang-format off
+	const __m128i yuyv_y = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i yuyv_u = _mm_setr_epi8(1, 1, 5, 5, 9, 9, 13, 13, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i yuyv_v = _mm_setr_epi8(3, 3, 7, 7, 11, 11, 15, 15, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i uyvy_y = _mm_setr_epi8(1, 3, 5, 7, 9, 11, 13, 15, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i uyvy_u = _mm_setr_epi8(0, 0, 4, 4, 8, 8, 12, 12, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i uyvy_v = _mm_setr_epi8(2, 2, 6, 6, 10, 10, 14, 14, -1, -1, -1, -1, -1, -1, -1, -1);
+	// First four pixels from the low load, last four from the load at byte 8.
+	const __m128i yuv_lo_y = _mm_setr_epi8(0, 3, 6, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i yuv_lo_u = _mm_setr_epi8(1, 4, 7, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i yuv_lo_v = _mm_setr_epi8(2, 5, 8, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i yuv_hi_y = _mm_setr_epi8(-1, -1, -1, -1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i yuv_hi_u = _mm_setr_epi8(-1, -1, -1, -1, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i yuv_hi_v = _mm_setr_epi8(-1, -1, -1, -1, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1);
+	// clang-format on
+
+	uint32_t x = 0;
+	for (; x + 8 <= width; x += 8) {
+		__m128i y8, u8, v8;
+
+		switch (format) {
+		case XRT_FORMAT_YUYV422: {
+			__m128i in = _mm_loadu_si128((const __m128i *)(src + x * 2));
+			y8 = _mm_shuffle_epi8(in, yuyv_y);
+			u8 = _mm_shuffle_epi8(in, yuyv_u);
+			v8 = _mm_shuffle_epi8(in, yuyv_v);
+		} break;
+		case XRT_FORMAT_UYVY422: {
+			__m128i in = _mm_loadu_si128((const __m128i *)(src + x * 2));
+			y8 = _mm_shuffle_epi8(in, uyvy_y);
+			u8 = _mm_shuffle_epi8(in, uyvy_u);
+			v8 = _mm_shuffle_epi8(in, uyvy_v);
+		} break;
+		default: {
+			__m128i lo = _mm_loadu_si128((const __m128i *)(src + x * 3));
+			__m128i hi = _mm_loadu_si128((const __m128i *)(src + x * 3 + 8));
+			y8 = _mm_or_si128(_mm_shuffle_epi8(lo, yuv_lo_y), _mm_shuffle_epi8(hi, yuv_hi_y));
+			u8 = _mm_or_si128(_mm_shuffle_epi8(lo, yuv_lo_u), _mm_shuffle_epi8(hi, yuv_hi_u));
+			v8 = _mm_or_si128(_mm_shuffle_epi8(lo, yuv_lo_v), _mm_shuffle_epi8(hi, yuv_hi_v));
+		} break;
+		}
+
+		__m256i y = _mm256_cvtepu8_epi32(y8);
+		__m256i u = _mm256_cvtepu8_epi32(u8);
+		__m256i v = _mm256_cvtepu8_epi32(v8);
+
+		// Same as t_hsv_filter_sample: [y / 8][u / 8][v / 8].
+		__m256i index = _mm256_slli_epi32(_mm256_and_si256(y, mask_f8), 7);
+		index = _mm256_or_si256(index, _mm256_slli_epi32(_mm256_and_si256(u, mask_f8), 2));
+		index = _mm256_or_si256(index, _mm256_srli_epi32(v, 3));
+
+		// Only the lowest byte is the entry, the others are ignored.
+		__m256i bits = _mm256_i32gather_epi32(table, index, 1);
+
+		dst0[x / 8] = (uint8_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_slli_epi32(bits, 31)));
+		dst1[x / 8] = (uint8_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_slli_epi32(bits, 30)));
+		dst2[x / 8] = (uint8_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_slli_epi32(bits, 29)));
+		dst3[x / 8] = (uint8_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_slli_epi32(bits, 28)));
+	}
+
+	return x;
+}
+#endif
+
+/*!
+ * Classify one row into the @ref XRT_FORMAT_BITMAP_8X1 masks, writes the
+ * row @p row of the masks.
+ */
+static inline void
+process_row_packed(
+    struct t_hsv_filter *f, const uint8_t *src, uint32_t row, uint32_t width, enum xrt_format format)
+{
+	uint8_t *dst0 = f->frame0->data + row * f->frame0->stride;
+	uint8_t *dst1 = f->frame1->data + row * f->frame1->stride;
+	uint8_t *dst2 = f->frame2->data + row * f->frame2->stride;
+	uint8_t *dst3 = f->frame3->data + row * f->frame3->stride;
+
+	uint32_t x = 0;
+
+#ifdef T_HSV_FILTER_HAVE_X86
+	if (f->use_avx2) {
+		x = process_row_packed_avx2(f, src, width, format, dst0, dst1, dst2, dst3);
+	}
+#endif
+
+	for (; x < width; x += 8) {
+		uint32_t num = width - x < 8 ? width - x : 8;
+		uint8_t b0 = 0, b1 = 0, b2 = 0, b3 = 0;
+
+		for (uint32_t i = 0; i < num; i++) {
+			uint8_t y, cb, cr;
+			fetch_pixel(src, x + i, format, &y, &cb, &cr);
+
+			uint8_t bits = t_hsv_filter_sample(&f->lut.table, y, cb, cr);
+			b0 |= ((bits >> 0) & 1) << i;
+			b1 |= ((bits >> 1) & 1) << i;
+			b2 |= ((bits >> 2) & 1) << i;
+			b3 |= ((bits >> 3) & 1) << i;
+		}
+
+		dst0[x / 8] = b0;
+		dst1[x / 8] = b1;
+		dst2[x / 8] = b2;
+		dst3[x / 8] = b3;
+	}
+}
+
+/*!
+ * Classify one row of @p format pixels, writes the row @p row of the masks.
+ */
+static inline void
+process_row(struct t_hsv_filter *f, const uint8_t *src, uint32_t row, uint32_t width, enum xrt_format format)
+{
+	if (f->output == T_HSV_FILTER_OUTPUT_BITMAP_8X1) {
+		process_row_packed(f, src, row, width, format);
+		return;
+	}
+
+	switch (format) {
+	case XRT_FORMAT_YUYV422: process_row_422(f, src, row, width, 0, 1, 2, 3); break;
+	case XRT_FORMAT_UYVY422: process_row_422(f, src, row, width, 1, 0, 3, 2); break;
+	default: process_row_yuv(f, src, row, width); break;
+	}
+}
+
 XRT_NO_INLINE static void
 process_frame_yuv(struct t_hsv_filter *f, struct xrt_frame *xf)
 {
-	struct xrt_frame *f0 = f->frame0;
-	struct xrt_frame *f1 = f->frame1;
-	struct xrt_frame *f2 = f->frame2;
-	struct xrt_frame *f3 = f->frame3;
-
 	for (uint32_t y = 0; y < xf->height; y++) {
-		uint8_t *src = (uint8_t *)xf->data + y * xf->stride;
-		uint8_t *dst0 = f0->data + y * f0->stride;
-		uint8_t *dst1 = f1->data + y * f1->stride;
-		uint8_t *dst2 = f2->data + y * f2->stride;
-		uint8_t *dst3 = f3->data + y * f3->stride;
-
-		for (uint32_t x = 0; x < xf->width; x += 1) {
-			uint8_t y = src[0];
-			uint8_t cb = src[1];
-			uint8_t cr = src[2];
-			src += 3;
-
-			process_sample(f, y, cb, cr, dst0, dst1, dst2, dst3);
-			dst0 += 1;
-			dst1 += 1;
-			dst2 += 1;
-			dst3 += 1;
-		}
+		const uint8_t *src = xf->data + y * xf->stride;
+		process_row(f, src, y, xf->width, XRT_FORMAT_YUV888);
 	}
 }
 
 XRT_NO_INLINE static void
 process_frame_yuyv(struct t_hsv_filter *f, struct xrt_frame *xf)
 {
-	struct xrt_frame *f0 = f->frame0;
-	struct xrt_frame *f1 = f->frame1;
-	struct xrt_frame *f2 = f->frame2;
-	struct xrt_frame *f3 = f->frame3;
+	for (uint32_t y = 0; y < xf->height; y++) {
+		const uint8_t *src = xf->data + y * xf->stride;
+		process_row(f, src, y, xf->width, XRT_FORMAT_YUYV422);
+	}
+}
 
+XRT_NO_INLINE static void
+process_frame_uyvy(struct t_hsv_filter *f, struct xrt_frame *xf)
+{
 	for (uint32_t y = 0; y < xf->height; y++) {
-		uint8_t *src = (uint8_t *)xf->data + y * xf->stride;
-		uint8_t *dst0 = f0->data + y * f0->stride;
-		uint8_t *dst1 = f1->data + y * f1->stride;
-		uint8_t *dst2 = f2->data + y * f2->stride;
-		uint8_t *dst3 = f3->data + y * f3->stride;
-
-		for (uint32_t x = 0; x < xf->width; x += 2) {
-			uint8_t y1 = src[0];
-			uint8_t cb = src[1];
-			uint8_t y2 = src[2];
-			uint8_t cr = src[3];
-			src += 4;
-
-			uint8_t bits0 = t_hsv_filter_sample(&f->table, y1, cb, cr);
-			uint8_t bits1 = t_hsv_filter_sample(&f->table, y2, cb, cr);
-
-			uint8_t v0 = (bits0 & (1 << 0)) ? 0xff : 0x00;
-			uint8_t v1 = (bits0 & (1 << 1)) ? 0xff : 0x00;
-			uint8_t v2 = (bits0 & (1 << 2)) ? 0xff : 0x00;
-			uint8_t v3 = (bits0 & (1 << 3)) ? 0xff : 0x00;
-			uint8_t v4 = (bits1 & (1 << 0)) ? 0xff : 0x00;
-			uint8_t v5 = (bits1 & (1 << 1)) ? 0xff : 0x00;
-			uint8_t v6 = (bits1 & (1 << 2)) ? 0xff : 0x00;
-			uint8_t v7 = (bits1 & (1 << 3)) ? 0xff : 0x00;
-
-			*(uint16_t *)dst0 = v0 | v4 << 8;
-			*(uint16_t *)dst1 = v1 | v5 << 8;
-			*(uint16_t *)dst2 = v2 | v6 << 8;
-			*(uint16_t *)dst3 = v3 | v7 << 8;
-
-			dst0 += 2;
-			dst1 += 2;
-			dst2 += 2;
-			dst3 += 2;
+		const uint8_t *src = xf->data + y * xf->stride;
+		process_row(f, src, y, xf->width, XRT_FORMAT_UYVY422);
+	}
+}
+
+#ifdef XRT_HAVE_JPEG
+static void
+jpeg_error_exit(j_common_ptr cinfo)
+{
+	struct t_hsv_filter_jpeg_error_mgr *err = (struct t_hsv_filter_jpeg_error_mgr *)cinfo->err;
+
+	char buffer[JMSG_LENGTH_MAX];
+	(*cinfo->err->format_message)(cinfo, buffer);
+	U_LOG_E("libjpeg: %s", buffer);
+
+	longjmp(err->jump, 1);
+}
+
+static void
+jpeg_output_message(j_common_ptr cinfo)
+{
+	// Warnings are too noisy for corrupt frames from cameras, drop them.
+}
+
+/*!
+ * Decodes the MJPEG frame a few rows at the time straight into YUV and
+ * classifies them, so no full decoded frame is ever written.
+ */
+XRT_NO_INLINE static bool
+process_frame_mjpeg(struct t_hsv_filter *f, struct xrt_frame *xf)
+{
+	struct jpeg_decompress_struct *cinfo = &f->cinfo;
+
+	if (xf->size < 16 || xf->data[0] != 0xFF || xf->data[1] != 0xD8) {
+		U_LOG_E("Invalid JPEG frame!");
+		return false;
+	}
+
+	if (setjmp(f->jerr.jump)) {
+		jpeg_abort_decompress(cinfo);
+		return false;
+	}
+
+	jpeg_mem_src(cinfo, xf->data, xf->size);
+
+	int ret = jpeg_read_header(cinfo, TRUE);
+	if (ret != JPEG_HEADER_OK) {
+		jpeg_abort_decompress(cinfo);
+		return false;
+	}
+
+	if (cinfo->image_width != xf->width || cinfo->image_height != xf->height) {
+		U_LOG_E("JPEG size %ux%u doesn't match frame size %ux%u!", cinfo->image_width, cinfo->image_height,
+		        xf->width, xf->height);
+		jpeg_abort_decompress(cinfo);
+		return false;
+	}
+
+	cinfo->out_color_space = JCS_YCbCr;
+	jpeg_start_decompress(cinfo);
+
+	uint32_t num_rows = cinfo->rec_outbuf_height;
+	if (num_rows < 1 || num_rows > MAX_JPEG_ROWS) {
+		num_rows = MAX_JPEG_ROWS;
+	}
+
+	size_t row_size = (size_t)xf->width * 3;
+	size_t size = row_size * num_rows;
+	if (f->jpeg_rows_size < size) {
+		free(f->jpeg_rows);
+		f->jpeg_rows = U_TYPED_ARRAY_CALLOC(uint8_t, size);
+		f->jpeg_rows_size = size;
+	}
+
+	JSAMPROW rows[MAX_JPEG_ROWS];
+	for (uint32_t i = 0; i < num_rows; i++) {
+		rows[i] = f->jpeg_rows + i * row_size;
+	}
+
+	while (cinfo->output_scanline < cinfo->output_height) {
+		uint32_t y = cinfo->output_scanline;
+		uint32_t read = jpeg_read_scanlines(cinfo, rows, num_rows);
+
+		for (uint32_t i = 0; i < read; i++) {
+			process_row(f, rows[i], y + i, xf->width, XRT_FORMAT_YUV888);
 		}
 	}
+
+	jpeg_finish_decompress(cinfo);
+
+	return true;
 }
+#endif
 
 static void
 ensure_buf_allocated(struct t_hsv_filter *f, struct xrt_frame *xf)
 {
 	uint32_t w = xf->width;
 	uint32_t h = xf->height;
+	enum xrt_format format = XRT_FORMAT_L8;
+
+	if (f->output == T_HSV_FILTER_OUTPUT_BITMAP_8X1) {
+		format = XRT_FORMAT_BITMAP_8X1;
+	}
 
-	u_frame_create_one_off(XRT_FORMAT_L8, w, h, &f->frame0);
-	u_frame_create_one_off(XRT_FORMAT_L8, w, h, &f->frame1);
-	u_frame_create_one_off(XRT_FORMAT_L8, w, h, &f->frame2);
-	u_frame_create_one_off(XRT_FORMAT_L8, w, h, &f->frame3);
+	u_frame_create_one_off(format, w, h, &f->frame0);
+	u_frame_create_one_off(format, w, h, &f->frame1);
+	u_frame_create_one_off(format, w, h, &f->frame2);
+	u_frame_create_one_off(format, w, h, &f->frame3);
 }
 
 static void
@@ -291,6 +636,22 @@ push_frame(struct xrt_frame_sink *xsink, struct xrt_frame *xf)
 		ensure_buf_allocated(f, xf);
 		process_frame_yuyv(f, xf);
 		break;
+	case XRT_FORMAT_UYVY422:
+		ensure_buf_allocated(f, xf);
+		process_frame_uyvy(f, xf);
+		break;
+#ifdef XRT_HAVE_JPEG
+	case XRT_FORMAT_MJPEG:
+		ensure_buf_allocated(f, xf);
+		if (!process_frame_mjpeg(f, xf)) {
+			xrt_frame_reference(&f->frame0, NULL);
+			xrt_frame_reference(&f->frame1, NULL);
+			xrt_frame_reference(&f->frame2, NULL);
+			xrt_frame_reference(&f->frame3, NULL);
+			return;
+		}
+		break;
+#endif
 	default: U_LOG_E("Bad format '%s'", u_format_str(xf->format)); return;
 	}
 
@@ -319,26 +680,101 @@ destroy(struct xrt_frame_node *node)
 {
 	struct t_hsv_filter *f = container_of(node, struct t_hsv_filter, node);
 	u_var_remove_root(f);
+#ifdef XRT_HAVE_JPEG
+	jpeg_destroy_decompress(&f->cinfo);
+	free(f->jpeg_rows);
+#endif
 	free(f);
 }
 
+/*!
+ * Expands one bitmap byte into eight pixels of 0xff or 0x00, the left most
+ * pixel first in memory on little endian: spread the byte into every byte
+ * lane, keep bit n in lane n, turn set lanes into 0x80 and then into 0xff.
+ */
+static inline uint64_t
+unpack_byte(uint8_t byte)
+{
+	uint64_t lanes = ((uint64_t)byte * 0x0101010101010101ULL) & 0x8040201008040201ULL;
+	lanes = ((lanes + 0x7f7f7f7f7f7f7f7fULL) & 0x8080808080808080ULL) >> 7;
+	return lanes * 0xff;
+}
+
+void
+t_hsv_filter_unpack_bitmap(struct xrt_frame *xf,
+                           uint32_t x,
+                           uint32_t y,
+                           uint32_t width,
+                           uint32_t height,
+                           uint8_t *dst,
+                           size_t dst_stride)
+{
+	assert(xf->format == XRT_FORMAT_BITMAP_8X1);
+	assert(x + width <= xf->width);
+	assert(y + height <= xf->height);
+
+	for (uint32_t row = 0; row < height; row++) {
+		const uint8_t *src = xf->data + (y + row) * xf->stride;
+		uint8_t *d = dst + row * dst_stride;
+		uint32_t i = 0;
+
+		// Single pixels up to the first whole byte.
+		for (; i < width && (x + i) % 8 != 0; i++) {
+			uint32_t sx = x + i;
+			d[i] = ((src[sx / 8] >> (sx % 8)) & 1) ? 0xff : 0x00;
+		}
+
+		// Eight pixels per byte.
+		for (; i + 8 <= width; i += 8) {
+			uint64_t pixels = unpack_byte(src[(x + i) / 8]);
+			memcpy(d + i, &pixels, sizeof(pixels));
+		}
+
+		for (; i < width; i++) {
+			uint32_t sx = x + i;
+			d[i] = ((src[sx / 8] >> (sx % 8)) & 1) ? 0xff : 0x00;
+		}
+	}
+}
+
 int
 t_hsv_filter_create(struct xrt_frame_context *xfctx,
                     struct t_hsv_filter_params *params,
                     struct xrt_frame_sink *sinks[4],
                     struct xrt_frame_sink **out_sink)
+{
+	return t_hsv_filter_create_with_output(xfctx, params, T_HSV_FILTER_OUTPUT_L8, sinks, out_sink);
+}
+
+int
+t_hsv_filter_create_with_output(struct xrt_frame_context *xfctx,
+                                struct t_hsv_filter_params *params,
+                                enum t_hsv_filter_output output,
+                                struct xrt_frame_sink *sinks[4],
+                                struct xrt_frame_sink **out_sink)
 {
 	struct t_hsv_filter *f = U_TYPED_CALLOC(struct t_hsv_filter);
 	f->base.push_frame = push_frame;
 	f->node.break_apart = break_apart;
 	f->node.destroy = destroy;
 	f->params = *params;
+	f->output = output;
+#ifdef T_HSV_FILTER_HAVE_X86
+	f->use_avx2 = __builtin_cpu_supports("avx2");
+#endif
 	f->sinks[0] = sinks[0];
 	f->sinks[1] = sinks[1];
 	f->sinks[2] = sinks[2];
 	f->sinks[3] = sinks[3];
 
-	t_hsv_build_optimized_table(&f->params, &f->table);
+	t_hsv_build_optimized_table(&f->params, &f->lut.table);
+
+#ifdef XRT_HAVE_JPEG
+	f->cinfo.err = jpeg_std_error(&f->jerr.base);
+	f->jerr.base.error_exit = jpeg_error_exit;
+	f->jerr.base.output_message = jpeg_output_message;
+	jpeg_create_decompress(&f->cinfo);
+#endif
 
 	xrt_frame_context_add(xfctx, &f->node);
 
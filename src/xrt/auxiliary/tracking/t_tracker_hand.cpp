@@ -16,6 +16,7 @@
 #include "util/u_sink.h"
 
 #include "t_helper_debug_sink.hpp"
+#include "t_helper_view_worker.hpp"
 #include "t_tracking.h"
 #include "tracking/t_calibration_opencv.hpp"
 
@@ -27,8 +28,8 @@
  */
 struct View
 {
-	cv::Mat undistort_rectify_map_x;
-	cv::Mat undistort_rectify_map_y;
+	//! Rounded to whole pixels, for cv::INTER_NEAREST.
+	cv::Mat undistort_rectify_map;
 
 	cv::Matx33d intrinsics;
 	cv::Mat distortion; // size may vary
@@ -48,8 +49,7 @@ struct View
 		distortion_fisheye = wrap.distortion_fisheye_mat;
 		use_fisheye = wrap.use_fisheye;
 
-		undistort_rectify_map_x = rectification.remap_x;
-		undistort_rectify_map_y = rectification.remap_y;
+		undistort_rectify_map = calibration_get_nearest_map(rectification);
 	}
 };
 
@@ -84,6 +84,8 @@ struct TrackerHand
 
 	HelperDebugSink debug = {HelperDebugSink::AllAvailable};
 
+	//! Processes the two views at the same time.
+	HelperViewWorker view_worker;
 
 	View view[2];
 
@@ -106,13 +108,13 @@ do_view(TrackerHand &t, View &view, cv::Mat &grey, cv::Mat &rgb)
 {
 	// Undistort and rectify the whole image.
 	//! @todo: This is an expensive operation, skip it if possible
-	cv::remap(grey,                         // src
-	          view.frame_undist_rectified,  // dst
-	          view.undistort_rectify_map_x, // map1
-	          view.undistort_rectify_map_y, // map2
-	          cv::INTER_NEAREST,            // interpolation
-	          cv::BORDER_CONSTANT,          // borderMode
-	          cv::Scalar(0, 0, 0));         // borderValue
+	cv::remap(grey,                        // src
+	          view.frame_undist_rectified, // dst
+	          view.undistort_rectify_map,  // map1
+	          cv::noArray(),               // map2
+	          cv::INTER_NEAREST,           // interpolation
+	          cv::BORDER_CONSTANT,         // borderMode
+	          cv::Scalar(0, 0, 0));        // borderValue
 
 #if 0
 	cv::threshold(view.frame_undist_rectified, // src
@@ -157,8 +159,8 @@ process(TrackerHand &t, struct xrt_frame *xf)
 	int rows = xf->height;
 	int stride = xf->stride;
 
-	int rect_cols = t.view[0].undistort_rectify_map_x.cols;
-	int rect_rows = t.view[0].undistort_rectify_map_x.rows;
+	int rect_cols = t.view[0].undistort_rectify_map.cols;
+	int rect_rows = t.view[0].undistort_rectify_map.rows;
 
 	if (cols != rect_cols || rows != rect_rows) {
 		U_LOG_E("%dx%d rectification matrix does not fit %dx%d Image", rect_cols, rect_rows, cols, rows);
@@ -182,11 +184,13 @@ process(TrackerHand &t, struct xrt_frame *xf)
 #endif
 
 #if 1
-	cv::Mat l_rgb(rows, cols, CV_8UC3, xf->data, stride);
-	cv::Mat r_rgb(rows, cols, CV_8UC3, xf->data + cols * 3, stride);
+	cv::Mat rgb[2] = {
+	    cv::Mat(rows, cols, CV_8UC3, xf->data, stride),
+	    cv::Mat(rows, cols, CV_8UC3, xf->data + cols * 3, stride),
+	};
 
-	do_view(t, t.view[0], l_rgb, t.debug.rgb[0]);
-	do_view(t, t.view[1], r_rgb, t.debug.rgb[1]);
+	// The views are independent, one on each thread.
+	t.view_worker.run([&](int i) { do_view(t, t.view[i], rgb[i], t.debug.rgb[i]); });
 	t.debug.submit();
 #endif
 
@@ -248,6 +252,12 @@ extern "C" int
 t_hand_start(struct xrt_tracked_hand *xth)
 {
 	auto &t = *container_of(xth, TrackerHand, base);
+
+	// Without the worker the views are processed in sequence.
+	if (t.view_worker.start() != 0) {
+		U_LOG_W("Failed to start view worker thread!");
+	}
+
 	return os_thread_helper_start(&t.oth, t_ht_run, &t);
 }
 
@@ -281,6 +291,9 @@ t_hand_node_break_apart(struct xrt_frame_node *node)
 {
 	auto &t = *container_of(node, TrackerHand, node);
 	os_thread_helper_stop(&t.oth);
+
+	// Only safe once the tracker thread is no longer processing frames.
+	t.view_worker.stop();
 }
 
 extern "C" void
@@ -398,6 +411,7 @@ t_hand_create(struct xrt_frame_context *xfctx,
 	u_var_add_vec3_f32(&t, &t.hand_data[0].hand_relation.pose.position, "hand.tracker.pos.0");
 	u_var_add_vec3_f32(&t, &t.hand_data[1].hand_relation.pose.position, "hand.tracker.pos.1");
 	u_var_add_sink(&t, &t.debug.sink, "Debug");
+	t.view_worker.add_vars(&t);
 
 	*out_sink = &t.sink;
 	*out_xth = &t.base;
@@ -15,6 +15,7 @@
 #include "tracking/t_calibration_opencv.hpp"
 #include "tracking/t_tracker_psmv_fusion.hpp"
 #include "tracking/t_helper_debug_sink.hpp"
+#include "tracking/t_helper_view_worker.hpp"
 
 #include "util/u_var.h"
 #include "util/u_misc.h"
@@ -38,8 +39,8 @@
  */
 struct View
 {
-	cv::Mat undistort_rectify_map_x;
-	cv::Mat undistort_rectify_map_y;
+	//! Rounded to whole pixels, for cv::INTER_NEAREST.
+	cv::Mat undistort_rectify_map;
 
 	cv::Matx33d intrinsics;
 	cv::Mat distortion; // size may vary
@@ -50,8 +51,25 @@ struct View
 
 	cv::Mat frame_undist_rectified;
 
+	//! The view expanded from a packed bitmap frame.
+	cv::Mat frame_unpacked;
+
+	//! Part of frame_undist_rectified searched last, the rest is black.
+	cv::Rect roi;
+
+	//! Copy of the calibration, for undistorting keypoints.
+	t_camera_calibration calib;
+	cv::Mat rectify_rotation;
+	cv::Mat rectify_projection;
+
+	//! Thresholded part of the raw view, when only undistorting keypoints.
+	cv::Mat frame_thresholded;
+
+	//! One per view so that the views can be processed in parallel.
+	cv::Ptr<cv::SimpleBlobDetector> sbd;
+
 	void
-	populate_from_calib(t_camera_calibration &calib, const RemapPair &rectification)
+	populate_from_calib(t_camera_calibration &calib, const ViewRectification &rectification)
 	{
 		CameraCalibrationWrapper wrap(calib);
 		intrinsics = wrap.intrinsics_mat;
@@ -59,8 +77,11 @@ struct View
 		distortion_fisheye = wrap.distortion_fisheye_mat;
 		use_fisheye = wrap.use_fisheye;
 
-		undistort_rectify_map_x = rectification.remap_x;
-		undistort_rectify_map_y = rectification.remap_y;
+		undistort_rectify_map = calibration_get_nearest_map(rectification.rectify);
+
+		this->calib = calib;
+		rectify_rotation = rectification.rotation_mat.clone();
+		rectify_projection = rectification.projection_mat.clone();
 	}
 };
 
@@ -87,6 +108,9 @@ struct TrackerPSMV
 
 	HelperDebugSink debug = {HelperDebugSink::AllAvailable};
 
+	//! Processes the two views at the same time.
+	HelperViewWorker view_worker;
+
 	//! Have we received a new IMU sample.
 	bool has_imu = false;
 
@@ -101,49 +125,125 @@ struct TrackerPSMV
 	bool calibrated;
 
 	cv::Mat disparity_to_depth;
+
+	//! Inverse of disparity_to_depth, projects positions into the views.
+	cv::Matx44d depth_to_disparity;
+
 	cv::Vec3d r_cam_translation;
 	cv::Matx33d r_cam_rotation;
 
-	cv::Ptr<cv::SimpleBlobDetector> sbd;
-
 	std::unique_ptr<xrt_fusion::PSMVFusionInterface> filter;
 
 	xrt_vec3 tracked_object_position;
+
+	//! Only search the views around the predicted ball position.
+	struct
+	{
+		bool enabled = true;
+
+		//! Pixels added on each side of the predicted ball.
+		int32_t padding = 32;
+
+		//! Fraction of the two views that was processed for the last frame.
+		float fraction = 1.0f;
+	} roi;
+
+	/*!
+	 * Detect blobs on the raw views and only undistort and rectify the
+	 * keypoints, instead of remapping the views before detection.
+	 */
+	bool sparse_undistort = false;
 };
 
 
+/*!
+ * Get a one byte per pixel image of the view starting at column @p x, packed
+ * bitmap frames from the HSV filter are expanded into the view's own buffer.
+ * Only the part of the view that is read to search @p roi of the rectified
+ * view is expanded, the rest of the buffer is left as it was.
+ */
+static cv::Mat
+get_view_grey(View &view, struct xrt_frame *xf, int x, int cols, const cv::Rect &roi)
+{
+	int rows = xf->height;
+
+	if (xf->format != XRT_FORMAT_BITMAP_8X1) {
+		return cv::Mat(rows, cols, CV_8UC1, xf->data + x, xf->stride);
+	}
+
+	view.frame_unpacked.create(rows, cols, CV_8UC1);
+
+	// Searching the full view reads the full view.
+	cv::Rect raw(cv::Point(0, 0), view.frame_unpacked.size());
+	if (roi.size() != view.undistort_rectify_map.size()) {
+		raw = calibration_get_nearest_map_source(view.undistort_rectify_map, roi, raw.size());
+	}
+
+	if (!raw.empty()) {
+		t_hsv_filter_unpack_bitmap(xf,                            // xf
+		                           x + raw.x,                     // x
+		                           raw.y,                         // y
+		                           raw.width,                     // width
+		                           raw.height,                    // height
+		                           view.frame_unpacked(raw).data, // dst
+		                           view.frame_unpacked.step);     // dst_stride
+	}
+
+	return view.frame_unpacked;
+}
+
 /*!
  * @brief Perform per-view (two in a stereo camera image) processing on an
  * image, before tracking math is performed.
  *
- * Right now, this is mainly finding blobs/keypoints.
+ * Right now, this is mainly finding blobs/keypoints. Only the part @p roi of
+ * the rectified image is searched, keypoints are still in full image space.
  */
 static void
-do_view(TrackerPSMV &t, View &view, cv::Mat &grey, cv::Mat &rgb)
+do_view(TrackerPSMV &t, View &view, cv::Mat &grey, cv::Mat &rgb, const cv::Rect &roi)
 {
-	// Undistort and rectify the whole image.
-	cv::remap(grey,                         // src
-	          view.frame_undist_rectified,  // dst
-	          view.undistort_rectify_map_x, // map1
-	          view.undistort_rectify_map_y, // map2
-	          cv::INTER_NEAREST,            // interpolation
-	          cv::BORDER_CONSTANT,          // borderMode
-	          cv::Scalar(0, 0, 0));         // borderValue
-
-	cv::threshold(view.frame_undist_rectified, // src
-	              view.frame_undist_rectified, // dst
-	              32.0,                        // thresh
-	              255.0,                       // maxval
-	              0);                          // type
+	cv::Size size = view.undistort_rectify_map.size();
+	if (view.frame_undist_rectified.size() != size) {
+		view.frame_undist_rectified = cv::Mat::zeros(size, CV_8UC1);
+		view.roi = cv::Rect();
+	}
+
+	// Clear what the last search left outside of this one.
+	if ((view.roi & roi) != view.roi) {
+		view.frame_undist_rectified(view.roi).setTo(0);
+	}
+	view.roi = roi;
+
+	cv::Mat rectified = view.frame_undist_rectified(roi);
+
+	// Undistort and rectify the searched part of the image.
+	cv::remap(grey,                            // src
+	          rectified,                       // dst
+	          view.undistort_rectify_map(roi), // map1
+	          cv::noArray(),                   // map2
+	          cv::INTER_NEAREST,               // interpolation
+	          cv::BORDER_CONSTANT,             // borderMode
+	          cv::Scalar(0, 0, 0));            // borderValue
+
+	cv::threshold(rectified, // src
+	              rectified, // dst
+	              32.0,      // thresh
+	              255.0,     // maxval
+	              0);        // type
 
 	// tracker_measurement_t m = {};
 
 	// Do blob detection with our masks.
 	//! @todo Re-enable masks.
-	t.sbd->detect(view.frame_undist_rectified, // image
-	              view.keypoints,              // keypoints
-	              cv::noArray());              // mask
-
+	view.sbd->detect(rectified,      // image
+	                 view.keypoints, // keypoints
+	                 cv::noArray()); // mask
+
+	// Move the keypoints back into full image space.
+	for (cv::KeyPoint &kp : view.keypoints) {
+		kp.pt.x += roi.x;
+		kp.pt.y += roi.y;
+	}
 
 	// Debug is wanted, draw the keypoints.
 	if (rgb.cols > 0) {
@@ -155,6 +255,129 @@ do_view(TrackerPSMV &t, View &view, cv::Mat &grey, cv::Mat &rgb)
 	}
 }
 
+/*!
+ * Get the part of the raw view that ends up in @p roi of the rectified view,
+ * the bounding box of the remap coordinates clamped to the view.
+ */
+static cv::Rect
+get_raw_roi(View &view, const cv::Mat &grey, const cv::Rect &roi)
+{
+	cv::Rect full(cv::Point(0, 0), grey.size());
+	if (roi.size() == view.undistort_rectify_map.size()) {
+		return full;
+	}
+
+	return calibration_get_nearest_map_source(view.undistort_rectify_map, roi, grey.size());
+}
+
+/*!
+ * @brief Same as @ref do_view but finds the blobs on the raw view and then
+ * only undistorts and rectifies the keypoints, the debug image shows the raw
+ * view. Keypoints are in full rectified image space.
+ */
+static void
+do_view_sparse(TrackerPSMV &t, View &view, cv::Mat &grey, cv::Mat &rgb, const cv::Rect &roi)
+{
+	cv::Rect raw_roi = get_raw_roi(view, grey, roi);
+	if (raw_roi.empty()) {
+		view.keypoints.clear();
+		return;
+	}
+
+	cv::threshold(grey(raw_roi),          // src
+	              view.frame_thresholded, // dst
+	              32.0,                   // thresh
+	              255.0,                  // maxval
+	              0);                     // type
+
+	view.sbd->detect(view.frame_thresholded, // image
+	                 view.keypoints,         // keypoints
+	                 cv::noArray());         // mask
+
+	// Debug is wanted, draw the keypoints on the raw view.
+	if (rgb.cols > 0) {
+		rgb.setTo(cv::Scalar(0, 0, 0));
+		cv::Mat rgb_roi = rgb(raw_roi);
+		cv::drawKeypoints(view.frame_thresholded,                     // image
+		                  view.keypoints,                             // keypoints
+		                  rgb_roi,                                    // outImage
+		                  cv::Scalar(255, 0, 0),                      // color
+		                  cv::DrawMatchesFlags::DRAW_RICH_KEYPOINTS); // flags
+	}
+
+	if (view.keypoints.empty()) {
+		return;
+	}
+
+	std::vector<cv::Point2f> points;
+	std::vector<cv::Point2f> undistorted;
+	points.reserve(view.keypoints.size());
+	for (const cv::KeyPoint &kp : view.keypoints) {
+		points.emplace_back(kp.pt.x + raw_roi.x, kp.pt.y + raw_roi.y);
+	}
+
+	calibration_undistort_points(view.calib,               // calib
+	                             points,                   // points
+	                             undistorted,              // out_points
+	                             view.rectify_rotation,    // rectify_transform_optional
+	                             view.rectify_projection); // new_camera_matrix_optional
+
+	for (size_t i = 0; i < view.keypoints.size(); i++) {
+		view.keypoints[i].pt = undistorted[i];
+	}
+}
+
+/*!
+ * @brief Work out where to search for the ball in each view, projects the
+ * position predicted by the fusion into both rectified views. Returns false
+ * when the ball is not tracked, or the projection is not usable, in which
+ * case the full views should be searched.
+ */
+static bool
+predict_rois(TrackerPSMV &t, struct xrt_frame *xf, cv::Rect &out_l_roi, cv::Rect &out_r_roi)
+{
+	if (!t.roi.enabled) {
+		return false;
+	}
+
+	struct xrt_space_relation rel = {};
+
+	os_thread_helper_lock(&t.oth);
+	t.filter->get_prediction(xf->timestamp, &rel);
+	os_thread_helper_unlock(&t.oth);
+
+	if ((rel.relation_flags & XRT_SPACE_RELATION_POSITION_TRACKED_BIT) == 0) {
+		return false;
+	}
+
+	// The fused pose is the body origin, the ball is on the lever arm.
+	xrt_vec3 pos = {};
+	xrt_fusion::psmv_fusion_ball_position(&rel.pose, &pos);
+
+	// Inverse of world_point_from_blobs, x is inverted there.
+	cv::Vec4d xydw = t.depth_to_disparity * cv::Vec4d(-pos.x, pos.y, pos.z, 1.0);
+	if (std::abs(xydw[3]) < 1e-9 || std::abs(pos.z) < 1e-3f) {
+		return false;
+	}
+
+	double x = xydw[0] / xydw[3];
+	double y = xydw[1] / xydw[3];
+	double disp = xydw[2] / xydw[3];
+
+	// The ball is 45mm across, disparity_to_depth(2, 3) is the focal length.
+	double focal = static_cast<cv::Matx44d>(t.disparity_to_depth)(2, 3);
+	double radius = std::abs(focal * 0.0225 / pos.z);
+	int half = (int)std::ceil(radius * 2.0) + t.roi.padding;
+
+	cv::Rect l_full(cv::Point(0, 0), t.view[0].undistort_rectify_map.size());
+	cv::Rect r_full(cv::Point(0, 0), t.view[1].undistort_rectify_map.size());
+
+	out_l_roi = cv::Rect((int)x - half, (int)y - half, half * 2, half * 2) & l_full;
+	out_r_roi = cv::Rect((int)(x + disp) - half, (int)y - half, half * 2, half * 2) & r_full;
+
+	return out_l_roi.area() > 0 && out_r_roi.area() > 0;
+}
+
 /*!
  * @brief Helper struct that keeps the value that produces the lowest "score" as
  * computed by your functor.
@@ -228,12 +451,13 @@ process(TrackerPSMV &t, struct xrt_frame *xf)
 	}
 
 	// Wrong type of frame: unreference and return?
-	if (xf->format != XRT_FORMAT_L8) {
+	if (xf->format != XRT_FORMAT_L8 && xf->format != XRT_FORMAT_BITMAP_8X1) {
 		xrt_frame_reference(&xf, NULL);
 		return;
 	}
 
 	if (!t.calibrated) {
+		xrt_frame_reference(&xf, NULL);
 		return;
 	}
 
@@ -244,14 +468,31 @@ process(TrackerPSMV &t, struct xrt_frame *xf)
 	t.view[1].keypoints.clear();
 
 	int cols = xf->width / 2;
-	int rows = xf->height;
-	int stride = xf->stride;
 
-	cv::Mat l_grey(rows, cols, CV_8UC1, xf->data, stride);
-	cv::Mat r_grey(rows, cols, CV_8UC1, xf->data + cols, stride);
+	cv::Rect full[2] = {
+	    cv::Rect(cv::Point(0, 0), t.view[0].undistort_rectify_map.size()),
+	    cv::Rect(cv::Point(0, 0), t.view[1].undistort_rectify_map.size()),
+	};
+	cv::Rect roi[2] = {full[0], full[1]};
+	bool use_roi = predict_rois(t, xf, roi[0], roi[1]);
+	auto do_view_func = t.sparse_undistort ? do_view_sparse : do_view;
+
+	// The views are independent until the matching, one on each thread.
+	std::function<void(int)> view_job = [&](int i) {
+		cv::Mat grey = get_view_grey(t.view[i], xf, i * cols, cols, roi[i]);
+		do_view_func(t, t.view[i], grey, t.debug.rgb[i], roi[i]);
+	};
+
+	t.view_worker.run(view_job);
+
+	// Lost the ball in the window, fall back to searching everything.
+	if (use_roi && (t.view[0].keypoints.empty() || t.view[1].keypoints.empty())) {
+		roi[0] = full[0];
+		roi[1] = full[1];
+		t.view_worker.run(view_job);
+	}
 
-	do_view(t, t.view[0], l_grey, t.debug.rgb[0]);
-	do_view(t, t.view[1], r_grey, t.debug.rgb[1]);
+	t.roi.fraction = (float)(roi[0].area() + roi[1].area()) / (float)(full[0].area() + full[1].area());
 
 	cv::Point3f last_point(t.tracked_object_position.x, t.tracked_object_position.y, t.tracked_object_position.z);
 	auto nearest_world = make_lowest_score_finder<cv::Point3f>([&](cv::Point3f world_point) {
@@ -294,9 +535,6 @@ process(TrackerPSMV &t, struct xrt_frame *xf)
 	// We are done with the debug frame.
 	t.debug.submit();
 
-	// We are done with the frame.
-	xrt_frame_reference(&xf, NULL);
-
 	if (nearest_world.got_one) {
 #if 0
 		//! @todo something less arbitrary for the lever arm?
@@ -318,6 +556,9 @@ process(TrackerPSMV &t, struct xrt_frame *xf)
 	} else {
 		t.filter->clear_position_tracked_flag();
 	}
+
+	// We are done with the frame, only now that the filter has it.
+	xrt_frame_reference(&xf, NULL);
 }
 
 /*!
@@ -407,6 +648,21 @@ imu_data(TrackerPSMV &t, timepoint_ns timestamp_ns, struct xrt_tracking_sample *
 	os_thread_helper_unlock(&t.oth);
 }
 
+static void
+imu_data_batch(TrackerPSMV &t, const struct xrt_tracking_timed_sample *samples, uint32_t count)
+{
+	os_thread_helper_lock(&t.oth);
+
+	// Don't do anything if we have stopped.
+	if (!os_thread_helper_is_running_locked(&t.oth)) {
+		os_thread_helper_unlock(&t.oth);
+		return;
+	}
+	t.filter->process_imu_batch(samples, count, NULL);
+
+	os_thread_helper_unlock(&t.oth);
+}
+
 static void
 frame(TrackerPSMV &t, struct xrt_frame *xf)
 {
@@ -429,6 +685,9 @@ static void
 break_apart(TrackerPSMV &t)
 {
 	os_thread_helper_stop(&t.oth);
+
+	// Only safe once the tracker thread is no longer processing frames.
+	t.view_worker.stop();
 }
 
 
@@ -445,6 +704,13 @@ t_psmv_push_imu(struct xrt_tracked_psmv *xtmv, timepoint_ns timestamp_ns, struct
 	imu_data(t, timestamp_ns, sample);
 }
 
+extern "C" void
+t_psmv_push_imu_batch(struct xrt_tracked_psmv *xtmv, const struct xrt_tracking_timed_sample *samples, uint32_t count)
+{
+	auto &t = *container_of(xtmv, TrackerPSMV, base);
+	imu_data_batch(t, samples, count);
+}
+
 extern "C" void
 t_psmv_get_tracked_pose(struct xrt_tracked_psmv *xtmv,
                         enum xrt_input_name name,
@@ -508,6 +774,12 @@ extern "C" int
 t_psmv_start(struct xrt_tracked_psmv *xtmv)
 {
 	auto &t = *container_of(xtmv, TrackerPSMV, base);
+
+	// Without the worker the views are processed in sequence.
+	if (t.view_worker.start() != 0) {
+		U_LOG_W("Failed to start view worker thread!");
+	}
+
 	return os_thread_helper_start(&t.oth, t_psmv_run, &t);
 }
 
@@ -525,6 +797,7 @@ t_psmv_create(struct xrt_frame_context *xfctx,
 
 	t.base.get_tracked_pose = t_psmv_get_tracked_pose;
 	t.base.push_imu = t_psmv_push_imu;
+	t.base.push_imu_batch = t_psmv_push_imu_batch;
 	t.base.destroy = t_psmv_fake_destroy;
 	t.base.colour = *rgb;
 	t.sink.push_frame = t_psmv_sink_push_frame;
@@ -562,9 +835,10 @@ t_psmv_create(struct xrt_frame_context *xfctx,
 	}
 
 	StereoRectificationMaps rectify(data);
-	t.view[0].populate_from_calib(data->view[0], rectify.view[0].rectify);
-	t.view[1].populate_from_calib(data->view[1], rectify.view[1].rectify);
+	t.view[0].populate_from_calib(data->view[0], rectify.view[0]);
+	t.view[1].populate_from_calib(data->view[1], rectify.view[1]);
 	t.disparity_to_depth = rectify.disparity_to_depth_mat;
+	t.depth_to_disparity = static_cast<cv::Matx44d>(t.disparity_to_depth).inv();
 	StereoCameraCalibrationWrapper wrapped(data);
 	t.r_cam_rotation = wrapped.camera_rotation_mat;
 	t.r_cam_translation = wrapped.camera_translation_mat;
@@ -587,12 +861,18 @@ t_psmv_create(struct xrt_frame_context *xfctx,
 	blob_params.minRepeatability = 1; // need this to avoid error?
 	// clang-format on
 
-	t.sbd = cv::SimpleBlobDetector::create(blob_params);
+	t.view[0].sbd = cv::SimpleBlobDetector::create(blob_params);
+	t.view[1].sbd = cv::SimpleBlobDetector::create(blob_params);
 	xrt_frame_context_add(xfctx, &t.node);
 
 	// Everything is safe, now setup the variable tracking.
 	u_var_add_root(&t, "PSMV Tracker", true);
 	u_var_add_vec3_f32(&t, &t.tracked_object_position, "last.ball.pos");
+	u_var_add_bool(&t, &t.roi.enabled, "ROI search");
+	u_var_add_i32(&t, &t.roi.padding, "ROI padding (px)");
+	u_var_add_ro_f32(&t, &t.roi.fraction, "ROI fraction processed");
+	u_var_add_bool(&t, &t.sparse_undistort, "Undistort keypoints only");
+	t.view_worker.add_vars(&t);
 	u_var_add_sink(&t, &t.debug.sink, "Debug");
 
 	*out_sink = &t.sink;
@@ -33,6 +33,12 @@ using ProcessModel = flexkalman::PoseSeparatelyDampedConstantVelocityProcessMode
 
 namespace xrt_fusion {
 
+/*!
+ * From the tracked body origin, approximately under the PS button, to the
+ * centre of the ball.
+ */
+static const Eigen::Vector3d default_lever_arm{0, 0.09, 0};
+
 struct TrackingInfo
 {
 	bool valid{false};
@@ -52,6 +58,10 @@ namespace {
 		                 const struct xrt_tracking_sample *sample,
 		                 const struct xrt_vec3 *orientation_variance_optional) override;
 		void
+		process_imu_batch(const struct xrt_tracking_timed_sample *samples,
+		                  size_t count,
+		                  const struct xrt_vec3 *orientation_variance_optional) override;
+		void
 		process_3d_vision_data(timepoint_ns timestamp_ns,
 		                       const struct xrt_vec3 *position,
 		                       const struct xrt_vec3 *variance_optional,
@@ -66,6 +76,10 @@ namespace {
 		reset_filter();
 		void
 		reset_filter_and_imu();
+		void
+		process_imu_sample(timepoint_ns timestamp_ns,
+		                   const struct xrt_tracking_sample *sample,
+		                   const Eigen::Vector3d &variance);
 
 		State filter_state;
 		ProcessModel process_model;
@@ -106,11 +120,32 @@ namespace {
 	                             const struct xrt_tracking_sample *sample,
 	                             const struct xrt_vec3 *orientation_variance_optional)
 	{
+		Eigen::Vector3d variance = Eigen::Vector3d::Constant(0.01);
+		if (orientation_variance_optional) {
+			variance = map_vec3(*orientation_variance_optional).cast<double>();
+		}
+		process_imu_sample(timestamp_ns, sample, variance);
+	}
 
+	void
+	PSMVFusion::process_imu_batch(const struct xrt_tracking_timed_sample *samples,
+	                              size_t count,
+	                              const struct xrt_vec3 *orientation_variance_optional)
+	{
 		Eigen::Vector3d variance = Eigen::Vector3d::Constant(0.01);
 		if (orientation_variance_optional) {
 			variance = map_vec3(*orientation_variance_optional).cast<double>();
 		}
+		for (size_t i = 0; i < count; i++) {
+			process_imu_sample(samples[i].timestamp_ns, &samples[i].sample, variance);
+		}
+	}
+
+	void
+	PSMVFusion::process_imu_sample(timepoint_ns timestamp_ns,
+	                               const struct xrt_tracking_sample *sample,
+	                               const Eigen::Vector3d &variance)
+	{
 		imu.handleAccel(map_vec3(sample->accel_m_s2).cast<double>(), timestamp_ns);
 		imu.handleGyro(map_vec3(sample->gyro_rad_secs).cast<double>(), timestamp_ns);
 		imu.postCorrect();
@@ -158,7 +193,7 @@ namespace {
 		if (variance_optional) {
 			variance = map_vec3(*variance_optional).cast<double>();
 		}
-		Eigen::Vector3d lever_arm{0, 0.09, 0};
+		Eigen::Vector3d lever_arm = default_lever_arm;
 		if (lever_arm_optional) {
 			lever_arm = map_vec3(*lever_arm_optional).cast<double>();
 		}
@@ -233,4 +268,13 @@ PSMVFusionInterface::create()
 	auto ret = std::make_unique<PSMVFusion>();
 	return ret;
 }
+
+void
+psmv_fusion_ball_position(const struct xrt_pose *pose, struct xrt_vec3 *out_position)
+{
+	Eigen::Quaterniond orientation = map_quat(pose->orientation).cast<double>();
+	Eigen::Vector3d position = map_vec3(pose->position).cast<double>();
+
+	map_vec3(*out_position) = (position + orientation * default_lever_arm).cast<float>();
+}
 } // namespace xrt_fusion
@@ -42,6 +42,15 @@ public:
 	process_imu_data(timepoint_ns timestamp_ns,
 	                 const struct xrt_tracking_sample *sample,
 	                 const struct xrt_vec3 *orientation_variance_optional) = 0;
+
+	/*!
+	 * Same as @ref process_imu_data for several samples in timestamp
+	 * order, the variance applies to all of them.
+	 */
+	virtual void
+	process_imu_batch(const struct xrt_tracking_timed_sample *samples,
+	                  size_t count,
+	                  const struct xrt_vec3 *orientation_variance_optional) = 0;
 	virtual void
 	process_3d_vision_data(timepoint_ns timestamp_ns,
 	                       const struct xrt_vec3 *position,
@@ -52,4 +61,13 @@ public:
 	virtual void
 	get_prediction(timepoint_ns when_ns, struct xrt_space_relation *out_relation) = 0;
 };
+
+/*!
+ * @brief Where the ball is for a pose from
+ * @ref PSMVFusionInterface::get_prediction, the fused pose is the body origin
+ * and the ball sits on the default lever arm of
+ * @ref PSMVFusionInterface::process_3d_vision_data, rotated with the body.
+ */
+void
+psmv_fusion_ball_position(const struct xrt_pose *pose, struct xrt_vec3 *out_position);
 } // namespace xrt_fusion
@@ -13,6 +13,7 @@
 #include "tracking/t_tracking.h"
 #include "tracking/t_calibration_opencv.hpp"
 #include "tracking/t_helper_debug_sink.hpp"
+#include "tracking/t_helper_view_worker.hpp"
 
 #include "util/u_misc.h"
 #include "util/u_debug.h"
@@ -34,6 +35,8 @@
 #include <Eigen/Eigen>
 #include <opencv2/opencv.hpp>
 #include <inttypes.h>
+#include <map>
+#include <algorithm>
 
 
 DEBUG_GET_ONCE_LOG_OPTION(psvr_log, "PSVR_TRACKING_LOG", U_LOGGING_WARN)
@@ -125,8 +128,8 @@ typedef struct blob_point
 
 struct View
 {
-	cv::Mat undistort_rectify_map_x;
-	cv::Mat undistort_rectify_map_y;
+	//! Rounded to whole pixels, for cv::INTER_NEAREST.
+	cv::Mat undistort_rectify_map;
 
 	cv::Matx33d intrinsics;
 	cv::Mat distortion; // size may vary
@@ -137,6 +140,15 @@ struct View
 
 	cv::Mat frame_undist_rectified;
 
+	//! The view expanded from a packed bitmap frame.
+	cv::Mat frame_unpacked;
+
+	//! Part of frame_undist_rectified searched last, the rest is black.
+	cv::Rect roi;
+
+	//! One per view so that the views can be processed in parallel.
+	cv::Ptr<cv::SimpleBlobDetector> sbd;
+
 	void
 	populate_from_calib(t_camera_calibration &calib, const RemapPair &rectification)
 	{
@@ -146,8 +158,7 @@ struct View
 		distortion_fisheye = wrap.distortion_fisheye_mat;
 		use_fisheye = wrap.use_fisheye;
 
-		undistort_rectify_map_x = rectification.remap_x;
-		undistort_rectify_map_y = rectification.remap_y;
+		undistort_rectify_map = calibration_get_nearest_map(rectification);
 	}
 };
 
@@ -201,6 +212,23 @@ typedef struct match_model
 	std::vector<match_data_t> measurements;
 } match_model_t;
 
+/*!
+ * The match models that can give different errors for one number of measured
+ * points. Only the first that many vertices of a model are compared, so models
+ * that share them are duplicates and only one of them is kept.
+ */
+typedef struct match_index
+{
+	//! Indices into TrackerPSVR::matches, sorted by key.
+	std::vector<uint32_t> models;
+
+	//! Distance of the first non-reference vertex of each model, ascending.
+	std::vector<float> keys;
+
+	//! Position in models for every match model, duplicates share one.
+	std::vector<uint32_t> slot_of_match;
+} match_index_t;
+
 /*!
  * Main PSVR tracking class.
  */
@@ -262,14 +290,45 @@ public:
 
 	HelperDebugSink debug = {HelperDebugSink::AllAvailable};
 
+	//! Processes the two views at the same time.
+	HelperViewWorker view_worker;
+
 	cv::Mat disparity_to_depth;
+
+	//! Inverse of disparity_to_depth, projects positions into the views.
+	cv::Matx44d depth_to_disparity;
+
 	cv::Vec3d r_cam_translation;
 	cv::Matx33d r_cam_rotation;
 
-	cv::Ptr<cv::SimpleBlobDetector> sbd;
+	//! Only search the views around the predicted LED positions.
+	struct
+	{
+		bool enabled = true;
+
+		//! Pixels added on each side of the predicted LEDs.
+		int32_t padding = 48;
+
+		//! Fraction of the two views that was processed for the last frame.
+		float fraction = 1.0f;
+	} roi;
+
 	std::vector<cv::KeyPoint> l_blobs, r_blobs;
 	std::vector<match_model_t> matches;
 
+	//! Unique match models, indexed by the number of measured points.
+	match_index_t match_index[PSVR_NUM_LEDS + 1];
+
+	//! Statistics of the last optical disambiguation.
+	struct
+	{
+		//! Match models that were looked at.
+		uint32_t candidates;
+
+		//! Candidates that were solved, the rest were pruned on error.
+		uint32_t solved;
+	} disambig;
+
 	// we refine our measurement by rejecting outliers and merging 'too
 	// close' points
 	std::vector<blob_point_t> world_points;
@@ -903,17 +962,26 @@ disambiguate(TrackerPSVR &t,
 
 	// optical matching.
 
+	uint32_t num_points = measured_points->size();
+	if (num_points > PSVR_NUM_LEDS) {
+		PSVR_DEBUG("Too many points to match %u", num_points);
+		return imu_solved_pose;
+	}
+
 	float lowest_error = 65535.0f;
 	int32_t best_model = -1;
 	uint32_t matched_vertex_indices[PSVR_NUM_LEDS];
 
+	t.disambig.candidates = 0;
+	t.disambig.solved = 0;
+
 	// we can early-out if we are 'close enough' to our last match model.
 	// if we just hold the previous led configuration, this increases
 	// performance and should cut down on jitter.
 	if (t.last_optical_model > 0 && t.done_correction) {
 
-		match_model_t m = t.matches[t.last_optical_model];
-		for (uint32_t i = 0; i < measured_points->size(); i++) {
+		const match_model_t &m = t.matches[t.last_optical_model];
+		for (uint32_t i = 0; i < num_points; i++) {
 			measured_points->at(i).vertex_index = m.measurements.at(i).vertex_index;
 		}
 		Eigen::Matrix4f res = solve_for_measurement(&t, measured_points, solved);
@@ -925,13 +993,11 @@ disambiguate(TrackerPSVR &t,
 		}
 	}
 
-
-
-	for (uint32_t i = 0; i < t.matches.size(); i++) {
-		match_model_t m = t.matches[i];
+	auto evaluate = [&](uint32_t model) {
+		const match_model_t &m = t.matches[model];
 		float error_sum = 0.0f;
-		float sign_diff = 0.0f;
-		(void)sign_diff;
+
+		t.disambig.candidates++;
 
 		// we have 2 measurements per vertex (distance and
 		// angle) and we are comparing only the 'non-basis
@@ -940,7 +1006,7 @@ disambiguate(TrackerPSVR &t,
 		// fill in our 'proposed' vertex indices from the model
 		// data (this will be overwritten once our best model is
 		// selected
-		for (uint32_t j = 0; j < measured_points->size(); j++) {
+		for (uint32_t j = 0; j < num_points; j++) {
 			measured_points->at(j).vertex_index = m.measurements.at(j).vertex_index;
 		}
 
@@ -951,7 +1017,7 @@ disambiguate(TrackerPSVR &t,
 
 		//@todo: use tags instead  of numeric vertex indices
 
-		for (uint32_t j = 0; j < measured_points->size(); j++) {
+		for (uint32_t j = 0; j < num_points; j++) {
 
 			if (measured_points->at(j).src_blob.btype == BLOB_TYPE_FRONT &&
 			    measured_points->at(j).vertex_index > 4) {
@@ -970,7 +1036,7 @@ disambiguate(TrackerPSVR &t,
 			if (dist > PSVR_DISAMBIG_REJECT_DIST) {
 				error_sum += 50.0f;
 			} else {
-				error_sum += fabs(measured_points->at(j).distance - m.measurements.at(j).distance);
+				error_sum += dist;
 			}
 
 			// if the angle is significantly different,
@@ -979,85 +1045,82 @@ disambiguate(TrackerPSVR &t,
 			if (angdiff > PSVR_DISAMBIG_REJECT_ANG) {
 				error_sum += 50.0f;
 			} else {
+				error_sum += angdiff;
+			}
 
-				error_sum += fabs(measured_points->at(j).angle - m.measurements.at(j).angle);
+			// the error only grows from here, stop as soon
+			// as this can no longer beat the best match.
+			if (error_sum / num_points > lowest_error) {
+				return;
 			}
 		}
 
-		float avg_error = (error_sum / measured_points->size());
+		float avg_error = (error_sum / num_points);
 		if (error_sum < 50) {
 			std::vector<match_data_t> meas_solved;
 			solve_for_measurement(&t, measured_points, &meas_solved);
-			float prev_diff = last_diff(t, &meas_solved, &t.last_vertices);
-			float imu_diff = last_diff(t, &meas_solved, solved);
-
-			Eigen::Vector4f tl_pos, tr_pos, bl_pos, br_pos;
-			bool has_bl = false;
-			bool has_br = false;
-			bool has_tl = false;
-			bool has_tr = false;
-
-			for (uint32_t j = 0; j < meas_solved.size(); j++) {
-				match_data_t *md = &meas_solved.at(j);
-				if (md->vertex_index == TAG_BL) {
-					bl_pos = md->position;
-					has_bl = true;
-				}
-				if (md->vertex_index == TAG_BR) {
-					br_pos = md->position;
-					has_br = true;
-				}
-				if (md->vertex_index == TAG_TL) {
-					tl_pos = md->position;
-					has_tl = true;
-				}
-				if (md->vertex_index == TAG_TR) {
-					tr_pos = md->position;
-					has_tr = true;
-				}
-			}
-
-			// reject any configuration where 'top' is below
-			// 'bottom
-
-			if (has_bl && has_tl && bl_pos.y() > tl_pos.y()) {
-				// U_LOG_D("IGNORING BL > TL %f %f",
-				// bl_pos.y(),
-				//      br_pos.y());
-				// ignore = true;
-			}
-			if (has_br && has_tr && br_pos.y() > tr_pos.y()) {
-				// U_LOG_D("IGNORING TL > TR %f %f",
-				// tl_pos.y(),
-				//       tr_pos.y());
-				// ignore = true;
-			}
+			t.disambig.solved++;
 
 			// once we have a lock, bias the detected
 			// configuration using the imu-solved result,
 			// and the solve from the previous frame
 
 			if (t.done_correction) {
+				float prev_diff = last_diff(t, &meas_solved, &t.last_vertices);
+				float imu_diff = last_diff(t, &meas_solved, solved);
 				avg_error += prev_diff;
 				avg_error += imu_diff;
 			}
 
 			// useful for debugging
 			// U_LOG_D(
-			//    "match %d dist to last: %f dist to imu: %f "
-			//    "rmsError: %f squaredSum:%f %d",
-			//    i, prev_diff, imu_diff, avg_error, error_sum,
-			//    ignore);
+			//    "match %d rmsError: %f squaredSum:%f %d",
+			//    model, avg_error, error_sum, ignore);
 		}
 		if (avg_error <= lowest_error && !ignore) {
 			lowest_error = avg_error;
-			best_model = i;
-			for (uint32_t i = 0; i < measured_points->size(); i++) {
+			best_model = model;
+			for (uint32_t i = 0; i < num_points; i++) {
 				matched_vertex_indices[i] = measured_points->at(i).vertex_index;
 			}
 		}
+	};
+
+	const match_index_t &index = t.match_index[num_points];
+	uint32_t num_models = index.models.size();
+
+	// start from the last best model, the pose rarely changes much
+	// between frames so this gives a tight bound for the search.
+	uint32_t skip = num_models;
+	if (t.last_optical_model < index.slot_of_match.size()) {
+		skip = index.slot_of_match[t.last_optical_model];
+		evaluate(index.models[skip]);
 	}
 
+	// then walk outwards from the models with the closest geometry,
+	// once the distance alone gets rejected all of the remaining models
+	// would be too, so stop if that can't beat the best match.
+	float key = num_points > 2 ? measured_points->at(2).distance : 0.0f;
+	uint32_t hi = std::lower_bound(index.keys.begin(), index.keys.end(), key) - index.keys.begin();
+	uint32_t lo = hi;
+	while (lo > 0 || hi < num_models) {
+		float lo_dist = lo > 0 ? key - index.keys[lo - 1] : INFINITY;
+		float hi_dist = hi < num_models ? index.keys[hi] - key : INFINITY;
+		bool take_lo = lo_dist < hi_dist;
+		float dist = take_lo ? lo_dist : hi_dist;
+		uint32_t slot = take_lo ? --lo : hi++;
+
+		if (dist > PSVR_DISAMBIG_REJECT_DIST && 50.0f / num_points > lowest_error) {
+			break;
+		}
+		if (slot != skip) {
+			evaluate(index.models[slot]);
+		}
+	}
+
+	PSVR_TRACE("Evaluated %u of %u match models, solved %u", t.disambig.candidates, num_models,
+	           t.disambig.solved);
+
 	// U_LOG_D("lowest_error %f", lowest_error);
 	if (best_model == -1) {
 		PSVR_INFO("COULD NOT MATCH MODEL!");
@@ -1218,26 +1281,129 @@ create_match_list(TrackerPSVR &t)
 }
 
 static void
-do_view(TrackerPSVR &t, View &view, cv::Mat &grey, cv::Mat &rgb)
+create_match_index(TrackerPSVR &t)
+{
+	// for every number of measured points keep one model for each set
+	// of leading vertices, the last one to match how the full search
+	// picked between equal errors.
+
+	for (uint32_t count = 1; count <= PSVR_NUM_LEDS; count++) {
+		match_index_t &index = t.match_index[count];
+		std::map<uint32_t, uint32_t> by_prefix;
+		std::vector<uint32_t> prefix_of_match(t.matches.size());
+
+		for (uint32_t i = 0; i < t.matches.size(); i++) {
+			uint32_t prefix = 0;
+			for (uint32_t j = 0; j < count; j++) {
+				prefix = prefix * PSVR_NUM_LEDS + t.matches[i].measurements[j].vertex_index;
+			}
+			by_prefix[prefix] = i;
+			prefix_of_match[i] = prefix;
+		}
+
+		// models sorted on the distance of their first non-reference vertex.
+		uint32_t key_slot = count > 2 ? 2 : count - 1;
+		std::vector<std::pair<float, uint32_t>> sorted;
+		for (auto &&entry : by_prefix) {
+			sorted.emplace_back(t.matches[entry.second].measurements[key_slot].distance, entry.second);
+		}
+		std::sort(sorted.begin(), sorted.end());
+
+		std::map<uint32_t, uint32_t> slot_of_prefix;
+		for (uint32_t slot = 0; slot < sorted.size(); slot++) {
+			index.keys.push_back(sorted[slot].first);
+			index.models.push_back(sorted[slot].second);
+			slot_of_prefix[prefix_of_match[sorted[slot].second]] = slot;
+		}
+
+		for (uint32_t i = 0; i < t.matches.size(); i++) {
+			index.slot_of_match.push_back(slot_of_prefix[prefix_of_match[i]]);
+		}
+	}
+}
+
+/*!
+ * Get a one byte per pixel image of the view starting at column @p x, packed
+ * bitmap frames from the HSV filter are expanded into the view's own buffer.
+ * Only the part of the view that is read to search @p roi of the rectified
+ * view is expanded, the rest of the buffer is left as it was.
+ */
+static cv::Mat
+get_view_grey(View &view, struct xrt_frame *xf, int x, int cols, const cv::Rect &roi)
 {
-	// Undistort and rectify the whole image.
-	cv::remap(grey,                         // src
-	          view.frame_undist_rectified,  // dst
-	          view.undistort_rectify_map_x, // map1
-	          view.undistort_rectify_map_y, // map2
-	          cv::INTER_NEAREST,            // interpolation - LINEAR seems
-	                                        // very slow on my setup
-	          cv::BORDER_CONSTANT,          // borderMode
-	          cv::Scalar(0, 0, 0));         // borderValue
-
-	cv::threshold(view.frame_undist_rectified, // src
-	              view.frame_undist_rectified, // dst
-	              32.0,                        // thresh
-	              255.0,                       // maxval
+	int rows = xf->height;
+
+	if (xf->format != XRT_FORMAT_BITMAP_8X1) {
+		return cv::Mat(rows, cols, CV_8UC1, xf->data + x, xf->stride);
+	}
+
+	view.frame_unpacked.create(rows, cols, CV_8UC1);
+
+	// Searching the full view reads the full view.
+	cv::Rect raw(cv::Point(0, 0), view.frame_unpacked.size());
+	if (roi.size() != view.undistort_rectify_map.size()) {
+		raw = calibration_get_nearest_map_source(view.undistort_rectify_map, roi, raw.size());
+	}
+
+	if (!raw.empty()) {
+		t_hsv_filter_unpack_bitmap(xf,                            // xf
+		                           x + raw.x,                     // x
+		                           raw.y,                         // y
+		                           raw.width,                     // width
+		                           raw.height,                    // height
+		                           view.frame_unpacked(raw).data, // dst
+		                           view.frame_unpacked.step);     // dst_stride
+	}
+
+	return view.frame_unpacked;
+}
+
+/*!
+ * Find the blobs in one view, only the part @p roi of the rectified image is
+ * searched, keypoints are still in full image space.
+ */
+static void
+do_view(TrackerPSVR &t, View &view, cv::Mat &grey, cv::Mat &rgb, const cv::Rect &roi)
+{
+	cv::Size size = view.undistort_rectify_map.size();
+	if (view.frame_undist_rectified.size() != size) {
+		view.frame_undist_rectified = cv::Mat::zeros(size, CV_8UC1);
+		view.roi = cv::Rect();
+	}
+
+	// Clear what the last search left outside of this one, the blob shape
+	// sampling reads the full image.
+	if ((view.roi & roi) != view.roi) {
+		view.frame_undist_rectified(view.roi).setTo(0);
+	}
+	view.roi = roi;
+
+	cv::Mat rectified = view.frame_undist_rectified(roi);
+
+	// Undistort and rectify the searched part of the image.
+	cv::remap(grey,                            // src
+	          rectified,                       // dst
+	          view.undistort_rectify_map(roi), // map1
+	          cv::noArray(),                   // map2
+	          cv::INTER_NEAREST,               // interpolation - LINEAR seems
+	                                           // very slow on my setup
+	          cv::BORDER_CONSTANT,             // borderMode
+	          cv::Scalar(0, 0, 0));            // borderValue
+
+	cv::threshold(rectified, // src
+	              rectified, // dst
+	              32.0,      // thresh
+	              255.0,     // maxval
 	              0);
-	t.sbd->detect(view.frame_undist_rectified, // image
-	              view.keypoints,              // keypoints
-	              cv::noArray());              // mask
+	view.sbd->detect(rectified,      // image
+	                 view.keypoints, // keypoints
+	                 cv::noArray()); // mask
+
+	// Move the keypoints back into full image space.
+	for (cv::KeyPoint &kp : view.keypoints) {
+		kp.pt.x += roi.x;
+		kp.pt.y += roi.y;
+	}
 
 	// Debug is wanted, draw the keypoints.
 	if (rgb.cols > 0) {
@@ -1249,6 +1415,64 @@ do_view(TrackerPSVR &t, View &view, cv::Mat &grey, cv::Mat &rgb)
 	}
 }
 
+/*!
+ * Work out where to search for the LEDs in each view, projects the predicted
+ * positions of the LEDs seen in the last frame into both rectified views.
+ * Returns false when tracking is lost, in which case the full views should be
+ * searched.
+ */
+static bool
+predict_rois(TrackerPSVR &t,
+             const std::vector<match_data_t> &predicted_pose,
+             cv::Rect &out_l_roi,
+             cv::Rect &out_r_roi)
+{
+	if (!t.roi.enabled || t.last_vertices.empty()) {
+		return false;
+	}
+
+	cv::Rect l_box;
+	cv::Rect r_box;
+	bool got_one = false;
+
+	for (const match_data_t &last : t.last_vertices) {
+		if (last.vertex_index < 0 || last.vertex_index >= (int32_t)predicted_pose.size()) {
+			continue;
+		}
+
+		const Eigen::Vector4f &pos = predicted_pose[last.vertex_index].position;
+
+		// Inverse of the disparity to 3d point conversion, x is inverted there.
+		cv::Vec4d xydw = t.depth_to_disparity * cv::Vec4d(-pos.x(), pos.y(), pos.z(), 1.0);
+		if (std::abs(xydw[3]) < 1e-9) {
+			return false;
+		}
+
+		int x = (int)(xydw[0] / xydw[3]);
+		int y = (int)(xydw[1] / xydw[3]);
+		int r_x = (int)(xydw[0] / xydw[3] + xydw[2] / xydw[3]);
+
+		cv::Rect l(x, y, 1, 1);
+		cv::Rect r(r_x, y, 1, 1);
+		l_box = got_one ? (l_box | l) : l;
+		r_box = got_one ? (r_box | r) : r;
+		got_one = true;
+	}
+
+	if (!got_one) {
+		return false;
+	}
+
+	int pad = t.roi.padding;
+	cv::Rect l_full(cv::Point(0, 0), t.view[0].undistort_rectify_map.size());
+	cv::Rect r_full(cv::Point(0, 0), t.view[1].undistort_rectify_map.size());
+
+	out_l_roi = cv::Rect(l_box.x - pad, l_box.y - pad, l_box.width + pad * 2, l_box.height + pad * 2) & l_full;
+	out_r_roi = cv::Rect(r_box.x - pad, r_box.y - pad, r_box.width + pad * 2, r_box.height + pad * 2) & r_full;
+
+	return out_l_roi.area() > 0 && out_r_roi.area() > 0;
+}
+
 typedef struct blob_data
 {
 	int tc_to_bc; // top center to bottom center
@@ -1280,7 +1504,7 @@ sample_line(cv::Mat &src, cv::Point2i start, cv::Point2i end, int *inside_length
 
 	while (1) {
 		// sample our pixel and see if it is in the interior
-		if (curr_x > 0 && curr_y > 0) {
+		if (curr_x > 0 && curr_y > 0 && curr_x < src.cols && curr_y < src.rows) {
 			// cv is row, column
 			uint8_t *val = src.ptr(curr_y, curr_x);
 
@@ -1532,14 +1756,30 @@ process(TrackerPSVR &t, struct xrt_frame *xf)
 	t.world_points.clear();
 
 	int cols = xf->width / 2;
-	int rows = xf->height;
-	int stride = xf->stride;
 
-	cv::Mat l_grey(rows, cols, CV_8UC1, xf->data, stride);
-	cv::Mat r_grey(rows, cols, CV_8UC1, xf->data + cols, stride);
+	cv::Rect full[2] = {
+	    cv::Rect(cv::Point(0, 0), t.view[0].undistort_rectify_map.size()),
+	    cv::Rect(cv::Point(0, 0), t.view[1].undistort_rectify_map.size()),
+	};
+	cv::Rect roi[2] = {full[0], full[1]};
+	bool use_roi = predict_rois(t, predicted_pose, roi[0], roi[1]);
+
+	// The views are independent until the matching, one on each thread.
+	std::function<void(int)> view_job = [&](int i) {
+		cv::Mat grey = get_view_grey(t.view[i], xf, i * cols, cols, roi[i]);
+		do_view(t, t.view[i], grey, t.debug.rgb[i], roi[i]);
+	};
+
+	t.view_worker.run(view_job);
+
+	// Lost the LEDs in the window, fall back to searching everything.
+	if (use_roi && (t.view[0].keypoints.empty() || t.view[1].keypoints.empty())) {
+		roi[0] = full[0];
+		roi[1] = full[1];
+		t.view_worker.run(view_job);
+	}
 
-	do_view(t, t.view[0], l_grey, t.debug.rgb[0]);
-	do_view(t, t.view[1], r_grey, t.debug.rgb[1]);
+	t.roi.fraction = (float)(roi[0].area() + roi[1].area()) / (float)(full[0].area() + full[1].area());
 
 	// if we wish to confirm our camera input contents, dump frames
 	// to disk
@@ -1862,8 +2102,12 @@ get_pose(TrackerPSVR &t, timepoint_ns when_ns, struct xrt_space_relation *out_re
 	os_thread_helper_unlock(&t.oth);
 }
 
+/*!
+ * Integrates all of the samples with the lock held once, the optical
+ * correction only depends on the final rotation so it's done after the loop.
+ */
 static void
-imu_data(TrackerPSVR &t, timepoint_ns timestamp_ns, struct xrt_tracking_sample *sample)
+imu_data_batch(TrackerPSVR &t, const struct xrt_tracking_timed_sample *samples, uint32_t count)
 {
 	os_thread_helper_lock(&t.oth);
 
@@ -1872,13 +2116,29 @@ imu_data(TrackerPSVR &t, timepoint_ns timestamp_ns, struct xrt_tracking_sample *
 		os_thread_helper_unlock(&t.oth);
 		return;
 	}
-	if (t.last_imu != 0) {
-		time_duration_ns delta_ns = timestamp_ns - t.last_imu;
-		float dt = time_ns_to_s(delta_ns);
-		// Super simple fusion.
-		math_quat_integrate_velocity(&t.fusion.rot, &sample->gyro_rad_secs, dt, &t.fusion.rot);
+
+	struct xrt_quat rot = t.fusion.rot;
+	timepoint_ns last_imu = t.last_imu;
+
+	for (uint32_t i = 0; i < count; i++) {
+		timepoint_ns timestamp_ns = samples[i].timestamp_ns;
+
+		if (last_imu != 0) {
+			time_duration_ns delta_ns = timestamp_ns - last_imu;
+			float dt = time_ns_to_s(delta_ns);
+			// Super simple fusion.
+			math_quat_integrate_velocity(&rot, &samples[i].sample.gyro_rad_secs, dt, &rot);
+		}
+		last_imu = timestamp_ns;
+
+#ifdef PSVR_DUMP_IMU_FOR_OFFLINE_ANALYSIS
+		fprintf(t.dump_file, "I,%" PRIu64 ", %f,%f,%f,%f\n\n", timestamp_ns, rot.x, rot.y, rot.z, rot.w);
+#endif
 	}
 
+	t.fusion.rot = rot;
+	t.last_imu = last_imu;
+
 	// apply our optical correction to imu rotation
 	// data
 
@@ -1900,13 +2160,8 @@ imu_data(TrackerPSVR &t, timepoint_ns timestamp_ns, struct xrt_tracking_sample *
 	t.optical.rot.z = corrected_rot_q.z();
 	t.optical.rot.w = corrected_rot_q.w();
 
-	t.last_imu = timestamp_ns;
-
 #ifdef PSVR_DUMP_IMU_FOR_OFFLINE_ANALYSIS
-	fprintf(t.dump_file, "I,%" PRIu64 ", %f,%f,%f,%f\n\n", timestamp_ns, t.fusion.rot.x, t.fusion.rot.y,
-	        t.fusion.rot.z, t.fusion.rot.w);
-
-	fprintf(t.dump_file, "C,%" PRIu64 ", %f,%f,%f,%f\n\n", timestamp_ns, corrected_rot_q.x(), corrected_rot_q.y(),
+	fprintf(t.dump_file, "C,%" PRIu64 ", %f,%f,%f,%f\n\n", last_imu, corrected_rot_q.x(), corrected_rot_q.y(),
 	        corrected_rot_q.z(), corrected_rot_q.w());
 #endif
 
@@ -1914,6 +2169,13 @@ imu_data(TrackerPSVR &t, timepoint_ns timestamp_ns, struct xrt_tracking_sample *
 	os_thread_helper_unlock(&t.oth);
 }
 
+static void
+imu_data(TrackerPSVR &t, timepoint_ns timestamp_ns, struct xrt_tracking_sample *sample)
+{
+	struct xrt_tracking_timed_sample timed = {timestamp_ns, *sample};
+	imu_data_batch(t, &timed, 1);
+}
+
 static void
 frame(TrackerPSVR &t, struct xrt_frame *xf)
 {
@@ -1937,6 +2199,9 @@ static void
 break_apart(TrackerPSVR &t)
 {
 	os_thread_helper_stop(&t.oth);
+
+	// Only safe once the tracker thread is no longer processing frames.
+	t.view_worker.stop();
 }
 
 
@@ -1953,6 +2218,13 @@ t_psvr_push_imu(struct xrt_tracked_psvr *xtvr, timepoint_ns timestamp_ns, struct
 	imu_data(t, timestamp_ns, sample);
 }
 
+extern "C" void
+t_psvr_push_imu_batch(struct xrt_tracked_psvr *xtvr, const struct xrt_tracking_timed_sample *samples, uint32_t count)
+{
+	auto &t = *container_of(xtvr, TrackerPSVR, base);
+	imu_data_batch(t, samples, count);
+}
+
 extern "C" void
 t_psvr_get_tracked_pose(struct xrt_tracked_psvr *xtvr, timepoint_ns when_ns, struct xrt_space_relation *out_relation)
 {
@@ -2013,6 +2285,10 @@ t_psvr_start(struct xrt_tracked_psvr *xtvr)
 	auto &t = *container_of(xtvr, TrackerPSVR, base);
 	int ret;
 
+	// Without the worker the views are processed in sequence.
+	if (t.view_worker.start() != 0) {
+		PSVR_WARN("Failed to start view worker thread!");
+	}
 
 	ret = os_thread_helper_start(&t.oth, t_psvr_run, &t);
 	if (ret != 0) {
@@ -2044,6 +2320,7 @@ t_psvr_create(struct xrt_frame_context *xfctx,
 	t.view[0].populate_from_calib(data->view[0], rectify.view[0].rectify);
 	t.view[1].populate_from_calib(data->view[1], rectify.view[1].rectify);
 	t.disparity_to_depth = rectify.disparity_to_depth_mat;
+	t.depth_to_disparity = static_cast<cv::Matx44d>(t.disparity_to_depth).inv();
 	StereoCameraCalibrationWrapper wrapped(data);
 	t.r_cam_rotation = wrapped.camera_rotation_mat;
 	t.r_cam_translation = wrapped.camera_translation_mat;
@@ -2067,7 +2344,8 @@ t_psvr_create(struct xrt_frame_context *xfctx,
 	blob_params.minRepeatability = 1; // need this to avoid error?
 	// clang-format on
 
-	t.sbd = cv::SimpleBlobDetector::create(blob_params);
+	t.view[0].sbd = cv::SimpleBlobDetector::create(blob_params);
+	t.view[1].sbd = cv::SimpleBlobDetector::create(blob_params);
 
 	t.target_optical_rotation_correction = Eigen::Quaternionf(1.0f, 0.0f, 0.0f, 0.0f);
 	t.optical_rotation_correction = Eigen::Quaternionf(1.0f, 0.0f, 0.0f, 0.0f);
@@ -2088,9 +2366,11 @@ t_psvr_create(struct xrt_frame_context *xfctx,
 	// offset our models center of rotation
 	create_model(t);
 	create_match_list(t);
+	create_match_index(t);
 
 	t.base.get_tracked_pose = t_psvr_get_tracked_pose;
 	t.base.push_imu = t_psvr_push_imu;
+	t.base.push_imu_batch = t_psvr_push_imu_batch;
 	t.base.destroy = t_psvr_fake_destroy;
 	t.sink.push_frame = t_psvr_sink_push_frame;
 	t.node.break_apart = t_psvr_node_break_apart;
@@ -2118,6 +2398,12 @@ t_psvr_create(struct xrt_frame_context *xfctx,
 	u_var_add_root(&t, "PSVR Tracker", true);
 	u_var_add_log_level(&t, &t.ll, "Log level");
 	u_var_add_sink(&t, &t.debug.sink, "Debug");
+	u_var_add_bool(&t, &t.roi.enabled, "ROI search");
+	u_var_add_i32(&t, &t.roi.padding, "ROI padding (px)");
+	u_var_add_ro_f32(&t, &t.roi.fraction, "ROI fraction processed");
+	t.view_worker.add_vars(&t);
+	u_var_add_ro_u32(&t, &t.disambig.candidates, "Disambiguation candidates");
+	u_var_add_ro_u32(&t, &t.disambig.solved, "Disambiguation solves");
 
 	*out_sink = &t.sink;
 	*out_xtvr = &t.base;
@@ -267,6 +267,22 @@ struct t_hsv_filter_params
 	} white;
 };
 
+/*!
+ * What kind of frames the HSV filter pushes on its channel sinks.
+ * @relates t_hsv_filter
+ */
+enum t_hsv_filter_output
+{
+	//! One @ref XRT_FORMAT_L8 frame per channel, 0xff or 0x00 per pixel.
+	T_HSV_FILTER_OUTPUT_L8,
+
+	/*!
+	 * One @ref XRT_FORMAT_BITMAP_8X1 frame per channel, one bit per pixel
+	 * with the left most pixel of each byte in the lowest bit.
+	 */
+	T_HSV_FILTER_OUTPUT_BITMAP_8X1,
+};
+
 struct t_hsv_filter_large_table
 {
 	uint8_t v[256][256][256];
@@ -294,6 +310,11 @@ t_hsv_filter_sample(struct t_hsv_filter_optimized_table *t, uint32_t y, uint32_t
 
 /*!
  * Construct an HSV filter sink.
+ *
+ * Takes YUV888, YUYV422, UYVY422 and, when built with libjpeg, MJPEG frames.
+ * The camera formats are classified in the same pass as they are read or
+ * decoded, so no converted copy of the frame is made.
+ *
  * @public @memberof t_hsv_filter
  *
  * @see xrt_frame_context
@@ -304,6 +325,37 @@ t_hsv_filter_create(struct xrt_frame_context *xfctx,
                     struct xrt_frame_sink *sinks[4],
                     struct xrt_frame_sink **out_sink);
 
+/*!
+ * Construct an HSV filter sink that pushes frames of the given @p output kind,
+ * @ref t_hsv_filter_create is the same as passing
+ * @ref T_HSV_FILTER_OUTPUT_L8.
+ *
+ * @public @memberof t_hsv_filter
+ *
+ * @see xrt_frame_context
+ */
+int
+t_hsv_filter_create_with_output(struct xrt_frame_context *xfctx,
+                                struct t_hsv_filter_params *params,
+                                enum t_hsv_filter_output output,
+                                struct xrt_frame_sink *sinks[4],
+                                struct xrt_frame_sink **out_sink);
+
+/*!
+ * Expands the rectangle at @p x, @p y of @p width by @p height pixels of a
+ * @ref XRT_FORMAT_BITMAP_8X1 frame into one byte per pixel, 0xff for set bits
+ * and 0x00 otherwise, so the trackers can consume the packed filter output.
+ * @p dst points at the first pixel of the rectangle.
+ */
+void
+t_hsv_filter_unpack_bitmap(struct xrt_frame *xf,
+                           uint32_t x,
+                           uint32_t y,
+                           uint32_t width,
+                           uint32_t height,
+                           uint8_t *dst,
+                           size_t dst_stride);
+
 
 /*
  *
@@ -0,0 +1,191 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Atomic 32 bit word helpers and a sequence counter latch, for data
+ *         shared between threads or processes without a lock.
+ * @author Collabora, Ltd.
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+#include <assert.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ *
+ * Loads, stores and fences.
+ *
+ */
+
+static inline uint32_t
+u_atomic_load_relaxed(const uint32_t *p)
+{
+#if defined(__GNUC__)
+	return __atomic_load_n(p, __ATOMIC_RELAXED);
+#elif defined(_MSC_VER)
+	return *(const volatile uint32_t *)p;
+#else
+#error "compiler not supported"
+#endif
+}
+
+static inline uint32_t
+u_atomic_load_acquire(const uint32_t *p)
+{
+#if defined(__GNUC__)
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#elif defined(_MSC_VER)
+	uint32_t v = *(const volatile uint32_t *)p;
+	MemoryBarrier();
+	return v;
+#else
+#error "compiler not supported"
+#endif
+}
+
+static inline uint32_t
+u_atomic_load_seq_cst(const uint32_t *p)
+{
+#if defined(__GNUC__)
+	return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+#elif defined(_MSC_VER)
+	MemoryBarrier();
+	uint32_t v = *(const volatile uint32_t *)p;
+	MemoryBarrier();
+	return v;
+#else
+#error "compiler not supported"
+#endif
+}
+
+static inline void
+u_atomic_store_relaxed(uint32_t *p, uint32_t v)
+{
+#if defined(__GNUC__)
+	__atomic_store_n(p, v, __ATOMIC_RELAXED);
+#elif defined(_MSC_VER)
+	*(volatile uint32_t *)p = v;
+#else
+#error "compiler not supported"
+#endif
+}
+
+static inline void
+u_atomic_store_seq_cst(uint32_t *p, uint32_t v)
+{
+#if defined(__GNUC__)
+	__atomic_store_n(p, v, __ATOMIC_SEQ_CST);
+#elif defined(_MSC_VER)
+	InterlockedExchange((volatile LONG *)p, (LONG)v);
+#else
+#error "compiler not supported"
+#endif
+}
+
+static inline void
+u_atomic_fence_release(void)
+{
+#if defined(__GNUC__)
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+#elif defined(_MSC_VER)
+	MemoryBarrier();
+#else
+#error "compiler not supported"
+#endif
+}
+
+static inline void
+u_atomic_fence_acquire(void)
+{
+#if defined(__GNUC__)
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+#elif defined(_MSC_VER)
+	MemoryBarrier();
+#else
+#error "compiler not supported"
+#endif
+}
+
+/*!
+ * Copy @p size bytes one 32 bit word at a time with relaxed atomic loads and
+ * stores, both pointers must be word aligned and the size a whole number of
+ * words. Used for data that is read while being written, so a torn copy is
+ * something the sequence counter catches and not a data race.
+ *
+ * @ingroup aux_util
+ */
+static inline void
+u_atomic_copy_relaxed(void *dst, const void *src, size_t size)
+{
+	assert(size % sizeof(uint32_t) == 0);
+
+	uint32_t *d = (uint32_t *)dst;
+	const uint32_t *s = (const uint32_t *)src;
+
+	for (size_t i = 0; i < size / sizeof(uint32_t); i++) {
+		u_atomic_store_relaxed(&d[i], u_atomic_load_relaxed(&s[i]));
+	}
+}
+
+
+/*
+ *
+ * Latch, a sequence counter with two copies of the data.
+ *
+ * The writer calls @ref u_atomic_latch before writing each copy, readers
+ * read copy `seq & 1` which is never the one being written. A reader retries
+ * if the counter changed while it was copying, all data words must be
+ * accessed with the relaxed functions above.
+ *
+ */
+
+/*!
+ * Moves the readers over to the other copy, all stores after this are not
+ * seen before the new sequence number. Only one writer at a time.
+ *
+ * @ingroup aux_util
+ */
+static inline void
+u_atomic_latch(uint32_t *seq)
+{
+	u_atomic_fence_release();
+	u_atomic_store_relaxed(seq, u_atomic_load_relaxed(seq) + 1);
+	u_atomic_fence_release();
+}
+
+/*!
+ * Start a read, returns the sequence number, `seq & 1` is the copy to read.
+ *
+ * @ingroup aux_util
+ */
+static inline uint32_t
+u_atomic_latch_read_begin(const uint32_t *seq)
+{
+	return u_atomic_load_acquire(seq);
+}
+
+/*!
+ * End a read started with @ref u_atomic_latch_read_begin, returns true if
+ * the copy was torn and the read has to be retried.
+ *
+ * @ingroup aux_util
+ */
+static inline bool
+u_atomic_latch_read_retry(const uint32_t *seq, uint32_t begin)
+{
+	u_atomic_fence_acquire();
+	return u_atomic_load_relaxed(seq) != begin;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
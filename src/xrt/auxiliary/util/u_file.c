@@ -77,17 +77,37 @@ u_file_get_path_in_config_dir(const char *filename, char *out_path, size_t out_p
 	return snprintf(out_path, out_path_size, "%s/%s", tmp, filename);
 }
 
-FILE *
-u_file_open_file_in_config_dir(const char *filename, const char *mode)
+ssize_t
+u_file_get_cache_dir(char *out_path, size_t out_path_size)
+{
+	const char *xdg_cache = getenv("XDG_CACHE_HOME");
+	const char *home = getenv("HOME");
+	if (xdg_cache != NULL) {
+		return snprintf(out_path, out_path_size, "%s/monado", xdg_cache);
+	}
+	if (home != NULL) {
+		return snprintf(out_path, out_path_size, "%s/.cache/monado", home);
+	}
+	return -1;
+}
+
+ssize_t
+u_file_get_path_in_cache_dir(const char *filename, char *out_path, size_t out_path_size)
 {
 	char tmp[PATH_MAX];
-	ssize_t i = u_file_get_config_dir(tmp, sizeof(tmp));
+	ssize_t i = u_file_get_cache_dir(tmp, sizeof(tmp));
 	if (i <= 0) {
-		return NULL;
+		return -1;
 	}
 
+	return snprintf(out_path, out_path_size, "%s/%s", tmp, filename);
+}
+
+static FILE *
+open_file_in_dir(const char *dir, const char *filename, const char *mode)
+{
 	char file_str[PATH_MAX + 15];
-	i = snprintf(file_str, sizeof(file_str), "%s/%s", tmp, filename);
+	ssize_t i = snprintf(file_str, sizeof(file_str), "%s/%s", dir, filename);
 	if (i <= 0) {
 		return NULL;
 	}
@@ -98,12 +118,36 @@ u_file_open_file_in_config_dir(const char *filename, const char *mode)
 	}
 
 	// Try creating the path.
-	mkpath(tmp);
+	mkpath(dir);
 
 	// Do not report error.
 	return fopen(file_str, mode);
 }
 
+FILE *
+u_file_open_file_in_cache_dir(const char *filename, const char *mode)
+{
+	char tmp[PATH_MAX];
+	ssize_t i = u_file_get_cache_dir(tmp, sizeof(tmp));
+	if (i <= 0) {
+		return NULL;
+	}
+
+	return open_file_in_dir(tmp, filename, mode);
+}
+
+FILE *
+u_file_open_file_in_config_dir(const char *filename, const char *mode)
+{
+	char tmp[PATH_MAX];
+	ssize_t i = u_file_get_config_dir(tmp, sizeof(tmp));
+	if (i <= 0) {
+		return NULL;
+	}
+
+	return open_file_in_dir(tmp, filename, mode);
+}
+
 #endif
 
 char *
@@ -47,6 +47,43 @@ get_config_path()
 	return {};
 #endif
 }
+static inline fs::path
+get_cache_path()
+{
+#ifdef XRT_OS_WINDOWS
+	auto local_app_data = fs::path{getenv("LOCALAPPDATA")};
+	return local_app_data / "monado" / "cache";
+#else
+
+	const char *xdg_cache = getenv("XDG_CACHE_HOME");
+	const char *home = getenv("HOME");
+	if (xdg_cache != NULL) {
+		return fs::path(xdg_cache) / "monado";
+	}
+	if (home != NULL) {
+		return fs::path(home) / ".cache" / "monado";
+	}
+	return {};
+#endif
+}
+
+static FILE *
+open_file_in_path(const fs::path &dir_path, const char *filename, const char *mode)
+{
+	auto file_path_string = (dir_path / filename).string();
+	FILE *file = fopen(file_path_string.c_str(), mode);
+	if (file != NULL) {
+		return file;
+	}
+
+	// Try creating the path.
+	auto directory = (dir_path / filename).parent_path();
+	fs::create_directories(directory);
+
+	// Do not report error.
+	return fopen(file_path_string.c_str(), mode);
+}
+
 ssize_t
 u_file_get_config_dir(char *out_path, size_t out_path_size)
 {
@@ -77,18 +114,40 @@ u_file_open_file_in_config_dir(const char *filename, const char *mode)
 		return NULL;
 	}
 
-	auto file_path_string = (config_path / filename).string();
-	FILE *file = fopen(file_path_string.c_str(), mode);
-	if (file != NULL) {
-		return file;
+	return open_file_in_path(config_path, filename, mode);
+}
+
+ssize_t
+u_file_get_cache_dir(char *out_path, size_t out_path_size)
+{
+	auto cache_path = get_cache_path();
+	if (cache_path.empty()) {
+		return -1;
 	}
+	auto cache_path_string = cache_path.string();
+	return snprintf(out_path, out_path_size, "%s", cache_path_string.c_str());
+}
 
-	// Try creating the path.
-	auto directory = (config_path / filename).parent_path();
-	fs::create_directories(directory);
+ssize_t
+u_file_get_path_in_cache_dir(const char *filename, char *out_path, size_t out_path_size)
+{
+	auto cache_path = get_cache_path();
+	if (cache_path.empty()) {
+		return -1;
+	}
+	auto path_string = (cache_path / filename).string();
+	return snprintf(out_path, out_path_size, "%s", path_string.c_str());
+}
 
-	// Do not report error.
-	return fopen(file_path_string.c_str(), mode);
+FILE *
+u_file_open_file_in_cache_dir(const char *filename, const char *mode)
+{
+	auto cache_path = get_cache_path();
+	if (cache_path.empty()) {
+		return NULL;
+	}
+
+	return open_file_in_path(cache_path, filename, mode);
 }
 
 #endif
@@ -28,6 +28,19 @@ u_file_get_path_in_config_dir(const char *suffix, char *out_path, size_t out_pat
 FILE *
 u_file_open_file_in_config_dir(const char *filename, const char *mode);
 
+/*!
+ * Directory for files that can be regenerated at any time, like precomputed
+ * tables, `$XDG_CACHE_HOME/monado` on Linux.
+ */
+ssize_t
+u_file_get_cache_dir(char *out_path, size_t out_path_size);
+
+ssize_t
+u_file_get_path_in_cache_dir(const char *filename, char *out_path, size_t out_path_size);
+
+FILE *
+u_file_open_file_in_cache_dir(const char *filename, const char *mode);
+
 char *
 u_file_read_content(FILE *file);
 
@@ -14,6 +14,19 @@
 #include <assert.h>
 
 
+/*!
+ * A frame that is a view into another frame.
+ *
+ * @implements xrt_frame
+ */
+struct u_frame_roi
+{
+	struct xrt_frame base;
+
+	//! The frame we are a view into, we hold a reference to it.
+	struct xrt_frame *original;
+};
+
 static void
 free_one_off(struct xrt_frame *xf)
 {
@@ -42,3 +55,60 @@ u_frame_create_one_off(enum xrt_format f, uint32_t width, uint32_t height, struc
 
 	xrt_frame_reference(out_frame, xf);
 }
+
+static void
+free_roi(struct xrt_frame *xf)
+{
+	struct u_frame_roi *roi = container_of(xf, struct u_frame_roi, base);
+
+	assert(xf->reference.count == 0);
+	xrt_frame_reference(&roi->original, NULL);
+	free(roi);
+}
+
+void
+u_frame_create_roi(struct xrt_frame *original,
+                   uint32_t x,
+                   uint32_t y,
+                   uint32_t width,
+                   uint32_t height,
+                   struct xrt_frame **out_frame)
+{
+	enum xrt_format f = original->format;
+	uint32_t block_width = u_format_block_width(f);
+	uint32_t block_height = u_format_block_height(f);
+	size_t block_size = u_format_block_size(f);
+
+	assert(width > 0);
+	assert(height > 0);
+	assert(u_format_is_blocks(f));
+	assert(x % block_width == 0 && width % block_width == 0);
+	assert(y % block_height == 0 && height % block_height == 0);
+	assert(x + width <= original->width);
+	assert(y + height <= original->height);
+
+	size_t offset = (y / block_height) * original->stride + (x / block_width) * block_size;
+	size_t num_rows = height / block_height;
+	size_t row_size = (width / block_width) * block_size;
+
+	struct u_frame_roi *roi = U_TYPED_CALLOC(struct u_frame_roi);
+	struct xrt_frame *xf = &roi->base;
+
+	xf->format = f;
+	xf->width = width;
+	xf->height = height;
+	xf->stride = original->stride;
+	xf->size = (num_rows - 1) * original->stride + row_size;
+	xf->data = original->data + offset;
+	xf->destroy = free_roi;
+
+	xf->timestamp = original->timestamp;
+	xf->source_timestamp = original->source_timestamp;
+	xf->source_sequence = original->source_sequence;
+	xf->source_id = original->source_id;
+	xf->stereo_format = XRT_STEREO_FORMAT_NONE;
+
+	xrt_frame_reference(&roi->original, original);
+
+	xrt_frame_reference(out_frame, xf);
+}
@@ -23,6 +23,20 @@ extern "C" {
 void
 u_frame_create_one_off(enum xrt_format f, uint32_t width, uint32_t height, struct xrt_frame **out_frame);
 
+/*!
+ * Creates a frame that is a view into a region of @p original, no pixels are
+ * copied. The new frame holds a reference to @p original that is released
+ * when its own reference reaches zero. The region must be aligned to the
+ * blocks of the format and fit inside of the original frame.
+ */
+void
+u_frame_create_roi(struct xrt_frame *original,
+                   uint32_t x,
+                   uint32_t y,
+                   uint32_t width,
+                   uint32_t height,
+                   struct xrt_frame **out_frame);
+
 
 #ifdef __cplusplus
 }
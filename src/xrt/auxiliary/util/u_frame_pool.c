@@ -0,0 +1,326 @@
+// Copyright 2019-2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  A pool of recycled @ref xrt_frame objects.
+ * @author Collabora, Ltd.
+ * @ingroup aux_util
+ */
+
+#include "xrt/xrt_config_os.h"
+
+#include "os/os_threading.h"
+
+#include "util/u_var.h"
+#include "util/u_misc.h"
+#include "util/u_format.h"
+#include "util/u_logging.h"
+#include "util/u_frame_pool.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+#ifdef XRT_OS_WINDOWS
+#include <malloc.h>
+#endif
+
+
+#define U_FRAME_POOL_CACHE_LINE_SIZE 64
+#define U_FRAME_POOL_PAGE_SIZE 4096
+
+
+/*
+ *
+ * Structs.
+ *
+ */
+
+/*!
+ * A frame that belongs to a @ref u_frame_pool.
+ *
+ * @implements xrt_frame
+ */
+struct u_frame_pool_frame
+{
+	struct xrt_frame base;
+
+	//! Owning pool, we hold a reference on it.
+	struct u_frame_pool *pool;
+
+	//! Next idle frame, only valid when on the free list.
+	struct u_frame_pool_frame *next;
+
+	//! Data pointer as allocated, xrt_frame::data may not be trusted.
+	uint8_t *buffer;
+
+	//! Size of the allocated buffer.
+	size_t buffer_size;
+};
+
+struct u_frame_pool
+{
+	/*!
+	 * One reference for the owner and one for each outstanding frame, the
+	 * pool is freed when it reaches zero.
+	 */
+	struct xrt_reference reference;
+
+	struct os_mutex mutex;
+
+	//! Idle frames ready to be reused, protected by the mutex.
+	struct u_frame_pool_frame *free_list;
+	uint32_t num_free;
+	uint32_t max_free;
+
+	//! Statistics, protected by the mutex and exposed via @ref u_var.
+	struct
+	{
+		uint64_t hits;
+		uint64_t misses;
+		uint64_t bytes_resident;
+	} stats;
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static uint8_t *
+aligned_alloc_buffer(size_t size)
+{
+	size_t alignment = size >= U_FRAME_POOL_PAGE_SIZE ? U_FRAME_POOL_PAGE_SIZE : U_FRAME_POOL_CACHE_LINE_SIZE;
+
+#ifdef XRT_OS_WINDOWS
+	return (uint8_t *)_aligned_malloc(size, alignment);
+#else
+	void *ptr = NULL;
+	if (posix_memalign(&ptr, alignment, size) != 0) {
+		return NULL;
+	}
+	return (uint8_t *)ptr;
+#endif
+}
+
+static void
+aligned_free_buffer(uint8_t *buffer)
+{
+#ifdef XRT_OS_WINDOWS
+	_aligned_free(buffer);
+#else
+	free(buffer);
+#endif
+}
+
+static void
+pool_unref(struct u_frame_pool *pool)
+{
+	if (!xrt_reference_dec(&pool->reference)) {
+		return;
+	}
+
+	assert(pool->free_list == NULL);
+
+	os_mutex_destroy(&pool->mutex);
+	free(pool);
+}
+
+/*!
+ * Must be called with the pool mutex held.
+ */
+static void
+free_frame_locked(struct u_frame_pool *pool, struct u_frame_pool_frame *pf)
+{
+	pool->stats.bytes_resident -= pf->buffer_size;
+
+	aligned_free_buffer(pf->buffer);
+	free(pf);
+}
+
+static inline bool
+frame_matches(struct u_frame_pool_frame *pf, enum xrt_format f, uint32_t width, uint32_t height)
+{
+	return pf->base.format == f && pf->base.width == width && pf->base.height == height;
+}
+
+/*!
+ * The @ref xrt_frame::destroy function, returns the frame to the pool.
+ */
+static void
+release_to_pool(struct xrt_frame *xf)
+{
+	struct u_frame_pool_frame *pf = container_of(xf, struct u_frame_pool_frame, base);
+	struct u_frame_pool *pool = pf->pool;
+
+	assert(xf->reference.count == 0);
+
+	os_mutex_lock(&pool->mutex);
+
+	if (pool->num_free < pool->max_free) {
+		pf->next = pool->free_list;
+		pool->free_list = pf;
+		pool->num_free++;
+	} else {
+		free_frame_locked(pool, pf);
+	}
+
+	os_mutex_unlock(&pool->mutex);
+
+	// Drop the reference the frame held on the pool.
+	pool_unref(pool);
+}
+
+/*!
+ * Look for a idle frame with the same layout, drops any idle frames with a
+ * different layout as the stream has changed mode.
+ *
+ * Must be called with the pool mutex held.
+ */
+static struct u_frame_pool_frame *
+take_matching_locked(struct u_frame_pool *pool, enum xrt_format f, uint32_t width, uint32_t height)
+{
+	struct u_frame_pool_frame **link = &pool->free_list;
+
+	while (*link != NULL) {
+		struct u_frame_pool_frame *pf = *link;
+
+		if (frame_matches(pf, f, width, height)) {
+			*link = pf->next;
+			pool->num_free--;
+			return pf;
+		}
+
+		link = &pf->next;
+	}
+
+	// Miss, so anything still idle has the wrong layout.
+	while (pool->free_list != NULL) {
+		struct u_frame_pool_frame *pf = pool->free_list;
+		pool->free_list = pf->next;
+		free_frame_locked(pool, pf);
+	}
+	pool->num_free = 0;
+
+	return NULL;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+void
+u_frame_pool_create(struct u_frame_pool **out_pool, const char *name, uint32_t max_free)
+{
+	struct u_frame_pool *pool = U_TYPED_CALLOC(struct u_frame_pool);
+
+	int ret = os_mutex_init(&pool->mutex);
+	if (ret != 0) {
+		U_LOG_E("Failed to init mutex!");
+		free(pool);
+		*out_pool = NULL;
+		return;
+	}
+
+	pool->max_free = max_free;
+	pool->reference.count = 1;
+
+	u_var_add_root(pool, name, true);
+	u_var_add_ro_u64(pool, &pool->stats.hits, "Hits");
+	u_var_add_ro_u64(pool, &pool->stats.misses, "Misses");
+	u_var_add_ro_u64(pool, &pool->stats.bytes_resident, "Bytes resident");
+
+	*out_pool = pool;
+}
+
+void
+u_frame_pool_destroy(struct u_frame_pool **pool_ptr)
+{
+	struct u_frame_pool *pool = *pool_ptr;
+	if (pool == NULL) {
+		return;
+	}
+
+	u_var_remove_root(pool);
+
+	os_mutex_lock(&pool->mutex);
+
+	// Frames released from now on are freed directly.
+	pool->max_free = 0;
+
+	while (pool->free_list != NULL) {
+		struct u_frame_pool_frame *pf = pool->free_list;
+		pool->free_list = pf->next;
+		free_frame_locked(pool, pf);
+	}
+	pool->num_free = 0;
+
+	os_mutex_unlock(&pool->mutex);
+
+	// Outstanding frames keeps the pool alive.
+	pool_unref(pool);
+
+	*pool_ptr = NULL;
+}
+
+void
+u_frame_pool_create_frame(struct u_frame_pool *pool,
+                          enum xrt_format f,
+                          uint32_t width,
+                          uint32_t height,
+                          struct xrt_frame **out_frame)
+{
+	assert(width > 0);
+	assert(height > 0);
+	assert(u_format_is_blocks(f));
+
+	os_mutex_lock(&pool->mutex);
+	struct u_frame_pool_frame *pf = take_matching_locked(pool, f, width, height);
+	if (pf != NULL) {
+		pool->stats.hits++;
+	} else {
+		pool->stats.misses++;
+	}
+	os_mutex_unlock(&pool->mutex);
+
+	if (pf == NULL) {
+		size_t stride = 0;
+		size_t size = 0;
+		u_format_size_for_dimensions(f, width, height, &stride, &size);
+
+		pf = U_TYPED_CALLOC(struct u_frame_pool_frame);
+		pf->buffer = aligned_alloc_buffer(size);
+		if (pf->buffer == NULL) {
+			U_LOG_E("Failed to allocate frame buffer of size %u!", (uint32_t)size);
+			free(pf);
+			xrt_frame_reference(out_frame, NULL);
+			return;
+		}
+		pf->buffer_size = size;
+
+		os_mutex_lock(&pool->mutex);
+		pool->stats.bytes_resident += size;
+		os_mutex_unlock(&pool->mutex);
+	}
+
+	// Reset all of the fields, users may have changed them.
+	U_ZERO(&pf->base);
+	pf->base.format = f;
+	pf->base.width = width;
+	pf->base.height = height;
+	pf->base.data = pf->buffer;
+	pf->base.destroy = release_to_pool;
+	pf->pool = pool;
+	pf->next = NULL;
+
+	u_format_size_for_dimensions(f, width, height, &pf->base.stride, &pf->base.size);
+
+	// Each outstanding frame holds a reference on the pool.
+	xrt_reference_inc(&pool->reference);
+
+	xrt_frame_reference(out_frame, &pf->base);
+}
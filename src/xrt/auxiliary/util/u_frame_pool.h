@@ -0,0 +1,74 @@
+// Copyright 2019-2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  A pool of recycled @ref xrt_frame objects.
+ * @author Collabora, Ltd.
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Default number of idle frames a pool keeps around.
+ *
+ * @ingroup aux_util
+ */
+#define U_FRAME_POOL_DEFAULT_MAX_FREE 4
+
+/*!
+ * A pool of @ref xrt_frame objects, frames handed out from the pool are
+ * returned to it when their reference count reaches zero. Only frames that
+ * match the requested format and size are reused, the pixel buffers are
+ * cache-line aligned, and page aligned if larger then a page.
+ *
+ * Frames can safely outlive the pool, and be released from any thread.
+ *
+ * @ingroup aux_util
+ */
+struct u_frame_pool;
+
+/*!
+ * Create a frame pool, @p name is used for the @ref u_var root. The pool keeps
+ * at most @p max_free idle frames around, anything more is freed on release.
+ *
+ * @public @memberof u_frame_pool
+ */
+void
+u_frame_pool_create(struct u_frame_pool **out_pool, const char *name, uint32_t max_free);
+
+/*!
+ * Destroy the pool, any frames still held are freed when their last
+ * reference is dropped. Sets @p pool_ptr to NULL.
+ *
+ * @public @memberof u_frame_pool
+ */
+void
+u_frame_pool_destroy(struct u_frame_pool **pool_ptr);
+
+/*!
+ * Get a frame from the pool, allocating a new one if no idle frame of the
+ * given format and size is available. The contents of the data buffer is
+ * undefined, just like with @ref u_frame_create_one_off, all other fields are
+ * reset. Sets @p out_frame to NULL on allocation failure.
+ *
+ * @public @memberof u_frame_pool
+ */
+void
+u_frame_pool_create_frame(struct u_frame_pool *pool,
+                          enum xrt_format f,
+                          uint32_t width,
+                          uint32_t height,
+                          struct xrt_frame **out_frame);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,62 @@
+// Copyright 2019-2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  A simple histogram of latencies, for exposing with @ref u_var.
+ * @author Collabora, Ltd.
+ * @ingroup aux_util
+ */
+
+#include "util/u_var.h"
+#include "util/u_time.h"
+#include "util/u_latency_histogram.h"
+
+#include <stdio.h>
+
+
+void
+u_latency_histogram_add(struct u_latency_histogram *h, uint64_t latency_ns)
+{
+	uint64_t ms = latency_ns / U_TIME_1MS_IN_NS;
+
+	// Bucket zero is below 1ms, bucket n is [2^(n-1), 2^n) ms.
+	uint32_t bin = 0;
+	while (ms > 0 && bin < U_LATENCY_HISTOGRAM_NUM_BINS - 1) {
+		ms >>= 1;
+		bin++;
+	}
+
+	float latency_ms = (float)time_ns_to_s(latency_ns) * 1000.f;
+
+	h->bins[bin]++;
+	h->count++;
+	h->last_ms = latency_ms;
+	h->mean_ms += (latency_ms - h->mean_ms) / (float)h->count;
+	if (latency_ms > h->max_ms) {
+		h->max_ms = latency_ms;
+	}
+}
+
+void
+u_latency_histogram_add_vars(struct u_latency_histogram *h, void *root, const char *prefix)
+{
+	char tmp[256];
+
+	snprintf(tmp, sizeof(tmp), "%s last (ms)", prefix);
+	u_var_add_ro_f32(root, &h->last_ms, tmp);
+	snprintf(tmp, sizeof(tmp), "%s mean (ms)", prefix);
+	u_var_add_ro_f32(root, &h->mean_ms, tmp);
+	snprintf(tmp, sizeof(tmp), "%s max (ms)", prefix);
+	u_var_add_ro_f32(root, &h->max_ms, tmp);
+
+	for (uint32_t i = 0; i < U_LATENCY_HISTOGRAM_NUM_BINS; i++) {
+		if (i == 0) {
+			snprintf(tmp, sizeof(tmp), "%s <1ms", prefix);
+		} else if (i == U_LATENCY_HISTOGRAM_NUM_BINS - 1) {
+			snprintf(tmp, sizeof(tmp), "%s >=%ums", prefix, 1u << (i - 1));
+		} else {
+			snprintf(tmp, sizeof(tmp), "%s %u-%ums", prefix, 1u << (i - 1), 1u << i);
+		}
+		u_var_add_ro_u64(root, &h->bins[i], tmp);
+	}
+}
@@ -0,0 +1,69 @@
+// Copyright 2019-2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  A simple histogram of latencies, for exposing with @ref u_var.
+ * @author Collabora, Ltd.
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Number of buckets in a @ref u_latency_histogram.
+ *
+ * @ingroup aux_util
+ */
+#define U_LATENCY_HISTOGRAM_NUM_BINS 12
+
+/*!
+ * A histogram of latencies with buckets that double in size, the first bucket
+ * holds everything below 1ms, the next 1-2ms, then 2-4ms and so on. The last
+ * bucket holds everything that doesn't fit in the others.
+ *
+ * Not thread safe, meant to be updated from one thread and only read with
+ * @ref u_var.
+ *
+ * @ingroup aux_util
+ */
+struct u_latency_histogram
+{
+	//! Number of samples in each bucket.
+	uint64_t bins[U_LATENCY_HISTOGRAM_NUM_BINS];
+
+	//! Total number of samples.
+	uint64_t count;
+
+	float last_ms;
+	float mean_ms;
+	float max_ms;
+};
+
+/*!
+ * Add a sample to the histogram.
+ *
+ * @public @memberof u_latency_histogram
+ */
+void
+u_latency_histogram_add(struct u_latency_histogram *h, uint64_t latency_ns);
+
+/*!
+ * Add the histogram to the @ref u_var root @p root, each variable name is
+ * prefixed with @p prefix.
+ *
+ * @public @memberof u_latency_histogram
+ */
+void
+u_latency_histogram_add_vars(struct u_latency_histogram *h, void *root, const char *prefix);
+
+
+#ifdef __cplusplus
+}
+#endif
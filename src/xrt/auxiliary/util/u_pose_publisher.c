@@ -0,0 +1,93 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Lock-free publication of the latest pose from a driver thread.
+ * @author Collabora, Ltd.
+ * @ingroup aux_util
+ */
+
+#include "xrt/xrt_compiler.h"
+
+#include "math/m_predict.h"
+
+#include "util/u_misc.h"
+#include "util/u_atomic.h"
+#include "util/u_time.h"
+#include "util/u_pose_publisher.h"
+
+#include <string.h>
+
+
+#define NUM_WORDS (sizeof(struct u_pose_publisher_state) / sizeof(uint32_t))
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+void
+u_pose_publisher_init(struct u_pose_publisher *upp)
+{
+	U_ZERO(upp);
+}
+
+void
+u_pose_publisher_publish(struct u_pose_publisher *upp,
+                         timepoint_ns timestamp_ns,
+                         const struct xrt_space_relation *relation)
+{
+	struct u_pose_publisher_state state = {0};
+	state.timestamp_ns = timestamp_ns;
+	state.relation = *relation;
+	state.published = 1;
+
+	uint32_t words[NUM_WORDS];
+	memcpy(words, &state, sizeof(words));
+
+	// Odd, readers use slot 1 while slot 0 is written.
+	u_atomic_latch(&upp->seq);
+	u_atomic_copy_relaxed(upp->slots[0], words, sizeof(words));
+
+	// Even, readers use slot 0 while slot 1 is written.
+	u_atomic_latch(&upp->seq);
+	u_atomic_copy_relaxed(upp->slots[1], words, sizeof(words));
+}
+
+bool
+u_pose_publisher_read(const struct u_pose_publisher *upp, struct u_pose_publisher_state *out_state)
+{
+	uint32_t words[NUM_WORDS];
+	uint32_t seq;
+
+	do {
+		seq = u_atomic_latch_read_begin(&upp->seq);
+		u_atomic_copy_relaxed(words, upp->slots[seq & 1], sizeof(words));
+	} while (u_atomic_latch_read_retry(&upp->seq, seq));
+
+	memcpy(out_state, words, sizeof(words));
+
+	if (!out_state->published) {
+		U_ZERO(out_state);
+		return false;
+	}
+
+	return true;
+}
+
+void
+u_pose_publisher_get(const struct u_pose_publisher *upp,
+                     timepoint_ns at_timestamp_ns,
+                     struct xrt_space_relation *out_relation)
+{
+	struct u_pose_publisher_state state;
+	if (!u_pose_publisher_read(upp, &state)) {
+		U_ZERO(out_relation);
+		return;
+	}
+
+	double delta_s = time_ns_to_s(at_timestamp_ns - state.timestamp_ns);
+	m_predict_relation(&state.relation, delta_s, out_relation);
+}
@@ -0,0 +1,101 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Lock-free publication of the latest pose from a driver thread.
+ * @author Collabora, Ltd.
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_defines.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * The state that is published, padded to a whole number of 32 bit words.
+ *
+ * @ingroup aux_util
+ */
+struct u_pose_publisher_state
+{
+	//! When @p relation was valid.
+	timepoint_ns timestamp_ns;
+
+	struct xrt_space_relation relation;
+
+	//! Has anything been published.
+	uint32_t published;
+	uint32_t _pad;
+};
+
+/*!
+ * Publishes the latest fused pose of a device from the thread that reads
+ * the device, typically at IMU rate, to any number of threads calling
+ * @ref xrt_device::get_tracked_pose without them contending on a lock.
+ *
+ * This is a sequence counter with two copies of the state, a latch, so a
+ * writer that gets preempted halfway through publishing never blocks the
+ * readers, they read the other copy. A reader only retries if a whole new
+ * state was published while it was copying. There must only be one writer
+ * at a time, any number of readers are fine.
+ *
+ * Zero initialise it, or use @ref u_pose_publisher_init.
+ *
+ * @ingroup aux_util
+ */
+struct u_pose_publisher
+{
+	uint32_t seq;
+	uint32_t slots[2][sizeof(struct u_pose_publisher_state) / sizeof(uint32_t)];
+};
+
+/*!
+ * Reset the publisher to having nothing published.
+ *
+ * @ingroup aux_util
+ */
+void
+u_pose_publisher_init(struct u_pose_publisher *upp);
+
+/*!
+ * Publish a new relation, only one thread may call this at a time.
+ *
+ * @ingroup aux_util
+ */
+void
+u_pose_publisher_publish(struct u_pose_publisher *upp,
+                         timepoint_ns timestamp_ns,
+                         const struct xrt_space_relation *relation);
+
+/*!
+ * Get a consistent copy of the latest published state without blocking the
+ * writer. Returns false, and zeroes @p out_state, if nothing has been
+ * published yet.
+ *
+ * @ingroup aux_util
+ */
+bool
+u_pose_publisher_read(const struct u_pose_publisher *upp, struct u_pose_publisher_state *out_state);
+
+/*!
+ * Read the latest published relation and predict it to @p at_timestamp_ns
+ * with @ref m_predict_relation, on the calling thread. Gives a zeroed
+ * relation if nothing has been published yet.
+ *
+ * @ingroup aux_util
+ */
+void
+u_pose_publisher_get(const struct u_pose_publisher *upp,
+                     timepoint_ns at_timestamp_ns,
+                     struct xrt_space_relation *out_relation);
+
+
+#ifdef __cplusplus
+}
+#endif
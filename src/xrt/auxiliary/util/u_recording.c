@@ -0,0 +1,663 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Recording and replay of frame streams with interleaved IMU samples.
+ * @author Collabora, Ltd.
+ * @ingroup aux_util
+ */
+
+#include "os/os_time.h"
+#include "os/os_threading.h"
+
+#include "util/u_var.h"
+#include "util/u_misc.h"
+#include "util/u_logging.h"
+#include "util/u_recording.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+
+/*
+ *
+ * File format.
+ *
+ */
+
+/*!
+ * Header of the file, followed by records.
+ */
+struct u_recording_file_header
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t padding;
+};
+
+/*!
+ * Frame record, followed by @p size bytes of frame data.
+ */
+struct u_recording_frame_record
+{
+	uint32_t width;
+	uint32_t height;
+	uint32_t format;
+	uint32_t stereo_format;
+	uint64_t stride;
+	uint64_t size;
+	uint64_t timestamp;
+	uint64_t source_timestamp;
+	uint64_t source_sequence;
+	uint64_t source_id;
+};
+
+/*!
+ * IMU record.
+ */
+struct u_recording_imu_record
+{
+	uint32_t stream;
+	uint32_t padding;
+	int64_t timestamp_ns;
+	float accel_m_s2[3];
+	float gyro_rad_secs[3];
+};
+
+
+/*
+ *
+ * Writer.
+ *
+ */
+
+struct u_recording_writer
+{
+	struct xrt_frame_node node;
+
+	FILE *file;
+
+	//! Protects the file and the fields below.
+	struct os_mutex mutex;
+
+	//! Set once broken apart, or a write failed.
+	bool stopped;
+
+	uint64_t frames;
+	uint64_t imu_samples;
+};
+
+/*!
+ * Must be called with the mutex held.
+ */
+static void
+write_locked(struct u_recording_writer *w, const void *data, size_t size)
+{
+	if (w->stopped) {
+		return;
+	}
+
+	if (fwrite(data, 1, size, w->file) != size) {
+		U_LOG_E("Failed to write to recording, stopping!");
+		w->stopped = true;
+	}
+}
+
+static void
+writer_break_apart(struct xrt_frame_node *node)
+{
+	struct u_recording_writer *w = container_of(node, struct u_recording_writer, node);
+
+	os_mutex_lock(&w->mutex);
+	w->stopped = true;
+	fflush(w->file);
+	os_mutex_unlock(&w->mutex);
+}
+
+static void
+writer_destroy(struct xrt_frame_node *node)
+{
+	struct u_recording_writer *w = container_of(node, struct u_recording_writer, node);
+
+	u_var_remove_root(w);
+
+	fclose(w->file);
+	os_mutex_destroy(&w->mutex);
+	free(w);
+}
+
+struct u_recording_writer *
+u_recording_writer_create(struct xrt_frame_context *xfctx, const char *path)
+{
+	FILE *file = fopen(path, "wb");
+	if (file == NULL) {
+		U_LOG_E("Could not open '%s' for recording!", path);
+		return NULL;
+	}
+
+	struct u_recording_file_header header = {0};
+	memcpy(header.magic, U_RECORDING_MAGIC, sizeof(header.magic));
+	header.version = U_RECORDING_VERSION;
+
+	if (fwrite(&header, sizeof(header), 1, file) != 1) {
+		U_LOG_E("Could not write header to '%s'!", path);
+		fclose(file);
+		return NULL;
+	}
+
+	struct u_recording_writer *w = U_TYPED_CALLOC(struct u_recording_writer);
+	w->node.break_apart = writer_break_apart;
+	w->node.destroy = writer_destroy;
+	w->file = file;
+
+	if (os_mutex_init(&w->mutex) != 0) {
+		fclose(file);
+		free(w);
+		return NULL;
+	}
+
+	xrt_frame_context_add(xfctx, &w->node);
+
+	u_var_add_root(w, "Recording", true);
+	u_var_add_ro_u64(w, &w->frames, "Frames");
+	u_var_add_ro_u64(w, &w->imu_samples, "IMU samples");
+
+	return w;
+}
+
+void
+u_recording_writer_write_frame(struct u_recording_writer *w, struct xrt_frame *xf)
+{
+	struct u_recording_frame_record record = {
+	    .width = xf->width,
+	    .height = xf->height,
+	    .format = (uint32_t)xf->format,
+	    .stereo_format = (uint32_t)xf->stereo_format,
+	    .stride = xf->stride,
+	    .size = xf->size,
+	    .timestamp = xf->timestamp,
+	    .source_timestamp = xf->source_timestamp,
+	    .source_sequence = xf->source_sequence,
+	    .source_id = xf->source_id,
+	};
+	uint32_t type = U_RECORDING_RECORD_FRAME;
+
+	os_mutex_lock(&w->mutex);
+	write_locked(w, &type, sizeof(type));
+	write_locked(w, &record, sizeof(record));
+	write_locked(w, xf->data, xf->size);
+	if (!w->stopped) {
+		w->frames++;
+	}
+	os_mutex_unlock(&w->mutex);
+}
+
+void
+u_recording_writer_write_imu(struct u_recording_writer *w,
+                             uint32_t stream,
+                             timepoint_ns timestamp_ns,
+                             struct xrt_tracking_sample *sample)
+{
+	struct u_recording_imu_record record = {
+	    .stream = stream,
+	    .timestamp_ns = timestamp_ns,
+	    .accel_m_s2 = {sample->accel_m_s2.x, sample->accel_m_s2.y, sample->accel_m_s2.z},
+	    .gyro_rad_secs = {sample->gyro_rad_secs.x, sample->gyro_rad_secs.y, sample->gyro_rad_secs.z},
+	};
+	uint32_t type = U_RECORDING_RECORD_IMU;
+
+	os_mutex_lock(&w->mutex);
+	write_locked(w, &type, sizeof(type));
+	write_locked(w, &record, sizeof(record));
+	if (!w->stopped) {
+		w->imu_samples++;
+	}
+	os_mutex_unlock(&w->mutex);
+}
+
+
+/*
+ *
+ * Recorder sink.
+ *
+ */
+
+/*!
+ * An @ref xrt_frame_sink that writes frames to a recording.
+ *
+ * @implements xrt_frame_sink
+ * @implements xrt_frame_node
+ */
+struct u_sink_recorder
+{
+	struct xrt_frame_sink base;
+	struct xrt_frame_node node;
+
+	struct u_recording_writer *writer;
+	struct xrt_frame_sink *downstream;
+};
+
+static void
+recorder_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
+{
+	struct u_sink_recorder *r = (struct u_sink_recorder *)xfs;
+
+	u_recording_writer_write_frame(r->writer, xf);
+
+	if (r->downstream != NULL) {
+		r->downstream->push_frame(r->downstream, xf);
+	}
+}
+
+static void
+recorder_break_apart(struct xrt_frame_node *node)
+{}
+
+static void
+recorder_destroy(struct xrt_frame_node *node)
+{
+	struct u_sink_recorder *r = container_of(node, struct u_sink_recorder, node);
+
+	free(r);
+}
+
+void
+u_sink_recorder_create(struct xrt_frame_context *xfctx,
+                       struct u_recording_writer *w,
+                       struct xrt_frame_sink *downstream,
+                       struct xrt_frame_sink **out_xfs)
+{
+	struct u_sink_recorder *r = U_TYPED_CALLOC(struct u_sink_recorder);
+
+	r->base.push_frame = recorder_frame;
+	r->node.break_apart = recorder_break_apart;
+	r->node.destroy = recorder_destroy;
+	r->writer = w;
+	r->downstream = downstream;
+
+	xrt_frame_context_add(xfctx, &r->node);
+
+	*out_xfs = &r->base;
+}
+
+
+/*
+ *
+ * Replay frameserver.
+ *
+ */
+
+/*!
+ * A @ref xrt_fs that replays a recording.
+ *
+ * @implements xrt_fs
+ * @implements xrt_frame_node
+ */
+struct u_recording_fs
+{
+	struct xrt_fs base;
+	struct xrt_frame_node node;
+
+	//! Replay thread, also protects the fields below.
+	struct os_thread_helper oth;
+
+	FILE *file;
+
+	//! Where the first record starts.
+	long records_offset;
+
+	//! The one mode, from the first frame.
+	struct xrt_fs_mode mode;
+
+	struct u_recording_fs_params params;
+
+	struct xrt_frame_sink *sink;
+
+	//! The end of the recording has been reached.
+	bool finished;
+
+	struct u_recording_fs_stats stats;
+};
+
+static inline struct u_recording_fs *
+u_recording_fs(struct xrt_fs *xfs)
+{
+	return (struct u_recording_fs *)xfs;
+}
+
+static void
+free_replayed_frame(struct xrt_frame *xf)
+{
+	assert(xf->reference.count == 0);
+	free(xf->data);
+	free(xf);
+}
+
+/*!
+ * Reads the next record, frames are returned with a reference in @p out_xf.
+ */
+static enum u_recording_record_type
+read_record(struct u_recording_fs *rfs,
+            struct xrt_frame **out_xf,
+            struct u_recording_imu_record *out_imu,
+            struct u_recording_frame_record *out_frame)
+{
+	uint32_t type = 0;
+	if (fread(&type, sizeof(type), 1, rfs->file) != 1) {
+		return U_RECORDING_RECORD_NONE;
+	}
+
+	switch (type) {
+	case U_RECORDING_RECORD_IMU:
+		if (fread(out_imu, sizeof(*out_imu), 1, rfs->file) != 1) {
+			return U_RECORDING_RECORD_NONE;
+		}
+		return U_RECORDING_RECORD_IMU;
+	case U_RECORDING_RECORD_FRAME: break;
+	default: U_LOG_E("Unknown record type %u in recording!", type); return U_RECORDING_RECORD_NONE;
+	}
+
+	if (fread(out_frame, sizeof(*out_frame), 1, rfs->file) != 1) {
+		return U_RECORDING_RECORD_NONE;
+	}
+
+	// Only peeking, skip the data.
+	if (out_xf == NULL) {
+		if (fseek(rfs->file, (long)out_frame->size, SEEK_CUR) != 0) {
+			return U_RECORDING_RECORD_NONE;
+		}
+		return U_RECORDING_RECORD_FRAME;
+	}
+
+	struct xrt_frame *xf = U_TYPED_CALLOC(struct xrt_frame);
+	xf->destroy = free_replayed_frame;
+	xf->width = out_frame->width;
+	xf->height = out_frame->height;
+	xf->stride = out_frame->stride;
+	xf->size = out_frame->size;
+	xf->format = (enum xrt_format)out_frame->format;
+	xf->stereo_format = (enum xrt_stereo_format)out_frame->stereo_format;
+	xf->timestamp = out_frame->timestamp;
+	xf->source_timestamp = out_frame->source_timestamp;
+	xf->source_sequence = out_frame->source_sequence;
+	xf->source_id = rfs->base.source_id;
+	xf->data = U_TYPED_ARRAY_CALLOC(uint8_t, xf->size);
+
+	if (fread(xf->data, 1, xf->size, rfs->file) != xf->size) {
+		free(xf->data);
+		free(xf);
+		return U_RECORDING_RECORD_NONE;
+	}
+
+	xrt_frame_reference(out_xf, xf);
+
+	return U_RECORDING_RECORD_FRAME;
+}
+
+/*!
+ * Sleep until @p timestamp_ns in the recording is due, in realtime mode.
+ */
+static void
+pace(struct u_recording_fs *rfs, uint64_t timestamp_ns, uint64_t *first_ts, uint64_t start_ns)
+{
+	if (!rfs->params.realtime) {
+		return;
+	}
+
+	if (*first_ts == 0) {
+		*first_ts = timestamp_ns;
+		return;
+	}
+
+	// Out of order samples are delivered right away.
+	if (timestamp_ns <= *first_ts) {
+		return;
+	}
+
+	uint64_t due_ns = start_ns + (timestamp_ns - *first_ts);
+	uint64_t now_ns = os_monotonic_get_ns();
+	if (due_ns > now_ns) {
+		os_nanosleep((long)(due_ns - now_ns));
+	}
+}
+
+static void *
+replay_run(void *ptr)
+{
+	struct u_recording_fs *rfs = (struct u_recording_fs *)ptr;
+	uint64_t start_ns = os_monotonic_get_ns();
+	uint64_t first_ts = 0;
+
+	os_thread_helper_lock(&rfs->oth);
+
+	while (os_thread_helper_is_running_locked(&rfs->oth)) {
+		os_thread_helper_unlock(&rfs->oth);
+
+		struct xrt_frame *xf = NULL;
+		struct u_recording_imu_record imu;
+		struct u_recording_frame_record frame;
+
+		uint64_t read_start_ns = os_monotonic_get_ns();
+		enum u_recording_record_type type = read_record(rfs, &xf, &imu, &frame);
+		uint64_t read_ns = os_monotonic_get_ns() - read_start_ns;
+		uint64_t push_ns = 0;
+
+		if (type == U_RECORDING_RECORD_FRAME) {
+			pace(rfs, xf->timestamp, &first_ts, start_ns);
+
+			uint64_t push_start_ns = os_monotonic_get_ns();
+			rfs->sink->push_frame(rfs->sink, xf);
+			push_ns = os_monotonic_get_ns() - push_start_ns;
+
+			xrt_frame_reference(&xf, NULL);
+		} else if (type == U_RECORDING_RECORD_IMU) {
+			pace(rfs, (uint64_t)imu.timestamp_ns, &first_ts, start_ns);
+
+			struct xrt_tracking_sample sample = {
+			    .accel_m_s2 = {imu.accel_m_s2[0], imu.accel_m_s2[1], imu.accel_m_s2[2]},
+			    .gyro_rad_secs = {imu.gyro_rad_secs[0], imu.gyro_rad_secs[1], imu.gyro_rad_secs[2]},
+			};
+
+			if (rfs->params.imu_func != NULL) {
+				rfs->params.imu_func(rfs->params.imu_ptr, imu.stream, imu.timestamp_ns, &sample);
+			}
+		}
+
+		os_thread_helper_lock(&rfs->oth);
+
+		rfs->stats.read_ns += read_ns;
+		rfs->stats.push_ns += push_ns;
+		if (push_ns > rfs->stats.push_max_ns) {
+			rfs->stats.push_max_ns = push_ns;
+		}
+
+		if (type == U_RECORDING_RECORD_FRAME) {
+			rfs->stats.frames++;
+		} else if (type == U_RECORDING_RECORD_IMU) {
+			rfs->stats.imu_samples++;
+		} else {
+			// End of the recording, or it is truncated.
+			break;
+		}
+	}
+
+	rfs->finished = true;
+	rfs->stats.duration_ns = os_monotonic_get_ns() - start_ns;
+
+	os_thread_helper_unlock(&rfs->oth);
+
+	return NULL;
+}
+
+static bool
+replay_enumerate_modes(struct xrt_fs *xfs, struct xrt_fs_mode **out_modes, uint32_t *out_count)
+{
+	struct u_recording_fs *rfs = u_recording_fs(xfs);
+
+	struct xrt_fs_mode *modes = U_TYPED_ARRAY_CALLOC(struct xrt_fs_mode, 1);
+	if (modes == NULL) {
+		return false;
+	}
+
+	modes[0] = rfs->mode;
+
+	*out_modes = modes;
+	*out_count = 1;
+
+	return true;
+}
+
+static bool
+replay_configure_capture(struct xrt_fs *xfs, struct xrt_fs_capture_parameters *cp)
+{
+	// Nothing to configure on a recording.
+	return false;
+}
+
+static bool
+replay_stream_start(struct xrt_fs *xfs,
+                    struct xrt_frame_sink *xs,
+                    enum xrt_fs_capture_type capture_type,
+                    uint32_t descriptor_index)
+{
+	struct u_recording_fs *rfs = u_recording_fs(xfs);
+
+	if (fseek(rfs->file, rfs->records_offset, SEEK_SET) != 0) {
+		return false;
+	}
+
+	rfs->sink = xs;
+	rfs->finished = false;
+	U_ZERO(&rfs->stats);
+
+	return os_thread_helper_start(&rfs->oth, replay_run, rfs) == 0;
+}
+
+static bool
+replay_stream_stop(struct xrt_fs *xfs)
+{
+	struct u_recording_fs *rfs = u_recording_fs(xfs);
+
+	os_thread_helper_stop(&rfs->oth);
+
+	return true;
+}
+
+static bool
+replay_is_running(struct xrt_fs *xfs)
+{
+	struct u_recording_fs *rfs = u_recording_fs(xfs);
+
+	os_thread_helper_lock(&rfs->oth);
+	bool running = os_thread_helper_is_running_locked(&rfs->oth) && !rfs->finished;
+	os_thread_helper_unlock(&rfs->oth);
+
+	return running;
+}
+
+static void
+replay_node_break_apart(struct xrt_frame_node *node)
+{
+	struct u_recording_fs *rfs = container_of(node, struct u_recording_fs, node);
+
+	replay_stream_stop(&rfs->base);
+}
+
+static void
+replay_node_destroy(struct xrt_frame_node *node)
+{
+	struct u_recording_fs *rfs = container_of(node, struct u_recording_fs, node);
+
+	u_var_remove_root(rfs);
+
+	os_thread_helper_destroy(&rfs->oth);
+	fclose(rfs->file);
+	free(rfs);
+}
+
+struct xrt_fs *
+u_recording_fs_open(struct xrt_frame_context *xfctx, const char *path, const struct u_recording_fs_params *params)
+{
+	FILE *file = fopen(path, "rb");
+	if (file == NULL) {
+		U_LOG_E("Could not open recording '%s'!", path);
+		return NULL;
+	}
+
+	struct u_recording_file_header header = {0};
+	if (fread(&header, sizeof(header), 1, file) != 1 ||
+	    memcmp(header.magic, U_RECORDING_MAGIC, sizeof(header.magic)) != 0) {
+		U_LOG_E("'%s' is not a recording!", path);
+		fclose(file);
+		return NULL;
+	}
+
+	if (header.version != U_RECORDING_VERSION) {
+		U_LOG_E("Recording '%s' has version %u, expected %u!", path, header.version, U_RECORDING_VERSION);
+		fclose(file);
+		return NULL;
+	}
+
+	struct u_recording_fs *rfs = U_TYPED_CALLOC(struct u_recording_fs);
+	rfs->file = file;
+	rfs->records_offset = ftell(file);
+	rfs->params = *params;
+
+	// Find the first frame for the mode.
+	enum u_recording_record_type type;
+	struct u_recording_imu_record imu;
+	struct u_recording_frame_record frame;
+	do {
+		type = read_record(rfs, NULL, &imu, &frame);
+	} while (type == U_RECORDING_RECORD_IMU);
+
+	if (type != U_RECORDING_RECORD_FRAME) {
+		U_LOG_E("Recording '%s' has no frames!", path);
+		fclose(file);
+		free(rfs);
+		return NULL;
+	}
+
+	rfs->mode.width = frame.width;
+	rfs->mode.height = frame.height;
+	rfs->mode.format = (enum xrt_format)frame.format;
+	rfs->mode.stereo_format = (enum xrt_stereo_format)frame.stereo_format;
+
+	if (os_thread_helper_init(&rfs->oth) != 0) {
+		fclose(file);
+		free(rfs);
+		return NULL;
+	}
+
+	snprintf(rfs->base.name, sizeof(rfs->base.name), "%s", path);
+	snprintf(rfs->base.product, sizeof(rfs->base.product), "Recording");
+	snprintf(rfs->base.manufacturer, sizeof(rfs->base.manufacturer), "Monado");
+	rfs->base.enumerate_modes = replay_enumerate_modes;
+	rfs->base.configure_capture = replay_configure_capture;
+	rfs->base.stream_start = replay_stream_start;
+	rfs->base.stream_stop = replay_stream_stop;
+	rfs->base.is_running = replay_is_running;
+	rfs->node.break_apart = replay_node_break_apart;
+	rfs->node.destroy = replay_node_destroy;
+
+	xrt_frame_context_add(xfctx, &rfs->node);
+
+	u_var_add_root(rfs, "Recording Frameserver", true);
+	u_var_add_ro_text(rfs, rfs->base.name, "File");
+	u_var_add_bool(rfs, &rfs->params.realtime, "Realtime");
+	u_var_add_ro_u64(rfs, &rfs->stats.frames, "Frames");
+	u_var_add_ro_u64(rfs, &rfs->stats.imu_samples, "IMU samples");
+
+	return &rfs->base;
+}
+
+void
+u_recording_fs_get_stats(struct xrt_fs *xfs, struct u_recording_fs_stats *out_stats)
+{
+	struct u_recording_fs *rfs = u_recording_fs(xfs);
+
+	os_thread_helper_lock(&rfs->oth);
+	*out_stats = rfs->stats;
+	os_thread_helper_unlock(&rfs->oth);
+}
@@ -0,0 +1,187 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Recording and replay of frame streams with interleaved IMU samples.
+ * @author Collabora, Ltd.
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_frame.h"
+#include "xrt/xrt_tracking.h"
+#include "xrt/xrt_frameserver.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * @defgroup aux_recording Frame and IMU recording
+ * @ingroup aux_util
+ *
+ * @brief A simple capture file format for frames and IMU samples.
+ *
+ * The file starts with @ref U_RECORDING_MAGIC and a version, followed by a
+ * list of records in the order they were written. Every record starts with
+ * a @ref u_recording_record_type. Frame records hold all of the @ref
+ * xrt_frame metadata followed by the raw frame data, IMU records hold a
+ * @ref xrt_tracking_sample tagged with a stream id. All values are stored in
+ * host byte order, the files are meant for benchmarking and regression
+ * testing on the machine, or at least architecture, they were made on.
+ */
+
+//! Magic at the start of every recording file.
+#define U_RECORDING_MAGIC "XRTREC\0\0"
+
+//! Version of the recording file format.
+#define U_RECORDING_VERSION 1
+
+/*!
+ * Type of a record in a recording.
+ *
+ * @ingroup aux_recording
+ */
+enum u_recording_record_type
+{
+	U_RECORDING_RECORD_NONE = 0,
+	U_RECORDING_RECORD_FRAME = 1,
+	U_RECORDING_RECORD_IMU = 2,
+};
+
+/*!
+ * Well known IMU stream ids, used for recordings of the camera trackers.
+ *
+ * @ingroup aux_recording
+ */
+enum u_recording_imu_stream
+{
+	U_RECORDING_IMU_STREAM_PSVR = 0,
+	U_RECORDING_IMU_STREAM_PSMV_0 = 1,
+	U_RECORDING_IMU_STREAM_PSMV_1 = 2,
+};
+
+/*!
+ * Called by the replay for every IMU sample, on the replay thread and in
+ * order with the frames.
+ *
+ * @ingroup aux_recording
+ */
+typedef void (*u_recording_imu_func)(void *ptr,
+                                     uint32_t stream,
+                                     timepoint_ns timestamp_ns,
+                                     struct xrt_tracking_sample *sample);
+
+/*!
+ * Writes frames and IMU samples to a recording file, safe to call from
+ * multiple threads. It is a node in the @ref xrt_frame_context it was
+ * created with and closes the file when the context is destroyed, anything
+ * written after the context has been broken apart is ignored.
+ *
+ * @ingroup aux_recording
+ */
+struct u_recording_writer;
+
+/*!
+ * Create a writer for a new recording at @p path.
+ *
+ * @ingroup aux_recording
+ */
+struct u_recording_writer *
+u_recording_writer_create(struct xrt_frame_context *xfctx, const char *path);
+
+/*!
+ * Write a frame record.
+ *
+ * @ingroup aux_recording
+ */
+void
+u_recording_writer_write_frame(struct u_recording_writer *w, struct xrt_frame *xf);
+
+/*!
+ * Write a IMU record.
+ *
+ * @ingroup aux_recording
+ */
+void
+u_recording_writer_write_imu(struct u_recording_writer *w,
+                             uint32_t stream,
+                             timepoint_ns timestamp_ns,
+                             struct xrt_tracking_sample *sample);
+
+/*!
+ * An @ref xrt_frame_sink that writes all frames to @p w and then passes
+ * them on to @p downstream, which may be NULL.
+ *
+ * @ingroup aux_recording
+ */
+void
+u_sink_recorder_create(struct xrt_frame_context *xfctx,
+                       struct u_recording_writer *w,
+                       struct xrt_frame_sink *downstream,
+                       struct xrt_frame_sink **out_xfs);
+
+/*!
+ * Parameters for @ref u_recording_fs_open.
+ *
+ * @ingroup aux_recording
+ */
+struct u_recording_fs_params
+{
+	//! Keep the recorded pace, otherwise replay as fast as possible.
+	bool realtime;
+
+	//! Optional, gets all of the IMU samples in the recording.
+	u_recording_imu_func imu_func;
+	void *imu_ptr;
+};
+
+/*!
+ * Statistics of a replay, valid once @ref xrt_fs::is_running returns false.
+ *
+ * @ingroup aux_recording
+ */
+struct u_recording_fs_stats
+{
+	uint64_t frames;
+	uint64_t imu_samples;
+
+	//! Wall time from stream start to the end of the recording.
+	uint64_t duration_ns;
+
+	//! Time spent reading records from the file.
+	uint64_t read_ns;
+
+	//! Time spent in the downstream sink, summed over all frames.
+	uint64_t push_ns;
+
+	//! Longest time spent in the downstream sink for one frame.
+	uint64_t push_max_ns;
+};
+
+/*!
+ * Create a @ref xrt_fs that replays a recording. It has one mode matching
+ * the first frame, frames keep their recorded timestamps and sequence numbers
+ * so that replays are deterministic regardless of pace. The stream stops
+ * by itself once the end of the recording is reached.
+ *
+ * @ingroup aux_recording
+ */
+struct xrt_fs *
+u_recording_fs_open(struct xrt_frame_context *xfctx, const char *path, const struct u_recording_fs_params *params);
+
+/*!
+ * Get the statistics of a replay created with @ref u_recording_fs_open.
+ *
+ * @ingroup aux_recording
+ */
+void
+u_recording_fs_get_stats(struct xrt_fs *xfs, struct u_recording_fs_stats *out_stats);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -25,6 +25,43 @@ struct u_sink_quirk_params
 	bool leap_motion;
 };
 
+/*!
+ * What a queue sink does with a new frame when it is full.
+ *
+ * @see u_sink_queue_params
+ */
+enum u_sink_queue_policy
+{
+	//! Drop the oldest queued frame to make room for the new one.
+	U_SINK_QUEUE_POLICY_DROP_OLDEST,
+	//! Drop the new frame, keeping the ones already queued.
+	U_SINK_QUEUE_POLICY_DROP_NEWEST,
+	//! Block the producer until there is room in the queue.
+	U_SINK_QUEUE_POLICY_BLOCK_PRODUCER,
+};
+
+/*!
+ * @see u_sink_queue_create_with_params
+ */
+struct u_sink_queue_params
+{
+	//! Number of frames that can be queued, zero is treated as one.
+	uint32_t depth;
+
+	enum u_sink_queue_policy policy;
+};
+
+/*!
+ * @see u_sink_fanout_create
+ */
+struct u_sink_fanout_branch_params
+{
+	struct xrt_frame_sink *sink;
+
+	//! What to do when this branch has not finished the previous frame.
+	enum u_sink_queue_policy policy;
+};
+
 /*!
  * @public @memberof xrt_frame_sink
  * @see xrt_frame_context
@@ -88,6 +125,50 @@ u_sink_queue_create(struct xrt_frame_context *xfctx,
                     struct xrt_frame_sink *downstream,
                     struct xrt_frame_sink **out_xfs);
 
+/*!
+ * @public @memberof xrt_frame_sink
+ * @see xrt_frame_context
+ * @see u_sink_queue_params
+ */
+bool
+u_sink_queue_create_with_params(struct xrt_frame_context *xfctx,
+                                struct xrt_frame_sink *downstream,
+                                const struct u_sink_queue_params *params,
+                                struct xrt_frame_sink **out_xfs);
+
+/*!
+ * Pushes each frame to all of the @p branches, the pushes are done on a pool
+ * of @p num_threads worker threads so a slow branch does not hold up the
+ * producer or the other branches. Each branch has one slot for a frame
+ * waiting on it, the policy of the branch decides what happens when a new
+ * frame arrives and that slot is taken. Zero threads means one per branch.
+ *
+ * @public @memberof xrt_frame_sink
+ * @see xrt_frame_context
+ */
+bool
+u_sink_fanout_create(struct xrt_frame_context *xfctx,
+                     const struct u_sink_fanout_branch_params *branches,
+                     uint32_t num_branches,
+                     uint32_t num_threads,
+                     struct xrt_frame_sink **out_xfs);
+
+/*!
+ * Decodes MJPEG frames into @p f, which must be either R8G8B8 or YUV888, on
+ * @p num_threads worker threads each with its own decompressor. Decoded
+ * frames are pushed downstream in the same order they arrived, new frames
+ * are dropped when all threads are busy and the pipeline is full.
+ *
+ * @public @memberof xrt_frame_sink
+ * @see xrt_frame_context
+ */
+bool
+u_sink_mjpeg_decoder_create(struct xrt_frame_context *xfctx,
+                            enum xrt_format f,
+                            uint32_t num_threads,
+                            struct xrt_frame_sink *downstream,
+                            struct xrt_frame_sink **out_xfs);
+
 /*!
  * @public @memberof xrt_frame_sink
  * @see xrt_frame_context
@@ -98,6 +179,20 @@ u_sink_quirk_create(struct xrt_frame_context *xfctx,
                     struct u_sink_quirk_params *params,
                     struct xrt_frame_sink **out_xfs);
 
+/*!
+ * Splits side-by-side or over-and-under stereo frames into one frame for each
+ * view, following @ref xrt_frame::stereo_format. The view frames point into
+ * the original frame, which is kept alive as long as any view is.
+ *
+ * @public @memberof xrt_frame_sink
+ * @see xrt_frame_context
+ */
+void
+u_sink_stereo_sbs_split_create(struct xrt_frame_context *xfctx,
+                               struct xrt_frame_sink *left,
+                               struct xrt_frame_sink *right,
+                               struct xrt_frame_sink **out_xfs);
+
 /*!
  * @public @memberof xrt_frame_sink
  * @see xrt_frame_context
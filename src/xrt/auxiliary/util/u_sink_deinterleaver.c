@@ -10,7 +10,7 @@
 
 #include "util/u_misc.h"
 #include "util/u_sink.h"
-#include "util/u_frame.h"
+#include "util/u_frame_pool.h"
 
 
 /*!
@@ -24,6 +24,9 @@ struct u_sink_deinterleaver
 	struct xrt_frame_node node;
 
 	struct xrt_frame_sink *downstream;
+
+	//! Deinterleaved frames are allocated from here.
+	struct u_frame_pool *pool;
 };
 
 
@@ -87,7 +90,10 @@ deinterleaves_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
 	const uint8_t *data = xf->data;
 	struct xrt_frame *frame = NULL;
 
-	u_frame_create_one_off(format, w, h, &frame);
+	u_frame_pool_create_frame(de->pool, format, w, h, &frame);
+	if (frame == NULL) {
+		return;
+	}
 
 	// Copy directly from original frame.
 	frame->timestamp = xf->timestamp;
@@ -115,6 +121,8 @@ destroy(struct xrt_frame_node *node)
 {
 	struct u_sink_deinterleaver *de = container_of(node, struct u_sink_deinterleaver, node);
 
+	u_frame_pool_destroy(&de->pool);
+
 	free(de);
 }
 
@@ -136,6 +144,9 @@ u_sink_deinterleaver_create(struct xrt_frame_context *xfctx,
 	de->node.break_apart = break_apart;
 	de->node.destroy = destroy;
 	de->downstream = downstream;
+	u_frame_pool_create(&de->pool, "Deinterleaver frame pool", U_FRAME_POOL_DEFAULT_MAX_FREE);
+
+	xrt_frame_context_add(xfctx, &de->node);
 
 	*out_xfs = &de->base;
 }
@@ -0,0 +1,337 @@
+// Copyright 2019-2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  An @ref xrt_frame_sink that fans out frames on a worker pool.
+ * @author Collabora, Ltd.
+ * @ingroup aux_util
+ */
+
+#include "util/u_var.h"
+#include "util/u_misc.h"
+#include "util/u_sink.h"
+#include "util/u_logging.h"
+
+#include <stdio.h>
+#include <pthread.h>
+
+
+/*!
+ * One downstream sink of the @ref u_sink_fanout, a branch only ever runs on
+ * one worker at the time so the downstream sink doesn't need to be reentrant.
+ */
+struct u_sink_fanout_branch
+{
+	struct xrt_frame_sink *sink;
+
+	enum u_sink_queue_policy policy;
+
+	//! Frame waiting to be pushed on this branch, holds a reference.
+	struct xrt_frame *pending;
+
+	//! A worker is currently pushing a frame on this branch.
+	bool busy;
+
+	struct
+	{
+		uint64_t delivered;
+		uint64_t dropped;
+	} stats;
+};
+
+/*!
+ * An @ref xrt_frame_sink that pushes frames to multiple downstream sinks,
+ * each push is done on a worker pool shared by all branches. Each branch
+ * holds a reference to the frame until it is done with it.
+ *
+ * @implements xrt_frame_sink
+ * @implements xrt_frame_node
+ */
+struct u_sink_fanout
+{
+	struct xrt_frame_sink base;
+	struct xrt_frame_node node;
+
+	struct u_sink_fanout_branch *branches;
+	uint32_t num_branches;
+
+	pthread_t *threads;
+	uint32_t num_threads;
+
+	pthread_mutex_t mutex;
+
+	//! Signaled when a branch may have become ready for a worker.
+	pthread_cond_t work_cond;
+
+	//! Signaled when a branch has finished a frame.
+	pthread_cond_t done_cond;
+
+	//! Where the workers starts looking for work, for fairness.
+	uint32_t next_branch;
+
+	bool running;
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+/*!
+ * Must be called with the mutex held.
+ */
+static struct u_sink_fanout_branch *
+find_ready_branch_locked(struct u_sink_fanout *f)
+{
+	for (uint32_t i = 0; i < f->num_branches; i++) {
+		uint32_t index = (f->next_branch + i) % f->num_branches;
+		struct u_sink_fanout_branch *b = &f->branches[index];
+
+		if (b->pending != NULL && !b->busy) {
+			f->next_branch = (index + 1) % f->num_branches;
+			return b;
+		}
+	}
+
+	return NULL;
+}
+
+static void *
+fanout_run(void *ptr)
+{
+	struct u_sink_fanout *f = (struct u_sink_fanout *)ptr;
+
+	pthread_mutex_lock(&f->mutex);
+
+	while (f->running) {
+		struct u_sink_fanout_branch *b = find_ready_branch_locked(f);
+
+		// No work, wait.
+		if (b == NULL) {
+			pthread_cond_wait(&f->work_cond, &f->mutex);
+			continue;
+		}
+
+		// Take the frame and its reference off the branch.
+		struct xrt_frame *frame = b->pending;
+		b->pending = NULL;
+		b->busy = true;
+
+		// Unlock the mutex when we do the work.
+		pthread_mutex_unlock(&f->mutex);
+
+		b->sink->push_frame(b->sink, frame);
+
+		// Drop our reference, once all branches are done the frame is freed.
+		xrt_frame_reference(&frame, NULL);
+
+		pthread_mutex_lock(&f->mutex);
+
+		b->busy = false;
+		b->stats.delivered++;
+
+		// A new frame might have been queued while we were busy.
+		if (b->pending != NULL) {
+			pthread_cond_signal(&f->work_cond);
+		}
+
+		// Wake up any producer blocked on this branch.
+		pthread_cond_broadcast(&f->done_cond);
+	}
+
+	pthread_mutex_unlock(&f->mutex);
+
+	return NULL;
+}
+
+static void
+fanout_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
+{
+	struct u_sink_fanout *f = (struct u_sink_fanout *)xfs;
+
+	pthread_mutex_lock(&f->mutex);
+
+	for (uint32_t i = 0; i < f->num_branches && f->running; i++) {
+		struct u_sink_fanout_branch *b = &f->branches[i];
+
+		if (b->pending != NULL) {
+			switch (b->policy) {
+			case U_SINK_QUEUE_POLICY_DROP_NEWEST: b->stats.dropped++; continue;
+			case U_SINK_QUEUE_POLICY_BLOCK_PRODUCER:
+				while (f->running && b->pending != NULL) {
+					pthread_cond_wait(&f->done_cond, &f->mutex);
+				}
+				break;
+			case U_SINK_QUEUE_POLICY_DROP_OLDEST:
+			default:
+				// Replaced below, releasing the reference.
+				b->stats.dropped++;
+				break;
+			}
+		}
+
+		if (!f->running) {
+			break;
+		}
+
+		xrt_frame_reference(&b->pending, xf);
+	}
+
+	// Wake up enough workers for the branches.
+	pthread_cond_broadcast(&f->work_cond);
+
+	pthread_mutex_unlock(&f->mutex);
+}
+
+static void
+break_apart(struct xrt_frame_node *node)
+{
+	struct u_sink_fanout *f = container_of(node, struct u_sink_fanout, node);
+	void *retval = NULL;
+
+	// The fields are protected.
+	pthread_mutex_lock(&f->mutex);
+
+	// Stop the threads and inhibit any new frames to be added.
+	f->running = false;
+
+	// Release any frames waiting for submission.
+	for (uint32_t i = 0; i < f->num_branches; i++) {
+		xrt_frame_reference(&f->branches[i].pending, NULL);
+	}
+
+	// Wake up the workers and any blocked producer.
+	pthread_cond_broadcast(&f->work_cond);
+	pthread_cond_broadcast(&f->done_cond);
+
+	// No longer need to protect fields.
+	pthread_mutex_unlock(&f->mutex);
+
+	// Wait for threads to finish.
+	for (uint32_t i = 0; i < f->num_threads; i++) {
+		pthread_join(f->threads[i], &retval);
+	}
+	f->num_threads = 0;
+}
+
+static void
+destroy(struct xrt_frame_node *node)
+{
+	struct u_sink_fanout *f = container_of(node, struct u_sink_fanout, node);
+
+	u_var_remove_root(f);
+
+	// Destroy resources.
+	pthread_mutex_destroy(&f->mutex);
+	pthread_cond_destroy(&f->work_cond);
+	pthread_cond_destroy(&f->done_cond);
+	free(f->branches);
+	free(f->threads);
+	free(f);
+}
+
+
+/*
+ *
+ * Exported functions.
+ *
+ */
+
+bool
+u_sink_fanout_create(struct xrt_frame_context *xfctx,
+                     const struct u_sink_fanout_branch_params *branches,
+                     uint32_t num_branches,
+                     uint32_t num_threads,
+                     struct xrt_frame_sink **out_xfs)
+{
+	if (num_branches == 0) {
+		U_LOG_E("Need at least one branch!");
+		return false;
+	}
+
+	struct u_sink_fanout *f = U_TYPED_CALLOC(struct u_sink_fanout);
+	int ret = 0;
+
+	f->base.push_frame = fanout_frame;
+	f->node.break_apart = break_apart;
+	f->node.destroy = destroy;
+	f->running = true;
+
+	f->num_branches = num_branches;
+	f->branches = U_TYPED_ARRAY_CALLOC(struct u_sink_fanout_branch, num_branches);
+	for (uint32_t i = 0; i < num_branches; i++) {
+		f->branches[i].sink = branches[i].sink;
+		f->branches[i].policy = branches[i].policy;
+	}
+
+	// More threads then branches would never have anything to do.
+	if (num_threads == 0 || num_threads > num_branches) {
+		num_threads = num_branches;
+	}
+	f->threads = U_TYPED_ARRAY_CALLOC(pthread_t, num_threads);
+
+	ret = pthread_mutex_init(&f->mutex, NULL);
+	if (ret != 0) {
+		free(f->threads);
+		free(f->branches);
+		free(f);
+		return false;
+	}
+
+	ret = pthread_cond_init(&f->work_cond, NULL);
+	if (ret != 0) {
+		pthread_mutex_destroy(&f->mutex);
+		free(f->threads);
+		free(f->branches);
+		free(f);
+		return false;
+	}
+
+	ret = pthread_cond_init(&f->done_cond, NULL);
+	if (ret != 0) {
+		pthread_cond_destroy(&f->work_cond);
+		pthread_mutex_destroy(&f->mutex);
+		free(f->threads);
+		free(f->branches);
+		free(f);
+		return false;
+	}
+
+	for (uint32_t i = 0; i < num_threads; i++) {
+		ret = pthread_create(&f->threads[i], NULL, fanout_run, f);
+		if (ret != 0) {
+			U_LOG_E("Failed to create worker thread %u!", i);
+			break;
+		}
+		f->num_threads++;
+	}
+
+	// Run with the threads we got, but we need at least one.
+	if (f->num_threads == 0) {
+		pthread_cond_destroy(&f->done_cond);
+		pthread_cond_destroy(&f->work_cond);
+		pthread_mutex_destroy(&f->mutex);
+		free(f->threads);
+		free(f->branches);
+		free(f);
+		return false;
+	}
+
+	u_var_add_root(f, "Fan-out sink", true);
+	u_var_add_ro_u32(f, &f->num_threads, "Worker threads");
+	for (uint32_t i = 0; i < num_branches; i++) {
+		char tmp[64];
+		snprintf(tmp, sizeof(tmp), "Branch %u delivered", i);
+		u_var_add_ro_u64(f, &f->branches[i].stats.delivered, tmp);
+		snprintf(tmp, sizeof(tmp), "Branch %u dropped", i);
+		u_var_add_ro_u64(f, &f->branches[i].stats.dropped, tmp);
+	}
+
+	xrt_frame_context_add(xfctx, &f->node);
+
+	*out_xfs = &f->base;
+
+	return true;
+}
@@ -0,0 +1,566 @@
+// Copyright 2019-2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  An @ref xrt_frame_sink that decodes MJPEG frames on worker threads.
+ * @author Collabora, Ltd.
+ * @ingroup aux_util
+ */
+
+#include "xrt/xrt_config_have.h"
+
+#include "os/os_time.h"
+
+#include "util/u_var.h"
+#include "util/u_misc.h"
+#include "util/u_sink.h"
+#include "util/u_time.h"
+#include "util/u_format.h"
+#include "util/u_logging.h"
+#include "util/u_frame_pool.h"
+
+#include <stdio.h>
+#include <pthread.h>
+
+#ifdef XRT_HAVE_JPEG
+#include <setjmp.h>
+#include "jpeglib.h"
+#endif
+
+
+#ifdef XRT_HAVE_JPEG
+
+#define U_SINK_MJPEG_MAX_THREADS 16
+#define U_SINK_MJPEG_NUM_TIMINGS 256
+
+
+/*
+ *
+ * Structs
+ *
+ */
+
+enum u_sink_mjpeg_job_state
+{
+	U_SINK_MJPEG_JOB_PENDING,
+	U_SINK_MJPEG_JOB_DECODING,
+	U_SINK_MJPEG_JOB_DONE,
+	U_SINK_MJPEG_JOB_FAILED,
+};
+
+/*!
+ * One frame going through the decoder, jobs live in a ring in the order the
+ * frames were pushed.
+ */
+struct u_sink_mjpeg_job
+{
+	enum u_sink_mjpeg_job_state state;
+
+	//! The compressed frame, holds a reference.
+	struct xrt_frame *src;
+
+	//! The decoded frame, holds a reference.
+	struct xrt_frame *dst;
+};
+
+/*!
+ * Error manager that jumps back into the decode function instead of exiting.
+ */
+struct u_sink_mjpeg_error_mgr
+{
+	struct jpeg_error_mgr base;
+
+	jmp_buf jump;
+};
+
+/*!
+ * A worker thread with its own decompressor instance.
+ */
+struct u_sink_mjpeg_worker
+{
+	struct u_sink_mjpeg_decoder *dec;
+
+	pthread_t thread;
+
+	struct jpeg_decompress_struct cinfo;
+	struct u_sink_mjpeg_error_mgr err;
+};
+
+/*!
+ * An @ref xrt_frame_sink that decodes MJPEG frames on a number of worker
+ * threads, and pushes the decoded frames downstream in the order they came in.
+ *
+ * @implements xrt_frame_sink
+ * @implements xrt_frame_node
+ */
+struct u_sink_mjpeg_decoder
+{
+	struct xrt_frame_sink base;
+	struct xrt_frame_node node;
+
+	struct xrt_frame_sink *downstream;
+
+	//! Either R8G8B8 or YUV888.
+	enum xrt_format format;
+
+	struct u_frame_pool *pool;
+
+	struct u_sink_mjpeg_worker workers[U_SINK_MJPEG_MAX_THREADS];
+	uint32_t num_workers;
+
+	//! Ring of jobs in push order, protected by the mutex.
+	struct u_sink_mjpeg_job *jobs;
+	uint32_t max_jobs;
+	uint32_t head;
+	uint32_t num_jobs;
+
+	//! A worker is pushing finished frames downstream, keeps them ordered.
+	bool delivering;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+
+	bool running;
+
+	//! Statistics, written with the mutex held, exposed with @ref u_var.
+	struct
+	{
+		uint64_t delivered;
+		uint64_t dropped;
+		uint64_t failed;
+
+		//! Number of frames in the pipeline.
+		uint32_t depth;
+
+		//! Time it took to decode the last frame.
+		float decode_ms;
+
+		float decode_times_ms[U_SINK_MJPEG_NUM_TIMINGS];
+		int decode_index;
+		struct u_var_timing decode_timing;
+	} stats;
+};
+
+
+/*
+ *
+ * Decoding.
+ *
+ */
+
+static void
+error_exit(j_common_ptr cinfo)
+{
+	struct u_sink_mjpeg_error_mgr *err = (struct u_sink_mjpeg_error_mgr *)cinfo->err;
+
+	char buffer[JMSG_LENGTH_MAX];
+	(*cinfo->err->format_message)(cinfo, buffer);
+	U_LOG_E("libjpeg: %s", buffer);
+
+	longjmp(err->jump, 1);
+}
+
+static void
+output_message(j_common_ptr cinfo)
+{
+	// Warnings are too noisy for corrupt frames from cameras, drop them.
+}
+
+static bool
+check_header(size_t size, const uint8_t *data)
+{
+	if (size < 16) {
+		U_LOG_E("Invalid JPEG file size! %u", (uint32_t)size);
+		return false;
+	}
+
+	if (data[0] != 0xFF || data[1] != 0xD8) {
+		U_LOG_E("Invalid file header! 0x%02X 0x%02X", data[0], data[1]);
+		return false;
+	}
+
+	return true;
+}
+
+static bool
+decode_frame(struct u_sink_mjpeg_worker *w, struct xrt_frame *src, struct xrt_frame *dst)
+{
+	struct jpeg_decompress_struct *cinfo = &w->cinfo;
+
+	if (!check_header(src->size, src->data)) {
+		return false;
+	}
+
+	if (setjmp(w->err.jump)) {
+		jpeg_abort_decompress(cinfo);
+		return false;
+	}
+
+	jpeg_mem_src(cinfo, src->data, src->size);
+
+	int ret = jpeg_read_header(cinfo, TRUE);
+	if (ret != JPEG_HEADER_OK) {
+		jpeg_abort_decompress(cinfo);
+		return false;
+	}
+
+	if (cinfo->image_width != dst->width || cinfo->image_height != dst->height) {
+		U_LOG_E("JPEG size %ux%u doesn't match frame size %ux%u!", cinfo->image_width, cinfo->image_height,
+		        dst->width, dst->height);
+		jpeg_abort_decompress(cinfo);
+		return false;
+	}
+
+	cinfo->out_color_space = dst->format == XRT_FORMAT_YUV888 ? JCS_YCbCr : JCS_RGB;
+	jpeg_start_decompress(cinfo);
+
+	while (cinfo->output_scanline < cinfo->output_height) {
+		JSAMPROW row = dst->data + cinfo->output_scanline * dst->stride;
+		jpeg_read_scanlines(cinfo, &row, 1);
+	}
+
+	jpeg_finish_decompress(cinfo);
+
+	return true;
+}
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static inline struct u_sink_mjpeg_job *
+job_at(struct u_sink_mjpeg_decoder *dec, uint32_t i)
+{
+	return &dec->jobs[(dec->head + i) % dec->max_jobs];
+}
+
+/*!
+ * Must be called with the mutex held.
+ */
+static struct u_sink_mjpeg_job *
+find_pending_locked(struct u_sink_mjpeg_decoder *dec)
+{
+	for (uint32_t i = 0; i < dec->num_jobs; i++) {
+		struct u_sink_mjpeg_job *job = job_at(dec, i);
+		if (job->state == U_SINK_MJPEG_JOB_PENDING) {
+			return job;
+		}
+	}
+
+	return NULL;
+}
+
+/*!
+ * Pushes all finished frames at the head of the ring downstream, only one
+ * thread at the time does this so that the order is kept. Must be called with
+ * the mutex held, but releases it while pushing.
+ */
+static void
+deliver_locked(struct u_sink_mjpeg_decoder *dec)
+{
+	if (dec->delivering) {
+		// That thread will pick up our frame as well.
+		return;
+	}
+
+	dec->delivering = true;
+
+	while (dec->num_jobs > 0) {
+		struct u_sink_mjpeg_job *job = job_at(dec, 0);
+		if (job->state != U_SINK_MJPEG_JOB_DONE && job->state != U_SINK_MJPEG_JOB_FAILED) {
+			break;
+		}
+
+		struct xrt_frame *frame = NULL;
+		bool done = job->state == U_SINK_MJPEG_JOB_DONE;
+
+		// Move the decoded frame out and release the compressed one.
+		frame = job->dst;
+		job->dst = NULL;
+		xrt_frame_reference(&job->src, NULL);
+
+		dec->head = (dec->head + 1) % dec->max_jobs;
+		dec->num_jobs--;
+		dec->stats.depth = dec->num_jobs;
+
+		if (!done) {
+			xrt_frame_reference(&frame, NULL);
+			continue;
+		}
+
+		dec->stats.delivered++;
+
+		pthread_mutex_unlock(&dec->mutex);
+
+		dec->downstream->push_frame(dec->downstream, frame);
+		xrt_frame_reference(&frame, NULL);
+
+		pthread_mutex_lock(&dec->mutex);
+	}
+
+	dec->delivering = false;
+}
+
+static void *
+worker_run(void *ptr)
+{
+	struct u_sink_mjpeg_worker *w = (struct u_sink_mjpeg_worker *)ptr;
+	struct u_sink_mjpeg_decoder *dec = w->dec;
+
+	pthread_mutex_lock(&dec->mutex);
+
+	while (dec->running) {
+		struct u_sink_mjpeg_job *job = find_pending_locked(dec);
+
+		// No new frame, wait.
+		if (job == NULL) {
+			pthread_cond_wait(&dec->cond, &dec->mutex);
+			continue;
+		}
+
+		job->state = U_SINK_MJPEG_JOB_DECODING;
+
+		// The job keeps the reference, and jobs are only removed once done.
+		struct xrt_frame *src = job->src;
+		struct xrt_frame *dst = NULL;
+
+		// Unlock the mutex when we do the work.
+		pthread_mutex_unlock(&dec->mutex);
+
+		uint64_t start_ns = os_monotonic_get_ns();
+
+		u_frame_pool_create_frame(dec->pool, dec->format, src->width, src->height, &dst);
+
+		bool ok = dst != NULL && decode_frame(w, src, dst);
+		if (ok) {
+			dst->timestamp = src->timestamp;
+			dst->source_timestamp = src->source_timestamp;
+			dst->source_sequence = src->source_sequence;
+			dst->source_id = src->source_id;
+			dst->stereo_format = src->stereo_format;
+		}
+
+		uint64_t end_ns = os_monotonic_get_ns();
+
+		pthread_mutex_lock(&dec->mutex);
+
+		job->dst = dst;
+		job->state = ok ? U_SINK_MJPEG_JOB_DONE : U_SINK_MJPEG_JOB_FAILED;
+
+		float decode_ms = (float)time_ns_to_s(end_ns - start_ns) * 1000.f;
+		dec->stats.decode_ms = decode_ms;
+		dec->stats.decode_index = (dec->stats.decode_index + 1) % U_SINK_MJPEG_NUM_TIMINGS;
+		dec->stats.decode_times_ms[dec->stats.decode_index] = decode_ms;
+		if (!ok) {
+			dec->stats.failed++;
+		}
+
+		deliver_locked(dec);
+	}
+
+	pthread_mutex_unlock(&dec->mutex);
+
+	return NULL;
+}
+
+static void
+receive_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
+{
+	struct u_sink_mjpeg_decoder *dec = (struct u_sink_mjpeg_decoder *)xfs;
+
+	if (xf->format != XRT_FORMAT_MJPEG) {
+		U_LOG_E("Can not decode from '%s'!", u_format_str(xf->format));
+		return;
+	}
+
+	pthread_mutex_lock(&dec->mutex);
+
+	// Saturated, drop the new frame, older ones are closer to done.
+	if (!dec->running || dec->num_jobs >= dec->max_jobs) {
+		dec->stats.dropped += dec->running ? 1 : 0;
+		pthread_mutex_unlock(&dec->mutex);
+		return;
+	}
+
+	struct u_sink_mjpeg_job *job = job_at(dec, dec->num_jobs);
+	job->state = U_SINK_MJPEG_JOB_PENDING;
+	xrt_frame_reference(&job->src, xf);
+
+	dec->num_jobs++;
+	dec->stats.depth = dec->num_jobs;
+
+	// Wake up a worker.
+	pthread_cond_signal(&dec->cond);
+
+	pthread_mutex_unlock(&dec->mutex);
+}
+
+static void
+break_apart(struct xrt_frame_node *node)
+{
+	struct u_sink_mjpeg_decoder *dec = container_of(node, struct u_sink_mjpeg_decoder, node);
+	void *retval = NULL;
+
+	// The fields are protected.
+	pthread_mutex_lock(&dec->mutex);
+
+	// Stop the threads and inhibit any new frames to be added.
+	dec->running = false;
+
+	// Wake up the threads.
+	pthread_cond_broadcast(&dec->cond);
+
+	// No longer need to protect fields.
+	pthread_mutex_unlock(&dec->mutex);
+
+	// Wait for threads to finish.
+	for (uint32_t i = 0; i < dec->num_workers; i++) {
+		pthread_join(dec->workers[i].thread, &retval);
+	}
+
+	// Only we are left, release any frames still in the pipeline.
+	for (uint32_t i = 0; i < dec->max_jobs; i++) {
+		xrt_frame_reference(&dec->jobs[i].src, NULL);
+		xrt_frame_reference(&dec->jobs[i].dst, NULL);
+	}
+	dec->num_jobs = 0;
+}
+
+static void
+destroy(struct xrt_frame_node *node)
+{
+	struct u_sink_mjpeg_decoder *dec = container_of(node, struct u_sink_mjpeg_decoder, node);
+
+	u_var_remove_root(dec);
+
+	for (uint32_t i = 0; i < dec->num_workers; i++) {
+		jpeg_destroy_decompress(&dec->workers[i].cinfo);
+	}
+
+	u_frame_pool_destroy(&dec->pool);
+
+	// Destroy resources.
+	pthread_mutex_destroy(&dec->mutex);
+	pthread_cond_destroy(&dec->cond);
+	free(dec->jobs);
+	free(dec);
+}
+
+#endif // XRT_HAVE_JPEG
+
+
+/*
+ *
+ * Exported functions.
+ *
+ */
+
+bool
+u_sink_mjpeg_decoder_create(struct xrt_frame_context *xfctx,
+                            enum xrt_format f,
+                            uint32_t num_threads,
+                            struct xrt_frame_sink *downstream,
+                            struct xrt_frame_sink **out_xfs)
+{
+#ifdef XRT_HAVE_JPEG
+	if (f != XRT_FORMAT_R8G8B8 && f != XRT_FORMAT_YUV888) {
+		U_LOG_E("Format '%s' not supported", u_format_str(f));
+		return false;
+	}
+
+	if (num_threads == 0) {
+		num_threads = 1;
+	}
+	if (num_threads > U_SINK_MJPEG_MAX_THREADS) {
+		num_threads = U_SINK_MJPEG_MAX_THREADS;
+	}
+
+	struct u_sink_mjpeg_decoder *dec = U_TYPED_CALLOC(struct u_sink_mjpeg_decoder);
+	int ret = 0;
+
+	dec->base.push_frame = receive_frame;
+	dec->node.break_apart = break_apart;
+	dec->node.destroy = destroy;
+	dec->downstream = downstream;
+	dec->format = f;
+	dec->running = true;
+
+	// One frame being decoded per thread and one waiting for each.
+	dec->max_jobs = num_threads * 2;
+	dec->jobs = U_TYPED_ARRAY_CALLOC(struct u_sink_mjpeg_job, dec->max_jobs);
+
+	ret = pthread_mutex_init(&dec->mutex, NULL);
+	if (ret != 0) {
+		free(dec->jobs);
+		free(dec);
+		return false;
+	}
+
+	ret = pthread_cond_init(&dec->cond, NULL);
+	if (ret != 0) {
+		pthread_mutex_destroy(&dec->mutex);
+		free(dec->jobs);
+		free(dec);
+		return false;
+	}
+
+	// Frames both being decoded and waiting on delivery.
+	u_frame_pool_create(&dec->pool, "MJPEG decoder frame pool", dec->max_jobs);
+
+	for (uint32_t i = 0; i < num_threads; i++) {
+		struct u_sink_mjpeg_worker *w = &dec->workers[i];
+
+		w->dec = dec;
+		w->cinfo.err = jpeg_std_error(&w->err.base);
+		w->err.base.error_exit = error_exit;
+		w->err.base.output_message = output_message;
+		jpeg_create_decompress(&w->cinfo);
+
+		ret = pthread_create(&w->thread, NULL, worker_run, w);
+		if (ret != 0) {
+			U_LOG_E("Failed to create worker thread %u!", i);
+			jpeg_destroy_decompress(&w->cinfo);
+			break;
+		}
+
+		dec->num_workers++;
+	}
+
+	if (dec->num_workers == 0) {
+		u_frame_pool_destroy(&dec->pool);
+		pthread_cond_destroy(&dec->cond);
+		pthread_mutex_destroy(&dec->mutex);
+		free(dec->jobs);
+		free(dec);
+		return false;
+	}
+
+	dec->stats.decode_timing.values.data = dec->stats.decode_times_ms;
+	dec->stats.decode_timing.values.length = U_SINK_MJPEG_NUM_TIMINGS;
+	dec->stats.decode_timing.values.index_ptr = &dec->stats.decode_index;
+	dec->stats.decode_timing.range = 10.f;
+	dec->stats.decode_timing.unit = "ms";
+	dec->stats.decode_timing.dynamic_rescale = true;
+
+	u_var_add_root(dec, "MJPEG decoder", true);
+	u_var_add_ro_u32(dec, &dec->num_workers, "Threads");
+	u_var_add_ro_u32(dec, &dec->stats.depth, "Pipeline depth");
+	u_var_add_ro_u64(dec, &dec->stats.delivered, "Delivered");
+	u_var_add_ro_u64(dec, &dec->stats.dropped, "Dropped");
+	u_var_add_ro_u64(dec, &dec->stats.failed, "Failed");
+	u_var_add_ro_f32(dec, &dec->stats.decode_ms, "Decode time (ms)");
+	u_var_add_f32_timing(dec, &dec->stats.decode_timing, "Decode time");
+
+	xrt_frame_context_add(xfctx, &dec->node);
+
+	*out_xfs = &dec->base;
+
+	return true;
+#else
+	U_LOG_E("Built without libjpeg support!");
+	return false;
+#endif
+}
@@ -7,13 +7,31 @@
  * @ingroup aux_util
  */
 
+#include "os/os_time.h"
+
+#include "util/u_var.h"
 #include "util/u_misc.h"
 #include "util/u_sink.h"
+#include "util/u_time.h"
 
 #include <stdio.h>
 #include <pthread.h>
 
 
+#define U_SINK_QUEUE_NUM_LATENCIES 256
+
+
+/*!
+ * A frame waiting in the @ref u_sink_queue.
+ */
+struct u_sink_queue_entry
+{
+	struct xrt_frame *frame;
+
+	//! When the frame was pushed into the queue.
+	uint64_t enqueued_ns;
+};
+
 /*!
  * An @ref xrt_frame_sink queue.
  * @implements xrt_frame_sink
@@ -25,65 +43,103 @@ struct u_sink_queue
 	struct xrt_frame_node node;
 
 	struct xrt_frame_sink *consumer;
-	struct xrt_frame *frame;
+
+	//! Ring of queued frames, protected by the mutex.
+	struct u_sink_queue_entry *entries;
+	uint32_t depth;
+	uint32_t head;
+	uint32_t num;
+
+	enum u_sink_queue_policy policy;
 
 	pthread_t thread;
 	pthread_mutex_t mutex;
+
+	//! Signaled when a frame is queued.
 	pthread_cond_t cond;
 
+	//! Signaled when a frame is taken off the queue.
+	pthread_cond_t space_cond;
+
+	//! Statistics, written with the mutex held, exposed with @ref u_var.
 	struct
 	{
-		uint64_t current;
-		uint64_t last;
-	} seq;
+		uint64_t pushed;
+		uint64_t delivered;
+		uint64_t dropped;
+
+		//! Time from enqueue to dequeue of the last delivered frame.
+		float latency_ms;
+
+		float latencies_ms[U_SINK_QUEUE_NUM_LATENCIES];
+		int latency_index;
+		struct u_var_timing latency_timing;
+	} stats;
 
 	bool running;
 };
 
+/*!
+ * Must be called with the mutex held and at least one frame queued.
+ */
+static struct u_sink_queue_entry
+pop_locked(struct u_sink_queue *q)
+{
+	struct u_sink_queue_entry entry = q->entries[q->head];
+
+	U_ZERO(&q->entries[q->head]);
+	q->head = (q->head + 1) % q->depth;
+	q->num--;
+
+	return entry;
+}
+
+/*!
+ * Must be called with the mutex held.
+ */
+static void
+record_latency_locked(struct u_sink_queue *q, uint64_t enqueued_ns)
+{
+	uint64_t now_ns = os_monotonic_get_ns();
+	float latency_ms = (float)time_ns_to_s(now_ns - enqueued_ns) * 1000.f;
+
+	q->stats.latency_ms = latency_ms;
+	q->stats.latency_index = (q->stats.latency_index + 1) % U_SINK_QUEUE_NUM_LATENCIES;
+	q->stats.latencies_ms[q->stats.latency_index] = latency_ms;
+	q->stats.delivered++;
+}
+
 static void *
 sque_run(void *ptr)
 {
 	struct u_sink_queue *q = (struct u_sink_queue *)ptr;
-	struct xrt_frame *frame = NULL;
 
 	pthread_mutex_lock(&q->mutex);
 
 	while (q->running) {
 
 		// No new frame, wait.
-		if (q->seq.last >= q->seq.current) {
+		if (q->num == 0) {
 			pthread_cond_wait(&q->cond, &q->mutex);
-		}
-
-		// Where we woken up to turn of.
-		if (!q->running) {
-			break;
-		}
-
-		// Just in case.
-		if (q->seq.last >= q->seq.current || q->frame == NULL) {
 			continue;
 		}
 
-		// We have a new frame, send it out.
-		q->seq.last = q->seq.current;
+		// We have a new frame, take it off the queue, we are now the
+		// one holding the reference to it.
+		struct u_sink_queue_entry entry = pop_locked(q);
+		record_latency_locked(q, entry.enqueued_ns);
 
-		// Take a reference on the current frame, this keeps it alive
-		// if it is replaced during the consumer processing it, but
-		// we no longer need to hold onto the frame on the queue we
-		// just move the pointer.
-		frame = q->frame;
-		q->frame = NULL;
+		// Wake up a producer waiting for room.
+		pthread_cond_signal(&q->space_cond);
 
 		// Unlock the mutex when we do the work.
 		pthread_mutex_unlock(&q->mutex);
 
 		// Send to the consumer that does the work.
-		q->consumer->push_frame(q->consumer, frame);
+		q->consumer->push_frame(q->consumer, entry.frame);
 
-		// Drop our reference we don't need it anymore,
-		// or it's held on the queue.
-		xrt_frame_reference(&frame, NULL);
+		// Drop our reference we don't need it anymore.
+		xrt_frame_reference(&entry.frame, NULL);
 
 		// Have to lock it again.
 		pthread_mutex_lock(&q->mutex);
@@ -102,11 +158,43 @@ sque_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
 	pthread_mutex_lock(&q->mutex);
 
 	// Only schedule new frames if we are running.
-	if (q->running) {
-		q->seq.current++;
-		xrt_frame_reference(&q->frame, xf);
+	if (!q->running) {
+		pthread_mutex_unlock(&q->mutex);
+		return;
 	}
 
+	q->stats.pushed++;
+
+	if (q->num >= q->depth) {
+		switch (q->policy) {
+		case U_SINK_QUEUE_POLICY_DROP_NEWEST:
+			q->stats.dropped++;
+			pthread_mutex_unlock(&q->mutex);
+			return;
+		case U_SINK_QUEUE_POLICY_BLOCK_PRODUCER:
+			while (q->running && q->num >= q->depth) {
+				pthread_cond_wait(&q->space_cond, &q->mutex);
+			}
+			// Where we woken up to turn off.
+			if (!q->running) {
+				pthread_mutex_unlock(&q->mutex);
+				return;
+			}
+			break;
+		case U_SINK_QUEUE_POLICY_DROP_OLDEST:
+		default: {
+			struct u_sink_queue_entry entry = pop_locked(q);
+			xrt_frame_reference(&entry.frame, NULL);
+			q->stats.dropped++;
+		} break;
+		}
+	}
+
+	struct u_sink_queue_entry *entry = &q->entries[(q->head + q->num) % q->depth];
+	xrt_frame_reference(&entry->frame, xf);
+	entry->enqueued_ns = os_monotonic_get_ns();
+	q->num++;
+
 	// Wake up the thread.
 	pthread_cond_signal(&q->cond);
 
@@ -126,10 +214,14 @@ break_apart(struct xrt_frame_node *node)
 	q->running = false;
 
 	// Release any frame waiting for submission.
-	xrt_frame_reference(&q->frame, NULL);
+	while (q->num > 0) {
+		struct u_sink_queue_entry entry = pop_locked(q);
+		xrt_frame_reference(&entry.frame, NULL);
+	}
 
-	// Wake up the thread.
+	// Wake up the thread and any blocked producer.
 	pthread_cond_signal(&q->cond);
+	pthread_cond_broadcast(&q->space_cond);
 
 	// No longer need to protect fields.
 	pthread_mutex_unlock(&q->mutex);
@@ -143,9 +235,13 @@ destroy(struct xrt_frame_node *node)
 {
 	struct u_sink_queue *q = container_of(node, struct u_sink_queue, node);
 
+	u_var_remove_root(q);
+
 	// Destroy resources.
 	pthread_mutex_destroy(&q->mutex);
 	pthread_cond_destroy(&q->cond);
+	pthread_cond_destroy(&q->space_cond);
+	free(q->entries);
 	free(q);
 }
 
@@ -158,6 +254,21 @@ destroy(struct xrt_frame_node *node)
 
 bool
 u_sink_queue_create(struct xrt_frame_context *xfctx, struct xrt_frame_sink *downstream, struct xrt_frame_sink **out_xfs)
+{
+	// Same as the original single slot queue, new frames replace old.
+	struct u_sink_queue_params params = {
+	    .depth = 1,
+	    .policy = U_SINK_QUEUE_POLICY_DROP_OLDEST,
+	};
+
+	return u_sink_queue_create_with_params(xfctx, downstream, &params, out_xfs);
+}
+
+bool
+u_sink_queue_create_with_params(struct xrt_frame_context *xfctx,
+                                struct xrt_frame_sink *downstream,
+                                const struct u_sink_queue_params *params,
+                                struct xrt_frame_sink **out_xfs)
 {
 	struct u_sink_queue *q = U_TYPED_CALLOC(struct u_sink_queue);
 	int ret = 0;
@@ -166,10 +277,14 @@ u_sink_queue_create(struct xrt_frame_context *xfctx, struct xrt_frame_sink *down
 	q->node.break_apart = break_apart;
 	q->node.destroy = destroy;
 	q->consumer = downstream;
+	q->depth = params->depth > 0 ? params->depth : 1;
+	q->policy = params->policy;
+	q->entries = U_TYPED_ARRAY_CALLOC(struct u_sink_queue_entry, q->depth);
 	q->running = true;
 
 	ret = pthread_mutex_init(&q->mutex, NULL);
 	if (ret != 0) {
+		free(q->entries);
 		free(q);
 		return false;
 	}
@@ -177,18 +292,45 @@ u_sink_queue_create(struct xrt_frame_context *xfctx, struct xrt_frame_sink *down
 	ret = pthread_cond_init(&q->cond, NULL);
 	if (ret) {
 		pthread_mutex_destroy(&q->mutex);
+		free(q->entries);
+		free(q);
+		return false;
+	}
+
+	ret = pthread_cond_init(&q->space_cond, NULL);
+	if (ret) {
+		pthread_cond_destroy(&q->cond);
+		pthread_mutex_destroy(&q->mutex);
+		free(q->entries);
 		free(q);
 		return false;
 	}
 
 	ret = pthread_create(&q->thread, NULL, sque_run, q);
 	if (ret != 0) {
+		pthread_cond_destroy(&q->space_cond);
 		pthread_cond_destroy(&q->cond);
 		pthread_mutex_destroy(&q->mutex);
+		free(q->entries);
 		free(q);
 		return false;
 	}
 
+	q->stats.latency_timing.values.data = q->stats.latencies_ms;
+	q->stats.latency_timing.values.length = U_SINK_QUEUE_NUM_LATENCIES;
+	q->stats.latency_timing.values.index_ptr = &q->stats.latency_index;
+	q->stats.latency_timing.range = 10.f;
+	q->stats.latency_timing.unit = "ms";
+	q->stats.latency_timing.dynamic_rescale = true;
+
+	u_var_add_root(q, "Sink queue", true);
+	u_var_add_ro_u32(q, &q->depth, "Depth");
+	u_var_add_ro_u64(q, &q->stats.pushed, "Pushed");
+	u_var_add_ro_u64(q, &q->stats.delivered, "Delivered");
+	u_var_add_ro_u64(q, &q->stats.dropped, "Dropped");
+	u_var_add_ro_f32(q, &q->stats.latency_ms, "Latency (ms)");
+	u_var_add_f32_timing(q, &q->stats.latency_timing, "Latency");
+
 	xrt_frame_context_add(xfctx, &q->node);
 
 	*out_xfs = &q->base;
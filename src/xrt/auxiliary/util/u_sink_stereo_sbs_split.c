@@ -0,0 +1,129 @@
+// Copyright 2019-2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  An @ref xrt_frame_sink that splits stereo frames into one per view.
+ * @author Collabora, Ltd.
+ * @ingroup aux_util
+ */
+
+#include "util/u_misc.h"
+#include "util/u_sink.h"
+#include "util/u_frame.h"
+#include "util/u_format.h"
+#include "util/u_logging.h"
+
+
+/*!
+ * An @ref xrt_frame_sink that splits stereo frames into one frame per view,
+ * the view frames point into the original frame and keeps it alive.
+ *
+ * @implements xrt_frame_sink
+ * @implements xrt_frame_node
+ */
+struct u_sink_stereo_sbs_split
+{
+	struct xrt_frame_sink base;
+	struct xrt_frame_node node;
+
+	struct xrt_frame_sink *left;
+	struct xrt_frame_sink *right;
+};
+
+
+/*
+ *
+ * Helpers
+ *
+ */
+
+static void
+split_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
+{
+	struct u_sink_stereo_sbs_split *s = (struct u_sink_stereo_sbs_split *)xfs;
+
+	// Compressed frames can't be split without decoding them.
+	if (!u_format_is_blocks(xf->format)) {
+		U_LOG_E("Can not split frames of format '%s'!", u_format_str(xf->format));
+		return;
+	}
+
+	uint32_t w = xf->width;
+	uint32_t h = xf->height;
+	uint32_t left_x = 0;
+	uint32_t left_y = 0;
+	uint32_t right_x = 0;
+	uint32_t right_y = 0;
+
+	switch (xf->stereo_format) {
+	case XRT_STEREO_FORMAT_SBS:
+		w = w / 2;
+		right_x = w;
+		break;
+	case XRT_STEREO_FORMAT_OAU:
+		h = h / 2;
+		right_y = h;
+		break;
+	default:
+		U_LOG_E("Can not split stereo format %u without copying!", (uint32_t)xf->stereo_format);
+		return;
+	}
+
+	// Each view needs to start on a block boundary.
+	if (w % u_format_block_width(xf->format) != 0 || h % u_format_block_height(xf->format) != 0) {
+		U_LOG_E("Can not split '%s' frame of %ux%u on block boundaries!", u_format_str(xf->format),
+		        xf->width, xf->height);
+		return;
+	}
+
+	struct xrt_frame *left = NULL;
+	struct xrt_frame *right = NULL;
+
+	u_frame_create_roi(xf, left_x, left_y, w, h, &left);
+	u_frame_create_roi(xf, right_x, right_y, w, h, &right);
+
+	s->left->push_frame(s->left, left);
+	s->right->push_frame(s->right, right);
+
+	// Refcount in case it's being held downstream, releases the original.
+	xrt_frame_reference(&left, NULL);
+	xrt_frame_reference(&right, NULL);
+}
+
+static void
+break_apart(struct xrt_frame_node *node)
+{}
+
+static void
+destroy(struct xrt_frame_node *node)
+{
+	struct u_sink_stereo_sbs_split *s = container_of(node, struct u_sink_stereo_sbs_split, node);
+
+	free(s);
+}
+
+
+/*
+ *
+ * Exported functions.
+ *
+ */
+
+void
+u_sink_stereo_sbs_split_create(struct xrt_frame_context *xfctx,
+                               struct xrt_frame_sink *left,
+                               struct xrt_frame_sink *right,
+                               struct xrt_frame_sink **out_xfs)
+{
+	struct u_sink_stereo_sbs_split *s = U_TYPED_CALLOC(struct u_sink_stereo_sbs_split);
+
+	s->base.push_frame = split_frame;
+	s->node.break_apart = break_apart;
+	s->node.destroy = destroy;
+	s->left = left;
+	s->right = right;
+
+	xrt_frame_context_add(xfctx, &s->node);
+
+	*out_xfs = &s->base;
+}
@@ -0,0 +1,431 @@
+// Copyright 2019-2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  YUV to RGB conversion kernels, scalar and SIMD.
+ * @author Collabora, Ltd.
+ * @ingroup aux_util
+ */
+
+#include "util/u_yuv_convert.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define U_YUV_CONVERT_HAVE_X86
+#include <immintrin.h>
+
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+
+/*
+ *
+ * Scalar reference implementation.
+ *
+ */
+
+static inline int
+clamp_to_byte(int v)
+{
+	if (v < 0) {
+		return 0;
+	}
+	if (v >= 255) {
+		return 255;
+	}
+	return v;
+}
+
+static inline void
+YUV444_to_R8G8B8(int y, int u, int v, uint8_t *dst)
+{
+	int C = y - 16;
+	int D = u - 128;
+	int E = v - 128;
+
+	dst[0] = clamp_to_byte((298 * C + 409 * E + 128) >> 8);
+	dst[1] = clamp_to_byte((298 * C - 100 * D - 209 * E + 128) >> 8);
+	dst[2] = clamp_to_byte((298 * C + 516 * D + 128) >> 8);
+}
+
+static void
+scalar_yuyv422_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	for (uint32_t x = 0; x < width; x += 2) {
+		uint8_t y0 = src[0];
+		uint8_t u = src[1];
+		uint8_t y1 = src[2];
+		uint8_t v = src[3];
+
+		YUV444_to_R8G8B8(y0, u, v, dst + 0);
+		YUV444_to_R8G8B8(y1, u, v, dst + 3);
+
+		src += 4;
+		dst += 6;
+	}
+}
+
+static void
+scalar_uyvy422_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	for (uint32_t x = 0; x < width; x += 2) {
+		uint8_t u = src[0];
+		uint8_t y0 = src[1];
+		uint8_t v = src[2];
+		uint8_t y1 = src[3];
+
+		YUV444_to_R8G8B8(y0, u, v, dst + 0);
+		YUV444_to_R8G8B8(y1, u, v, dst + 3);
+
+		src += 4;
+		dst += 6;
+	}
+}
+
+static void
+scalar_yuv888_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	for (uint32_t x = 0; x < width; x++) {
+		YUV444_to_R8G8B8(src[0], src[1], src[2], dst);
+
+		src += 3;
+		dst += 3;
+	}
+}
+
+static const struct u_yuv_convert_funcs scalar_funcs = {
+    .name = "scalar",
+    .yuyv422_to_r8g8b8 = scalar_yuyv422_to_r8g8b8,
+    .uyvy422_to_r8g8b8 = scalar_uyvy422_to_r8g8b8,
+    .yuv888_to_r8g8b8 = scalar_yuv888_to_r8g8b8,
+};
+
+
+#ifdef U_YUV_CONVERT_HAVE_X86
+
+/*
+ *
+ * SSE4.1 implementation.
+ *
+ * Does the same integer math as the scalar version in 32-bit lanes, four
+ * pixels at the time. Each iteration does a full 16 byte store of which 12
+ * bytes are valid, the next iteration overwrites the rest, so the loops stop
+ * early enough to not write outside of the row and hand over to the scalar
+ * code for the last few pixels.
+ *
+ */
+
+TARGET_SSE41 static inline __m128i
+sse41_clamp_shift(__m128i v)
+{
+	v = _mm_srai_epi32(v, 8);
+	v = _mm_min_epi32(v, _mm_set1_epi32(255));
+	return _mm_max_epi32(v, _mm_setzero_si128());
+}
+
+/*!
+ * Takes Y, U and V in 32-bit lanes, returns packed R8G8B8 in the lower 12
+ * bytes of the register.
+ */
+TARGET_SSE41 static inline __m128i
+sse41_yuv_to_rgb(__m128i y, __m128i u, __m128i v)
+{
+	const __m128i c128 = _mm_set1_epi32(128);
+
+	__m128i C = _mm_sub_epi32(y, _mm_set1_epi32(16));
+	__m128i D = _mm_sub_epi32(u, c128);
+	__m128i E = _mm_sub_epi32(v, c128);
+
+	__m128i C298 = _mm_add_epi32(_mm_mullo_epi32(C, _mm_set1_epi32(298)), c128);
+	__m128i D100 = _mm_mullo_epi32(D, _mm_set1_epi32(100));
+	__m128i E209 = _mm_mullo_epi32(E, _mm_set1_epi32(209));
+
+	__m128i R = _mm_add_epi32(C298, _mm_mullo_epi32(E, _mm_set1_epi32(409)));
+	__m128i G = _mm_sub_epi32(_mm_sub_epi32(C298, D100), E209);
+	__m128i B = _mm_add_epi32(C298, _mm_mullo_epi32(D, _mm_set1_epi32(516)));
+
+	R = sse41_clamp_shift(R);
+	G = sse41_clamp_shift(G);
+	B = sse41_clamp_shift(B);
+
+	__m128i rgbx = _mm_or_si128(R, _mm_or_si128(_mm_slli_epi32(G, 8), _mm_slli_epi32(B, 16)));
+
+	const __m128i pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+	return _mm_shuffle_epi8(rgbx, pack);
+}
+
+/*!
+ * Shared loop for the 4:2:2 formats, the masks pick out the components.
+ * Returns the number of pixels converted.
+ */
+TARGET_SSE41 static inline uint32_t
+sse41_422_loop(const uint8_t *src, uint8_t *dst, uint32_t width, __m128i y_mask, __m128i u_mask, __m128i v_mask)
+{
+	uint32_t x = 0;
+
+	for (; x + 6 <= width; x += 4) {
+		__m128i in = _mm_loadl_epi64((const __m128i *)(src + x * 2));
+
+		__m128i y = _mm_shuffle_epi8(in, y_mask);
+		__m128i u = _mm_shuffle_epi8(in, u_mask);
+		__m128i v = _mm_shuffle_epi8(in, v_mask);
+
+		_mm_storeu_si128((__m128i *)(dst + x * 3), sse41_yuv_to_rgb(y, u, v));
+	}
+
+	return x;
+}
+
+TARGET_SSE41 static void
+sse41_yuyv422_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	const __m128i y_mask = _mm_setr_epi8(0, -1, -1, -1, 2, -1, -1, -1, 4, -1, -1, -1, 6, -1, -1, -1);
+	const __m128i u_mask = _mm_setr_epi8(1, -1, -1, -1, 1, -1, -1, -1, 5, -1, -1, -1, 5, -1, -1, -1);
+	const __m128i v_mask = _mm_setr_epi8(3, -1, -1, -1, 3, -1, -1, -1, 7, -1, -1, -1, 7, -1, -1, -1);
+
+	uint32_t x = sse41_422_loop(src, dst, width, y_mask, u_mask, v_mask);
+
+	scalar_yuyv422_to_r8g8b8(src + x * 2, dst + x * 3, width - x);
+}
+
+TARGET_SSE41 static void
+sse41_uyvy422_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	const __m128i y_mask = _mm_setr_epi8(1, -1, -1, -1, 3, -1, -1, -1, 5, -1, -1, -1, 7, -1, -1, -1);
+	const __m128i u_mask = _mm_setr_epi8(0, -1, -1, -1, 0, -1, -1, -1, 4, -1, -1, -1, 4, -1, -1, -1);
+	const __m128i v_mask = _mm_setr_epi8(2, -1, -1, -1, 2, -1, -1, -1, 6, -1, -1, -1, 6, -1, -1, -1);
+
+	uint32_t x = sse41_422_loop(src, dst, width, y_mask, u_mask, v_mask);
+
+	scalar_uyvy422_to_r8g8b8(src + x * 2, dst + x * 3, width - x);
+}
+
+TARGET_SSE41 static void
+sse41_yuv888_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	const __m128i y_mask = _mm_setr_epi8(0, -1, -1, -1, 3, -1, -1, -1, 6, -1, -1, -1, 9, -1, -1, -1);
+	const __m128i u_mask = _mm_setr_epi8(1, -1, -1, -1, 4, -1, -1, -1, 7, -1, -1, -1, 10, -1, -1, -1);
+	const __m128i v_mask = _mm_setr_epi8(2, -1, -1, -1, 5, -1, -1, -1, 8, -1, -1, -1, 11, -1, -1, -1);
+
+	uint32_t x = 0;
+
+	// Loads 16 bytes of which 12 are used, same margin as the store.
+	for (; x + 6 <= width; x += 4) {
+		__m128i in = _mm_loadu_si128((const __m128i *)(src + x * 3));
+
+		__m128i y = _mm_shuffle_epi8(in, y_mask);
+		__m128i u = _mm_shuffle_epi8(in, u_mask);
+		__m128i v = _mm_shuffle_epi8(in, v_mask);
+
+		_mm_storeu_si128((__m128i *)(dst + x * 3), sse41_yuv_to_rgb(y, u, v));
+	}
+
+	scalar_yuv888_to_r8g8b8(src + x * 3, dst + x * 3, width - x);
+}
+
+static const struct u_yuv_convert_funcs sse41_funcs = {
+    .name = "sse4.1",
+    .yuyv422_to_r8g8b8 = sse41_yuyv422_to_r8g8b8,
+    .uyvy422_to_r8g8b8 = sse41_uyvy422_to_r8g8b8,
+    .yuv888_to_r8g8b8 = sse41_yuv888_to_r8g8b8,
+};
+
+
+/*
+ *
+ * AVX2 implementation.
+ *
+ * Same as the SSE4.1 version but eight pixels at the time, the in-lane byte
+ * shuffles means that each 128-bit lane handles four pixels. The two lanes
+ * are stored separately, the high one overlapping the unused tail of the low.
+ *
+ */
+
+TARGET_AVX2 static inline __m256i
+avx2_clamp_shift(__m256i v)
+{
+	v = _mm256_srai_epi32(v, 8);
+	v = _mm256_min_epi32(v, _mm256_set1_epi32(255));
+	return _mm256_max_epi32(v, _mm256_setzero_si256());
+}
+
+TARGET_AVX2 static inline __m256i
+avx2_yuv_to_rgb(__m256i y, __m256i u, __m256i v)
+{
+	const __m256i c128 = _mm256_set1_epi32(128);
+
+	__m256i C = _mm256_sub_epi32(y, _mm256_set1_epi32(16));
+	__m256i D = _mm256_sub_epi32(u, c128);
+	__m256i E = _mm256_sub_epi32(v, c128);
+
+	__m256i C298 = _mm256_add_epi32(_mm256_mullo_epi32(C, _mm256_set1_epi32(298)), c128);
+	__m256i D100 = _mm256_mullo_epi32(D, _mm256_set1_epi32(100));
+	__m256i E209 = _mm256_mullo_epi32(E, _mm256_set1_epi32(209));
+
+	__m256i R = _mm256_add_epi32(C298, _mm256_mullo_epi32(E, _mm256_set1_epi32(409)));
+	__m256i G = _mm256_sub_epi32(_mm256_sub_epi32(C298, D100), E209);
+	__m256i B = _mm256_add_epi32(C298, _mm256_mullo_epi32(D, _mm256_set1_epi32(516)));
+
+	R = avx2_clamp_shift(R);
+	G = avx2_clamp_shift(G);
+	B = avx2_clamp_shift(B);
+
+	__m256i rgbx = _mm256_or_si256(R, _mm256_or_si256(_mm256_slli_epi32(G, 8), _mm256_slli_epi32(B, 16)));
+
+	const __m256i pack = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1, //
+	                                      0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+	return _mm256_shuffle_epi8(rgbx, pack);
+}
+
+TARGET_AVX2 static inline void
+avx2_store_rgb(uint8_t *dst, __m256i rgb)
+{
+	_mm_storeu_si128((__m128i *)(dst + 0), _mm256_castsi256_si128(rgb));
+	_mm_storeu_si128((__m128i *)(dst + 12), _mm256_extracti128_si256(rgb, 1));
+}
+
+/*!
+ * Shared loop for the 4:2:2 formats, the masks pick out the components, the
+ * high lane masks index into the upper eight bytes of the source.
+ * Returns the number of pixels converted.
+ */
+TARGET_AVX2 static inline uint32_t
+avx2_422_loop(const uint8_t *src, uint8_t *dst, uint32_t width, __m256i y_mask, __m256i u_mask, __m256i v_mask)
+{
+	uint32_t x = 0;
+
+	for (; x + 10 <= width; x += 8) {
+		__m128i in128 = _mm_loadu_si128((const __m128i *)(src + x * 2));
+		__m256i in = _mm256_broadcastsi128_si256(in128);
+
+		__m256i y = _mm256_shuffle_epi8(in, y_mask);
+		__m256i u = _mm256_shuffle_epi8(in, u_mask);
+		__m256i v = _mm256_shuffle_epi8(in, v_mask);
+
+		avx2_store_rgb(dst + x * 3, avx2_yuv_to_rgb(y, u, v));
+	}
+
+	return x;
+}
+
+TARGET_AVX2 static void
+avx2_yuyv422_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	const __m256i y_mask = _mm256_setr_epi8(0, -1, -1, -1, 2, -1, -1, -1, 4, -1, -1, -1, 6, -1, -1, -1, //
+	                                        8, -1, -1, -1, 10, -1, -1, -1, 12, -1, -1, -1, 14, -1, -1, -1);
+	const __m256i u_mask = _mm256_setr_epi8(1, -1, -1, -1, 1, -1, -1, -1, 5, -1, -1, -1, 5, -1, -1, -1, //
+	                                        9, -1, -1, -1, 9, -1, -1, -1, 13, -1, -1, -1, 13, -1, -1, -1);
+	const __m256i v_mask = _mm256_setr_epi8(3, -1, -1, -1, 3, -1, -1, -1, 7, -1, -1, -1, 7, -1, -1, -1, //
+	                                        11, -1, -1, -1, 11, -1, -1, -1, 15, -1, -1, -1, 15, -1, -1, -1);
+
+	uint32_t x = avx2_422_loop(src, dst, width, y_mask, u_mask, v_mask);
+
+	scalar_yuyv422_to_r8g8b8(src + x * 2, dst + x * 3, width - x);
+}
+
+TARGET_AVX2 static void
+avx2_uyvy422_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	const __m256i y_mask = _mm256_setr_epi8(1, -1, -1, -1, 3, -1, -1, -1, 5, -1, -1, -1, 7, -1, -1, -1, //
+	                                        9, -1, -1, -1, 11, -1, -1, -1, 13, -1, -1, -1, 15, -1, -1, -1);
+	const __m256i u_mask = _mm256_setr_epi8(0, -1, -1, -1, 0, -1, -1, -1, 4, -1, -1, -1, 4, -1, -1, -1, //
+	                                        8, -1, -1, -1, 8, -1, -1, -1, 12, -1, -1, -1, 12, -1, -1, -1);
+	const __m256i v_mask = _mm256_setr_epi8(2, -1, -1, -1, 2, -1, -1, -1, 6, -1, -1, -1, 6, -1, -1, -1, //
+	                                        10, -1, -1, -1, 10, -1, -1, -1, 14, -1, -1, -1, 14, -1, -1, -1);
+
+	uint32_t x = avx2_422_loop(src, dst, width, y_mask, u_mask, v_mask);
+
+	scalar_uyvy422_to_r8g8b8(src + x * 2, dst + x * 3, width - x);
+}
+
+TARGET_AVX2 static void
+avx2_yuv888_to_r8g8b8(const uint8_t *src, uint8_t *dst, uint32_t width)
+{
+	const __m256i y_mask = _mm256_setr_epi8(0, -1, -1, -1, 3, -1, -1, -1, 6, -1, -1, -1, 9, -1, -1, -1, //
+	                                        0, -1, -1, -1, 3, -1, -1, -1, 6, -1, -1, -1, 9, -1, -1, -1);
+	const __m256i u_mask = _mm256_setr_epi8(1, -1, -1, -1, 4, -1, -1, -1, 7, -1, -1, -1, 10, -1, -1, -1, //
+	                                        1, -1, -1, -1, 4, -1, -1, -1, 7, -1, -1, -1, 10, -1, -1, -1);
+	const __m256i v_mask = _mm256_setr_epi8(2, -1, -1, -1, 5, -1, -1, -1, 8, -1, -1, -1, 11, -1, -1, -1, //
+	                                        2, -1, -1, -1, 5, -1, -1, -1, 8, -1, -1, -1, 11, -1, -1, -1);
+
+	uint32_t x = 0;
+
+	// Each lane loads 16 bytes of which 12 are used, same margin as the store.
+	for (; x + 10 <= width; x += 8) {
+		__m128i lo = _mm_loadu_si128((const __m128i *)(src + x * 3 + 0));
+		__m128i hi = _mm_loadu_si128((const __m128i *)(src + x * 3 + 12));
+		__m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+
+		__m256i y = _mm256_shuffle_epi8(in, y_mask);
+		__m256i u = _mm256_shuffle_epi8(in, u_mask);
+		__m256i v = _mm256_shuffle_epi8(in, v_mask);
+
+		avx2_store_rgb(dst + x * 3, avx2_yuv_to_rgb(y, u, v));
+	}
+
+	scalar_yuv888_to_r8g8b8(src + x * 3, dst + x * 3, width - x);
+}
+
+static const struct u_yuv_convert_funcs avx2_funcs = {
+    .name = "avx2",
+    .yuyv422_to_r8g8b8 = avx2_yuyv422_to_r8g8b8,
+    .uyvy422_to_r8g8b8 = avx2_uyvy422_to_r8g8b8,
+    .yuv888_to_r8g8b8 = avx2_yuv888_to_r8g8b8,
+};
+
+#endif // U_YUV_CONVERT_HAVE_X86
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+const struct u_yuv_convert_funcs *
+u_yuv_convert_get_scalar(void)
+{
+	return &scalar_funcs;
+}
+
+const struct u_yuv_convert_funcs *
+u_yuv_convert_get_sse41(void)
+{
+#ifdef U_YUV_CONVERT_HAVE_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse4.1")) {
+		return &sse41_funcs;
+	}
+#endif
+	return NULL;
+}
+
+const struct u_yuv_convert_funcs *
+u_yuv_convert_get_avx2(void)
+{
+#ifdef U_YUV_CONVERT_HAVE_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		return &avx2_funcs;
+	}
+#endif
+	return NULL;
+}
+
+const struct u_yuv_convert_funcs *
+u_yuv_convert_get_best(void)
+{
+	const struct u_yuv_convert_funcs *funcs = NULL;
+
+	funcs = u_yuv_convert_get_avx2();
+	if (funcs != NULL) {
+		return funcs;
+	}
+
+	funcs = u_yuv_convert_get_sse41();
+	if (funcs != NULL) {
+		return funcs;
+	}
+
+	return u_yuv_convert_get_scalar();
+}
@@ -0,0 +1,82 @@
+// Copyright 2019-2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  YUV to RGB conversion kernels, scalar and SIMD.
+ * @author Collabora, Ltd.
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Converts one row of @p width pixels from the source format to packed
+ * R8G8B8. The source rows for the 4:2:2 formats must have a even width.
+ *
+ * @ingroup aux_util
+ */
+typedef void (*u_yuv_convert_row_func)(const uint8_t *src, uint8_t *dst, uint32_t width);
+
+/*!
+ * A set of conversion kernels for one instruction set, all implementations
+ * produce bit-exact the same output as the scalar reference implementation.
+ *
+ * A NEON implementation slots in as just another one of these.
+ *
+ * @ingroup aux_util
+ */
+struct u_yuv_convert_funcs
+{
+	//! Name of the implementation, for logging.
+	const char *name;
+
+	u_yuv_convert_row_func yuyv422_to_r8g8b8;
+	u_yuv_convert_row_func uyvy422_to_r8g8b8;
+	u_yuv_convert_row_func yuv888_to_r8g8b8;
+};
+
+/*!
+ * The scalar reference implementation, always available.
+ *
+ * @ingroup aux_util
+ */
+const struct u_yuv_convert_funcs *
+u_yuv_convert_get_scalar(void);
+
+/*!
+ * The SSE4.1 implementation, returns NULL if not built or the CPU does not
+ * support it.
+ *
+ * @ingroup aux_util
+ */
+const struct u_yuv_convert_funcs *
+u_yuv_convert_get_sse41(void);
+
+/*!
+ * The AVX2 implementation, returns NULL if not built or the CPU does not
+ * support it.
+ *
+ * @ingroup aux_util
+ */
+const struct u_yuv_convert_funcs *
+u_yuv_convert_get_avx2(void);
+
+/*!
+ * The fastest implementation supported by the CPU we are running on.
+ *
+ * @ingroup aux_util
+ */
+const struct u_yuv_convert_funcs *
+u_yuv_convert_get_best(void);
+
+
+#ifdef __cplusplus
+}
+#endif
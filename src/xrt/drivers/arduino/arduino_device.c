@@ -27,6 +27,7 @@
 #include "util/u_device.h"
 #include "util/u_bitwise.h"
 #include "util/u_logging.h"
+#include "util/u_pose_publisher.h"
 
 #include "arduino_interface.h"
 
@@ -86,6 +87,9 @@ struct arduino_device
 		struct m_imu_pre_filter pre_filter;
 
 		struct m_imu_3dof fusion;
+
+		//! Latest fused pose, read without the lock.
+		struct u_pose_publisher pose_publisher;
 	};
 
 
@@ -143,6 +147,19 @@ read_i16(const uint8_t *buffer, size_t offset)
  *
  */
 
+static void
+publish_fusion_pose(struct arduino_device *ad, timepoint_ns timestamp_ns)
+{
+	struct xrt_space_relation relation = {0};
+	relation.pose.orientation = ad->fusion.rot;
+
+	//! @todo assuming that orientation is actually currently tracked.
+	relation.relation_flags = (enum xrt_space_relation_flags)(XRT_SPACE_RELATION_ORIENTATION_VALID_BIT |
+	                                                          XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT);
+
+	u_pose_publisher_publish(&ad->pose_publisher, timestamp_ns, &relation);
+}
+
 static void
 update_fusion(struct arduino_device *ad,
               struct arduino_parsed_sample *sample,
@@ -155,6 +172,7 @@ update_fusion(struct arduino_device *ad,
 	ad->device_time += (uint64_t)sample->delta * 1000;
 
 	m_imu_3dof_update(&ad->fusion, ad->device_time, &accel, &gyro);
+	publish_fusion_pose(ad, timestamp_ns);
 
 	double delta_device_ms = (double)sample->delta / 1000.0;
 	double delta_host_ms = (double)delta_ns / (1000.0 * 1000.0);
@@ -272,13 +290,13 @@ arduino_run_thread(void *ptr)
  */
 
 static void
-arduino_get_fusion_pose(struct arduino_device *ad, enum xrt_input_name name, struct xrt_space_relation *out_relation)
+arduino_get_fusion_pose(struct arduino_device *ad,
+                        enum xrt_input_name name,
+                        uint64_t at_timestamp_ns,
+                        struct xrt_space_relation *out_relation)
 {
-	out_relation->pose.orientation = ad->fusion.rot;
-
-	//! @todo assuming that orientation is actually currently tracked.
-	out_relation->relation_flags = (enum xrt_space_relation_flags)(XRT_SPACE_RELATION_ORIENTATION_VALID_BIT |
-	                                                               XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT);
+	// Doesn't take the lock, so never waits on the reading thread.
+	u_pose_publisher_get(&ad->pose_publisher, at_timestamp_ns, out_relation);
 }
 
 static void
@@ -335,8 +353,7 @@ arduino_device_get_tracked_pose(struct xrt_device *xdev,
 {
 	struct arduino_device *ad = arduino_device(xdev);
 
-	(void)at_timestamp_ns;
-	arduino_get_fusion_pose(ad, name, out_relation);
+	arduino_get_fusion_pose(ad, name, at_timestamp_ns, out_relation);
 }
 
 
@@ -398,6 +415,7 @@ arduino_device_create(struct os_ble_device *ble)
 	ad->ll = debug_get_log_option_arduino_log();
 
 	m_imu_3dof_init(&ad->fusion, M_IMU_3DOF_USE_GRAVITY_DUR_300MS);
+	publish_fusion_pose(ad, os_monotonic_get_ns());
 
 #define DEG_TO_RAD ((double)M_PI / 180.0)
 	float accel_ticks_to_float = (4.0 * MATH_GRAVITY_M_S2) / INT16_MAX;
@@ -630,31 +630,40 @@ psmv_led_and_trigger_update(struct psmv_device *psmv, int64_t time)
 	os_mutex_unlock(&psmv->lock);
 }
 
+/*!
+ * Applies the calibration to all of the samples of one report, they are then
+ * pushed to the tracker in one batch or fed one by one to the orientation
+ * only fusion.
+ */
 static void
 update_fusion(struct psmv_device *psmv,
-              struct psmv_parsed_sample *sample,
-              timepoint_ns timestamp_ns,
-              time_duration_ns delta_ns)
+              struct psmv_parsed_sample *samples,
+              const timepoint_ns *timestamps,
+              uint32_t count)
 {
 	struct xrt_vec3 mag = {0.0f, 0.0f, 0.0f};
 
 	(void)mag;
 
+	struct xrt_tracking_timed_sample timed[2];
+	assert(count <= ARRAY_SIZE(timed));
 
-	struct xrt_vec3_i32 *ra = &sample->accel;
-	struct xrt_vec3_i32 *rg = &sample->gyro;
+	for (uint32_t i = 0; i < count; i++) {
+		struct xrt_vec3_i32 *ra = &samples[i].accel;
+		struct xrt_vec3_i32 *rg = &samples[i].gyro;
 
-	m_imu_pre_filter_data(&psmv->calibration.prefilter, ra, rg, &psmv->read.accel, &psmv->read.gyro);
+		m_imu_pre_filter_data(&psmv->calibration.prefilter, ra, rg, &psmv->read.accel, &psmv->read.gyro);
 
-	if (psmv->ball != NULL) {
-		// We have positional tracking
-		struct xrt_tracking_sample sample;
-		sample.accel_m_s2 = psmv->read.accel;
-		sample.gyro_rad_secs = psmv->read.gyro;
+		if (psmv->ball != NULL) {
+			// We have positional tracking, push them all at once below.
+			timed[i].timestamp_ns = timestamps[i];
+			timed[i].sample.accel_m_s2 = psmv->read.accel;
+			timed[i].sample.gyro_rad_secs = psmv->read.gyro;
+			continue;
+		}
 
-		xrt_tracked_psmv_push_imu(psmv->ball, timestamp_ns, &sample);
-	} else {
 		// Orientation-only tracking
+		timepoint_ns timestamp_ns = timestamps[i];
 
 #if 0
 		// Super simple fusion.
@@ -668,6 +677,10 @@ update_fusion(struct psmv_device *psmv,
 		imu_fusion_get_prediction_rotation_vec(psmv->fusion.fusion, timestamp_ns, &psmv->fusion.rotvec);
 #endif
 	}
+
+	if (psmv->ball != NULL) {
+		xrt_tracked_psmv_push_imu_batch(psmv->ball, timed, count);
+	}
 }
 
 /*!
@@ -747,12 +760,12 @@ psmv_run_thread(void *ptr)
 		// Process the parsed data.
 		if (num == 2) {
 			// ZCM1
-			update_fusion(psmv, &input.samples[0], now_ns - (delta_ns / 2.0), (delta_ns / 2.0));
-			update_fusion(psmv, &input.samples[1], now_ns, (delta_ns / 2.0));
+			timepoint_ns timestamps[2] = {now_ns - (delta_ns / 2.0), now_ns};
+			update_fusion(psmv, input.samples, timestamps, 2);
 			psmv->last_timestamp_ns = now_ns;
 		} else if (num == 1) {
 			// ZCM2
-			update_fusion(psmv, &input.sample, now_ns, delta_ns);
+			update_fusion(psmv, &input.sample, &now_ns, 1);
 			psmv->last_timestamp_ns = now_ns;
 		} else {
 			assert(false);
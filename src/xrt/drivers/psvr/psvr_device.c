@@ -32,6 +32,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <assert.h>
 
 #include "psvr_device.h"
 
@@ -295,22 +296,34 @@ read_sample_and_apply_calibration(struct psvr_device *psvr,
 	*out_gyro = gyro;
 }
 
+/*!
+ * Applies the calibration to all of the samples of one report and feeds them
+ * to the tracker or fusion in one batch.
+ */
 static void
-update_fusion(struct psvr_device *psvr, struct psvr_parsed_sample *sample, uint64_t timestamp_ns)
+update_fusion(struct psvr_device *psvr,
+              struct psvr_parsed_sample *samples,
+              const timepoint_ns *timestamps,
+              uint32_t count)
 {
 	struct xrt_vec3 mag = {0.0f, 0.0f, 0.0f};
 	(void)mag;
 
-	read_sample_and_apply_calibration(psvr, sample, &psvr->read.accel, &psvr->read.gyro);
+	struct xrt_tracking_timed_sample timed[2];
+	assert(count <= ARRAY_SIZE(timed));
 
-	if (psvr->tracker != NULL) {
-		struct xrt_tracking_sample sample;
-		sample.accel_m_s2 = psvr->read.accel;
-		sample.gyro_rad_secs = psvr->read.gyro;
+	for (uint32_t i = 0; i < count; i++) {
+		read_sample_and_apply_calibration(psvr, &samples[i], &psvr->read.accel, &psvr->read.gyro);
+
+		timed[i].timestamp_ns = timestamps[i];
+		timed[i].sample.accel_m_s2 = psvr->read.accel;
+		timed[i].sample.gyro_rad_secs = psvr->read.gyro;
+	}
 
-		xrt_tracked_psvr_push_imu(psvr->tracker, timestamp_ns, &sample);
+	if (psvr->tracker != NULL) {
+		xrt_tracked_psvr_push_imu_batch(psvr->tracker, timed, count);
 	} else {
-		m_imu_3dof_update(&psvr->fusion, timestamp_ns, &psvr->read.accel, &psvr->read.gyro);
+		m_imu_3dof_update_batch(&psvr->fusion, timed, count);
 	}
 }
 
@@ -385,16 +398,12 @@ handle_tracker_sensor_msg(struct psvr_device *psvr, unsigned char *buffer, int s
 	timepoint_ns timestamp_ns = (uint64_t)now_ns - (uint64_t)inter_sample_duration_ns;
 
 	// Make sure timestamps are always after a previous timestamp.
-	timestamp_ns = ensure_forward_progress_timestamps(psvr, timestamp_ns);
-
-	// Update the fusion with first sample.
-	update_fusion(psvr, &s->samples[0], timestamp_ns);
-
-	// Make sure timestamps are always after a previous timestamp.
-	timestamp_ns = ensure_forward_progress_timestamps(psvr, now_ns);
+	timepoint_ns timestamps[2];
+	timestamps[0] = ensure_forward_progress_timestamps(psvr, timestamp_ns);
+	timestamps[1] = ensure_forward_progress_timestamps(psvr, now_ns);
 
-	// Update the fusion with second sample.
-	update_fusion(psvr, &s->samples[1], timestamp_ns);
+	// Update the fusion with both samples.
+	update_fusion(psvr, s->samples, timestamps, 2);
 }
 
 static void
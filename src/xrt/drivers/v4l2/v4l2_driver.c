@@ -15,6 +15,7 @@
 #include "util/u_debug.h"
 #include "util/u_format.h"
 #include "util/u_logging.h"
+#include "util/u_latency_histogram.h"
 
 #include "v4l2_interface.h"
 
@@ -161,6 +162,9 @@ struct v4l2_fs
 	bool is_configured;
 	bool is_running;
 	enum u_logging_level ll;
+
+	//! Time from capture until the frame is pushed to the sink.
+	struct u_latency_histogram latency;
 };
 
 /*!
@@ -788,6 +792,7 @@ v4l2_fs_create(struct xrt_frame_context *xfctx,
 	for (size_t i = 0; i < vid->num_states; i++) {
 		u_var_add_i32(vid, &vid->states[i].want[0].value, vid->states[i].name);
 	}
+	u_latency_histogram_add_vars(&vid->latency, vid, "Capture latency");
 	// clang-format on
 
 	v4l2_list_modes(vid);
@@ -907,7 +912,6 @@ v4l2_fs_stream_run(void *ptr)
 		xrt_frame_reference(&xf, &vf->base);
 		uint8_t *data = (uint8_t *)vf->mem;
 
-		//! @todo Sequence number and timestamp.
 		xf->width = desc->base.width;
 		xf->height = desc->base.height;
 		xf->format = desc->base.format;
@@ -918,11 +922,20 @@ v4l2_fs_stream_run(void *ptr)
 		xf->size = v_buf.bytesused - desc->offset;
 		xf->source_id = vid->base.source_id;
 		xf->source_sequence = v_buf.sequence;
+		xf->source_timestamp = os_timeval_to_ns(&v_buf.timestamp);
+
+		uint64_t now_ns = os_monotonic_get_ns();
 
-		if ((v_buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC) != 0) {
-			xf->timestamp = os_timeval_to_ns(&v_buf.timestamp);
+		// Only monotonic kernel timestamps are in our time domain,
+		// otherwise dequeue time is the best we got.
+		if ((v_buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC) {
+			xf->timestamp = xf->source_timestamp;
+		} else {
+			xf->timestamp = now_ns;
 		}
 
+		u_latency_histogram_add(&vid->latency, now_ns > xf->timestamp ? now_ns - xf->timestamp : 0);
+
 		vid->sink->push_frame(vid->sink, xf);
 
 		// The frame is requeued as soon as the refcount reaches zero,
@@ -16,12 +16,14 @@
 #include "util/u_misc.h"
 #include "util/u_debug.h"
 #include "util/u_format.h"
-#include "util/u_frame.h"
+#include "util/u_frame_pool.h"
 #include "util/u_logging.h"
+#include "util/u_latency_histogram.h"
 
 
 #include <stdio.h>
 #include <assert.h>
+#include <inttypes.h>
 
 #include "vf_interface.h"
 
@@ -81,6 +83,9 @@ struct vf_fs
 	enum xrt_fs_capture_type capture_type;
 	struct xrt_frame_sink *sink;
 
+	//! Decoded samples are copied into frames from this pool.
+	struct u_frame_pool *pool;
+
 	uint32_t selected;
 
 	struct xrt_fs_capture_parameters capture_params;
@@ -88,6 +93,12 @@ struct vf_fs
 	bool is_configured;
 	bool is_running;
 	enum u_logging_level ll;
+
+	//! Used when the buffers don't carry a sequence number.
+	uint64_t sequence;
+
+	//! Time from capture until the frame is pushed to the sink.
+	struct u_latency_histogram latency;
 };
 
 /*!
@@ -197,6 +208,10 @@ vf_fs_destroy(struct vf_fs *vid)
 	os_thread_helper_stop(&vid->play_thread);
 	os_thread_helper_destroy(&vid->play_thread);
 
+	u_var_remove_root(vid);
+
+	u_frame_pool_destroy(&vid->pool);
+
 	free(vid);
 }
 
@@ -216,6 +231,36 @@ vf_fs_node_destroy(struct xrt_frame_node *node)
 
 #include <gst/video/video-frame.h>
 
+/*!
+ * Work out when the buffer was captured in the @ref os_monotonic_get_ns time
+ * domain, the PTS is the running time in the pipeline clock so we measure how
+ * long ago that was on the pipeline clock. Falls back to @p now_ns.
+ */
+static uint64_t
+get_capture_time_ns(struct vf_fs *vid, GstBuffer *buffer, uint64_t now_ns)
+{
+	GstClockTime pts = GST_BUFFER_PTS(buffer);
+	if (!GST_CLOCK_TIME_IS_VALID(pts)) {
+		return now_ns;
+	}
+
+	GstClock *clock = gst_element_get_clock(vid->source);
+	if (clock == NULL) {
+		return now_ns;
+	}
+
+	GstClockTime capture_clock = gst_element_get_base_time(vid->source) + pts;
+	GstClockTime clock_now = gst_clock_get_time(clock);
+	gst_object_unref(clock);
+
+	// Not played back in real time, or in the future.
+	if (clock_now < capture_clock || clock_now - capture_clock > now_ns) {
+		return now_ns;
+	}
+
+	return now_ns - (clock_now - capture_clock);
+}
+
 void
 vf_fs_frame(struct vf_fs *vid, GstSample *sample)
 {
@@ -223,7 +268,10 @@ vf_fs_frame(struct vf_fs *vid, GstSample *sample)
 	buffer = gst_sample_get_buffer(sample);
 	GstCaps *caps = gst_sample_get_caps(sample);
 
-	static int seq = 0;
+	uint64_t seq = vid->sequence++;
+	if (GST_BUFFER_OFFSET_IS_VALID(buffer)) {
+		seq = GST_BUFFER_OFFSET(buffer);
+	}
 
 	GstVideoFrame frame;
 	GstVideoInfo info;
@@ -235,32 +283,39 @@ vf_fs_frame(struct vf_fs *vid, GstSample *sample)
 
 		struct xrt_frame *xf = NULL;
 
-		u_frame_create_one_off(vid->format, vid->width, vid->height, &xf);
-
-		//! @todo Sequence number and timestamp.
-		xf->width = vid->width;
-		xf->height = vid->height;
-		xf->format = vid->format;
-		xf->stereo_format = vid->stereo_format;
-
-		xf->data = frame.data[plane];
-		xf->stride = info.stride[plane];
-		xf->size = info.size;
-		xf->source_id = vid->base.source_id;
-		xf->source_sequence = seq;
-		xf->timestamp = os_monotonic_get_ns();
-		if (vid->sink) {
-			vid->sink->push_frame(vid->sink, xf);
-			// The frame is requeued as soon as the refcount reaches
-			// zero, this can be done safely from another thread.
-			// xrt_frame_reference(&xf, NULL);
+		u_frame_pool_create_frame(vid->pool, vid->format, vid->width, vid->height, &xf);
+		if (xf == NULL) {
+			VF_ERROR(vid, "Failed to allocate frame %" PRIu64, seq);
+		} else {
+			uint64_t now_ns = os_monotonic_get_ns();
+
+			xf->stereo_format = vid->stereo_format;
+			xf->source_id = vid->base.source_id;
+			xf->source_sequence = seq;
+			xf->source_timestamp = GST_CLOCK_TIME_IS_VALID(GST_BUFFER_PTS(buffer)) ? GST_BUFFER_PTS(buffer) : 0;
+			xf->timestamp = get_capture_time_ns(vid, buffer, now_ns);
+
+			// The mapped memory is only valid until unmapped, so copy it.
+			const uint8_t *src = (const uint8_t *)frame.data[plane];
+			size_t src_stride = info.stride[plane];
+			size_t row_size = src_stride < xf->stride ? src_stride : xf->stride;
+			for (int y = 0; y < vid->height; y++) {
+				memcpy(xf->data + y * xf->stride, src + y * src_stride, row_size);
+			}
+
+			if (vid->sink) {
+				u_latency_histogram_add(&vid->latency, os_monotonic_get_ns() - xf->timestamp);
+				vid->sink->push_frame(vid->sink, xf);
+			}
+
+			// The frame goes back to the pool once all references are gone.
+			xrt_frame_reference(&xf, NULL);
 		}
+
 		gst_video_frame_unmap(&frame);
 	} else {
-		VF_ERROR(vid, "Failed to map frame %d", seq);
+		VF_ERROR(vid, "Failed to map frame %" PRIu64, seq);
 	}
-
-	seq++;
 }
 
 static GstFlowReturn
@@ -356,6 +411,7 @@ alloc_and_init_common(struct xrt_frame_context *xfctx,      //
 	vid->got_sample = false;
 	vid->format = format;
 	vid->stereo_format = stereo_format;
+	u_frame_pool_create(&vid->pool, "Video file frame pool", U_FRAME_POOL_DEFAULT_MAX_FREE);
 
 	GstBus *bus = NULL;
 
@@ -422,6 +478,7 @@ alloc_and_init_common(struct xrt_frame_context *xfctx,      //
 	u_var_add_root(vid, "Video File Frameserver", true);
 	u_var_add_ro_text(vid, vid->base.name, "Card");
 	u_var_add_ro_u32(vid, &vid->ll, "Log Level");
+	u_latency_histogram_add_vars(&vid->latency, vid, "Capture latency");
 	// clang-format on
 
 	return &(vid->base);
@@ -22,7 +22,6 @@
 #include "xrt/xrt_prober.h"
 
 #include "math/m_api.h"
-#include "math/m_predict.h"
 #include "util/u_debug.h"
 #include "util/u_device.h"
 #include "util/u_json.h"
@@ -356,22 +355,26 @@ vive_controller_get_hand_tracking(struct xrt_device *xdev,
 }
 
 static void
-predict_pose(struct vive_controller_device *d, uint64_t at_timestamp_ns, struct xrt_space_relation *out_relation)
+publish_pose(struct vive_controller_device *d)
 {
-	timepoint_ns prediction_ns = at_timestamp_ns - d->imu.ts_received_ns;
-	double prediction_s = time_ns_to_s(prediction_ns);
-
-	timepoint_ns monotonic_now_ns = os_monotonic_get_ns();
-	timepoint_ns remaining_ns = at_timestamp_ns - monotonic_now_ns;
-	VIVE_TRACE(d, "dev %s At %ldns: Pose requested for +%ldns (%ldns), predicting %ldns", d->base.str,
-	           monotonic_now_ns, remaining_ns, at_timestamp_ns, prediction_ns);
-
 	//! @todo integrate position here
 	struct xrt_space_relation relation = {0};
 	relation.pose.orientation = d->rot_filtered;
 	relation.relation_flags = XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT;
 
-	m_predict_relation(&relation, prediction_s, out_relation);
+	u_pose_publisher_publish(&d->pose_publisher, d->imu.ts_received_ns, &relation);
+}
+
+static void
+predict_pose(struct vive_controller_device *d, uint64_t at_timestamp_ns, struct xrt_space_relation *out_relation)
+{
+	timepoint_ns monotonic_now_ns = os_monotonic_get_ns();
+	timepoint_ns remaining_ns = at_timestamp_ns - monotonic_now_ns;
+	VIVE_TRACE(d, "dev %s At %ldns: Pose requested for +%ldns (%ldns)", d->base.str, monotonic_now_ns,
+	           remaining_ns, at_timestamp_ns);
+
+	// Predicts from when the pose was published, doesn't block the controller thread.
+	u_pose_publisher_get(&d->pose_publisher, at_timestamp_ns, out_relation);
 }
 
 static void
@@ -392,9 +395,7 @@ vive_controller_device_get_tracked_pose(struct xrt_device *xdev,
 	// Clear out the relation.
 	U_ZERO(out_relation);
 
-	os_mutex_lock(&d->lock);
 	predict_pose(d, at_timestamp_ns, out_relation);
-	os_mutex_unlock(&d->lock);
 
 	struct xrt_vec3 pos = out_relation->pose.position;
 	struct xrt_quat quat = out_relation->pose.orientation;
@@ -607,6 +608,7 @@ vive_controller_handle_imu_sample(struct vive_controller_device *d, struct watch
 	m_imu_3dof_update(&d->fusion, d->imu.time_ns, &acceleration, &angular_velocity);
 
 	d->rot_filtered = d->fusion.rot;
+	publish_pose(d);
 
 	//      VIVE_TRACE(d, "Rot %f %f %f", d->rot_filtered.x,
 	//                           d->rot_filtered.y, d->rot_filtered.z);
@@ -1048,6 +1050,11 @@ vive_controller_create(struct os_hid_device *controller_hid, enum watchman_gen w
 
 	m_imu_3dof_init(&d->fusion, M_IMU_3DOF_USE_GRAVITY_DUR_20MS);
 
+	// Identity until the first IMU sample has been fused.
+	d->rot_filtered = (struct xrt_quat){0, 0, 0, 1};
+	d->imu.ts_received_ns = os_monotonic_get_ns();
+	publish_pose(d);
+
 	/* default values, will be queried from device */
 	d->config.imu.gyro_range = 8.726646f;
 	d->config.imu.acc_range = 39.226600f;
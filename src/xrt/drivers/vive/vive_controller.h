@@ -18,6 +18,7 @@
 #include "math/m_imu_3dof.h"
 #include "util/u_logging.h"
 #include "util/u_hand_tracking.h"
+#include "util/u_pose_publisher.h"
 #include "vive/vive_config.h"
 
 
@@ -68,6 +69,9 @@ struct vive_controller_device
 
 	struct xrt_quat rot_filtered;
 
+	//! Latest fused pose, read by get_tracked_pose without the lock.
+	struct u_pose_publisher pose_publisher;
+
 	enum u_logging_level ll;
 
 	uint32_t last_ticks;
@@ -19,7 +19,6 @@
 #include "util/u_time.h"
 
 #include "math/m_api.h"
-#include "math/m_predict.h"
 
 #include "os/os_hid.h"
 #include "os/os_time.h"
@@ -94,22 +93,26 @@ vive_device_update_inputs(struct xrt_device *xdev)
 }
 
 static void
-predict_pose(struct vive_device *d, uint64_t at_timestamp_ns, struct xrt_space_relation *out_relation)
+publish_pose(struct vive_device *d)
 {
-	timepoint_ns prediction_ns = at_timestamp_ns - d->imu.ts_received_ns;
-	double prediction_s = time_ns_to_s(prediction_ns);
-
-	timepoint_ns monotonic_now_ns = os_monotonic_get_ns();
-	timepoint_ns remaining_ns = at_timestamp_ns - monotonic_now_ns;
-	VIVE_TRACE(d, "dev %s At %ldns: Pose requested for +%ldns (%ldns), predicting %ldns", d->base.str,
-	           monotonic_now_ns, remaining_ns, at_timestamp_ns, prediction_ns);
-
 	//! @todo integrate position here
 	struct xrt_space_relation relation = {0};
 	relation.pose.orientation = d->rot_filtered;
 	relation.relation_flags = XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT;
 
-	m_predict_relation(&relation, prediction_s, out_relation);
+	u_pose_publisher_publish(&d->pose_publisher, d->imu.ts_received_ns, &relation);
+}
+
+static void
+predict_pose(struct vive_device *d, uint64_t at_timestamp_ns, struct xrt_space_relation *out_relation)
+{
+	timepoint_ns monotonic_now_ns = os_monotonic_get_ns();
+	timepoint_ns remaining_ns = at_timestamp_ns - monotonic_now_ns;
+	VIVE_TRACE(d, "dev %s At %ldns: Pose requested for +%ldns (%ldns)", d->base.str, monotonic_now_ns,
+	           remaining_ns, at_timestamp_ns);
+
+	// Predicts from when the pose was published, doesn't block the sensors thread.
+	u_pose_publisher_get(&d->pose_publisher, at_timestamp_ns, out_relation);
 }
 
 static void
@@ -128,12 +131,7 @@ vive_device_get_tracked_pose(struct xrt_device *xdev,
 	// Clear out the relation.
 	U_ZERO(out_relation);
 
-	//! @todo Use this properly.
-	(void)at_timestamp_ns;
-
-	os_mutex_lock(&d->lock);
 	predict_pose(d, at_timestamp_ns, out_relation);
-	os_mutex_unlock(&d->lock);
 }
 
 static void
@@ -294,6 +292,10 @@ update_imu(struct vive_device *d, const void *buffer)
 	d->imu.ts_received_ns = os_monotonic_get_ns();
 	int i, j;
 
+	// New samples are fused in one batch after the loop.
+	struct xrt_tracking_timed_sample timed[3];
+	uint32_t num_timed = 0;
+
 	/*
 	 * The three samples are updated round-robin. New messages
 	 * can contain already seen samples in any place, but the
@@ -393,10 +395,20 @@ update_imu(struct vive_device *d, const void *buffer)
 		d->last.gyro = angular_velocity;
 		d->imu.sequence = seq;
 
-		m_imu_3dof_update(&d->fusion, d->imu.time_ns, &acceleration, &angular_velocity);
+		timed[num_timed].timestamp_ns = d->imu.time_ns;
+		timed[num_timed].sample.accel_m_s2 = acceleration;
+		timed[num_timed].sample.gyro_rad_secs = angular_velocity;
+		num_timed++;
+	}
 
-		d->rot_filtered = d->fusion.rot;
+	if (num_timed == 0) {
+		return;
 	}
+
+	m_imu_3dof_update_batch(&d->fusion, timed, num_timed);
+
+	d->rot_filtered = d->fusion.rot;
+	publish_pose(d);
 }
 
 
@@ -857,6 +869,11 @@ vive_device_create(struct os_hid_device *mainboard_dev,
 	// Init here.
 	m_imu_3dof_init(&d->fusion, M_IMU_3DOF_USE_GRAVITY_DUR_20MS);
 
+	// Identity until the first IMU sample has been fused.
+	d->rot_filtered = (struct xrt_quat){0, 0, 0, 1};
+	d->imu.ts_received_ns = os_monotonic_get_ns();
+	publish_pose(d);
+
 	u_var_add_root(d, "Vive Device", true);
 	u_var_add_gui_header(d, &d->gui.calibration, "Calibration");
 	u_var_add_vec3_f32(d, &d->config.imu.acc_scale, "acc_scale");
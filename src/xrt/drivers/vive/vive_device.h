@@ -13,6 +13,7 @@
 #include "math/m_imu_3dof.h"
 #include "os/os_threading.h"
 #include "util/u_logging.h"
+#include "util/u_pose_publisher.h"
 #include "util/u_distortion_mesh.h"
 #include "vive/vive_config.h"
 
@@ -67,6 +68,9 @@ struct vive_device
 
 	struct xrt_quat rot_filtered;
 
+	//! Latest fused pose, read by get_tracked_pose without the lock.
+	struct u_pose_publisher pose_publisher;
+
 	enum u_logging_level ll;
 	bool disconnect_notified;
 
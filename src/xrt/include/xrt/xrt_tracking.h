@@ -122,6 +122,15 @@ struct xrt_tracking_sample
 	struct xrt_vec3 gyro_rad_secs;
 };
 
+/*!
+ * IMU Sample with the time it was taken, used to push several samples at once.
+ */
+struct xrt_tracking_timed_sample
+{
+	timepoint_ns timestamp_ns;
+	struct xrt_tracking_sample sample;
+};
+
 /*!
  * @interface xrt_tracked_psmv
  *
@@ -145,6 +154,14 @@ struct xrt_tracked_psmv
 	 */
 	void (*push_imu)(struct xrt_tracked_psmv *, timepoint_ns timestamp_ns, struct xrt_tracking_sample *sample);
 
+	/*!
+	 * Push several IMU samples in timestamp order into the tracking system,
+	 * typically all of the samples from one report.
+	 */
+	void (*push_imu_batch)(struct xrt_tracked_psmv *,
+	                       const struct xrt_tracking_timed_sample *samples,
+	                       uint32_t count);
+
 	/*!
 	 * Called by the owning @ref xrt_device @ref xdev to get the pose of
 	 * the ball in the tracking space at the given time.
@@ -184,6 +201,14 @@ struct xrt_tracked_psvr
 	 */
 	void (*push_imu)(struct xrt_tracked_psvr *, timepoint_ns timestamp_ns, struct xrt_tracking_sample *sample);
 
+	/*!
+	 * Push several IMU samples in timestamp order into the tracking system,
+	 * typically all of the samples from one report.
+	 */
+	void (*push_imu_batch)(struct xrt_tracked_psvr *,
+	                       const struct xrt_tracking_timed_sample *samples,
+	                       uint32_t count);
+
 	/*!
 	 * Called by the owning @ref xrt_device @ref xdev to get the pose of
 	 * the psvr in the tracking space at the given time.
@@ -250,6 +275,15 @@ xrt_tracked_psmv_push_imu(struct xrt_tracked_psmv *psmv, timepoint_ns timestamp_
 	psmv->push_imu(psmv, timestamp_ns, sample);
 }
 
+//! @public @memberof xrt_tracked_psmv
+static inline void
+xrt_tracked_psmv_push_imu_batch(struct xrt_tracked_psmv *psmv,
+                                const struct xrt_tracking_timed_sample *samples,
+                                uint32_t count)
+{
+	psmv->push_imu_batch(psmv, samples, count);
+}
+
 //! @public @memberof xrt_tracked_psmv
 static inline void
 xrt_tracked_psmv_destroy(struct xrt_tracked_psmv **xtmv_ptr)
@@ -279,6 +313,15 @@ xrt_tracked_psvr_push_imu(struct xrt_tracked_psvr *psvr, timepoint_ns timestamp_
 	psvr->push_imu(psvr, timestamp_ns, sample);
 }
 
+//! @public @memberof xrt_tracked_psmv
+static inline void
+xrt_tracked_psvr_push_imu_batch(struct xrt_tracked_psvr *psvr,
+                                const struct xrt_tracking_timed_sample *samples,
+                                uint32_t count)
+{
+	psvr->push_imu_batch(psvr, samples, count);
+}
+
 //! @public @memberof xrt_tracked_psmv
 static inline void
 xrt_tracked_psvr_destroy(struct xrt_tracked_psvr **xtvr_ptr)
@@ -54,11 +54,40 @@ struct ipc_connection
 
 	struct os_mutex mutex;
 
+	/*!
+	 * Our command ring in the shared memory if we use it, protected by
+	 * @ref mutex just like the socket.
+	 */
+	struct ipc_shared_command_ring *command_ring;
+
 #ifdef XRT_OS_ANDROID
 	struct ipc_client_android *ica;
 #endif // XRT_OS_ANDROID
 
 	enum u_logging_level ll;
+
+	//! Always ask the server for poses, don't use the pose rings.
+	bool exact_poses;
+
+	/*!
+	 * @name Batched input updates
+	 * Protected by @ref inputs_mutex.
+	 * @{
+	 */
+	struct os_mutex inputs_mutex;
+
+	//! Our slot in @ref ipc_shared_memory::input_slots.
+	uint32_t input_slot;
+
+	//! Our copy of the inputs, the devices point into it.
+	struct ipc_shared_input_buffer inputs;
+
+	//! When the last batched update was done.
+	uint64_t inputs_updated_ns;
+
+	//! Devices that have not been handed the last batched update yet.
+	bool inputs_pending[IPC_SHARED_MAX_DEVICES];
+	/*! @} */
 };
 
 /*
@@ -67,6 +96,40 @@ struct ipc_connection
  *
  */
 
+/*!
+ * Can a call with a reply of @p reply_size go over the command ring, used by
+ * the generated code.
+ */
+static inline bool
+ipc_client_command_ring_enabled(struct ipc_connection *ipc_c, size_t reply_size)
+{
+	return ipc_c->command_ring != NULL && reply_size <= IPC_COMMAND_RING_REPLY_SIZE;
+}
+
+/*!
+ * Do a call over the command ring, must be called with @ref
+ * ipc_connection::mutex held. Used by the generated code.
+ */
+xrt_result_t
+ipc_client_command_ring_call(
+    struct ipc_connection *ipc_c, const void *msg, size_t msg_size, void *out_reply, size_t reply_size);
+
+/*!
+ * Send a request that has no reply, over the command ring if we use it.
+ * Errors from handling it are returned by the next synchronous call. Must be
+ * called with @ref ipc_connection::mutex held. Used by the generated code.
+ */
+xrt_result_t
+ipc_client_send_async(struct ipc_connection *ipc_c, const void *msg, size_t msg_size);
+
+/*!
+ * If we use the command ring tell the server that the next request comes
+ * over the socket, must be called with @ref ipc_connection::mutex held. Used
+ * by the generated code.
+ */
+xrt_result_t
+ipc_client_command_ring_use_socket(struct ipc_connection *ipc_c);
+
 /*!
  * Create an IPC client system compositor.
  *
@@ -85,5 +148,27 @@ ipc_client_create_system_compositor(struct ipc_connection *ipc_c,
 struct xrt_device *
 ipc_client_hmd_create(struct ipc_connection *ipc_c, struct xrt_tracking_origin *xtrack, uint32_t device_id);
 
+/*!
+ * Update the inputs of a device, the first device asking updates the inputs
+ * of all devices in one call and the others then use that update. So a
+ * state tracker updating all of its devices in a row only does one round
+ * trip to the server.
+ */
+xrt_result_t
+ipc_client_update_inputs(struct ipc_connection *ipc_c, uint32_t device_id);
+
+/*!
+ * Get the pose from the pose ring that the server publishes in the shared
+ * memory, predicting it on this side. Returns false if the pose has to be
+ * got from the server instead, because there is no ring for it, the input
+ * isn't active or @ref ipc_connection::exact_poses is set.
+ */
+bool
+ipc_client_get_pose_from_ring(struct ipc_connection *ipc_c,
+                              uint32_t device_id,
+                              enum xrt_input_name name,
+                              uint64_t at_timestamp_ns,
+                              struct xrt_space_relation *out_relation);
+
 struct xrt_device *
 ipc_client_device_create(struct ipc_connection *ipc_c, struct xrt_tracking_origin *xtrack, uint32_t device_id);
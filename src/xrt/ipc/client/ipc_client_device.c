@@ -25,6 +25,8 @@
 #include "util/u_debug.h"
 #include "util/u_device.h"
 
+#include "shared/ipc_pose_ring.h"
+#include "shared/ipc_input_slot.h"
 #include "client/ipc_client.h"
 #include "ipc_client_generated.h"
 
@@ -35,6 +37,9 @@
  *
  */
 
+//! How long a batched input update can be used by the other devices.
+#define IPC_CLIENT_INPUTS_MAX_AGE_NS (U_TIME_1MS_IN_NS * 2)
+
 /*!
  * An IPC client proxy for an @ref xrt_device.
  * @implements xrt_device
@@ -82,7 +87,7 @@ ipc_client_device_update_inputs(struct xrt_device *xdev)
 {
 	struct ipc_client_device *icd = ipc_client_device(xdev);
 
-	xrt_result_t r = ipc_call_device_update_input(icd->ipc_c, icd->device_id);
+	xrt_result_t r = ipc_client_update_inputs(icd->ipc_c, icd->device_id);
 	if (r != XRT_SUCCESS) {
 		IPC_ERROR(icd->ipc_c, "Error sending input update!");
 	}
@@ -96,6 +101,10 @@ ipc_client_device_get_tracked_pose(struct xrt_device *xdev,
 {
 	struct ipc_client_device *icd = ipc_client_device(xdev);
 
+	if (ipc_client_get_pose_from_ring(icd->ipc_c, icd->device_id, name, at_timestamp_ns, out_relation)) {
+		return;
+	}
+
 	xrt_result_t r =
 	    ipc_call_device_get_tracked_pose(icd->ipc_c, icd->device_id, name, at_timestamp_ns, out_relation);
 	if (r != XRT_SUCCESS) {
@@ -103,6 +112,81 @@ ipc_client_device_get_tracked_pose(struct xrt_device *xdev,
 	}
 }
 
+xrt_result_t
+ipc_client_update_inputs(struct ipc_connection *ipc_c, uint32_t device_id)
+{
+	struct ipc_shared_memory *ism = ipc_c->ism;
+	uint64_t now_ns = os_monotonic_get_ns();
+	xrt_result_t r = XRT_SUCCESS;
+
+	os_mutex_lock(&ipc_c->inputs_mutex);
+
+	// Don't hand out an old update to a device that wasn't updated with the others.
+	bool fresh = now_ns - ipc_c->inputs_updated_ns < IPC_CLIENT_INPUTS_MAX_AGE_NS;
+
+	if (!fresh || !ipc_c->inputs_pending[device_id]) {
+		uint64_t generation = 0;
+		r = ipc_call_device_update_inputs_all(ipc_c, &generation);
+		ipc_c->inputs_updated_ns = now_ns;
+
+		// Only read the slot if something changed, and then only the devices that did.
+		if (r == XRT_SUCCESS && generation != ipc_c->inputs.generation) {
+			ipc_input_slot_read(ism, ipc_c->input_slot, &ipc_c->inputs);
+		}
+
+		for (uint32_t i = 0; i < ism->num_isdevs; i++) {
+			ipc_c->inputs_pending[i] = r == XRT_SUCCESS;
+		}
+	}
+
+	ipc_c->inputs_pending[device_id] = false;
+
+	os_mutex_unlock(&ipc_c->inputs_mutex);
+
+	return r;
+}
+
+bool
+ipc_client_get_pose_from_ring(struct ipc_connection *ipc_c,
+                              uint32_t device_id,
+                              enum xrt_input_name name,
+                              uint64_t at_timestamp_ns,
+                              struct xrt_space_relation *out_relation)
+{
+	if (ipc_c->exact_poses) {
+		return false;
+	}
+
+	struct ipc_shared_memory *ism = ipc_c->ism;
+	struct ipc_shared_device *isdev = &ism->isdevs[device_id];
+	struct xrt_input *inputs = &ipc_c->inputs.inputs[isdev->first_input_index];
+
+	/*
+	 * Let the server sort out inactive and disabled inputs, it clears the
+	 * active flag when the device or this client has IO disabled. The
+	 * rings themselves only know about the device, so a client that has
+	 * its IO disabled still gets ring poses until its next input update.
+	 */
+	bool active = false;
+	for (uint32_t i = 0; i < isdev->num_inputs; i++) {
+		if (inputs[i].name == name) {
+			active = inputs[i].active;
+			break;
+		}
+	}
+
+	if (!active) {
+		return false;
+	}
+
+	struct ipc_shared_pose_ring *ring = ipc_pose_ring_find(ism, device_id, name);
+	if (ring == NULL) {
+		return false;
+	}
+
+	return ipc_pose_ring_get(ring, (timepoint_ns)at_timestamp_ns, out_relation);
+}
+
 void
 ipc_client_device_get_hand_tracking(struct xrt_device *xdev,
                                     enum xrt_input_name name,
@@ -167,9 +251,9 @@ ipc_client_device_create(struct ipc_connection *ipc_c, struct xrt_tracking_origi
 	// Print name.
 	snprintf(icd->base.str, XRT_DEVICE_NAME_LEN, "%s", isdev->str);
 
-	// Setup inputs, by pointing directly to the shared memory.
+	// Setup inputs, by pointing directly to the connection's copy.
 	assert(isdev->num_inputs > 0);
-	icd->base.inputs = &ism->inputs[isdev->first_input_index];
+	icd->base.inputs = &ipc_c->inputs.inputs[isdev->first_input_index];
 	icd->base.num_inputs = isdev->num_inputs;
 
 	// Setup outputs, if any point directly into the shared memory.
@@ -83,7 +83,7 @@ ipc_client_hmd_update_inputs(struct xrt_device *xdev)
 {
 	struct ipc_client_hmd *ich = ipc_client_hmd(xdev);
 
-	xrt_result_t r = ipc_call_device_update_input(ich->ipc_c, ich->device_id);
+	xrt_result_t r = ipc_client_update_inputs(ich->ipc_c, ich->device_id);
 	if (r != XRT_SUCCESS) {
 		IPC_ERROR(ich->ipc_c, "Error calling input update!");
 	}
@@ -97,6 +97,10 @@ ipc_client_hmd_get_tracked_pose(struct xrt_device *xdev,
 {
 	struct ipc_client_hmd *ich = ipc_client_hmd(xdev);
 
+	if (ipc_client_get_pose_from_ring(ich->ipc_c, ich->device_id, name, at_timestamp_ns, out_relation)) {
+		return;
+	}
+
 	xrt_result_t r =
 	    ipc_call_device_get_tracked_pose(ich->ipc_c, ich->device_id, name, at_timestamp_ns, out_relation);
 	if (r != XRT_SUCCESS) {
@@ -146,9 +150,9 @@ ipc_client_hmd_create(struct ipc_connection *ipc_c, struct xrt_tracking_origin *
 	// Print name.
 	snprintf(ich->base.str, XRT_DEVICE_NAME_LEN, "%s", isdev->str);
 
-	// Setup inputs, by pointing directly to the shared memory.
+	// Setup inputs, by pointing directly to the connection's copy.
 	assert(isdev->num_inputs > 0);
-	ich->base.inputs = &ism->inputs[isdev->first_input_index];
+	ich->base.inputs = &ipc_c->inputs.inputs[isdev->first_input_index];
 	ich->base.num_inputs = isdev->num_inputs;
 
 #if 0
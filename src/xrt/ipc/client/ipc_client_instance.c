@@ -18,6 +18,8 @@
 #include "util/u_debug.h"
 
 #include "shared/ipc_protocol.h"
+#include "shared/ipc_command_ring.h"
+#include "shared/ipc_shmem.h"
 #include "client/ipc_client.h"
 #include "ipc_client_generated.h"
 
@@ -29,6 +31,7 @@
 #include <sys/mman.h>
 #include <sys/un.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <unistd.h>
 
 
@@ -42,6 +45,11 @@
 #endif // XRT_OS_ANDROID
 
 DEBUG_GET_ONCE_LOG_OPTION(ipc_log, "IPC_LOG", U_LOGGING_WARN)
+DEBUG_GET_ONCE_BOOL_OPTION(ipc_exact_poses, "IPC_EXACT_POSES", false)
+DEBUG_GET_ONCE_BOOL_OPTION(ipc_command_ring, "IPC_COMMAND_RING", false)
+
+//! How long to wait on the command ring before checking that the server is still there.
+#define COMMAND_RING_TIMEOUT_MS 500
 
 /*
  *
@@ -137,6 +145,115 @@ ipc_connect(struct ipc_connection *ipc_c)
 #endif
 
 
+static bool
+server_gone(struct ipc_connection *ipc_c)
+{
+	struct pollfd pfd = {
+	    .fd = ipc_c->imc.socket_fd,
+	    .events = 0,
+	};
+
+	// Only hang up and errors, there is never anything for us to read.
+	int ret = poll(&pfd, 1, 0);
+
+	return ret < 0 || (pfd.revents & (POLLHUP | POLLERR | POLLNVAL)) != 0;
+}
+
+
+static xrt_result_t
+enable_command_ring(struct ipc_connection *ipc_c)
+{
+	xrt_shmem_handle_t handle = XRT_SHMEM_HANDLE_INVALID;
+	void *map = NULL;
+
+	xrt_result_t r = ipc_call_instance_enable_command_ring(ipc_c, &handle, 1);
+	if (r == XRT_SUCCESS) {
+		r = ipc_shmem_map(handle, sizeof(struct ipc_shared_command_ring), &map);
+	}
+
+	// The mapping is all we need.
+	ipc_shmem_destroy(&handle);
+
+	// The server only reads the ring from now on, no going back.
+	if (r != XRT_SUCCESS) {
+		return r;
+	}
+
+	ipc_c->command_ring = (struct ipc_shared_command_ring *)map;
+
+	return XRT_SUCCESS;
+}
+
+
+/*
+ *
+ * 'Exported' connection functions.
+ *
+ */
+
+xrt_result_t
+ipc_client_command_ring_call(
+    struct ipc_connection *ipc_c, const void *msg, size_t msg_size, void *out_reply, size_t reply_size)
+{
+	struct ipc_shared_command_ring *ring = ipc_c->command_ring;
+	uint32_t reply_seq = ipc_command_ring_get_reply_seq(ring);
+
+	while (!ipc_command_ring_push(ring, msg, msg_size, COMMAND_RING_TIMEOUT_MS)) {
+		if (server_gone(ipc_c)) {
+			IPC_ERROR(ipc_c, "Server gone while sending on command ring!");
+			return XRT_ERROR_IPC_FAILURE;
+		}
+	}
+
+	while (!ipc_command_ring_wait_reply(ring, reply_seq, out_reply, reply_size, COMMAND_RING_TIMEOUT_MS)) {
+		if (server_gone(ipc_c)) {
+			IPC_ERROR(ipc_c, "Server gone while waiting for reply on command ring!");
+			return XRT_ERROR_IPC_FAILURE;
+		}
+	}
+
+	return XRT_SUCCESS;
+}
+
+xrt_result_t
+ipc_client_send_async(struct ipc_connection *ipc_c, const void *msg, size_t msg_size)
+{
+	if (ipc_c->command_ring == NULL) {
+		return ipc_send(&ipc_c->imc, msg, msg_size);
+	}
+
+	while (!ipc_command_ring_push(ipc_c->command_ring, msg, msg_size, COMMAND_RING_TIMEOUT_MS)) {
+		if (server_gone(ipc_c)) {
+			IPC_ERROR(ipc_c, "Server gone while sending on command ring!");
+			return XRT_ERROR_IPC_FAILURE;
+		}
+	}
+
+	return XRT_SUCCESS;
+}
+
+xrt_result_t
+ipc_client_command_ring_use_socket(struct ipc_connection *ipc_c)
+{
+	if (ipc_c->command_ring == NULL) {
+		return XRT_SUCCESS;
+	}
+
+	struct ipc_command_msg msg = {
+	    .cmd = IPC_COMMAND_RING_ON_SOCKET,
+	};
+
+	while (!ipc_command_ring_push(ipc_c->command_ring, &msg, sizeof(msg), COMMAND_RING_TIMEOUT_MS)) {
+		if (server_gone(ipc_c)) {
+			IPC_ERROR(ipc_c, "Server gone while sending on command ring!");
+			return XRT_ERROR_IPC_FAILURE;
+		}
+	}
+
+	return XRT_SUCCESS;
+}
+
+
 /*
  *
  * Member functions.
@@ -201,6 +318,9 @@ ipc_client_instance_destroy(struct xrt_instance *xinst)
 	// service considers us to be connected until fd is closed
 	ipc_message_channel_close(&ii->ipc_c.imc);
 
+	ipc_shmem_unmap(ii->ipc_c.command_ring, sizeof(struct ipc_shared_command_ring));
+	ii->ipc_c.command_ring = NULL;
+
 	for (size_t i = 0; i < ii->num_xtracks; i++) {
 		u_var_remove_root(ii->xtracks[i]);
 		free(ii->xtracks[i]);
@@ -209,6 +329,7 @@ ipc_client_instance_destroy(struct xrt_instance *xinst)
 	ii->num_xtracks = 0;
 
 	os_mutex_destroy(&ii->ipc_c.mutex);
+	os_mutex_destroy(&ii->ipc_c.inputs_mutex);
 
 #ifdef XRT_OS_ANDROID
 	ipc_client_android_destroy(&(ii->ipc_c.ica));
@@ -241,6 +362,7 @@ ipc_instance_create(struct xrt_instance_info *i_info, struct xrt_instance **out_
 	// FDs needs to be set to something negative.
 	ii->ipc_c.imc.socket_fd = -1;
 	ii->ipc_c.ism_handle = XRT_SHMEM_HANDLE_INVALID;
+	ii->ipc_c.exact_poses = debug_get_bool_option_ipc_exact_poses();
 
 	if (!ipc_connect(&ii->ipc_c)) {
 		IPC_ERROR((&ii->ipc_c),
@@ -288,10 +410,32 @@ ipc_instance_create(struct xrt_instance_info *i_info, struct xrt_instance **out_
 		return -1;
 	}
 
+	r = ipc_call_instance_get_input_slot(&ii->ipc_c, &ii->ipc_c.input_slot);
+	if (r != XRT_SUCCESS) {
+		IPC_ERROR((&ii->ipc_c), "Failed to get input slot!");
+		free(ii);
+		return -1;
+	}
+
 	uint32_t count = 0;
 	struct xrt_tracking_origin *xtrack = NULL;
 	struct ipc_shared_memory *ism = ii->ipc_c.ism;
 
+	// From now on calls go over the command ring, in its own shared memory.
+	if (debug_get_bool_option_ipc_command_ring()) {
+		r = enable_command_ring(&ii->ipc_c);
+		if (r != XRT_SUCCESS) {
+			IPC_ERROR((&ii->ipc_c), "Failed to enable command ring!");
+			// The service drops us when the socket is closed.
+			ipc_message_channel_close(&ii->ipc_c.imc);
+			free(ii);
+			return -1;
+		}
+	}
+
+	// The server starts our slot from the initial state, so do the same.
+	memcpy(ii->ipc_c.inputs.inputs, ism->inputs, sizeof(ii->ipc_c.inputs.inputs));
+
 	// Query the server for how many tracking origins it has.
 	count = 0;
 	for (uint32_t i = 0; i < ism->num_itracks; i++) {
@@ -328,6 +472,7 @@ ipc_instance_create(struct xrt_instance_info *i_info, struct xrt_instance **out_
 	*out_xinst = &ii->base;
 
 	os_mutex_init(&ii->ipc_c.mutex);
+	os_mutex_init(&ii->ipc_c.inputs_mutex);
 
 	return 0;
 }
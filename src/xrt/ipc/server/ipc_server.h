@@ -93,6 +93,12 @@ struct ipc_client_state
 	//! Is the inputs and outputs active.
 	bool io_active;
 
+	/*!
+	 * The inputs as last given to this client, published to the client's
+	 * slot in @ref ipc_shared_memory::input_slots when they change.
+	 */
+	struct ipc_shared_input_buffer inputs;
+
 	//! Number of swapchains in use by client
 	uint32_t num_swapchains;
 
@@ -118,6 +124,24 @@ struct ipc_client_state
 	struct ipc_queued_event queued_events[IPC_EVENT_QUEUE_SIZE];
 
 	int server_thread_index;
+
+	/*!
+	 * The command ring the client sends requests over, NULL if it only
+	 * uses the socket. Mapped from @ref command_ring_handle.
+	 */
+	struct ipc_shared_command_ring *command_ring;
+
+	//! Shared memory of @ref command_ring, only shared with this client.
+	xrt_shmem_handle_t command_ring_handle;
+
+	//! Was the request being handled popped from @ref command_ring.
+	bool reply_on_command_ring;
+
+	/*!
+	 * First error from an asynchronous call, the client doesn't wait for
+	 * those so it is returned by the next synchronous call instead.
+	 */
+	xrt_result_t async_result;
 };
 
 enum ipc_thread_state
@@ -303,6 +327,12 @@ struct ipc_server
 	struct ipc_shared_memory *ism;
 	xrt_shmem_handle_t ism_handle;
 
+	//! Thread sampling the poses into the pose rings in @ref ism.
+	struct os_thread_helper pose_ring_thread;
+
+	//! Time between samples, zero if the pose rings are not used.
+	uint64_t pose_ring_period_ns;
+
 	struct ipc_server_mainloop ml;
 
 	// Is the mainloop supposed to run.
@@ -364,6 +394,15 @@ update_server_state(struct ipc_server *vs);
 void *
 ipc_server_client_thread(void *_cs);
 
+/*!
+ * Send the reply to the request being handled, over the command ring if
+ * that is where the request came from, otherwise over the socket.
+ *
+ * @ingroup ipc_server
+ */
+xrt_result_t
+ipc_server_send_reply(volatile struct ipc_client_state *ics, const void *data, size_t size);
+
 /*!
  * @defgroup ipc_server_internals Server Internals
  * @brief These are only called by the platform-specific mainloop polling code.
@@ -12,6 +12,9 @@
 #include "util/u_misc.h"
 #include "util/u_trace_marker.h"
 
+#include "shared/ipc_input_slot.h"
+#include "shared/ipc_command_ring.h"
+#include "shared/ipc_shmem.h"
 #include "server/ipc_server.h"
 #include "ipc_server_generated.h"
 
@@ -497,50 +500,145 @@ ipc_handle_swapchain_destroy(volatile struct ipc_client_state *ics, uint32_t id)
 	return XRT_SUCCESS;
 }
 
-xrt_result_t
-ipc_handle_device_update_input(volatile struct ipc_client_state *ics, uint32_t id)
+/*!
+ * Update the inputs of the device and copy them into the client's own copy
+ * of the inputs, returns true and bumps the generation if anything changed.
+ * Only called from the thread of the client, so no locking is needed.
+ */
+static bool
+update_device_inputs(volatile struct ipc_client_state *ics, uint32_t device_id)
 {
-	// To make the code a bit more readable.
-	uint32_t device_id = id;
 	struct ipc_shared_memory *ism = ics->server->ism;
 	struct ipc_device *idev = get_idev(ics, device_id);
 	struct xrt_device *xdev = idev->xdev;
 	struct ipc_shared_device *isdev = &ism->isdevs[device_id];
+	struct ipc_shared_input_buffer *inputs = (struct ipc_shared_input_buffer *)&ics->inputs;
 
 	// Update inputs.
 	xrt_device_update_inputs(xdev);
 
-	// Copy data into the shared memory.
 	struct xrt_input *src = xdev->inputs;
-	struct xrt_input *dst = &ism->inputs[isdev->first_input_index];
-	size_t size = sizeof(struct xrt_input) * isdev->num_inputs;
-
+	struct xrt_input *dst = &inputs->inputs[isdev->first_input_index];
 	bool io_active = ics->io_active && idev->io_active;
-	if (io_active) {
-		memcpy(dst, src, size);
-	} else {
-		memset(dst, 0, size);
+	bool changed = false;
+
+	for (uint32_t i = 0; i < isdev->num_inputs; i++) {
+		struct xrt_input input;
 
-		for (uint32_t i = 0; i < isdev->num_inputs; i++) {
-			dst[i].name = src[i].name;
+		if (io_active) {
+			memcpy(&input, &src[i], sizeof(input));
+		} else {
+			memset(&input, 0, sizeof(input));
+			input.name = src[i].name;
 
 			// Special case the rotation of the head.
-			if (dst[i].name == XRT_INPUT_GENERIC_HEAD_POSE) {
-				dst[i].active = src[i].active;
+			if (input.name == XRT_INPUT_GENERIC_HEAD_POSE) {
+				input.active = src[i].active;
 			}
 		}
+
+		if (memcmp(&dst[i], &input, sizeof(input)) != 0) {
+			memcpy(&dst[i], &input, sizeof(input));
+			changed = true;
+		}
+	}
+
+	if (changed) {
+		inputs->device_generations[device_id] = ++inputs->generation;
+	}
+
+	return changed;
+}
+
+xrt_result_t
+ipc_handle_device_update_input(volatile struct ipc_client_state *ics, uint32_t id)
+{
+	// To make the code a bit more readable.
+	uint32_t device_id = id;
+	struct ipc_shared_memory *ism = ics->server->ism;
+	bool changed[IPC_SHARED_MAX_DEVICES] = {0};
+
+	changed[device_id] = update_device_inputs(ics, device_id);
+
+	if (changed[device_id]) {
+		ipc_input_slot_publish(ism, ics->server_thread_index, (struct ipc_shared_input_buffer *)&ics->inputs,
+		                       changed);
 	}
 
 	// Reply.
 	return XRT_SUCCESS;
 }
 
+xrt_result_t
+ipc_handle_device_update_inputs_all(volatile struct ipc_client_state *ics, uint64_t *out_generation)
+{
+	struct ipc_shared_memory *ism = ics->server->ism;
+	bool changed[IPC_SHARED_MAX_DEVICES] = {0};
+	bool any_changed = false;
+
+	for (uint32_t device_id = 0; device_id < ism->num_isdevs; device_id++) {
+		changed[device_id] = update_device_inputs(ics, device_id);
+		any_changed = any_changed || changed[device_id];
+	}
+
+	if (any_changed) {
+		ipc_input_slot_publish(ism, ics->server_thread_index, (struct ipc_shared_input_buffer *)&ics->inputs,
+		                       changed);
+	}
+
+	*out_generation = ics->inputs.generation;
+
+	// Reply.
+	return XRT_SUCCESS;
+}
+
+xrt_result_t
+ipc_handle_instance_get_input_slot(volatile struct ipc_client_state *ics, uint32_t *out_slot)
+{
+	*out_slot = (uint32_t)ics->server_thread_index;
+
+	return XRT_SUCCESS;
+}
+
+xrt_result_t
+ipc_handle_instance_enable_command_ring(volatile struct ipc_client_state *ics,
+                                        uint32_t max_num_handles,
+                                        xrt_shmem_handle_t *out_handles,
+                                        uint32_t *out_num_handles)
+{
+	assert(max_num_handles >= 1);
+
+	if (ics->command_ring != NULL) {
+		IPC_ERROR(ics->server, "Command ring already enabled!");
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	// Not in the main shared memory, only this client gets to map it.
+	struct ipc_shared_command_ring *ring = NULL;
+	xrt_shmem_handle_t handle = XRT_SHMEM_HANDLE_INVALID;
+	xrt_result_t xret = ipc_shmem_create(sizeof(*ring), &handle, (void **)&ring);
+	if (xret != XRT_SUCCESS) {
+		IPC_ERROR(ics->server, "Failed to create command ring shared memory!");
+		return xret;
+	}
+
+	// The client isn't using it until we have replied.
+	ipc_command_ring_reset(ring);
+	ics->command_ring = ring;
+	ics->command_ring_handle = handle;
+
+	out_handles[0] = handle;
+	*out_num_handles = 1;
+
+	return XRT_SUCCESS;
+}
+
 static struct xrt_input *
 find_input(volatile struct ipc_client_state *ics, uint32_t device_id, enum xrt_input_name name)
 {
 	struct ipc_shared_memory *ism = ics->server->ism;
 	struct ipc_shared_device *isdev = &ism->isdevs[device_id];
-	struct xrt_input *io = &ism->inputs[isdev->first_input_index];
+	struct xrt_input *io = (struct xrt_input *)&ics->inputs.inputs[isdev->first_input_index];
 
 	for (uint32_t i = 0; i < isdev->num_inputs; i++) {
 		if (io[i].name == name) {
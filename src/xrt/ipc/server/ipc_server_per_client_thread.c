@@ -12,6 +12,8 @@
 
 #include "util/u_misc.h"
 
+#include "shared/ipc_command_ring.h"
+#include "shared/ipc_shmem.h"
 #include "server/ipc_server.h"
 #include "ipc_server_generated.h"
 
@@ -57,6 +59,95 @@ setup_epoll(volatile struct ipc_client_state *ics)
 	return epoll_fd;
 }
 
+static bool
+receive_and_dispatch(volatile struct ipc_client_state *ics, uint8_t *buf)
+{
+	// Only one request, anything after it is left for the next time.
+	size_t len = 0;
+	xrt_result_t ret = ipc_receive_request((struct ipc_message_channel *)&ics->imc, buf, IPC_BUF_SIZE, &len);
+	if (ret != XRT_SUCCESS) {
+		IPC_ERROR(ics->server, "Invalid packet received, disconnecting client.");
+		return false;
+	}
+
+	// Check the first 4 bytes of the message and dispatch.
+	ipc_command_t *ipc_command = (uint32_t *)buf;
+	xrt_result_t result = ipc_dispatch(ics, ipc_command);
+	if (result != XRT_SUCCESS) {
+		IPC_ERROR(ics->server, "During packet handling, disconnecting client.");
+		return false;
+	}
+
+	return true;
+}
+
+/*!
+ * Once the client has enabled the command ring all requests come over it,
+ * calls that need the socket push a marker first so order is kept.
+ */
+static void
+command_ring_loop(volatile struct ipc_client_state *ics, int epoll_fd, uint8_t *buf)
+{
+	struct ipc_shared_command_ring *ring = ics->command_ring;
+
+	IPC_INFO(ics->server, "Client switched to the command ring.");
+
+	while (ics->server->running) {
+		const int half_a_second_ms = 500;
+		size_t len = 0;
+
+		if (!ipc_command_ring_pop(ring, buf, &len, half_a_second_ms)) {
+			struct epoll_event event = {0};
+
+			// Timed out, check that the client is still there.
+			int ret = epoll_wait(epoll_fd, &event, 1, 0);
+			if (ret < 0) {
+				IPC_ERROR(ics->server, "Failed epoll_wait '%i', disconnecting client.", ret);
+				break;
+			}
+
+			// Detect clients disconnecting gracefully.
+			if (ret > 0 && (event.events & (EPOLLHUP | EPOLLERR)) != 0) {
+				IPC_INFO(ics->server, "Client disconnected.");
+				break;
+			}
+
+			continue;
+		}
+
+		if (len < 4) {
+			IPC_ERROR(ics->server, "Invalid request on command ring, disconnecting client.");
+			break;
+		}
+
+		ipc_command_t *ipc_command = (uint32_t *)buf;
+
+		// The actual request is on the socket.
+		if (*ipc_command == IPC_COMMAND_RING_ON_SOCKET) {
+			if (!receive_and_dispatch(ics, buf)) {
+				break;
+			}
+			continue;
+		}
+
+		// Only calls the client would send this way, with the right size.
+		if (!ipc_command_ring_allowed(*ipc_command, len)) {
+			IPC_ERROR(ics->server, "Invalid command %u on command ring, disconnecting client.",
+			          *ipc_command);
+			break;
+		}
+
+		ics->reply_on_command_ring = true;
+		xrt_result_t result = ipc_dispatch(ics, ipc_command);
+		ics->reply_on_command_ring = false;
+
+		if (result != XRT_SUCCESS) {
+			IPC_ERROR(ics->server, "During packet handling, disconnecting client.");
+			break;
+		}
+	}
+}
+
 
 /*
  *
@@ -102,19 +193,13 @@ client_loop(volatile struct ipc_client_state *ics)
 			break;
 		}
 
-		// Finally get the data that is waiting for us.
-		//! @todo replace this call
-		ssize_t len = recv(ics->imc.socket_fd, &buf, IPC_BUF_SIZE, 0);
-		if (len < 4) {
-			IPC_ERROR(ics->server, "Invalid packet received, disconnecting client.");
+		if (!receive_and_dispatch(ics, buf)) {
 			break;
 		}
 
-		// Check the first 4 bytes of the message and dispatch.
-		ipc_command_t *ipc_command = (uint32_t *)buf;
-		xrt_result_t result = ipc_dispatch(ics, ipc_command);
-		if (result != XRT_SUCCESS) {
-			IPC_ERROR(ics->server, "During packet handling, disconnecting client.");
+		// The client has switched over to the command ring.
+		if (ics->command_ring != NULL) {
+			command_ring_loop(ics, epoll_fd, buf);
 			break;
 		}
 	}
@@ -132,6 +217,13 @@ client_loop(volatile struct ipc_client_state *ics)
 
 	ics->num_swapchains = 0;
 
+	// The ring goes away with the client.
+	ipc_shmem_unmap(ics->command_ring, sizeof(struct ipc_shared_command_ring));
+	ipc_shmem_destroy((xrt_shmem_handle_t *)&ics->command_ring_handle);
+	ics->command_ring = NULL;
+	ics->reply_on_command_ring = false;
+	ics->async_result = XRT_SUCCESS;
+
 	ics->server->threads[ics->server_thread_index].state = IPC_THREAD_STOPPING;
 	ics->server_thread_index = -1;
 	memset((void *)&ics->client_state, 0, sizeof(struct ipc_app_state));
@@ -183,6 +275,17 @@ client_loop(volatile struct ipc_client_state *ics)
  *
  */
 
+xrt_result_t
+ipc_server_send_reply(volatile struct ipc_client_state *ics, const void *data, size_t size)
+{
+	if (ics->reply_on_command_ring) {
+		ipc_command_ring_write_reply(ics->command_ring, data, size);
+		return XRT_SUCCESS;
+	}
+
+	return ipc_send((struct ipc_message_channel *)&ics->imc, data, size);
+}
+
 void *
 ipc_server_client_thread(void *_ics)
 {
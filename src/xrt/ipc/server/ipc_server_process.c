@@ -22,6 +22,8 @@
 #include "util/u_trace_marker.h"
 
 #include "shared/ipc_shmem.h"
+#include "shared/ipc_pose_ring.h"
+#include "shared/ipc_input_slot.h"
 #include "server/ipc_server.h"
 
 #include <stdlib.h>
@@ -58,6 +60,11 @@ oxr_sdl2_hack_stop(void **hack_ptr);
 
 DEBUG_GET_ONCE_BOOL_OPTION(exit_on_disconnect, "IPC_EXIT_ON_DISCONNECT", false)
 DEBUG_GET_ONCE_LOG_OPTION(ipc_log, "IPC_LOG", U_LOGGING_WARN)
+/*
+ * Off by default, clients extrapolate from the sampled poses instead of using
+ * the prediction of the driver, which needs drivers that report velocities.
+ */
+DEBUG_GET_ONCE_NUM_OPTION(pose_ring_hz, "IPC_POSE_RING_HZ", 0)
 
 struct _z_sort_data
 {
@@ -94,6 +101,9 @@ teardown_all(struct ipc_server *s)
 {
 	u_var_remove_root(s);
 
+	// Stop sampling before the devices go away.
+	os_thread_helper_destroy(&s->pose_ring_thread);
+
 	xrt_comp_native_destroy(&s->xcn);
 
 	xrt_syscomp_destroy(&s->xsysc);
@@ -176,6 +186,119 @@ handle_binding(struct ipc_shared_memory *ism,
 	*output_pair_index_ptr = output_pair_index;
 }
 
+static void
+publish_pose_rings(struct ipc_server *s, uint32_t index)
+{
+	struct ipc_shared_memory *ism = s->ism;
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	for (uint32_t i = 0; i < ism->num_isdevs; i++) {
+		struct ipc_device *idev = &s->idevs[i];
+		struct ipc_shared_device *isdev = &ism->isdevs[i];
+
+		for (uint32_t k = 0; k < isdev->num_pose_rings; k++) {
+			struct ipc_shared_pose_ring *ring = &ism->pose_rings[isdev->first_pose_ring_index + k];
+			struct xrt_space_relation relation = {0};
+
+			// Same as getting the pose, the head pose is always given out.
+			if (idev->io_active || ring->name == XRT_INPUT_GENERIC_HEAD_POSE) {
+				xrt_device_get_tracked_pose(idev->xdev, ring->name, now_ns, &relation);
+			}
+
+			ipc_pose_ring_publish(ring, index, (timepoint_ns)now_ns, &relation);
+		}
+	}
+}
+
+/*!
+ * Is any client connected. Not locked, a stale read at most means sampling one
+ * more period after the last client left, a new client signals the thread
+ * after it has been marked as connected.
+ */
+static bool
+has_clients(struct ipc_server *s)
+{
+	for (uint32_t i = 0; i < IPC_MAX_CLIENTS; i++) {
+		if (s->threads[i].ics.server_thread_index >= 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void *
+pose_ring_thread(void *ptr)
+{
+	struct ipc_server *s = (struct ipc_server *)ptr;
+	struct os_thread_helper *oth = &s->pose_ring_thread;
+	uint64_t period_ns = s->pose_ring_period_ns;
+	uint64_t next_ns = os_monotonic_get_ns();
+	uint32_t index = 0;
+
+	os_thread_helper_lock(oth);
+
+	while (os_thread_helper_is_running_locked(oth)) {
+		// Nobody to read the rings, wait for a client to connect.
+		if (!has_clients(s)) {
+			os_thread_helper_wait_locked(oth);
+			next_ns = os_monotonic_get_ns();
+			continue;
+		}
+
+		os_thread_helper_unlock(oth);
+
+		publish_pose_rings(s, index++);
+
+		// Sleep until an absolute deadline so the rate doesn't drift.
+		next_ns += period_ns;
+		uint64_t now_ns = os_monotonic_get_ns();
+		if (next_ns > now_ns) {
+			os_nanosleep((long)(next_ns - now_ns));
+		} else if (now_ns - next_ns > period_ns) {
+			// Too far behind, don't try to catch up with a burst.
+			next_ns = now_ns;
+		}
+
+		os_thread_helper_lock(oth);
+	}
+
+	os_thread_helper_unlock(oth);
+
+	return NULL;
+}
+
+static void
+init_pose_rings(struct ipc_server *s, struct xrt_device *xdev, struct ipc_shared_device *isdev, uint32_t *index_ptr)
+{
+	struct ipc_shared_memory *ism = s->ism;
+	uint32_t index = *index_ptr;
+	uint32_t start = index;
+
+	for (size_t k = 0; k < xdev->num_inputs; k++) {
+		enum xrt_input_name name = xdev->inputs[k].name;
+		if (XRT_GET_INPUT_TYPE(name) != XRT_INPUT_TYPE_POSE) {
+			continue;
+		}
+
+		// Clients fall back to asking the server for this pose.
+		if (index >= IPC_SHARED_MAX_POSE_RINGS) {
+			IPC_WARN(s, "Out of pose rings for '%s'!", xdev->str);
+			break;
+		}
+
+		ism->pose_rings[index++].name = name;
+	}
+
+	// Setup the 'offsets' and number of pose rings.
+	if (start != index) {
+		isdev->num_pose_rings = index - start;
+		isdev->first_pose_ring_index = start;
+	}
+
+	*index_ptr = index;
+}
+
 static int
 init_shm(struct ipc_server *s)
 {
@@ -225,6 +348,7 @@ init_shm(struct ipc_server *s)
 	uint32_t binding_index = 0;
 	uint32_t input_pair_index = 0;
 	uint32_t output_pair_index = 0;
+	uint32_t pose_ring_index = 0;
 
 	for (size_t i = 0; i < IPC_SERVER_NUM_XDEVS; i++) {
 		struct xrt_device *xdev = s->idevs[i].xdev;
@@ -306,6 +430,11 @@ init_shm(struct ipc_server *s)
 			isdev->num_outputs = output_index - output_start;
 			isdev->first_output_index = output_start;
 		}
+
+		// Pose rings, if the server publishes them.
+		if (s->pose_ring_period_ns > 0) {
+			init_pose_rings(s, xdev, isdev, &pose_ring_index);
+		}
 	}
 
 	// Finally tell the client how many devices we have.
@@ -378,8 +507,21 @@ ipc_server_start_client_listener_thread(struct ipc_server *vs, int fd)
 	ics->server = vs;
 	ics->server_thread_index = cs_index;
 	ics->io_active = true;
+
+	// Start the new client from the initial state of the inputs.
+	struct ipc_shared_input_buffer *inputs = (struct ipc_shared_input_buffer *)&ics->inputs;
+	U_ZERO(inputs);
+	memcpy(inputs->inputs, vs->ism->inputs, sizeof(inputs->inputs));
+	ipc_input_slot_reset(vs->ism, cs_index, inputs);
 	os_thread_start(&it->thread, ipc_server_client_thread, (void *)ics);
 
+	// Wake up the pose ring thread if it was waiting for a client.
+	if (vs->pose_ring_period_ns > 0) {
+		os_thread_helper_lock(&vs->pose_ring_thread);
+		os_thread_helper_signal_locked(&vs->pose_ring_thread);
+		os_thread_helper_unlock(&vs->pose_ring_thread);
+	}
+
 	// Unlock when we are done.
 	os_mutex_unlock(&vs->global_state_lock);
 }
@@ -390,6 +532,13 @@ init_all(struct ipc_server *s)
 	// Yes we should be running.
 	s->running = true;
 	s->exit_on_disconnect = debug_get_bool_option_exit_on_disconnect();
+	s->ll = debug_get_log_option_ipc_log();
+
+	int64_t pose_ring_hz = debug_get_num_option_pose_ring_hz();
+	s->pose_ring_period_ns = pose_ring_hz > 0 ? U_1_000_000_000 / (uint64_t)pose_ring_hz : 0;
+
+	// Init before anything else so teardown_all can always destroy it.
+	os_thread_helper_init(&s->pose_ring_thread);
 
 	int ret = xrt_instance_create(NULL, &s->xinst);
 	if (ret < 0) {
@@ -449,6 +598,14 @@ init_all(struct ipc_server *s)
 		return ret;
 	}
 
+	if (s->pose_ring_period_ns > 0) {
+		ret = os_thread_helper_start(&s->pose_ring_thread, pose_ring_thread, s);
+		if (ret != 0) {
+			teardown_all(s);
+			return -1;
+		}
+	}
+
 	ret = ipc_server_mainloop_init(&s->ml);
 	if (ret < 0) {
 		teardown_all(s);
@@ -466,8 +623,6 @@ init_all(struct ipc_server *s)
 		return ret;
 	}
 
-	s->ll = debug_get_log_option_ipc_log();
-
 	u_var_add_root(s, "IPC Server", false);
 	u_var_add_ro_u32(s, &s->ll, "log level");
 	u_var_add_bool(s, &s->exit_on_disconnect, "exit_on_disconnect");
@@ -971,6 +1126,7 @@ init_server_state(struct ipc_server *s)
 		ics->server = s;
 		ics->xc = &s->xcn->base;
 		ics->server_thread_index = -1;
+		ics->command_ring_handle = XRT_SHMEM_HANDLE_INVALID;
 	}
 }
 
@@ -0,0 +1,242 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Shared memory command ring transport, for internal use only
+ * @author Collabora, Ltd.
+ * @ingroup ipc_shared
+ */
+
+#include "xrt/xrt_compiler.h"
+#include "xrt/xrt_config_os.h"
+
+#include "os/os_time.h"
+
+#include "util/u_misc.h"
+#include "util/u_atomic.h"
+
+#include "shared/ipc_command_ring.h"
+
+#include <string.h>
+#include <assert.h>
+
+#ifdef XRT_OS_LINUX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <time.h>
+#endif
+
+
+/*!
+ * How many times to check before going to sleep, most calls are answered
+ * faster than it takes to go to sleep and be woken up again. Only done when
+ * the other side can run at the same time, see @ref get_spin_count.
+ */
+#define SPIN_COUNT 2000
+
+
+/*
+ *
+ * Atomic and futex helpers.
+ *
+ * The waker stores the value and then loads the waiting flag while the
+ * waiter stores the waiting flag and then loads the value, both need to be
+ * sequentially consistent so at least one side sees the other.
+ *
+ */
+
+static inline void
+cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+static void
+futex_wait(uint32_t *word, uint32_t expected, uint64_t timeout_ns)
+{
+#ifdef XRT_OS_LINUX
+	struct timespec ts;
+	ts.tv_sec = (time_t)(timeout_ns / U_1_000_000_000);
+	ts.tv_nsec = (long)(timeout_ns % U_1_000_000_000);
+
+	// Not private, the word is in memory shared between processes.
+	syscall(SYS_futex, word, FUTEX_WAIT, expected, &ts, NULL, 0);
+#else
+	(void)word;
+	(void)expected;
+	os_nanosleep(U_TIME_HALF_MS_IN_NS);
+#endif
+}
+
+static void
+futex_wake(uint32_t *word)
+{
+#ifdef XRT_OS_LINUX
+	syscall(SYS_futex, word, FUTEX_WAKE, 1, NULL, NULL, 0);
+#else
+	(void)word;
+#endif
+}
+
+/*!
+ * With only one CPU spinning just keeps the other side from running.
+ */
+static int
+get_spin_count(void)
+{
+	static int spin_count = -1;
+
+	if (spin_count < 0) {
+#ifdef XRT_OS_LINUX
+		spin_count = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? SPIN_COUNT : 0;
+#else
+		spin_count = SPIN_COUNT;
+#endif
+	}
+
+	return spin_count;
+}
+
+/*!
+ * Wait for @p word to no longer be @p expected, spinning first and then
+ * sleeping with @p waiting set so the other side knows to wake us up.
+ */
+static bool
+wait_for_change(uint32_t *word, uint32_t expected, uint32_t *waiting, int timeout_ms)
+{
+	int spin_count = get_spin_count();
+
+	for (int i = 0; i < spin_count; i++) {
+		if (u_atomic_load_acquire(word) != expected) {
+			return true;
+		}
+		cpu_relax();
+	}
+
+	uint64_t now_ns = os_monotonic_get_ns();
+	uint64_t deadline_ns = now_ns + (uint64_t)timeout_ms * U_TIME_1MS_IN_NS;
+	bool changed = false;
+
+	u_atomic_store_seq_cst(waiting, 1);
+
+	while (!(changed = u_atomic_load_seq_cst(word) != expected) && now_ns < deadline_ns) {
+		futex_wait(word, expected, deadline_ns - now_ns);
+		now_ns = os_monotonic_get_ns();
+	}
+
+	u_atomic_store_seq_cst(waiting, 0);
+
+	return changed;
+}
+
+static void
+wake_if_waiting(uint32_t *word, uint32_t *waiting)
+{
+	if (u_atomic_load_seq_cst(waiting) != 0) {
+		futex_wake(word);
+	}
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+void
+ipc_command_ring_reset(struct ipc_shared_command_ring *ring)
+{
+	U_ZERO(ring);
+}
+
+uint32_t
+ipc_command_ring_get_reply_seq(const struct ipc_shared_command_ring *ring)
+{
+	return u_atomic_load_acquire(&ring->reply_seq);
+}
+
+bool
+ipc_command_ring_push(struct ipc_shared_command_ring *ring, const void *data, size_t size, int timeout_ms)
+{
+	assert(size <= IPC_BUF_SIZE);
+
+	// Only we write the head.
+	uint32_t head = ring->request_head;
+	uint32_t tail = u_atomic_load_acquire(&ring->request_tail);
+
+	if (head - tail >= IPC_COMMAND_RING_SLOTS &&
+	    !wait_for_change(&ring->request_tail, tail, &ring->client_waiting_space, timeout_ms)) {
+		return false;
+	}
+
+	uint32_t slot = head % IPC_COMMAND_RING_SLOTS;
+	memcpy(ring->requests[slot], data, size);
+	ring->request_sizes[slot] = (uint32_t)size;
+
+	u_atomic_store_seq_cst(&ring->request_head, head + 1);
+	wake_if_waiting(&ring->request_head, &ring->server_waiting_request);
+
+	return true;
+}
+
+bool
+ipc_command_ring_wait_reply(struct ipc_shared_command_ring *ring,
+                            uint32_t reply_seq,
+                            void *out_data,
+                            size_t size,
+                            int timeout_ms)
+{
+	assert(size <= IPC_COMMAND_RING_REPLY_SIZE);
+
+	if (!wait_for_change(&ring->reply_seq, reply_seq, &ring->client_waiting_reply, timeout_ms)) {
+		return false;
+	}
+
+	memcpy(out_data, ring->reply, size);
+
+	return true;
+}
+
+bool
+ipc_command_ring_pop(struct ipc_shared_command_ring *ring, void *out_data, size_t *out_size, int timeout_ms)
+{
+	// Only we write the tail.
+	uint32_t tail = ring->request_tail;
+
+	if (!wait_for_change(&ring->request_head, tail, &ring->server_waiting_request, timeout_ms)) {
+		return false;
+	}
+
+	// Don't trust the size, the memory is shared with the client.
+	uint32_t slot = tail % IPC_COMMAND_RING_SLOTS;
+	size_t size = ring->request_sizes[slot];
+	if (size > IPC_BUF_SIZE) {
+		size = IPC_BUF_SIZE;
+	}
+
+	memcpy(out_data, ring->requests[slot], size);
+	*out_size = size;
+
+	u_atomic_store_seq_cst(&ring->request_tail, tail + 1);
+	wake_if_waiting(&ring->request_tail, &ring->client_waiting_space);
+
+	return true;
+}
+
+void
+ipc_command_ring_write_reply(struct ipc_shared_command_ring *ring, const void *data, size_t size)
+{
+	assert(size <= IPC_COMMAND_RING_REPLY_SIZE);
+
+	memcpy(ring->reply, data, size);
+	ring->reply_size = (uint32_t)size;
+
+	u_atomic_store_seq_cst(&ring->reply_seq, ring->reply_seq + 1);
+	wake_if_waiting(&ring->reply_seq, &ring->client_waiting_reply);
+}
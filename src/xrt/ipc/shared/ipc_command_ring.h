@@ -0,0 +1,87 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Shared memory command ring transport, for internal use only
+ * @author Collabora, Ltd.
+ * @ingroup ipc_shared
+ */
+
+#pragma once
+
+#include "shared/ipc_protocol.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * A request with this command, the value of IPC_ERR, tells the server that
+ * the actual request is sent over the socket. Used for calls that pass
+ * handles or whose reply doesn't fit in the ring.
+ *
+ * @ingroup ipc_shared
+ */
+#define IPC_COMMAND_RING_ON_SOCKET 0
+
+/*!
+ * Reset the ring, only to be called when neither side is using it.
+ *
+ * @ingroup ipc_shared
+ */
+void
+ipc_command_ring_reset(struct ipc_shared_command_ring *ring);
+
+/*!
+ * Number of replies so far, read it before pushing a request that expects a
+ * reply and give it to @ref ipc_command_ring_wait_reply.
+ *
+ * @ingroup ipc_shared
+ */
+uint32_t
+ipc_command_ring_get_reply_seq(const struct ipc_shared_command_ring *ring);
+
+/*!
+ * Push a request, waits for up to @p timeout_ms if the ring is full. Returns
+ * false if it's still full after that. Client side.
+ *
+ * @ingroup ipc_shared
+ */
+bool
+ipc_command_ring_push(struct ipc_shared_command_ring *ring, const void *data, size_t size, int timeout_ms);
+
+/*!
+ * Wait for up to @p timeout_ms for the reply after @p reply_seq and copy it
+ * to @p out_data, returns false on time out. Client side.
+ *
+ * @ingroup ipc_shared
+ */
+bool
+ipc_command_ring_wait_reply(struct ipc_shared_command_ring *ring,
+                            uint32_t reply_seq,
+                            void *out_data,
+                            size_t size,
+                            int timeout_ms);
+
+/*!
+ * Wait for up to @p timeout_ms for a request and copy it into @p out_data,
+ * which must be @ref IPC_BUF_SIZE big. Returns false on time out. Server side.
+ *
+ * @ingroup ipc_shared
+ */
+bool
+ipc_command_ring_pop(struct ipc_shared_command_ring *ring, void *out_data, size_t *out_size, int timeout_ms);
+
+/*!
+ * Write the reply to the request last popped. Server side.
+ *
+ * @ingroup ipc_shared
+ */
+void
+ipc_command_ring_write_reply(struct ipc_shared_command_ring *ring, const void *data, size_t size);
+
+
+#ifdef __cplusplus
+}
+#endif
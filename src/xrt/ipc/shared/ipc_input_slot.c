@@ -0,0 +1,127 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Per client input slots in the shared memory, for internal use only
+ * @author Collabora, Ltd.
+ * @ingroup ipc_shared
+ */
+
+#include "xrt/xrt_compiler.h"
+
+#include "util/u_atomic.h"
+
+#include "shared/ipc_input_slot.h"
+
+
+/*
+ *
+ * Helpers, the slot is written by the server and read by the client at the
+ * same time. Every word is copied atomically, so a torn read is a retry
+ * caught by the sequence counter and not a data race.
+ *
+ */
+
+static void
+copy_device_inputs(const struct ipc_shared_memory *ism,
+                   uint32_t device_id,
+                   struct xrt_input *dst,
+                   const struct xrt_input *src)
+{
+	const struct ipc_shared_device *isdev = &ism->isdevs[device_id];
+	uint32_t first = isdev->first_input_index;
+
+	u_atomic_copy_relaxed(&dst[first], &src[first], sizeof(struct xrt_input) * isdev->num_inputs);
+}
+
+static void
+copy_generation(uint64_t *dst, const uint64_t *src)
+{
+	u_atomic_copy_relaxed(dst, src, sizeof(*dst));
+}
+
+static void
+write_buffer(const struct ipc_shared_memory *ism,
+             struct ipc_shared_input_buffer *dst,
+             const struct ipc_shared_input_buffer *src,
+             const bool changed[IPC_SHARED_MAX_DEVICES])
+{
+	for (uint32_t i = 0; i < ism->num_isdevs; i++) {
+		if (changed[i]) {
+			copy_device_inputs(ism, i, dst->inputs, src->inputs);
+			copy_generation(&dst->device_generations[i], &src->device_generations[i]);
+		}
+	}
+
+	copy_generation(&dst->generation, &src->generation);
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+void
+ipc_input_slot_reset(struct ipc_shared_memory *ism, uint32_t slot_index, const struct ipc_shared_input_buffer *src)
+{
+	struct ipc_shared_input_slot *slot = &ism->input_slots[slot_index];
+
+	u_atomic_latch(&slot->seq);
+	u_atomic_copy_relaxed(&slot->buffers[0], src, sizeof(*src));
+	u_atomic_latch(&slot->seq);
+	u_atomic_copy_relaxed(&slot->buffers[1], src, sizeof(*src));
+}
+
+void
+ipc_input_slot_publish(struct ipc_shared_memory *ism,
+                       uint32_t slot_index,
+                       const struct ipc_shared_input_buffer *src,
+                       const bool changed[IPC_SHARED_MAX_DEVICES])
+{
+	struct ipc_shared_input_slot *slot = &ism->input_slots[slot_index];
+
+	// Odd, the client reads buffer 1 while buffer 0 is written.
+	u_atomic_latch(&slot->seq);
+	write_buffer(ism, &slot->buffers[0], src, changed);
+
+	// Even, the client reads buffer 0 while buffer 1 is written.
+	u_atomic_latch(&slot->seq);
+	write_buffer(ism, &slot->buffers[1], src, changed);
+}
+
+bool
+ipc_input_slot_read(const struct ipc_shared_memory *ism, uint32_t slot_index, struct ipc_shared_input_buffer *inout)
+{
+	const struct ipc_shared_input_slot *slot = &ism->input_slots[slot_index];
+	uint64_t device_generations[IPC_SHARED_MAX_DEVICES];
+	uint64_t generation;
+	uint32_t seq;
+
+	/*
+	 * Compared against the generations of the last successful read, so a
+	 * retry copies everything again that a torn read might have copied.
+	 */
+	do {
+		seq = u_atomic_latch_read_begin(&slot->seq);
+		const struct ipc_shared_input_buffer *buffer = &slot->buffers[seq & 1];
+
+		copy_generation(&generation, &buffer->generation);
+		for (uint32_t i = 0; i < ism->num_isdevs; i++) {
+			copy_generation(&device_generations[i], &buffer->device_generations[i]);
+			if (device_generations[i] != inout->device_generations[i]) {
+				copy_device_inputs(ism, i, inout->inputs, buffer->inputs);
+			}
+		}
+	} while (u_atomic_latch_read_retry(&slot->seq, seq));
+
+	bool changed = generation != inout->generation;
+
+	inout->generation = generation;
+	for (uint32_t i = 0; i < ism->num_isdevs; i++) {
+		inout->device_generations[i] = device_generations[i];
+	}
+
+	return changed;
+}
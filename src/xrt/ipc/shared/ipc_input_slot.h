@@ -0,0 +1,53 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Per client input slots in the shared memory, for internal use only
+ * @author Collabora, Ltd.
+ * @ingroup ipc_shared
+ */
+
+#pragma once
+
+#include "shared/ipc_protocol.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Reset the slot to hold a copy of @p src, only to be called when no client
+ * is using the slot.
+ *
+ * @ingroup ipc_shared
+ */
+void
+ipc_input_slot_reset(struct ipc_shared_memory *ism, uint32_t slot_index, const struct ipc_shared_input_buffer *src);
+
+/*!
+ * Publish the inputs of the devices marked in @p changed from @p src, which
+ * is the private copy of the server thread of the client using the slot.
+ *
+ * @ingroup ipc_shared
+ */
+void
+ipc_input_slot_publish(struct ipc_shared_memory *ism,
+                       uint32_t slot_index,
+                       const struct ipc_shared_input_buffer *src,
+                       const bool changed[IPC_SHARED_MAX_DEVICES]);
+
+/*!
+ * Bring the private copy @p inout of the client up to date with the slot,
+ * only copying the inputs of devices whose generation has changed. Never
+ * blocks the server, returns true if anything changed.
+ *
+ * @ingroup ipc_shared
+ */
+bool
+ipc_input_slot_read(const struct ipc_shared_memory *ism, uint32_t slot_index, struct ipc_shared_input_buffer *inout);
+
+
+#ifdef __cplusplus
+}
+#endif
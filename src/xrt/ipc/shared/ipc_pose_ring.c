@@ -0,0 +1,155 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Pose rings in the shared memory, for internal use only
+ * @author Collabora, Ltd.
+ * @ingroup ipc_shared
+ */
+
+#include "math/m_api.h"
+#include "math/m_vec3.h"
+#include "math/m_predict.h"
+
+#include "util/u_misc.h"
+#include "util/u_time.h"
+
+#include "shared/ipc_pose_ring.h"
+
+#include <assert.h>
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static void
+interpolate(const struct u_pose_publisher_state *a,
+            const struct u_pose_publisher_state *b,
+            float t,
+            struct xrt_space_relation *out_relation)
+{
+	const struct xrt_space_relation *ra = &a->relation;
+	const struct xrt_space_relation *rb = &b->relation;
+
+	struct xrt_quat qa = ra->pose.orientation;
+	struct xrt_quat qb = rb->pose.orientation;
+
+	// Take the shortest path, the samples are close enough for a nlerp.
+	float dot = qa.x * qb.x + qa.y * qb.y + qa.z * qb.z + qa.w * qb.w;
+	float tb = dot < 0.0f ? -t : t;
+	float ta = 1.0f - t;
+
+	struct xrt_quat q = {
+	    qa.x * ta + qb.x * tb,
+	    qa.y * ta + qb.y * tb,
+	    qa.z * ta + qb.z * tb,
+	    qa.w * ta + qb.w * tb,
+	};
+
+	// Only claim what both samples have.
+	enum xrt_space_relation_flags flags = ra->relation_flags & rb->relation_flags;
+
+	U_ZERO(out_relation);
+	out_relation->relation_flags = flags;
+
+	if ((flags & XRT_SPACE_RELATION_ORIENTATION_VALID_BIT) != 0) {
+		math_quat_normalize(&q);
+		out_relation->pose.orientation = q;
+	} else {
+		out_relation->pose.orientation.w = 1.0f;
+	}
+
+	out_relation->pose.position =
+	    m_vec3_add(m_vec3_mul_scalar(ra->pose.position, ta), m_vec3_mul_scalar(rb->pose.position, t));
+	out_relation->linear_velocity =
+	    m_vec3_add(m_vec3_mul_scalar(ra->linear_velocity, ta), m_vec3_mul_scalar(rb->linear_velocity, t));
+	out_relation->angular_velocity =
+	    m_vec3_add(m_vec3_mul_scalar(ra->angular_velocity, ta), m_vec3_mul_scalar(rb->angular_velocity, t));
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+struct ipc_shared_pose_ring *
+ipc_pose_ring_find(struct ipc_shared_memory *ism, uint32_t device_id, enum xrt_input_name name)
+{
+	struct ipc_shared_device *isdev = &ism->isdevs[device_id];
+	struct ipc_shared_pose_ring *rings = &ism->pose_rings[isdev->first_pose_ring_index];
+
+	for (uint32_t i = 0; i < isdev->num_pose_rings; i++) {
+		if (rings[i].name == name) {
+			return &rings[i];
+		}
+	}
+
+	return NULL;
+}
+
+void
+ipc_pose_ring_publish(struct ipc_shared_pose_ring *ring,
+                      uint32_t index,
+                      timepoint_ns timestamp_ns,
+                      const struct xrt_space_relation *relation)
+{
+	u_pose_publisher_publish(&ring->samples[index % IPC_POSE_RING_SIZE], timestamp_ns, relation);
+}
+
+bool
+ipc_pose_ring_get(const struct ipc_shared_pose_ring *ring,
+                  timepoint_ns at_timestamp_ns,
+                  struct xrt_space_relation *out_relation)
+{
+	struct u_pose_publisher_state states[IPC_POSE_RING_SIZE];
+	uint32_t count = 0;
+
+	// Sorted by time, the server may overwrite a sample while we read.
+	for (uint32_t i = 0; i < IPC_POSE_RING_SIZE; i++) {
+		struct u_pose_publisher_state state;
+		if (!u_pose_publisher_read(&ring->samples[i], &state)) {
+			continue;
+		}
+
+		uint32_t k = count++;
+		for (; k > 0 && states[k - 1].timestamp_ns > state.timestamp_ns; k--) {
+			states[k] = states[k - 1];
+		}
+		states[k] = state;
+	}
+
+	if (count == 0) {
+		U_ZERO(out_relation);
+		return false;
+	}
+
+	const struct u_pose_publisher_state *first = &states[0];
+	const struct u_pose_publisher_state *last = &states[count - 1];
+
+	// Outside of the ring, predict from the closest sample.
+	if (at_timestamp_ns >= last->timestamp_ns || at_timestamp_ns <= first->timestamp_ns) {
+		const struct u_pose_publisher_state *closest = at_timestamp_ns >= last->timestamp_ns ? last : first;
+		double delta_s = time_ns_to_s(at_timestamp_ns - closest->timestamp_ns);
+		m_predict_relation(&closest->relation, delta_s, out_relation);
+		return true;
+	}
+
+	uint32_t i = 1;
+	while (states[i].timestamp_ns < at_timestamp_ns) {
+		i++;
+	}
+
+	const struct u_pose_publisher_state *a = &states[i - 1];
+	const struct u_pose_publisher_state *b = &states[i];
+	assert(b->timestamp_ns > a->timestamp_ns);
+
+	float t = (float)(at_timestamp_ns - a->timestamp_ns) / (float)(b->timestamp_ns - a->timestamp_ns);
+	interpolate(a, b, t, out_relation);
+
+	return true;
+}
@@ -0,0 +1,56 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Pose rings in the shared memory, for internal use only
+ * @author Collabora, Ltd.
+ * @ingroup ipc_shared
+ */
+
+#pragma once
+
+#include "shared/ipc_protocol.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Find the pose ring of input @p name on device @p device_id, returns NULL
+ * if the server doesn't publish that input.
+ *
+ * @ingroup ipc_shared
+ */
+struct ipc_shared_pose_ring *
+ipc_pose_ring_find(struct ipc_shared_memory *ism, uint32_t device_id, enum xrt_input_name name);
+
+/*!
+ * Publish a new sample, overwriting the oldest one. The server must only
+ * call this from one thread and increment @p index by one each time.
+ *
+ * @ingroup ipc_shared
+ */
+void
+ipc_pose_ring_publish(struct ipc_shared_pose_ring *ring,
+                      uint32_t index,
+                      timepoint_ns timestamp_ns,
+                      const struct xrt_space_relation *relation);
+
+/*!
+ * Get the relation at @p at_timestamp_ns from the samples in the ring,
+ * interpolating between the two samples around it or predicting from the
+ * closest sample with @ref m_predict_relation if it's outside of the ring.
+ * Returns false if nothing has been published yet.
+ *
+ * @ingroup ipc_shared
+ */
+bool
+ipc_pose_ring_get(const struct ipc_shared_pose_ring *ring,
+                  timepoint_ns at_timestamp_ns,
+                  struct xrt_space_relation *out_relation);
+
+
+#ifdef __cplusplus
+}
+#endif
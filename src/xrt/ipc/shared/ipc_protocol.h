@@ -19,6 +19,8 @@
 #include "xrt/xrt_device.h"
 #include "xrt/xrt_tracking.h"
 
+#include "util/u_pose_publisher.h"
+
 
 #define IPC_MSG_SOCK_FILE "/tmp/monado_comp_ipc"
 #define IPC_MAX_SWAPCHAIN_HANDLES 8
@@ -36,6 +38,10 @@
 #define IPC_SHARED_MAX_INPUTS 1024
 #define IPC_SHARED_MAX_OUTPUTS 128
 #define IPC_SHARED_MAX_BINDINGS 64
+#define IPC_SHARED_MAX_POSE_RINGS 64
+#define IPC_POSE_RING_SIZE 4
+#define IPC_COMMAND_RING_SLOTS 8
+#define IPC_COMMAND_RING_REPLY_SIZE IPC_BUF_SIZE
 
 
 /*
@@ -113,11 +119,103 @@ struct ipc_shared_device
 	//! 'Offset' into the array of outputs where the outputs starts.
 	uint32_t first_output_index;
 
+	//! Number of pose rings, zero if the server doesn't publish any.
+	uint32_t num_pose_rings;
+	//! 'Offset' into the array of pose rings where the rings starts.
+	uint32_t first_pose_ring_index;
+
 	bool orientation_tracking_supported;
 	bool position_tracking_supported;
 	bool hand_tracking_supported;
 };
 
+/*!
+ * The inputs of all devices as seen by one client.
+ *
+ * @ingroup ipc
+ */
+struct ipc_shared_input_buffer
+{
+	//! Bumped every time any of the @ref inputs changes.
+	uint64_t generation;
+
+	//! Value of @ref generation when the inputs of each device last changed.
+	uint64_t device_generations[IPC_SHARED_MAX_DEVICES];
+
+	struct xrt_input inputs[IPC_SHARED_MAX_INPUTS];
+};
+
+/*!
+ * Inputs of one client, double buffered with a sequence counter so that the
+ * client can read a consistent snapshot without taking any lock while the
+ * server thread of the client writes a new one. Only the server thread of
+ * the client writes to it.
+ *
+ * @ingroup ipc
+ */
+struct ipc_shared_input_slot
+{
+	//! Odd while buffer 0 is written and even while buffer 1 is written.
+	uint32_t seq;
+
+	struct ipc_shared_input_buffer buffers[2];
+};
+
+/*!
+ * Single producer single consumer ring of requests from one client to its
+ * server thread, with room for one reply going back. Lets calls that fit be
+ * done without going through the socket, the sides only wake each other up
+ * with a futex when the other side is sleeping.
+ *
+ * Each ring is in its own shared memory, only mapped by the server and the
+ * one client using it, so clients can't write into each others rings.
+ *
+ * @ingroup ipc
+ */
+struct ipc_shared_command_ring
+{
+	//! Number of requests pushed by the client, the server sleeps on it.
+	uint32_t request_head;
+
+	//! Number of requests taken by the server, the client sleeps on it when full.
+	uint32_t request_tail;
+
+	//! Number of replies written by the server, the client sleeps on it.
+	uint32_t reply_seq;
+
+	//! Set by the server while sleeping on @ref request_head.
+	uint32_t server_waiting_request;
+
+	//! Set by the client while sleeping on @ref request_tail.
+	uint32_t client_waiting_space;
+
+	//! Set by the client while sleeping on @ref reply_seq.
+	uint32_t client_waiting_reply;
+
+	uint32_t request_sizes[IPC_COMMAND_RING_SLOTS];
+	uint8_t requests[IPC_COMMAND_RING_SLOTS][IPC_BUF_SIZE];
+
+	uint32_t reply_size;
+	uint8_t reply[IPC_COMMAND_RING_REPLY_SIZE];
+};
+
+/*!
+ * Recent samples of a pose input, written round robin by the server at a
+ * fixed rate so that clients can interpolate and predict the pose themselves
+ * instead of asking the server for every pose. Each sample is consistent on
+ * its own, readers never block the server.
+ *
+ * @ingroup ipc
+ */
+struct ipc_shared_pose_ring
+{
+	//! Which pose input the samples are of.
+	enum xrt_input_name name;
+
+	//! The samples, not in any particular order.
+	struct u_pose_publisher samples[IPC_POSE_RING_SIZE];
+};
+
 /*!
  * Data for a single composition layer.
  *
@@ -227,14 +325,23 @@ struct ipc_shared_memory
 		enum xrt_blend_mode blend_mode;
 	} hmd;
 
+	/*!
+	 * Initial state of the inputs, clients get the up to date state from
+	 * their slot in @ref input_slots.
+	 */
 	struct xrt_input inputs[IPC_SHARED_MAX_INPUTS];
 
+	//! Inputs as last updated for each client, indexed by client slot.
+	struct ipc_shared_input_slot input_slots[IPC_MAX_CLIENTS];
+
 	struct xrt_output outputs[IPC_SHARED_MAX_OUTPUTS];
 
 	struct ipc_shared_binding_profile binding_profiles[IPC_SHARED_MAX_BINDINGS];
 	struct xrt_binding_input_pair input_pairs[IPC_SHARED_MAX_INPUTS];
 	struct xrt_binding_output_pair output_pairs[IPC_SHARED_MAX_OUTPUTS];
 
+	struct ipc_shared_pose_ring pose_rings[IPC_SHARED_MAX_POSE_RINGS];
+
 	struct ipc_layer_slot slots[IPC_MAX_SLOTS];
 };
 
@@ -10,6 +10,7 @@
  */
 
 #include <xrt/xrt_config_os.h>
+#include <xrt/xrt_compiler.h>
 
 #include "shared/ipc_shmem.h"
 
@@ -24,6 +25,7 @@
 // non-android unix
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <stdio.h>
 #endif
 
 #if defined(XRT_OS_ANDROID)
@@ -56,12 +58,24 @@ ipc_shmem_create(size_t size, xrt_shmem_handle_t *out_handle, void **out_map)
 xrt_result_t
 ipc_shmem_create(size_t size, xrt_shmem_handle_t *out_handle, void **out_map)
 {
+	static xrt_atomic_s32_t counter = 0;
+
+	/*
+	 * Regions are created from several threads, a unique name and
+	 * O_EXCL makes sure that two of them never end up sharing one.
+	 */
+	char name[64];
+	snprintf(name, sizeof(name), MONADO_SHMEM_NAME "_%d_%d", (int)getpid(), xrt_atomic_s32_inc_return(&counter));
+
 	*out_handle = -1;
-	int fd = shm_open(MONADO_SHMEM_NAME, O_CREAT | O_RDWR, S_IRUSR | S_IWUSR);
+	int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
 	if (fd < 0) {
 		return XRT_ERROR_IPC_FAILURE;
 	}
 
+	// Don't need the name entry anymore, we can share the FD.
+	shm_unlink(name);
+
 	if (ftruncate(fd, size) < 0) {
 		close(fd);
 		return XRT_ERROR_IPC_FAILURE;
@@ -72,8 +86,6 @@ ipc_shmem_create(size_t size, xrt_shmem_handle_t *out_handle, void **out_map)
 		return result;
 	}
 
-	// Don't need the name entry anymore, we can share the FD.
-	shm_unlink(MONADO_SHMEM_NAME);
 	*out_handle = fd;
 	return XRT_SUCCESS;
 }
@@ -104,12 +116,21 @@ ipc_shmem_map(xrt_shmem_handle_t handle, size_t size, void **out_map)
 	const int access = PROT_READ | PROT_WRITE;
 	const int flags = MAP_SHARED;
 	void *ptr = mmap(NULL, size, access, flags, handle, 0);
-	if (ptr == NULL) {
+	if (ptr == NULL || ptr == MAP_FAILED) {
 		return XRT_ERROR_IPC_FAILURE;
 	}
 	*out_map = ptr;
 	return XRT_SUCCESS;
 }
+
+void
+ipc_shmem_unmap(void *map, size_t size)
+{
+	if (map == NULL) {
+		return;
+	}
+	munmap(map, size);
+}
 #else
 #error "OS not yet supported"
 #endif
@@ -51,6 +51,18 @@ ipc_shmem_create(size_t size, xrt_shmem_handle_t *out_handle, void **out_map);
 xrt_result_t
 ipc_shmem_map(xrt_shmem_handle_t handle, size_t size, void **out_map);
 
+/*!
+ * Unmap a shared memory region mapped with @ref ipc_shmem_create or
+ * @ref ipc_shmem_map.
+ *
+ * @param[in] map The mapping of the region.
+ * @param[in] size Size of region
+ *
+ * @public @memberof xrt_shmem_handle_t
+ */
+void
+ipc_shmem_unmap(void *map, size_t size);
+
 /*!
  * Destroy a handle to a shared memory region.
  *
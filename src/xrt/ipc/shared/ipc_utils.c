@@ -13,6 +13,7 @@
 
 #include "shared/ipc_utils.h"
 #include "shared/ipc_protocol.h"
+#include "ipc_protocol_generated.h"
 
 #include <errno.h>
 #include <sys/socket.h>
@@ -90,7 +91,8 @@ ipc_receive(struct ipc_message_channel *imc, void *out_data, size_t size)
 	msg.msg_iovlen = 1;
 	msg.msg_flags = 0;
 
-	ssize_t len = recvmsg(imc->socket_fd, &msg, MSG_NOSIGNAL);
+	// A stream, wait for the whole message and not more.
+	ssize_t len = recvmsg(imc->socket_fd, &msg, MSG_NOSIGNAL | MSG_WAITALL);
 
 	if (len < 0) {
 		int code = errno;
@@ -107,6 +109,39 @@ ipc_receive(struct ipc_message_channel *imc, void *out_data, size_t size)
 	return XRT_SUCCESS;
 }
 
+xrt_result_t
+ipc_receive_request(struct ipc_message_channel *imc, void *out_data, size_t size, size_t *out_size)
+{
+	assert(size >= sizeof(ipc_command_t));
+
+	uint8_t *buf = (uint8_t *)out_data;
+	ipc_command_t cmd;
+
+	xrt_result_t ret = ipc_receive(imc, buf, sizeof(cmd));
+	if (ret != XRT_SUCCESS) {
+		return ret;
+	}
+
+	memcpy(&cmd, buf, sizeof(cmd));
+
+	size_t msg_size = ipc_cmd_msg_size(cmd);
+	if (msg_size < sizeof(cmd) || msg_size > size) {
+		IPC_ERROR(imc, "Invalid command %u received!", (uint32_t)cmd);
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	if (msg_size > sizeof(cmd)) {
+		ret = ipc_receive(imc, buf + sizeof(cmd), msg_size - sizeof(cmd));
+		if (ret != XRT_SUCCESS) {
+			return ret;
+		}
+	}
+
+	*out_size = msg_size;
+
+	return XRT_SUCCESS;
+}
+
 union imcontrol_buf {
 	uint8_t buf[512];
 	struct cmsghdr align;
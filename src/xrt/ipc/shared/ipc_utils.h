@@ -69,6 +69,23 @@ ipc_send(struct ipc_message_channel *imc, const void *data, size_t size);
 xrt_result_t
 ipc_receive(struct ipc_message_channel *imc, void *out_data, size_t size);
 
+/*!
+ * Receive exactly one request over the IPC channel, the command first and
+ * then the rest of the message of that command. The socket is a stream, so
+ * requests sent back to back, like an asynchronous call followed by another
+ * call, are received one at a time instead of together.
+ *
+ * @param imc Message channel to use
+ * @param[out] out_data Pointer to the buffer to fill with the request. Must
+ * not be null.
+ * @param[in] size Size of @p out_data, requests that don't fit are errors.
+ * @param[out] out_size Size of the received request.
+ *
+ * @public @memberof ipc_message_channel
+ */
+xrt_result_t
+ipc_receive_request(struct ipc_message_channel *imc, void *out_data, size_t size, size_t *out_size);
+
 /*!
  * @name File Descriptor utilities
  * @brief These are typically called from within the send/receive_handles
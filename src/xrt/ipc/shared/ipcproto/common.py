@@ -220,6 +220,7 @@ class Call:
         self.out_args = []
         self.in_handles = None
         self.out_handles = None
+        self.is_async = False
         for key, val in data.items():
             if key == 'id':
                 self.id = val
@@ -231,8 +232,14 @@ class Call:
                 self.out_handles = HandleType(val)
             elif key == 'in_handles':
                 self.in_handles = HandleType(val)
+            elif key == 'async':
+                self.is_async = bool(val)
             else:
                 raise RuntimeError("Unrecognized key")
+        if self.is_async and (self.out_args or self.in_handles or
+                              self.out_handles):
+            raise RuntimeError("Async call " + name +
+                               " can not have out args or handles")
         if not self.id:
             self.id = "IPC_" + name.upper()
 
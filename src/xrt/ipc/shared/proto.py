@@ -87,6 +87,19 @@ ipc_cmd_to_str(ipc_command_t id)
                 f.write("\t" + arg.get_struct_field() + ";\n")
             f.write("};\n")
 
+    # The socket is a stream, the reader needs to know where requests end.
+    f.write('''
+static inline size_t
+ipc_cmd_msg_size(ipc_command_t id)
+{
+\tswitch (id) {''')
+    for call in p.calls:
+        msg = ("struct ipc_%s_msg" % call.name
+               if call.needs_msg_struct else "struct ipc_command_msg")
+        f.write("\n\tcase " + call.id + ": return sizeof(" + msg + ");")
+    f.write("\n\tdefault: return 0;")
+    f.write("\n\t}\n}\n")
+
     f.close()
 
 
@@ -124,6 +137,25 @@ def generate_client_c(file, p):
                     " = " + call.in_handles.count_arg_name + ",\n")
         f.write("\t};\n")
 
+        # No reply, errors are returned by the next synchronous call.
+        if call.is_async:
+            f.write("""
+\t// Other threads must not write to the fd at the same time
+\tos_mutex_lock(&ipc_c->mutex);
+""")
+            f.write("\n\t// Send our request, without waiting for a reply")
+            write_invocation(
+                f,
+                'xrt_result_t ret',
+                'ipc_client_send_async',
+                ('ipc_c', '&_msg', 'sizeof(_msg)'),
+                indent="\t"
+            )
+            f.write(";\n")
+            f.write("\n\tos_mutex_unlock(&ipc_c->mutex);")
+            f.write("\n\treturn ret;\n}\n")
+            continue
+
         # Reply struct
         if call.out_args:
             f.write("\tstruct ipc_" + call.name + "_reply _reply;\n")
@@ -138,11 +170,47 @@ def generate_client_c(file, p):
 """)
         cleanup = "os_mutex_unlock(&ipc_c->mutex);"
 
+        f.write("\n\txrt_result_t ret;\n")
+
+        # Calls without handles can use the command ring.
+        if not call.in_handles and not call.out_handles:
+            f.write("\n\t// Use the command ring if we can.")
+            f.write("\n\tif (ipc_client_command_ring_enabled(ipc_c, "
+                    "sizeof(_reply))) {")
+            write_invocation(
+                f,
+                'ret',
+                'ipc_client_command_ring_call',
+                (
+                    'ipc_c',
+                    '&_msg',
+                    'sizeof(_msg)',
+                    '&_reply',
+                    'sizeof(_reply)'
+                ),
+                indent="\t\t"
+            )
+            f.write(';')
+            write_result_handler(f, 'ret', cleanup, indent="\t\t")
+            for arg in call.out_args:
+                f.write("\t\t*out_" + arg.name + " = _reply." + arg.name +
+                        ";\n")
+            f.write("\n\t\t" + cleanup)
+            f.write("\n\t\treturn _reply.result;\n\t}\n")
+
+        # The server only looks at the socket when told to.
+        f.write("\n\t// Tell the server to read the socket, "
+                "if it is using the command ring.")
+        write_invocation(f, 'ret', 'ipc_client_command_ring_use_socket',
+                         ['ipc_c'], indent="\t")
+        f.write(';')
+        write_result_handler(f, 'ret', cleanup, indent="\t")
+
         # Prepare initial sending
         func = 'ipc_send'
         args = ['&ipc_c->imc', '&_msg', 'sizeof(_msg)']
         f.write("\n\t// Send our request")
-        write_invocation(f, 'xrt_result_t ret', func, args, indent="\t")
+        write_invocation(f, 'ret', func, args, indent="\t")
         f.write(';')
         write_result_handler(f, 'ret', cleanup, indent="\t")
 
@@ -337,15 +405,38 @@ ipc_dispatch(volatile struct ipc_client_state *ics, ipc_command_t *ipc_command)
                          call.name, args, indent="\t\t")
         f.write(";\n")
 
+        # The client doesn't wait for a reply, keep the error for later.
+        if call.is_async:
+            f.write("\n\t\t// Returned by the next synchronous call.\n")
+            f.write("\t\tif (reply.result != XRT_SUCCESS && "
+                    "ics->async_result == XRT_SUCCESS) {\n")
+            f.write("\t\t\tics->async_result = reply.result;\n")
+            f.write("\t\t}\n")
+            f.write("\t\treturn XRT_SUCCESS;\n")
+            f.write("\t}\n")
+            continue
+
+        # Hand over any error from earlier asynchronous calls.
+        f.write("\n\t\t// Error from an earlier asynchronous call.\n")
+        f.write("\t\tif (reply.result == XRT_SUCCESS && "
+                "ics->async_result != XRT_SUCCESS) {\n")
+        f.write("\t\t\treply.result = ics->async_result;\n")
+        f.write("\t\t\tics->async_result = XRT_SUCCESS;\n")
+        f.write("\t\t}\n")
+
         # TODO do we check reply.result and
         # error out before replying if it's not success?
 
-        func = 'ipc_send'
-        args = ["(struct ipc_message_channel *)&ics->imc",
+        # Replies go back the same way the request came.
+        func = 'ipc_server_send_reply'
+        args = ["ics",
                 "&reply",
                 "sizeof(reply)"]
         if call.out_handles:
-            func += '_handles_' + call.out_handles.stem
+            func = 'ipc_send_handles_' + call.out_handles.stem
+            args = ["(struct ipc_message_channel *)&ics->imc",
+                    "&reply",
+                    "sizeof(reply)"]
             args.extend(call.out_handles.arg_names)
         write_invocation(f, 'xrt_result_t ret', func, args, indent="\t\t")
         f.write(";")
@@ -357,6 +448,28 @@ ipc_dispatch(volatile struct ipc_client_state *ics, ipc_command_t *ipc_command)
 \t}
 }
 
+''')
+
+    # Same rule as the client uses to decide what goes on the ring.
+    f.write('''bool
+ipc_command_ring_allowed(ipc_command_t cmd, size_t size)
+{
+\tswitch (cmd) {
+''')
+    for call in p.calls:
+        if call.in_handles or call.out_handles:
+            continue
+        msg = ("struct ipc_%s_msg" % call.name
+               if call.needs_msg_struct else "struct ipc_command_msg")
+        reply = ("struct ipc_%s_reply" % call.name
+                 if call.out_args else "struct ipc_result_reply")
+        f.write("\tcase " + call.id + ":\n")
+        f.write("\t\treturn size == sizeof(%s) &&\n" % msg)
+        f.write("\t\t       sizeof(%s) <= "
+                "IPC_COMMAND_RING_REPLY_SIZE;\n" % reply)
+    f.write('''\tdefault: return false;
+\t}
+}
 ''')
     f.close()
 
@@ -391,6 +504,23 @@ def generate_server_header(file, p):
     )
     f.write(";\n")
 
+    f.write('''
+/*!
+ * Is @p cmd with a request of @p size bytes allowed on the command ring,
+ * requests popped from the ring are written by the client and must be
+ * checked before being dispatched.
+ */''')
+    write_decl(
+        f,
+        "bool",
+        "ipc_command_ring_allowed",
+        [
+            "ipc_command_t cmd",
+            "size_t size"
+        ]
+    )
+    f.write(";\n\n")
+
     for call in p.calls:
         call.write_handler_decl(f)
         f.write(";\n")
@@ -20,6 +20,8 @@
 #include "util/u_var.h"
 #include "util/u_misc.h"
 #include "util/u_sink.h"
+#include "util/u_debug.h"
+#include "util/u_recording.h"
 #include "util/u_config_json.h"
 #include "p_prober.h"
 
@@ -33,6 +35,36 @@
  *
  */
 
+#ifdef XRT_HAVE_OPENCV
+DEBUG_GET_ONCE_OPTION(record_path, "P_TRACKING_RECORD", NULL)
+DEBUG_GET_ONCE_BOOL_OPTION(hsv_packed, "P_TRACKING_HSV_PACKED", false)
+
+/*!
+ * Records the IMU samples pushed to a psmv tracker, before passing them on.
+ *
+ * @implements xrt_tracked_psmv
+ */
+struct p_recorded_psmv
+{
+	struct xrt_tracked_psmv base;
+	struct xrt_tracked_psmv *xtmv;
+	struct u_recording_writer *writer;
+	uint32_t stream;
+};
+
+/*!
+ * Records the IMU samples pushed to the psvr tracker, before passing them on.
+ *
+ * @implements xrt_tracked_psvr
+ */
+struct p_recorded_psvr
+{
+	struct xrt_tracked_psvr base;
+	struct xrt_tracked_psvr *xtvr;
+	struct u_recording_writer *writer;
+};
+#endif
+
 /*!
  * @implements xrt_tracking_factory
  * @extends xrt_tracking_origin
@@ -78,6 +110,13 @@ struct p_factory
 
 	//! Pre-created psvr trackers.
 	struct xrt_tracked_psvr *xtvr;
+
+	//! Records frames and IMU samples, only set with P_TRACKING_RECORD.
+	struct u_recording_writer *writer;
+
+	//! Recording wrappers handed out instead of the trackers.
+	struct p_recorded_psmv recorded_xtmv[2];
+	struct p_recorded_psvr recorded_xtvr;
 #endif
 
 	// Frameserver.
@@ -98,6 +137,125 @@ p_factory(struct xrt_tracking_factory *xfact)
 }
 
 #ifdef XRT_HAVE_OPENCV
+static void
+recorded_psmv_push_imu(struct xrt_tracked_psmv *xtmv, timepoint_ns timestamp_ns, struct xrt_tracking_sample *sample)
+{
+	struct p_recorded_psmv *r = (struct p_recorded_psmv *)xtmv;
+
+	u_recording_writer_write_imu(r->writer, r->stream, timestamp_ns, sample);
+	xrt_tracked_psmv_push_imu(r->xtmv, timestamp_ns, sample);
+}
+
+static void
+recorded_psmv_push_imu_batch(struct xrt_tracked_psmv *xtmv,
+                             const struct xrt_tracking_timed_sample *samples,
+                             uint32_t count)
+{
+	struct p_recorded_psmv *r = (struct p_recorded_psmv *)xtmv;
+
+	for (uint32_t i = 0; i < count; i++) {
+		struct xrt_tracking_sample sample = samples[i].sample;
+		u_recording_writer_write_imu(r->writer, r->stream, samples[i].timestamp_ns, &sample);
+	}
+	xrt_tracked_psmv_push_imu_batch(r->xtmv, samples, count);
+}
+
+static void
+recorded_psmv_get_tracked_pose(struct xrt_tracked_psmv *xtmv,
+                               enum xrt_input_name name,
+                               timepoint_ns when_ns,
+                               struct xrt_space_relation *out_relation)
+{
+	struct p_recorded_psmv *r = (struct p_recorded_psmv *)xtmv;
+
+	xrt_tracked_psmv_get_tracked_pose(r->xtmv, name, when_ns, out_relation);
+}
+
+static void
+recorded_psmv_destroy(struct xrt_tracked_psmv *xtmv)
+{
+	// Owned by the factory, the tracker is owned by the frame context.
+}
+
+static struct xrt_tracked_psmv *
+wrap_psmv(struct p_factory *fact, struct xrt_tracked_psmv *xtmv, size_t index)
+{
+	if (fact->writer == NULL) {
+		return xtmv;
+	}
+
+	struct p_recorded_psmv *r = &fact->recorded_xtmv[index];
+	r->base.origin = xtmv->origin;
+	r->base.colour = xtmv->colour;
+	r->base.push_imu = recorded_psmv_push_imu;
+	r->base.push_imu_batch = recorded_psmv_push_imu_batch;
+	r->base.get_tracked_pose = recorded_psmv_get_tracked_pose;
+	r->base.destroy = recorded_psmv_destroy;
+	r->xtmv = xtmv;
+	r->writer = fact->writer;
+	r->stream = U_RECORDING_IMU_STREAM_PSMV_0 + (uint32_t)index;
+
+	return &r->base;
+}
+
+static void
+recorded_psvr_push_imu(struct xrt_tracked_psvr *xtvr, timepoint_ns timestamp_ns, struct xrt_tracking_sample *sample)
+{
+	struct p_recorded_psvr *r = (struct p_recorded_psvr *)xtvr;
+
+	u_recording_writer_write_imu(r->writer, U_RECORDING_IMU_STREAM_PSVR, timestamp_ns, sample);
+	xrt_tracked_psvr_push_imu(r->xtvr, timestamp_ns, sample);
+}
+
+static void
+recorded_psvr_push_imu_batch(struct xrt_tracked_psvr *xtvr,
+                             const struct xrt_tracking_timed_sample *samples,
+                             uint32_t count)
+{
+	struct p_recorded_psvr *r = (struct p_recorded_psvr *)xtvr;
+
+	for (uint32_t i = 0; i < count; i++) {
+		struct xrt_tracking_sample sample = samples[i].sample;
+		u_recording_writer_write_imu(r->writer, U_RECORDING_IMU_STREAM_PSVR, samples[i].timestamp_ns, &sample);
+	}
+	xrt_tracked_psvr_push_imu_batch(r->xtvr, samples, count);
+}
+
+static void
+recorded_psvr_get_tracked_pose(struct xrt_tracked_psvr *xtvr,
+                               timepoint_ns when_ns,
+                               struct xrt_space_relation *out_relation)
+{
+	struct p_recorded_psvr *r = (struct p_recorded_psvr *)xtvr;
+
+	xrt_tracked_psvr_get_tracked_pose(r->xtvr, when_ns, out_relation);
+}
+
+static void
+recorded_psvr_destroy(struct xrt_tracked_psvr *xtvr)
+{
+	// Owned by the factory, the tracker is owned by the frame context.
+}
+
+static struct xrt_tracked_psvr *
+wrap_psvr(struct p_factory *fact, struct xrt_tracked_psvr *xtvr)
+{
+	if (fact->writer == NULL) {
+		return xtvr;
+	}
+
+	struct p_recorded_psvr *r = &fact->recorded_xtvr;
+	r->base.origin = xtvr->origin;
+	r->base.push_imu = recorded_psvr_push_imu;
+	r->base.push_imu_batch = recorded_psvr_push_imu_batch;
+	r->base.get_tracked_pose = recorded_psvr_get_tracked_pose;
+	r->base.destroy = recorded_psvr_destroy;
+	r->xtvr = xtvr;
+	r->writer = fact->writer;
+
+	return &r->base;
+}
+
 static void
 on_video_device(struct xrt_prober *xp,
                 struct xrt_prober_device *pdev,
@@ -177,12 +335,12 @@ p_factory_ensure_frameserver(struct p_factory *fact)
 	fact->xtmv[0]->origin = &fact->origin;
 	fact->xtmv[1]->origin = &fact->origin;
 
-	// We create the default multi-channel hsv filter.
+	// We create the default multi-channel hsv filter, packed masks are
+	// opt-in until the trackers can search them without expanding them.
 	struct t_hsv_filter_params params = T_HSV_DEFAULT_PARAMS();
-	t_hsv_filter_create(&fact->xfctx, &params, xsinks, &xsink);
-
-	// The filter only supports yuv or yuyv formats.
-	u_sink_create_to_yuv_or_yuyv(&fact->xfctx, xsink, &xsink);
+	enum t_hsv_filter_output output =
+	    debug_get_bool_option_hsv_packed() ? T_HSV_FILTER_OUTPUT_BITMAP_8X1 : T_HSV_FILTER_OUTPUT_L8;
+	t_hsv_filter_create_with_output(&fact->xfctx, &params, output, xsinks, &xsink);
 
 	// Put a queue before it to multi-thread the filter.
 	u_sink_queue_create(&fact->xfctx, xsink, &xsink);
@@ -219,6 +377,16 @@ p_factory_ensure_frameserver(struct p_factory *fact)
 		break;
 	}
 
+	// Record what the trackers see, the quirks have been applied to the frames by then.
+	const char *record_path = debug_get_option_record_path();
+	if (record_path != NULL) {
+		fact->writer = u_recording_writer_create(&fact->xfctx, record_path);
+	}
+	if (fact->writer != NULL) {
+		U_LOG_I("Recording tracking to '%s'.", record_path);
+		u_sink_recorder_create(&fact->xfctx, fact->writer, xsink, &xsink);
+	}
+
 	u_sink_quirk_create(&fact->xfctx, xsink, &qp, &xsink);
 
 	// Start the stream now.
@@ -256,7 +424,7 @@ p_factory_create_tracked_psmv(struct xrt_tracking_factory *xfact,
 	fact->num_xtmv++;
 
 	t_psmv_start(xtmv);
-	*out_xtmv = xtmv;
+	*out_xtmv = wrap_psmv(fact, xtmv, fact->num_xtmv - 1);
 
 	return 0;
 #else
@@ -286,7 +454,7 @@ p_factory_create_tracked_psvr(struct xrt_tracking_factory *xfact,
 
 	fact->started_xtvr = true;
 	t_psvr_start(xtvr);
-	*out_xtvr = xtvr;
+	*out_xtvr = wrap_psvr(fact, xtvr);
 
 	return 0;
 #else
@@ -374,6 +542,7 @@ p_tracking_teardown(struct prober *p)
 	fact->xtmv[0] = NULL;
 	fact->xtmv[1] = NULL;
 	fact->xtvr = NULL;
+	fact->writer = NULL;
 #endif
 
 	// Take down the node graph.
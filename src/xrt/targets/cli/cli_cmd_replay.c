@@ -0,0 +1,484 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Replay a tracking recording through the camera trackers.
+ * @author Collabora, Ltd.
+ */
+
+#include "xrt/xrt_config_have.h"
+#include "xrt/xrt_frame.h"
+#include "xrt/xrt_frameserver.h"
+#include "xrt/xrt_tracking.h"
+
+#include "os/os_time.h"
+
+#include "util/u_var.h"
+#include "util/u_misc.h"
+#include "util/u_sink.h"
+#include "util/u_debug.h"
+#include "util/u_time.h"
+#include "util/u_recording.h"
+#include "util/u_hand_tracking.h"
+
+#include "tracking/t_tracking.h"
+
+#include "cli_common.h"
+
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <inttypes.h>
+
+
+#define P(...) fprintf(stderr, __VA_ARGS__)
+
+//! How long to wait for a tracker to finish a frame before giving up on it.
+#define DRAIN_TIMEOUT_NS (U_TIME_1MS_IN_NS * 1000)
+
+//! Same option as the prober, so the trackers get the same masks.
+DEBUG_GET_ONCE_BOOL_OPTION(hsv_packed, "P_TRACKING_HSV_PACKED", false)
+
+enum replay_tracker
+{
+	REPLAY_TRACKER_PSVR,
+	REPLAY_TRACKER_PSMV,
+	REPLAY_TRACKER_HAND,
+};
+
+/*!
+ * Sits in front of a tracker and keeps a reference to the last frame pushed
+ * to it. The trackers release a frame once they are done with it, so when
+ * ours is the only reference left the poses include that frame.
+ */
+struct replay_drain
+{
+	struct xrt_frame_sink base;
+	struct xrt_frame_sink *downstream;
+
+	struct xrt_frame *frame;
+};
+
+struct replay
+{
+	//! Sits between the replay and the trackers, samples the poses.
+	struct xrt_frame_sink pose_sink;
+	struct xrt_frame_sink *downstream;
+
+	struct xrt_frame_context xfctx;
+
+	enum replay_tracker tracker;
+
+	struct xrt_tracked_psvr *xtvr;
+	struct xrt_tracked_psmv *xtmv[2];
+	struct xrt_tracked_hand *xth;
+
+	//! One in front of each tracker.
+	struct replay_drain drains[3];
+	size_t num_drains;
+
+	//! Only warn once about a tracker that holds on to its frames.
+	bool warned_drain;
+
+	//! Optional pose output.
+	FILE *poses;
+
+	//! Used when printing the tracker stats.
+	struct
+	{
+		const char *root;
+		uint64_t runs;
+		double sum_ms;
+		float max_ms;
+	} visit;
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static void
+print_usage(const char *prog)
+{
+	P("Usage: %s replay <recording> <calibration.json> [options]\n", prog);
+	P("\n");
+	P("Options:\n");
+	P("  --tracker <psvr|psmv|hand> - Tracker to replay through, default psvr.\n");
+	P("  --fast                     - Replay as fast as possible, not at recorded pace.\n");
+	P("  --poses <file.csv>         - Write the tracked pose at every frame.\n");
+	P("\n");
+	P("Every frame is tracked before the next one is pushed, so the poses do\n");
+	P("not depend on timing and --fast measures the time the trackers take.\n");
+	P("Set P_TRACKING_HSV_PACKED like for the service to use packed masks.\n");
+}
+
+static void
+write_pose(struct replay *r, uint64_t timestamp_ns, const char *name, struct xrt_space_relation *rel)
+{
+	struct xrt_pose *p = &rel->pose;
+
+	fprintf(r->poses, "%" PRIu64 ",%s,%u,%f,%f,%f,%f,%f,%f,%f\n", timestamp_ns, name,
+	        (unsigned int)rel->relation_flags, p->position.x, p->position.y, p->position.z, p->orientation.x,
+	        p->orientation.y, p->orientation.z, p->orientation.w);
+}
+
+static void
+sample_poses(struct replay *r, uint64_t timestamp_ns)
+{
+	struct xrt_space_relation rel;
+
+	switch (r->tracker) {
+	case REPLAY_TRACKER_PSVR:
+		U_ZERO(&rel);
+		xrt_tracked_psvr_get_tracked_pose(r->xtvr, timestamp_ns, &rel);
+		write_pose(r, timestamp_ns, "psvr", &rel);
+		break;
+	case REPLAY_TRACKER_PSMV:
+		for (size_t i = 0; i < ARRAY_SIZE(r->xtmv); i++) {
+			U_ZERO(&rel);
+			xrt_tracked_psmv_get_tracked_pose(r->xtmv[i], XRT_INPUT_PSMV_GRIP_POSE, timestamp_ns, &rel);
+			write_pose(r, timestamp_ns, i == 0 ? "psmv_0" : "psmv_1", &rel);
+		}
+		break;
+	case REPLAY_TRACKER_HAND: {
+		struct u_hand_joint_default_set joints;
+		enum xrt_input_name names[2] = {
+		    XRT_INPUT_GENERIC_HAND_TRACKING_LEFT,
+		    XRT_INPUT_GENERIC_HAND_TRACKING_RIGHT,
+		};
+		for (size_t i = 0; i < ARRAY_SIZE(names); i++) {
+			U_ZERO(&rel);
+			U_ZERO(&joints);
+			r->xth->get_tracked_joints(r->xth, names[i], timestamp_ns, &joints, &rel);
+			write_pose(r, timestamp_ns, i == 0 ? "hand_left" : "hand_right", &rel);
+		}
+	} break;
+	}
+}
+
+
+/*
+ *
+ * Drain sinks.
+ *
+ */
+
+static void
+drain_push_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
+{
+	struct replay_drain *d = container_of(xfs, struct replay_drain, base);
+
+	xrt_frame_reference(&d->frame, xf);
+	d->downstream->push_frame(d->downstream, xf);
+}
+
+static struct xrt_frame_sink *
+drain_wrap(struct replay *r, struct xrt_frame_sink *downstream)
+{
+	assert(r->num_drains < ARRAY_SIZE(r->drains));
+
+	struct replay_drain *d = &r->drains[r->num_drains++];
+	d->base.push_frame = drain_push_frame;
+	d->downstream = downstream;
+
+	return &d->base;
+}
+
+/*!
+ * Wait for the trackers to finish the frames that were just pushed.
+ */
+static void
+drain_wait(struct replay *r)
+{
+	for (size_t i = 0; i < r->num_drains; i++) {
+		struct replay_drain *d = &r->drains[i];
+		if (d->frame == NULL) {
+			continue;
+		}
+
+		uint64_t start_ns = os_monotonic_get_ns();
+		while (d->frame->reference.count > 1) {
+			if (os_monotonic_get_ns() - start_ns > DRAIN_TIMEOUT_NS) {
+				if (!r->warned_drain) {
+					P("A tracker is holding on to its frames, poses may lag behind!\n");
+					r->warned_drain = true;
+				}
+				break;
+			}
+			os_nanosleep(U_TIME_1MS_IN_NS / 10);
+		}
+
+		xrt_frame_reference(&d->frame, NULL);
+	}
+}
+
+
+/*
+ *
+ * Replay callbacks.
+ *
+ */
+
+static void
+pose_sink_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
+{
+	struct replay *r = container_of(xfs, struct replay, pose_sink);
+
+	r->downstream->push_frame(r->downstream, xf);
+	drain_wait(r);
+
+	if (r->poses != NULL) {
+		sample_poses(r, xf->timestamp);
+	}
+}
+
+static void
+push_imu(void *ptr, uint32_t stream, timepoint_ns timestamp_ns, struct xrt_tracking_sample *sample)
+{
+	struct replay *r = (struct replay *)ptr;
+
+	switch (stream) {
+	case U_RECORDING_IMU_STREAM_PSVR:
+		if (r->xtvr != NULL) {
+			xrt_tracked_psvr_push_imu(r->xtvr, timestamp_ns, sample);
+		}
+		break;
+	case U_RECORDING_IMU_STREAM_PSMV_0:
+	case U_RECORDING_IMU_STREAM_PSMV_1:
+		if (r->xtmv[stream - U_RECORDING_IMU_STREAM_PSMV_0] != NULL) {
+			xrt_tracked_psmv_push_imu(r->xtmv[stream - U_RECORDING_IMU_STREAM_PSMV_0], timestamp_ns,
+			                          sample);
+		}
+		break;
+	default: break;
+	}
+}
+
+
+/*
+ *
+ * Tracker stats, read from the variable tracking of the trackers.
+ *
+ */
+
+static void
+visit_enter(const char *name, void *priv)
+{
+	struct replay *r = (struct replay *)priv;
+
+	U_ZERO(&r->visit);
+	r->visit.root = name;
+}
+
+static void
+visit_elem(struct u_var_info *info, void *priv)
+{
+	struct replay *r = (struct replay *)priv;
+
+	if (strcmp(info->name, "Views runs") == 0) {
+		r->visit.runs = *(uint64_t *)info->ptr;
+	} else if (strcmp(info->name, "Views sum (ms)") == 0) {
+		r->visit.sum_ms = *(double *)info->ptr;
+	} else if (strcmp(info->name, "Views max (ms)") == 0) {
+		r->visit.max_ms = *(float *)info->ptr;
+	}
+}
+
+static void
+visit_exit(const char *name, void *priv)
+{
+	struct replay *r = (struct replay *)priv;
+
+	if (r->visit.runs == 0) {
+		return;
+	}
+
+	P("  %-24s %8" PRIu64 " runs, avg %7.3f ms, max %7.3f ms\n", r->visit.root, r->visit.runs,
+	  r->visit.sum_ms / (double)r->visit.runs, r->visit.max_ms);
+}
+
+
+/*
+ *
+ * Pipeline.
+ *
+ */
+
+static void
+create_pipeline(struct replay *r, struct t_stereo_camera_calibration *data)
+{
+	struct xrt_frame_sink *xsink = NULL;
+
+	if (r->tracker == REPLAY_TRACKER_HAND) {
+		t_hand_create(&r->xfctx, data, &r->xth, &xsink);
+		xsink = drain_wrap(r, xsink);
+		u_sink_create_to_r8g8b8_or_l8(&r->xfctx, xsink, &xsink);
+		t_hand_start(r->xth);
+		r->downstream = xsink;
+		return;
+	}
+
+	// Same setup as the prober, minus the queue so no frames are dropped before the trackers.
+	struct xrt_frame_sink *xsinks[4] = {0};
+	struct xrt_colour_rgb_f32 rgb[2] = {{1.f, 0.f, 0.f}, {1.f, 0.f, 1.f}};
+
+	if (r->tracker == REPLAY_TRACKER_PSMV) {
+		t_psmv_create(&r->xfctx, &rgb[0], data, &r->xtmv[0], &xsinks[0]);
+		t_psmv_create(&r->xfctx, &rgb[1], data, &r->xtmv[1], &xsinks[1]);
+		xsinks[0] = drain_wrap(r, xsinks[0]);
+		xsinks[1] = drain_wrap(r, xsinks[1]);
+	} else {
+		t_psvr_create(&r->xfctx, data, &r->xtvr, &xsinks[2]);
+		xsinks[2] = drain_wrap(r, xsinks[2]);
+	}
+
+	struct t_hsv_filter_params params = T_HSV_DEFAULT_PARAMS();
+	enum t_hsv_filter_output output =
+	    debug_get_bool_option_hsv_packed() ? T_HSV_FILTER_OUTPUT_BITMAP_8X1 : T_HSV_FILTER_OUTPUT_L8;
+	t_hsv_filter_create_with_output(&r->xfctx, &params, output, xsinks, &xsink);
+
+	if (r->tracker == REPLAY_TRACKER_PSMV) {
+		t_psmv_start(r->xtmv[0]);
+		t_psmv_start(r->xtmv[1]);
+	} else {
+		t_psvr_start(r->xtvr);
+	}
+
+	r->downstream = xsink;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+int
+cli_cmd_replay(int argc, const char **argv)
+{
+	if (argc < 4) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	const char *recording_path = argv[2];
+	const char *calibration_path = argv[3];
+	const char *poses_path = NULL;
+	struct replay r = {0};
+	bool fast = false;
+
+	for (int i = 4; i < argc; i++) {
+		if (strcmp(argv[i], "--fast") == 0) {
+			fast = true;
+		} else if (strcmp(argv[i], "--poses") == 0 && i + 1 < argc) {
+			poses_path = argv[++i];
+		} else if (strcmp(argv[i], "--tracker") == 0 && i + 1 < argc) {
+			const char *name = argv[++i];
+			if (strcmp(name, "psvr") == 0) {
+				r.tracker = REPLAY_TRACKER_PSVR;
+			} else if (strcmp(name, "psmv") == 0) {
+				r.tracker = REPLAY_TRACKER_PSMV;
+			} else if (strcmp(name, "hand") == 0) {
+				r.tracker = REPLAY_TRACKER_HAND;
+			} else {
+				P("Unknown tracker '%s'!\n", name);
+				return 1;
+			}
+		} else {
+			P("Unknown option '%s'!\n\n", argv[i]);
+			print_usage(argv[0]);
+			return 1;
+		}
+	}
+
+	// Needed to read the stats of the trackers.
+	u_var_force_on();
+
+	FILE *file = fopen(calibration_path, "rb");
+	if (file == NULL) {
+		P("Could not open calibration '%s'!\n", calibration_path);
+		return 1;
+	}
+
+	struct t_stereo_camera_calibration *data = NULL;
+	bool loaded = t_stereo_camera_calibration_load_v1(file, &data);
+	fclose(file);
+	if (!loaded) {
+		P("Could not load calibration '%s'!\n", calibration_path);
+		return 1;
+	}
+
+	if (poses_path != NULL) {
+		r.poses = fopen(poses_path, "w");
+		if (r.poses == NULL) {
+			P("Could not open '%s' for writing!\n", poses_path);
+			t_stereo_camera_calibration_reference(&data, NULL);
+			return 1;
+		}
+		fprintf(r.poses, "timestamp_ns,name,flags,px,py,pz,ox,oy,oz,ow\n");
+	}
+
+	struct u_recording_fs_params params = {
+	    .realtime = !fast,
+	    .imu_func = push_imu,
+	    .imu_ptr = &r,
+	};
+
+	struct xrt_fs *xfs = u_recording_fs_open(&r.xfctx, recording_path, &params);
+	if (xfs == NULL) {
+		P("Could not open recording '%s'!\n", recording_path);
+		xrt_frame_context_destroy_nodes(&r.xfctx);
+		t_stereo_camera_calibration_reference(&data, NULL);
+		if (r.poses != NULL) {
+			fclose(r.poses);
+		}
+		return 1;
+	}
+
+	create_pipeline(&r, data);
+	r.pose_sink.push_frame = pose_sink_frame;
+
+	P("Replaying '%s' %s.\n", recording_path, fast ? "as fast as possible" : "at recorded pace");
+
+	xrt_fs_stream_start(xfs, &r.pose_sink, XRT_FS_CAPTURE_TYPE_TRACKING, 0);
+
+	while (xrt_fs_is_running(xfs)) {
+		os_nanosleep(U_TIME_1MS_IN_NS * 10);
+	}
+
+	// Every frame was drained before the next one, so the trackers are idle.
+	xrt_fs_stream_stop(xfs);
+
+	struct u_recording_fs_stats stats;
+	u_recording_fs_get_stats(xfs, &stats);
+
+	double duration_s = time_ns_to_s(stats.duration_ns);
+	double frames = (double)(stats.frames > 0 ? stats.frames : 1);
+
+	P("Replay:\n");
+	P("  frames       %8" PRIu64 "\n", stats.frames);
+	P("  imu samples  %8" PRIu64 "\n", stats.imu_samples);
+	P("  duration     %8.3f s\n", duration_s);
+	P("  throughput   %8.2f fps\n", duration_s > 0.0 ? (double)stats.frames / duration_s : 0.0);
+	P("Stages:\n");
+	P("  read         avg %7.3f ms\n", time_ns_to_s(stats.read_ns) * 1000.0 / frames);
+	P("  sinks        avg %7.3f ms, max %7.3f ms\n", time_ns_to_s(stats.push_ns) * 1000.0 / frames,
+	  time_ns_to_s(stats.push_max_ns) * 1000.0);
+	P("Trackers:\n");
+	u_var_visit(visit_enter, visit_exit, visit_elem, &r);
+
+	// Take down the node graph, then the data it used.
+	xrt_frame_context_destroy_nodes(&r.xfctx);
+	t_stereo_camera_calibration_reference(&data, NULL);
+
+	if (r.poses != NULL) {
+		fclose(r.poses);
+		P("Wrote poses to '%s'.\n", poses_path);
+	}
+
+	return 0;
+}
@@ -23,6 +23,9 @@ cli_cmd_lighthouse(int argc, const char **argv);
 int
 cli_cmd_probe(int argc, const char **argv);
 
+int
+cli_cmd_replay(int argc, const char **argv);
+
 int
 cli_cmd_test(int argc, const char **argv);
 
@@ -9,6 +9,7 @@
 #include "cli_common.h"
 
 #include "xrt/xrt_config_os.h"
+#include "xrt/xrt_config_have.h"
 
 #include <string.h>
 #include <stdio.h>
@@ -32,6 +33,9 @@ cli_print_help(int argc, const char **argv)
 	P("  lighthouse - Control the power of lighthouses [on|off].\n");
 	P("  calibrate  - Calibrate a camera and save config (not implemented yet).\n");
 	P("  trace      - Tracing functionality.\n");
+#ifdef XRT_HAVE_OPENCV
+	P("  replay     - Replay a tracking recording through the trackers.\n");
+#endif
 
 	return 1;
 }
@@ -62,5 +66,10 @@ main(int argc, const char **argv)
 		return cli_cmd_trace(argc, argv);
 	}
 #endif // !XRT_OS_WINDOWS
+#ifdef XRT_HAVE_OPENCV
+	if (strcmp(argv[1], "replay") == 0) {
+		return cli_cmd_replay(argc, argv);
+	}
+#endif // XRT_HAVE_OPENCV
 	return cli_print_help(argc, argv);
 }
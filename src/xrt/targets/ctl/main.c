@@ -177,7 +177,7 @@ main(int argc, char *argv[])
 		}
 	}
 
-	struct ipc_connection ipc_c;
+	struct ipc_connection ipc_c = {0};
 	os_mutex_init(&ipc_c.mutex);
 	int ret = do_connect(&ipc_c);
 	if (ret != 0) {
@@ -0,0 +1,227 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief IPC command ring tests and transport benchmark.
+ * @author Collabora, Ltd.
+ */
+
+#include "catch/catch.hpp"
+
+#include <shared/ipc_command_ring.h>
+#include <shared/ipc_utils.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+
+struct test_request
+{
+	uint32_t cmd;
+	uint32_t value;
+};
+
+struct test_reply
+{
+	xrt_result_t result;
+	uint32_t value;
+};
+
+static constexpr uint32_t cmd_echo = 1;
+static constexpr uint32_t cmd_quit = 2;
+
+static std::unique_ptr<ipc_shared_command_ring>
+make_ring()
+{
+	// Too big for the stack.
+	std::unique_ptr<ipc_shared_command_ring> ring{new ipc_shared_command_ring};
+	ipc_command_ring_reset(ring.get());
+	return ring;
+}
+
+/*!
+ * Acts like a server thread, replies with the value doubled and counts the
+ * markers for requests on the socket.
+ */
+static void
+ring_server(ipc_shared_command_ring *ring, uint32_t *out_markers)
+{
+	uint8_t buf[IPC_BUF_SIZE];
+
+	while (true) {
+		size_t size = 0;
+		if (!ipc_command_ring_pop(ring, buf, &size, 500)) {
+			continue;
+		}
+
+		test_request req = {};
+		memcpy(&req, buf, size < sizeof(req) ? size : sizeof(req));
+
+		if (req.cmd == IPC_COMMAND_RING_ON_SOCKET) {
+			(*out_markers)++;
+			continue;
+		}
+
+		test_reply reply = {XRT_SUCCESS, req.value * 2};
+		ipc_command_ring_write_reply(ring, &reply, sizeof(reply));
+
+		if (req.cmd == cmd_quit) {
+			return;
+		}
+	}
+}
+
+static bool
+ring_call(ipc_shared_command_ring *ring, uint32_t cmd, uint32_t value, test_reply *out_reply)
+{
+	test_request req = {cmd, value};
+	uint32_t reply_seq = ipc_command_ring_get_reply_seq(ring);
+
+	return ipc_command_ring_push(ring, &req, sizeof(req), 500) &&
+	       ipc_command_ring_wait_reply(ring, reply_seq, out_reply, sizeof(*out_reply), 500);
+}
+
+static void
+socket_server(int fd)
+{
+	ipc_message_channel imc = {fd, U_LOGGING_WARN};
+
+	while (true) {
+		test_request req = {};
+		if (ipc_receive(&imc, &req, sizeof(req)) != XRT_SUCCESS) {
+			return;
+		}
+
+		test_reply reply = {XRT_SUCCESS, req.value * 2};
+		if (ipc_send(&imc, &reply, sizeof(reply)) != XRT_SUCCESS || req.cmd == cmd_quit) {
+			return;
+		}
+	}
+}
+
+static bool
+socket_call(ipc_message_channel *imc, uint32_t cmd, uint32_t value, test_reply *out_reply)
+{
+	test_request req = {cmd, value};
+
+	return ipc_send(imc, &req, sizeof(req)) == XRT_SUCCESS &&
+	       ipc_receive(imc, out_reply, sizeof(*out_reply)) == XRT_SUCCESS;
+}
+
+
+TEST_CASE("ipc_command_ring")
+{
+	auto ring = make_ring();
+
+	SECTION("Nothing pushed")
+	{
+		uint8_t buf[IPC_BUF_SIZE];
+		size_t size = 0;
+		CHECK_FALSE(ipc_command_ring_pop(ring.get(), buf, &size, 1));
+
+		test_reply reply = {};
+		CHECK_FALSE(ipc_command_ring_wait_reply(ring.get(), 0, &reply, sizeof(reply), 1));
+	}
+
+	SECTION("Full ring times out")
+	{
+		test_request req = {cmd_echo, 0};
+		for (uint32_t i = 0; i < IPC_COMMAND_RING_SLOTS; i++) {
+			CHECK(ipc_command_ring_push(ring.get(), &req, sizeof(req), 1));
+		}
+		CHECK_FALSE(ipc_command_ring_push(ring.get(), &req, sizeof(req), 1));
+
+		// Requests come out in order and make space.
+		uint8_t buf[IPC_BUF_SIZE];
+		size_t size = 0;
+		CHECK(ipc_command_ring_pop(ring.get(), buf, &size, 1));
+		CHECK(size == sizeof(req));
+		CHECK(ipc_command_ring_push(ring.get(), &req, sizeof(req), 1));
+	}
+
+	SECTION("Calls with a server thread")
+	{
+		uint32_t markers = 0;
+		std::thread server(ring_server, ring.get(), &markers);
+
+		// Enough calls to wrap the ring and the counters many times.
+		const uint32_t num_calls = 20000;
+		uint32_t bad = 0;
+
+		for (uint32_t i = 0; i < num_calls; i++) {
+			// Sprinkle in markers, they don't get replies.
+			if (i % 100 == 0) {
+				test_request marker = {IPC_COMMAND_RING_ON_SOCKET, 0};
+				REQUIRE(ipc_command_ring_push(ring.get(), &marker, sizeof(marker), 500));
+			}
+
+			test_reply reply = {};
+			REQUIRE(ring_call(ring.get(), cmd_echo, i, &reply));
+			if (reply.value != i * 2) {
+				bad++;
+			}
+		}
+
+		test_reply reply = {};
+		REQUIRE(ring_call(ring.get(), cmd_quit, 0, &reply));
+		server.join();
+
+		CHECK(bad == 0);
+		CHECK(markers == num_calls / 100);
+	}
+}
+
+TEST_CASE("ipc_command_ring_benchmark", "[.][benchmark]")
+{
+	using clock = std::chrono::steady_clock;
+	const uint32_t num_calls = 200000;
+
+	// Ring.
+	{
+		auto ring = make_ring();
+		uint32_t markers = 0;
+		std::thread server(ring_server, ring.get(), &markers);
+
+		auto start = clock::now();
+		for (uint32_t i = 0; i < num_calls; i++) {
+			test_reply reply = {};
+			REQUIRE(ring_call(ring.get(), cmd_echo, i, &reply));
+		}
+		std::chrono::duration<double> elapsed = clock::now() - start;
+
+		test_reply reply = {};
+		REQUIRE(ring_call(ring.get(), cmd_quit, 0, &reply));
+		server.join();
+
+		printf("command ring: %.0f calls/s\n", num_calls / elapsed.count());
+	}
+
+	// Socket, the same kind of socket the service uses.
+	{
+		int fds[2];
+		REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+		ipc_message_channel imc = {fds[0], U_LOGGING_WARN};
+		std::thread server(socket_server, fds[1]);
+
+		auto start = clock::now();
+		for (uint32_t i = 0; i < num_calls; i++) {
+			test_reply reply = {};
+			REQUIRE(socket_call(&imc, cmd_echo, i, &reply));
+		}
+		std::chrono::duration<double> elapsed = clock::now() - start;
+
+		test_reply reply = {};
+		REQUIRE(socket_call(&imc, cmd_quit, 0, &reply));
+		server.join();
+
+		close(fds[0]);
+		close(fds[1]);
+
+		printf("socket:       %.0f calls/s\n", num_calls / elapsed.count());
+	}
+}
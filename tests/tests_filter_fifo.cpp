@@ -0,0 +1,201 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Filter fifo tests, compared to a plain list of all pushed samples.
+ * @author Collabora, Ltd.
+ */
+
+#include "catch/catch.hpp"
+
+#include <math/m_filter_fifo.h>
+
+#include <random>
+#include <vector>
+
+
+struct Sample
+{
+	xrt_vec3 v;
+	uint64_t timestamp_ns;
+};
+
+//! The last @p num samples, the fifo starts out with @p num samples at zero.
+static std::vector<Sample>
+window(const std::vector<Sample> &all, size_t num)
+{
+	std::vector<Sample> ret(all.end() - num, all.end());
+	return ret;
+}
+
+static size_t
+reference_stats(const std::vector<Sample> &win,
+                uint64_t start_ns,
+                uint64_t stop_ns,
+                double out_mean[3],
+                double out_cov[9])
+{
+	std::vector<const Sample *> in;
+	for (const Sample &s : win) {
+		if (s.timestamp_ns >= start_ns && s.timestamp_ns <= stop_ns) {
+			in.push_back(&s);
+		}
+	}
+
+	for (int i = 0; i < 3; i++) {
+		out_mean[i] = 0.0;
+	}
+	for (int i = 0; i < 9; i++) {
+		out_cov[i] = 0.0;
+	}
+	if (in.empty()) {
+		return 0;
+	}
+
+	for (const Sample *s : in) {
+		out_mean[0] += s->v.x;
+		out_mean[1] += s->v.y;
+		out_mean[2] += s->v.z;
+	}
+	for (int i = 0; i < 3; i++) {
+		out_mean[i] /= in.size();
+	}
+
+	for (const Sample *s : in) {
+		double d[3] = {s->v.x - out_mean[0], s->v.y - out_mean[1], s->v.z - out_mean[2]};
+		for (int r = 0; r < 3; r++) {
+			for (int c = 0; c < 3; c++) {
+				out_cov[r * 3 + c] += d[r] * d[c];
+			}
+		}
+	}
+	for (int i = 0; i < 9; i++) {
+		out_cov[i] /= in.size();
+	}
+
+	return in.size();
+}
+
+TEST_CASE("m_ff_vec3_f32")
+{
+	// Sizes around the power of two capacity edges.
+	for (size_t num : {1, 7, 8, 9, 100, 1000}) {
+		DYNAMIC_SECTION("num " << num)
+		{
+			std::mt19937 rng(1337);
+			std::uniform_int_distribution<int> dt(0, 3); // Repeated timestamps are allowed.
+			std::normal_distribution<float> noise(0.0f, 0.05f);
+
+			m_ff_vec3_f32 *ff = nullptr;
+			m_ff_vec3_f32_alloc(&ff, num);
+			REQUIRE(m_ff_vec3_f32_get_num(ff) == num);
+
+			std::vector<Sample> all(num, Sample{{0, 0, 0}, 0});
+			uint64_t now_ns = 1;
+
+			// Long enough for the running sums to be rebased many times.
+			for (int i = 0; i < 20000; i++) {
+				now_ns += dt(rng) * 1000 * 1000;
+
+				Sample s = {{noise(rng), 9.81f + noise(rng), -0.5f * noise(rng) + noise(rng)}, now_ns};
+				m_ff_vec3_f32_push(ff, &s.v, s.timestamp_ns);
+				all.push_back(s);
+
+				if (i % 97 != 0) {
+					continue;
+				}
+
+				std::vector<Sample> win = window(all, num);
+
+				xrt_vec3 v;
+				uint64_t ts;
+				REQUIRE(m_ff_vec3_f32_get(ff, 0, &v, &ts));
+				CHECK(ts == win.back().timestamp_ns);
+				CHECK(v.y == win.back().v.y);
+				REQUIRE(m_ff_vec3_f32_get(ff, num - 1, &v, &ts));
+				CHECK(ts == win.front().timestamp_ns);
+				CHECK_FALSE(m_ff_vec3_f32_get(ff, num, &v, &ts));
+
+				for (uint64_t span_ms : {0, 2, 20, 300, 5000}) {
+					uint64_t span_ns = span_ms * 1000 * 1000;
+					uint64_t start_ns = now_ns > span_ns ? now_ns - span_ns : 0;
+					uint64_t stop_ns = now_ns - (span_ms % 3) * 1000 * 1000;
+
+					double mean[3];
+					double cov[9];
+					size_t ref = reference_stats(win, start_ns, stop_ns, mean, cov);
+
+					xrt_vec3 average;
+					CHECK(m_ff_vec3_f32_filter(ff, start_ns, stop_ns, &average) == ref);
+					CHECK(average.x == Approx(mean[0]).margin(1e-6));
+					CHECK(average.y == Approx(mean[1]).margin(1e-6));
+					CHECK(average.z == Approx(mean[2]).margin(1e-6));
+
+					xrt_vec3 stats_mean;
+					xrt_matrix_3x3 stats_cov;
+					CHECK(m_ff_vec3_f32_stats(ff, start_ns, stop_ns, &stats_mean, &stats_cov) == ref);
+					CHECK(stats_mean.y == Approx(mean[1]).margin(1e-5));
+					for (int c = 0; c < 9; c++) {
+						CHECK(stats_cov.v[c] == Approx(cov[c]).margin(1e-6));
+					}
+				}
+			}
+
+			xrt_vec3 average;
+			CHECK(m_ff_vec3_f32_filter(ff, now_ns, now_ns - 1, &average) == 0);
+			CHECK(average.x == 0.0f);
+
+			m_ff_vec3_f32_free(&ff);
+			CHECK(ff == nullptr);
+		}
+	}
+}
+
+TEST_CASE("m_ff_f64")
+{
+	const size_t num = 50;
+
+	m_ff_f64 *ff = nullptr;
+	m_ff_f64_alloc(&ff, num);
+
+	std::vector<double> values(num, 0.0);
+	std::vector<uint64_t> timestamps(num, 0);
+
+	for (uint64_t i = 1; i <= 5000; i++) {
+		double v = 1000.0 + (double)(i % 17) * 0.25;
+		m_ff_f64_push(ff, &v, i * 10);
+		values.push_back(v);
+		timestamps.push_back(i * 10);
+	}
+
+	// The last 20 samples.
+	uint64_t start_ns = timestamps.back() - 19 * 10;
+	uint64_t stop_ns = timestamps.back();
+
+	double sum = 0.0;
+	for (size_t i = values.size() - 20; i < values.size(); i++) {
+		sum += values[i];
+	}
+	double ref_mean = sum / 20.0;
+	double ref_var = 0.0;
+	for (size_t i = values.size() - 20; i < values.size(); i++) {
+		ref_var += (values[i] - ref_mean) * (values[i] - ref_mean);
+	}
+	ref_var /= 20.0;
+
+	double average;
+	CHECK(m_ff_f64_filter(ff, start_ns, stop_ns, &average) == 20);
+	CHECK(average == Approx(ref_mean));
+
+	double mean;
+	double variance;
+	CHECK(m_ff_f64_stats(ff, start_ns, stop_ns, &mean, &variance) == 20);
+	CHECK(mean == Approx(ref_mean));
+	CHECK(variance == Approx(ref_var).margin(1e-9));
+
+	// Nothing older than the window.
+	CHECK(m_ff_f64_stats(ff, 0, timestamps[timestamps.size() - num - 1], &mean, &variance) == 0);
+	CHECK(mean == 0.0);
+
+	m_ff_f64_free(&ff);
+}
@@ -0,0 +1,189 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief HSV filter tests, the packed and L8 outputs against a per pixel
+ *        reference.
+ * @author Collabora, Ltd.
+ */
+
+#include "catch/catch.hpp"
+
+#include <xrt/xrt_frame.h>
+#include <util/u_frame.h>
+#include <tracking/t_tracking.h>
+
+#include <memory>
+#include <vector>
+
+
+struct capture_sink
+{
+	xrt_frame_sink base = {};
+	xrt_frame *frame = nullptr;
+
+	capture_sink()
+	{
+		base.push_frame = push;
+	}
+
+	~capture_sink()
+	{
+		xrt_frame_reference(&frame, nullptr);
+	}
+
+	static void
+	push(xrt_frame_sink *xs, xrt_frame *xf)
+	{
+		capture_sink *cs = (capture_sink *)xs;
+		xrt_frame_reference(&cs->frame, xf);
+	}
+};
+
+/*!
+ * Run one frame through a new filter, @p sinks get the masks.
+ */
+static void
+run_filter(enum t_hsv_filter_output output, xrt_frame *xf, capture_sink sinks[4])
+{
+	xrt_frame_context xfctx = {};
+	t_hsv_filter_params params = T_HSV_DEFAULT_PARAMS();
+	xrt_frame_sink *xsinks[4] = {&sinks[0].base, &sinks[1].base, &sinks[2].base, &sinks[3].base};
+	xrt_frame_sink *xsink = nullptr;
+
+	t_hsv_filter_create_with_output(&xfctx, &params, output, xsinks, &xsink);
+	xsink->push_frame(xsink, xf);
+	xrt_frame_context_destroy_nodes(&xfctx);
+}
+
+static void
+fill_random(xrt_frame *xf, uint32_t seed)
+{
+	for (size_t i = 0; i < xf->size; i++) {
+		seed = seed * 1664525u + 1013904223u;
+		xf->data[i] = (uint8_t)(seed >> 24);
+	}
+}
+
+static uint8_t
+reference_bits(t_hsv_filter_optimized_table *table, const xrt_frame *xf, uint32_t x, uint32_t y)
+{
+	const uint8_t *row = xf->data + y * xf->stride;
+
+	if (xf->format == XRT_FORMAT_YUYV422) {
+		const uint8_t *m = row + (x & ~1u) * 2;
+		return t_hsv_filter_sample(table, row[x * 2], m[1], m[3]);
+	}
+
+	const uint8_t *p = row + x * 3;
+	return t_hsv_filter_sample(table, p[0], p[1], p[2]);
+}
+
+/*!
+ * Checks the masks of both outputs bit by bit, including the padding bits
+ * of the last byte which must be zero.
+ */
+static void
+check_format(enum xrt_format format, uint32_t width)
+{
+	const uint32_t height = 3;
+
+	xrt_frame *xf = nullptr;
+	u_frame_create_one_off(format, width, height, &xf);
+	REQUIRE(xf != nullptr);
+	fill_random(xf, width);
+
+	std::unique_ptr<t_hsv_filter_optimized_table> table{new t_hsv_filter_optimized_table};
+	t_hsv_filter_params params = T_HSV_DEFAULT_PARAMS();
+	t_hsv_build_optimized_table(&params, table.get());
+
+	capture_sink packed[4];
+	capture_sink l8[4];
+	run_filter(T_HSV_FILTER_OUTPUT_BITMAP_8X1, xf, packed);
+	run_filter(T_HSV_FILTER_OUTPUT_L8, xf, l8);
+
+	for (uint32_t c = 0; c < 4; c++) {
+		REQUIRE(packed[c].frame != nullptr);
+		REQUIRE(l8[c].frame != nullptr);
+		CHECK(packed[c].frame->format == XRT_FORMAT_BITMAP_8X1);
+		CHECK(l8[c].frame->format == XRT_FORMAT_L8);
+	}
+
+	uint32_t bad_packed = 0;
+	uint32_t bad_l8 = 0;
+
+	for (uint32_t y = 0; y < height; y++) {
+		for (uint32_t byte = 0; byte < (width + 7) / 8; byte++) {
+			uint8_t expected[4] = {};
+
+			for (uint32_t i = 0; i < 8 && byte * 8 + i < width; i++) {
+				uint32_t x = byte * 8 + i;
+				uint8_t bits = reference_bits(table.get(), xf, x, y);
+
+				for (uint32_t c = 0; c < 4; c++) {
+					uint8_t bit = (bits >> c) & 1;
+					expected[c] |= bit << i;
+
+					uint8_t pixel = l8[c].frame->data[y * l8[c].frame->stride + x];
+					if (pixel != (bit ? 0xff : 0x00)) {
+						bad_l8++;
+					}
+				}
+			}
+
+			for (uint32_t c = 0; c < 4; c++) {
+				if (packed[c].frame->data[y * packed[c].frame->stride + byte] != expected[c]) {
+					bad_packed++;
+				}
+			}
+		}
+	}
+
+	CHECK(bad_packed == 0);
+	CHECK(bad_l8 == 0);
+
+	xrt_frame_reference(&xf, nullptr);
+}
+
+
+TEST_CASE("t_hsv_filter")
+{
+	SECTION("Random data hits every colour")
+	{
+		// Otherwise the comparisons below only compare zeros.
+		const uint32_t width = 256;
+		xrt_frame *xf = nullptr;
+		u_frame_create_one_off(XRT_FORMAT_YUV888, width, 1, &xf);
+		fill_random(xf, width);
+
+		std::unique_ptr<t_hsv_filter_optimized_table> table{new t_hsv_filter_optimized_table};
+		t_hsv_filter_params params = T_HSV_DEFAULT_PARAMS();
+		t_hsv_build_optimized_table(&params, table.get());
+
+		uint8_t seen = 0;
+		for (uint32_t x = 0; x < width; x++) {
+			seen |= reference_bits(table.get(), xf, x, 0);
+		}
+		CHECK((seen & 0x7) == 0x7);
+
+		xrt_frame_reference(&xf, nullptr);
+	}
+
+	SECTION("YUV888")
+	{
+		// Whole groups of eight, tails and odd widths.
+		for (uint32_t width : {1u, 7u, 8u, 9u, 15u, 16u, 17u, 33u, 67u, 640u}) {
+			INFO("width " << width);
+			check_format(XRT_FORMAT_YUV888, width);
+		}
+	}
+
+	SECTION("YUYV422")
+	{
+		// Two pixels per macro pixel, so only even widths.
+		for (uint32_t width : {2u, 6u, 8u, 10u, 14u, 18u, 34u, 66u, 640u}) {
+			INFO("width " << width);
+			check_format(XRT_FORMAT_YUYV422, width);
+		}
+	}
+}
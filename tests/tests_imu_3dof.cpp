@@ -0,0 +1,72 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Batched 3dof IMU fusion tests.
+ * @author Collabora, Ltd.
+ */
+
+#include "catch/catch.hpp"
+
+#include <math/m_imu_3dof.h>
+
+#include <cmath>
+#include <cstring>
+
+
+static xrt_tracking_timed_sample
+make_sample(uint64_t timestamp_ns, int n)
+{
+	float t = (float)n * 0.01f;
+	bool rotating = (n / 500) % 2 == 1;
+
+	xrt_tracking_timed_sample s = {};
+	s.timestamp_ns = (timepoint_ns)timestamp_ns;
+	s.sample.accel_m_s2 = {0.1f * std::sin(t), 9.81f + 0.05f * std::cos(t), 0.02f};
+	s.sample.gyro_rad_secs = {rotating ? 0.3f * std::sin(t) : 0.0f, 0.01f, 0.2f * std::cos(t * 0.3f)};
+	return s;
+}
+
+TEST_CASE("m_imu_3dof_update_batch")
+{
+	m_imu_3dof single;
+	m_imu_3dof batch;
+	m_imu_3dof_init(&single, M_IMU_3DOF_USE_GRAVITY_DUR_20MS);
+	m_imu_3dof_init(&batch, M_IMU_3DOF_USE_GRAVITY_DUR_20MS);
+
+	SECTION("Empty batch does nothing")
+	{
+		m_imu_3dof_update_batch(&batch, nullptr, 0);
+		CHECK(batch.state == M_IMU_3DOF_STATE_START);
+	}
+
+	SECTION("Same result as one sample at a time")
+	{
+		uint64_t timestamp_ns = 1000 * 1000;
+		int n = 0;
+
+		for (int report = 0; report < 2000; report++) {
+			xrt_tracking_timed_sample samples[3];
+			uint32_t count = 1 + report % 3;
+
+			for (uint32_t i = 0; i < count; i++) {
+				timestamp_ns += 1000 * 1000 + (report * 7919) % 50000;
+				samples[i] = make_sample(timestamp_ns, n++);
+
+				m_imu_3dof_update(&single, samples[i].timestamp_ns, &samples[i].sample.accel_m_s2,
+				                  &samples[i].sample.gyro_rad_secs);
+			}
+
+			m_imu_3dof_update_batch(&batch, samples, count);
+
+			// Same code in the same order, so bit exact.
+			REQUIRE(std::memcmp(&single.rot, &batch.rot, sizeof(single.rot)) == 0);
+			REQUIRE(single.last.timestamp_ns == batch.last.timestamp_ns);
+			REQUIRE(single.last.delta_ms == batch.last.delta_ms);
+			REQUIRE(single.grav.error_angle == batch.grav.error_angle);
+		}
+	}
+
+	m_imu_3dof_close(&single);
+	m_imu_3dof_close(&batch);
+}
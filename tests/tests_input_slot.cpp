@@ -0,0 +1,187 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief IPC per client input slot tests.
+ * @author Collabora, Ltd.
+ */
+
+#include "catch/catch.hpp"
+
+#include <shared/ipc_input_slot.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+
+static constexpr uint32_t num_devices = 2;
+static constexpr uint32_t inputs_per_device = 64;
+
+static std::unique_ptr<ipc_shared_memory>
+make_ism()
+{
+	// Way too big for the stack.
+	std::unique_ptr<ipc_shared_memory> ism{new ipc_shared_memory{}};
+
+	ism->num_isdevs = num_devices;
+	for (uint32_t i = 0; i < num_devices; i++) {
+		ism->isdevs[i].first_input_index = i * inputs_per_device;
+		ism->isdevs[i].num_inputs = inputs_per_device;
+	}
+
+	return ism;
+}
+
+/*!
+ * Stamp all inputs of a device with @p generation, like the server thread
+ * does with its private copy before publishing.
+ */
+static void
+stamp_device(ipc_shared_input_buffer *buffer, uint32_t device_id, uint64_t generation)
+{
+	for (uint32_t i = 0; i < inputs_per_device; i++) {
+		xrt_input *input = &buffer->inputs[device_id * inputs_per_device + i];
+		input->active = true;
+		input->timestamp = (int64_t)generation;
+		input->value.vec1.x = (float)generation;
+	}
+
+	buffer->generation = generation;
+	buffer->device_generations[device_id] = generation;
+}
+
+/*!
+ * Are all inputs of the device from the generation the buffer claims.
+ */
+static bool
+device_is_consistent(const ipc_shared_input_buffer *buffer, uint32_t device_id)
+{
+	uint64_t generation = buffer->device_generations[device_id];
+
+	for (uint32_t i = 0; i < inputs_per_device; i++) {
+		const xrt_input *input = &buffer->inputs[device_id * inputs_per_device + i];
+		if ((uint64_t)input->timestamp != generation || input->value.vec1.x != (float)generation) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+TEST_CASE("ipc_input_slot")
+{
+	auto ism = make_ism();
+	std::unique_ptr<ipc_shared_input_buffer> src{new ipc_shared_input_buffer{}};
+	std::unique_ptr<ipc_shared_input_buffer> client{new ipc_shared_input_buffer{}};
+
+	ipc_input_slot_reset(ism.get(), 0, src.get());
+
+	SECTION("Nothing changed")
+	{
+		CHECK_FALSE(ipc_input_slot_read(ism.get(), 0, client.get()));
+	}
+
+	SECTION("Only changed devices are copied")
+	{
+		bool changed[IPC_SHARED_MAX_DEVICES] = {};
+		changed[1] = true;
+		stamp_device(src.get(), 0, 1);
+		stamp_device(src.get(), 1, 1);
+
+		// Device 0 is stamped in the source but not marked as changed.
+		ipc_input_slot_publish(ism.get(), 0, src.get(), changed);
+
+		// Something the client did to its copy, must survive the read.
+		client->inputs[0].timestamp = 42;
+
+		CHECK(ipc_input_slot_read(ism.get(), 0, client.get()));
+		CHECK(client->generation == 1);
+		CHECK(client->device_generations[0] == 0);
+		CHECK(client->device_generations[1] == 1);
+		CHECK(client->inputs[0].timestamp == 42);
+		CHECK(device_is_consistent(client.get(), 1));
+
+		// Both buffers were written, the next read doesn't see a change.
+		CHECK_FALSE(ipc_input_slot_read(ism.get(), 0, client.get()));
+		CHECK(client->inputs[0].timestamp == 42);
+
+		// Now device 0 changes.
+		changed[0] = true;
+		changed[1] = false;
+		stamp_device(src.get(), 0, 2);
+		ipc_input_slot_publish(ism.get(), 0, src.get(), changed);
+
+		CHECK(ipc_input_slot_read(ism.get(), 0, client.get()));
+		CHECK(client->device_generations[0] == 2);
+		CHECK(client->device_generations[1] == 1);
+		CHECK(device_is_consistent(client.get(), 0));
+		CHECK(device_is_consistent(client.get(), 1));
+	}
+
+	SECTION("Reads while the server publishes")
+	{
+		/*
+		 * The server changes one or both devices at a time as fast as it
+		 * can, so reads get torn and retried. Whatever the reader ends
+		 * up with must be whole devices with the generations it claims,
+		 * a retry that skipped a device copied by the torn read would
+		 * leave mixed inputs behind.
+		 */
+		const uint64_t num_publishes = 100000;
+		std::atomic<bool> done{false};
+
+		std::thread server([&] {
+			for (uint64_t g = 1; g <= num_publishes; g++) {
+				bool changed[IPC_SHARED_MAX_DEVICES] = {};
+				for (uint32_t d = 0; d < num_devices; d++) {
+					if (g % 3 == 0 || g % num_devices == d) {
+						stamp_device(src.get(), d, g);
+						changed[d] = true;
+					}
+				}
+
+				ipc_input_slot_publish(ism.get(), 0, src.get(), changed);
+
+				// Let the reader run on single CPU machines.
+				if (g % 64 == 0) {
+					std::this_thread::yield();
+				}
+			}
+			done = true;
+		});
+
+		uint64_t last_generation = 0;
+		uint32_t bad = 0;
+		uint32_t backwards = 0;
+		uint32_t reads = 0;
+		bool stop = false;
+
+		while (!stop) {
+			// One last read after the server is done.
+			stop = done;
+
+			ipc_input_slot_read(ism.get(), 0, client.get());
+			reads++;
+
+			for (uint32_t d = 0; d < num_devices; d++) {
+				if (!device_is_consistent(client.get(), d)) {
+					bad++;
+				}
+			}
+
+			if (client->generation < last_generation) {
+				backwards++;
+			}
+			last_generation = client->generation;
+		}
+
+		server.join();
+
+		CHECK(bad == 0);
+		CHECK(backwards == 0);
+		CHECK(reads > 1);
+		CHECK(client->generation == num_publishes);
+	}
+}
@@ -0,0 +1,149 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief IPC request receiving tests, over the same kind of socket the
+ *        service uses.
+ * @author Collabora, Ltd.
+ */
+
+#include "catch/catch.hpp"
+
+#include <shared/ipc_protocol.h>
+#include <shared/ipc_utils.h>
+#include <ipc_protocol_generated.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <vector>
+
+
+struct socket_pair
+{
+	ipc_message_channel client = {-1, U_LOGGING_WARN};
+	ipc_message_channel server = {-1, U_LOGGING_WARN};
+
+	socket_pair()
+	{
+		int fds[2];
+		REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+		client.socket_fd = fds[0];
+		server.socket_fd = fds[1];
+	}
+
+	~socket_pair()
+	{
+		ipc_message_channel_close(&client);
+		ipc_message_channel_close(&server);
+	}
+};
+
+static ipc_compositor_begin_frame_msg
+make_async_msg()
+{
+	ipc_compositor_begin_frame_msg msg = {};
+	msg.cmd = IPC_COMPOSITOR_BEGIN_FRAME;
+	msg.frame_id = 1234;
+	return msg;
+}
+
+static ipc_system_set_primary_client_msg
+make_sync_msg()
+{
+	ipc_system_set_primary_client_msg msg = {};
+	msg.cmd = IPC_SYSTEM_SET_PRIMARY_CLIENT;
+	msg.id = 7;
+	return msg;
+}
+
+/*!
+ * Receive the two requests on the server side, reply to the second one like
+ * the service does and check that the client gets the reply.
+ */
+static void
+check_async_then_sync(socket_pair &sp)
+{
+	uint8_t buf[IPC_BUF_SIZE];
+	size_t size = 0;
+
+	// The asynchronous call first, without the start of the next request.
+	REQUIRE(ipc_receive_request(&sp.server, buf, sizeof(buf), &size) == XRT_SUCCESS);
+	REQUIRE(size == sizeof(ipc_compositor_begin_frame_msg));
+
+	ipc_compositor_begin_frame_msg async_msg = {};
+	memcpy(&async_msg, buf, sizeof(async_msg));
+	CHECK(async_msg.cmd == IPC_COMPOSITOR_BEGIN_FRAME);
+	CHECK(async_msg.frame_id == 1234);
+
+	// The synchronous call is still there.
+	REQUIRE(ipc_receive_request(&sp.server, buf, sizeof(buf), &size) == XRT_SUCCESS);
+	REQUIRE(size == sizeof(ipc_system_set_primary_client_msg));
+
+	ipc_system_set_primary_client_msg sync_msg = {};
+	memcpy(&sync_msg, buf, sizeof(sync_msg));
+	CHECK(sync_msg.cmd == IPC_SYSTEM_SET_PRIMARY_CLIENT);
+	CHECK(sync_msg.id == 7);
+
+	// Which means the client gets its reply.
+	ipc_result_reply reply = {XRT_SUCCESS};
+	REQUIRE(ipc_send(&sp.server, &reply, sizeof(reply)) == XRT_SUCCESS);
+
+	ipc_result_reply client_reply = {XRT_ERROR_IPC_FAILURE};
+	REQUIRE(ipc_receive(&sp.client, &client_reply, sizeof(client_reply)) == XRT_SUCCESS);
+	CHECK(client_reply.result == XRT_SUCCESS);
+}
+
+
+TEST_CASE("ipc_receive_request")
+{
+	socket_pair sp;
+
+	SECTION("Asynchronous call followed by a synchronous call")
+	{
+		ipc_compositor_begin_frame_msg async_msg = make_async_msg();
+		ipc_system_set_primary_client_msg sync_msg = make_sync_msg();
+
+		// Back to back, like the client does without waiting for a reply.
+		REQUIRE(ipc_send(&sp.client, &async_msg, sizeof(async_msg)) == XRT_SUCCESS);
+		REQUIRE(ipc_send(&sp.client, &sync_msg, sizeof(sync_msg)) == XRT_SUCCESS);
+
+		check_async_then_sync(sp);
+	}
+
+	SECTION("Both requests in one write")
+	{
+		ipc_compositor_begin_frame_msg async_msg = make_async_msg();
+		ipc_system_set_primary_client_msg sync_msg = make_sync_msg();
+
+		std::vector<uint8_t> both(sizeof(async_msg) + sizeof(sync_msg));
+		memcpy(both.data(), &async_msg, sizeof(async_msg));
+		memcpy(both.data() + sizeof(async_msg), &sync_msg, sizeof(sync_msg));
+		REQUIRE(ipc_send(&sp.client, both.data(), both.size()) == XRT_SUCCESS);
+
+		check_async_then_sync(sp);
+	}
+
+	SECTION("Unknown command")
+	{
+		ipc_command_msg msg = {};
+		msg.cmd = (ipc_command)0x7fffffff;
+		REQUIRE(ipc_send(&sp.client, &msg, sizeof(msg)) == XRT_SUCCESS);
+
+		uint8_t buf[IPC_BUF_SIZE];
+		size_t size = 0;
+		CHECK(ipc_receive_request(&sp.server, buf, sizeof(buf), &size) != XRT_SUCCESS);
+	}
+
+	SECTION("Client goes away halfway through a request")
+	{
+		ipc_compositor_begin_frame_msg async_msg = make_async_msg();
+		REQUIRE(ipc_send(&sp.client, &async_msg, sizeof(async_msg) - 1) == XRT_SUCCESS);
+		ipc_message_channel_close(&sp.client);
+
+		uint8_t buf[IPC_BUF_SIZE];
+		size_t size = 0;
+		CHECK(ipc_receive_request(&sp.server, buf, sizeof(buf), &size) != XRT_SUCCESS);
+	}
+}
@@ -0,0 +1,136 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Lock-free pose publisher tests.
+ * @author Collabora, Ltd.
+ */
+
+#include "catch/catch.hpp"
+
+#include <util/u_pose_publisher.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+static xrt_space_relation
+make_relation(uint32_t n)
+{
+	// Every field is derived from n, so a torn copy can be detected.
+	float f = (float)n;
+
+	xrt_space_relation rel = {};
+	rel.relation_flags = (xrt_space_relation_flags)(XRT_SPACE_RELATION_ORIENTATION_VALID_BIT |
+	                                                XRT_SPACE_RELATION_POSITION_VALID_BIT);
+	rel.pose.orientation = {0.0f, 0.0f, 0.0f, 1.0f};
+	rel.pose.position = {f, f + 1.0f, f + 2.0f};
+	rel.linear_velocity = {f + 3.0f, f + 4.0f, f + 5.0f};
+	rel.angular_velocity = {f + 6.0f, f + 7.0f, f + 8.0f};
+	return rel;
+}
+
+static bool
+is_consistent(const u_pose_publisher_state &state)
+{
+	const xrt_space_relation &rel = state.relation;
+	float f = rel.pose.position.x;
+
+	return state.timestamp_ns == (timepoint_ns)f * 1000 &&   //
+	       rel.pose.position.y == f + 1.0f &&                 //
+	       rel.pose.position.z == f + 2.0f &&                 //
+	       rel.linear_velocity.x == f + 3.0f &&               //
+	       rel.linear_velocity.y == f + 4.0f &&               //
+	       rel.linear_velocity.z == f + 5.0f &&               //
+	       rel.angular_velocity.x == f + 6.0f &&              //
+	       rel.angular_velocity.y == f + 7.0f &&              //
+	       rel.angular_velocity.z == f + 8.0f &&              //
+	       rel.pose.orientation.w == 1.0f;
+}
+
+TEST_CASE("u_pose_publisher")
+{
+	u_pose_publisher upp;
+	u_pose_publisher_init(&upp);
+
+	SECTION("Nothing published")
+	{
+		u_pose_publisher_state state;
+		CHECK_FALSE(u_pose_publisher_read(&upp, &state));
+		CHECK(state.timestamp_ns == 0);
+
+		xrt_space_relation rel;
+		u_pose_publisher_get(&upp, 1000, &rel);
+		CHECK(rel.relation_flags == XRT_SPACE_RELATION_BITMASK_NONE);
+	}
+
+	SECTION("Latest is read")
+	{
+		for (uint32_t n = 1; n < 5; n++) {
+			xrt_space_relation rel = make_relation(n);
+			u_pose_publisher_publish(&upp, (timepoint_ns)n * 1000, &rel);
+		}
+
+		u_pose_publisher_state state;
+		REQUIRE(u_pose_publisher_read(&upp, &state));
+		CHECK(state.timestamp_ns == 4000);
+		CHECK(state.relation.pose.position.x == 4.0f);
+		CHECK(is_consistent(state));
+	}
+
+	SECTION("Get predicts from the published timestamp")
+	{
+		xrt_space_relation rel = make_relation(0);
+		rel.relation_flags = (xrt_space_relation_flags)(rel.relation_flags |
+		                                                XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT);
+		u_pose_publisher_publish(&upp, 1000 * 1000 * 1000, &rel);
+
+		xrt_space_relation out;
+		u_pose_publisher_get(&upp, 1500 * 1000 * 1000, &out);
+		CHECK(out.pose.position.x == Approx(0.0f + 3.0f * 0.5f));
+		CHECK(out.pose.position.y == Approx(1.0f + 4.0f * 0.5f));
+		CHECK(out.pose.position.z == Approx(2.0f + 5.0f * 0.5f));
+	}
+
+	SECTION("Readers never see torn state")
+	{
+		const uint32_t count = 200000;
+		std::atomic<bool> done{false};
+		std::atomic<uint32_t> torn{0};
+		std::atomic<uint32_t> backwards{0};
+
+		std::vector<std::thread> readers;
+		for (int i = 0; i < 3; i++) {
+			readers.emplace_back([&]() {
+				float last = 0.0f;
+				while (!done.load()) {
+					u_pose_publisher_state state;
+					if (!u_pose_publisher_read(&upp, &state)) {
+						continue;
+					}
+					if (!is_consistent(state)) {
+						torn++;
+					}
+					if (state.relation.pose.position.x < last) {
+						backwards++;
+					}
+					last = state.relation.pose.position.x;
+				}
+			});
+		}
+
+		for (uint32_t n = 1; n <= count; n++) {
+			xrt_space_relation rel = make_relation(n);
+			u_pose_publisher_publish(&upp, (timepoint_ns)n * 1000, &rel);
+		}
+
+		done = true;
+		for (auto &t : readers) {
+			t.join();
+		}
+
+		CHECK(torn == 0);
+		CHECK(backwards == 0);
+	}
+}
@@ -0,0 +1,176 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief IPC pose ring interpolation and prediction tests.
+ * @author Collabora, Ltd.
+ */
+
+#include "catch/catch.hpp"
+
+#include <shared/ipc_pose_ring.h>
+
+#include <cmath>
+#include <memory>
+
+
+using Catch::Matchers::WithinAbs;
+
+static constexpr timepoint_ns ms = 1000000;
+
+static constexpr enum xrt_space_relation_flags all_flags = (enum xrt_space_relation_flags)(
+    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_POSITION_VALID_BIT |
+    XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT | XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT);
+
+static std::unique_ptr<ipc_shared_pose_ring>
+make_ring()
+{
+	std::unique_ptr<ipc_shared_pose_ring> ring{new ipc_shared_pose_ring{}};
+	ring->name = XRT_INPUT_GENERIC_HEAD_POSE;
+	return ring;
+}
+
+static xrt_space_relation
+make_relation(xrt_quat orientation, xrt_vec3 position)
+{
+	xrt_space_relation rel = {};
+	rel.relation_flags = all_flags;
+	rel.pose.orientation = orientation;
+	rel.pose.position = position;
+	return rel;
+}
+
+static void
+check_vec3(const xrt_vec3 &a, const xrt_vec3 &b)
+{
+	CHECK_THAT(a.x, WithinAbs(b.x, 1e-5));
+	CHECK_THAT(a.y, WithinAbs(b.y, 1e-5));
+	CHECK_THAT(a.z, WithinAbs(b.z, 1e-5));
+}
+
+/*!
+ * Both signs are the same rotation, compare up to the sign.
+ */
+static void
+check_quat(const xrt_quat &a, const xrt_quat &b)
+{
+	float dot = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+	CHECK_THAT(std::abs(dot), WithinAbs(1.0, 1e-5));
+}
+
+
+TEST_CASE("ipc_pose_ring_get")
+{
+	auto ring = make_ring();
+	const float s = std::sqrt(0.5f);
+	const xrt_quat identity = {0.f, 0.f, 0.f, 1.f};
+	const xrt_quat quarter_z = {0.f, 0.f, s, s};
+
+	SECTION("Nothing published")
+	{
+		xrt_space_relation rel = {};
+		CHECK_FALSE(ipc_pose_ring_get(ring.get(), 10 * ms, &rel));
+		CHECK(rel.relation_flags == 0);
+	}
+
+	SECTION("At and between samples")
+	{
+		// Published out of order around the ring, like after wrapping.
+		for (uint32_t i = 0; i < IPC_POSE_RING_SIZE; i++) {
+			uint32_t index = i + 2;
+			float x = (float)index;
+			xrt_space_relation rel = make_relation(identity, {x, 0.f, 0.f});
+			ipc_pose_ring_publish(ring.get(), index, (timepoint_ns)index * 2 * ms, &rel);
+		}
+
+		xrt_space_relation rel = {};
+
+		// Exactly on every sample, including the first and last.
+		for (uint32_t index = 2; index < IPC_POSE_RING_SIZE + 2; index++) {
+			REQUIRE(ipc_pose_ring_get(ring.get(), (timepoint_ns)index * 2 * ms, &rel));
+			check_vec3(rel.pose.position, {(float)index, 0.f, 0.f});
+			CHECK(rel.relation_flags == all_flags);
+		}
+
+		// A quarter of the way between the second and third sample.
+		REQUIRE(ipc_pose_ring_get(ring.get(), 6 * ms + ms / 2, &rel));
+		check_vec3(rel.pose.position, {3.25f, 0.f, 0.f});
+		check_quat(rel.pose.orientation, identity);
+	}
+
+	SECTION("Interpolation only claims what both samples have")
+	{
+		xrt_space_relation a = make_relation(identity, {0.f, 0.f, 0.f});
+		xrt_space_relation b = make_relation(identity, {1.f, 0.f, 0.f});
+		b.relation_flags = XRT_SPACE_RELATION_ORIENTATION_VALID_BIT;
+		ipc_pose_ring_publish(ring.get(), 0, 10 * ms, &a);
+		ipc_pose_ring_publish(ring.get(), 1, 20 * ms, &b);
+
+		xrt_space_relation rel = {};
+		REQUIRE(ipc_pose_ring_get(ring.get(), 15 * ms, &rel));
+		CHECK(rel.relation_flags == XRT_SPACE_RELATION_ORIENTATION_VALID_BIT);
+	}
+
+	SECTION("Interpolation takes the shortest path")
+	{
+		// The same rotation with the opposite sign, halfway must not be
+		// a quarter turn from either.
+		xrt_quat negated = {-quarter_z.x, -quarter_z.y, -quarter_z.z, -quarter_z.w};
+		xrt_space_relation a = make_relation(identity, {});
+		xrt_space_relation b = make_relation(negated, {});
+		ipc_pose_ring_publish(ring.get(), 0, 10 * ms, &a);
+		ipc_pose_ring_publish(ring.get(), 1, 20 * ms, &b);
+
+		xrt_space_relation rel = {};
+		REQUIRE(ipc_pose_ring_get(ring.get(), 15 * ms, &rel));
+
+		// An eighth turn around Z.
+		const float c = std::cos((float)M_PI / 8.f);
+		const float z = std::sin((float)M_PI / 8.f);
+		check_quat(rel.pose.orientation, {0.f, 0.f, z, c});
+
+		// Still a unit quaternion.
+		const xrt_quat &q = rel.pose.orientation;
+		CHECK_THAT(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w, WithinAbs(1.0, 1e-5));
+	}
+
+	SECTION("Predicts outside of the samples")
+	{
+		xrt_space_relation a = make_relation(identity, {0.f, 0.f, 0.f});
+		a.linear_velocity = {1.f, 0.f, 0.f};
+		a.angular_velocity = {0.f, 0.f, (float)M_PI};
+
+		xrt_space_relation b = a;
+		b.pose.position = {0.01f, 0.f, 0.f};
+
+		ipc_pose_ring_publish(ring.get(), 0, 10 * ms, &a);
+		ipc_pose_ring_publish(ring.get(), 1, 20 * ms, &b);
+
+		xrt_space_relation rel = {};
+
+		// Half a second after the last sample, a quarter turn around Z.
+		REQUIRE(ipc_pose_ring_get(ring.get(), 520 * ms, &rel));
+		check_vec3(rel.pose.position, {0.51f, 0.f, 0.f});
+		check_quat(rel.pose.orientation, quarter_z);
+		check_vec3(rel.linear_velocity, a.linear_velocity);
+
+		// Before the first sample goes backwards from it.
+		REQUIRE(ipc_pose_ring_get(ring.get(), 0, &rel));
+		check_vec3(rel.pose.position, {-0.01f, 0.f, 0.f});
+	}
+
+	SECTION("Single sample")
+	{
+		xrt_space_relation a = make_relation(quarter_z, {1.f, 2.f, 3.f});
+		ipc_pose_ring_publish(ring.get(), 0, 10 * ms, &a);
+
+		xrt_space_relation rel = {};
+		REQUIRE(ipc_pose_ring_get(ring.get(), 10 * ms, &rel));
+		check_vec3(rel.pose.position, a.pose.position);
+		check_quat(rel.pose.orientation, quarter_z);
+
+		// No velocities, so the pose stays put.
+		REQUIRE(ipc_pose_ring_get(ring.get(), 30 * ms, &rel));
+		check_vec3(rel.pose.position, a.pose.position);
+	}
+}
@@ -0,0 +1,107 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Batched relation prediction tests.
+ * @author Collabora, Ltd.
+ */
+
+#include "catch/catch.hpp"
+
+#include <math/m_api.h>
+#include <math/m_predict.h>
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+
+static const xrt_space_relation_flags all_flags = (xrt_space_relation_flags)(
+    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_POSITION_VALID_BIT |
+    XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT | XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT);
+
+static xrt_space_relation
+make_relation(int n)
+{
+	float t = (float)n;
+
+	xrt_space_relation rel = {};
+	rel.relation_flags = (xrt_space_relation_flags)(all_flags & ~(n % 5 == 4 ? (1u << (n % 4)) : 0u));
+	rel.pose.orientation = {std::sin(t), std::cos(t * 0.7f), 0.3f, 0.5f * std::sin(t * 1.3f)};
+	math_quat_normalize(&rel.pose.orientation);
+	rel.pose.position = {t * 0.1f, 1.6f, -0.2f * t};
+	rel.linear_velocity = {0.5f * std::cos(t), 0.1f, -0.3f};
+	// Include a few that barely rotate, to hit the taylor series path.
+	float scale = n % 7 == 0 ? 1e-7f : 4.0f;
+	rel.angular_velocity = {scale * std::sin(t * 0.5f), scale * 0.3f, scale * std::cos(t * 2.1f)};
+	return rel;
+}
+
+static void
+check_same_quat(const xrt_quat &a, const xrt_quat &b)
+{
+	// Same rotation, the sign of the quaternion is free.
+	float dot = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+	CHECK(std::fabs(dot) == Approx(1.0f).margin(1e-5f));
+}
+
+static void
+check_same_vec3(const xrt_vec3 &a, const xrt_vec3 &b)
+{
+	CHECK(a.x == Approx(b.x).margin(1e-5f));
+	CHECK(a.y == Approx(b.y).margin(1e-5f));
+	CHECK(a.z == Approx(b.z).margin(1e-5f));
+}
+
+static void
+check_same_relation(const xrt_space_relation &a, const xrt_space_relation &b)
+{
+	CHECK(a.relation_flags == b.relation_flags);
+	check_same_quat(a.pose.orientation, b.pose.orientation);
+	check_same_vec3(a.pose.position, b.pose.position);
+	check_same_vec3(a.linear_velocity, b.linear_velocity);
+	check_same_vec3(a.angular_velocity, b.angular_velocity);
+}
+
+TEST_CASE("m_predict_relations")
+{
+	// Not a multiple of the chunk size, so the last chunk is partial.
+	std::vector<xrt_space_relation> rels(37);
+	for (size_t i = 0; i < rels.size(); i++) {
+		rels[i] = make_relation((int)i);
+	}
+
+	SECTION("Zero delta copies")
+	{
+		std::vector<xrt_space_relation> out(rels.size());
+		m_predict_relations(rels.data(), (uint32_t)rels.size(), 0.0, out.data());
+		CHECK(memcmp(rels.data(), out.data(), rels.size() * sizeof(xrt_space_relation)) == 0);
+	}
+
+	SECTION("Same result as one at a time")
+	{
+		for (double delta_s : {0.005, 0.02, -0.01}) {
+			for (uint32_t count : {1u, 16u, 37u}) {
+				// Fields that are not valid are left as they were.
+				std::vector<xrt_space_relation> out(rels.begin(), rels.begin() + count);
+				std::vector<xrt_space_relation> ref = out;
+				m_predict_relations(rels.data(), count, delta_s, out.data());
+
+				for (uint32_t i = 0; i < count; i++) {
+					m_predict_relation(&rels[i], delta_s, &ref[i]);
+					check_same_relation(out[i], ref[i]);
+				}
+			}
+		}
+	}
+
+	SECTION("In place")
+	{
+		// Start from a copy, fields that are not valid are left as they were.
+		std::vector<xrt_space_relation> out = rels;
+		m_predict_relations(rels.data(), (uint32_t)rels.size(), 0.011, out.data());
+
+		m_predict_relations(rels.data(), (uint32_t)rels.size(), 0.011, rels.data());
+		CHECK(memcmp(rels.data(), out.data(), rels.size() * sizeof(xrt_space_relation)) == 0);
+	}
+}
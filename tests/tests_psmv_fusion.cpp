@@ -0,0 +1,95 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief PS Move fusion ball position tests.
+ * @author Collabora, Ltd.
+ */
+
+#include "catch/catch.hpp"
+
+#include <tracking/t_tracker_psmv_fusion.hpp>
+
+#include <cmath>
+
+
+using Catch::Matchers::WithinAbs;
+
+static void
+check_ball(const xrt_pose &pose, const xrt_vec3 &expected)
+{
+	xrt_vec3 ball = {};
+	xrt_fusion::psmv_fusion_ball_position(&pose, &ball);
+
+	CHECK_THAT(ball.x, WithinAbs(expected.x, 1e-5));
+	CHECK_THAT(ball.y, WithinAbs(expected.y, 1e-5));
+	CHECK_THAT(ball.z, WithinAbs(expected.z, 1e-5));
+}
+
+TEST_CASE("psmv_fusion_ball_position")
+{
+	const float s = std::sqrt(0.5f);
+
+	SECTION("Identity orientation")
+	{
+		xrt_pose pose = {{0.f, 0.f, 0.f, 1.f}, {0.1f, 0.2f, -1.f}};
+		check_ball(pose, {0.1f, 0.29f, -1.f});
+	}
+
+	SECTION("Rolled a quarter turn")
+	{
+		// A quarter turn around Z moves the ball from above to the left.
+		xrt_pose pose = {{0.f, 0.f, s, s}, {0.1f, 0.2f, -1.f}};
+		check_ball(pose, {0.01f, 0.2f, -1.f});
+	}
+
+	SECTION("Pitched towards the camera")
+	{
+		// A quarter turn around X moves the ball from above to the front.
+		xrt_pose pose = {{s, 0.f, 0.f, s}, {0.f, 0.f, -1.f}};
+		check_ball(pose, {0.f, 0.f, -0.91f});
+	}
+
+	SECTION("Upside down")
+	{
+		xrt_pose pose = {{1.f, 0.f, 0.f, 0.f}, {0.f, 0.f, -1.f}};
+		check_ball(pose, {0.f, -0.09f, -1.f});
+	}
+}
+
+TEST_CASE("psmv_fusion_ball_position_matches_filter")
+{
+	auto filter = xrt_fusion::PSMVFusionInterface::create();
+
+	// Gravity along X, the controller is lying on its side.
+	xrt_tracking_sample sample = {};
+	sample.accel_m_s2 = {9.81f, 0.f, 0.f};
+
+	// The measured ball, the filter puts the body origin on the lever arm.
+	xrt_vec3 measured = {0.1f, 0.2f, -1.f};
+
+	timepoint_ns ts = 1000000;
+	for (int i = 0; i < 200; i++) {
+		filter->process_imu_data(ts, &sample, NULL);
+		filter->process_3d_vision_data(ts, &measured, NULL, NULL, 15);
+		ts += 10000000;
+	}
+
+	xrt_space_relation rel = {};
+	filter->get_prediction(ts, &rel);
+	REQUIRE((rel.relation_flags & XRT_SPACE_RELATION_POSITION_TRACKED_BIT) != 0);
+	REQUIRE(std::abs(rel.pose.orientation.w) < 0.9f);
+
+	xrt_vec3 ball = {};
+	xrt_fusion::psmv_fusion_ball_position(&rel.pose, &ball);
+
+	CHECK_THAT(ball.x, WithinAbs(measured.x, 1e-2));
+	CHECK_THAT(ball.y, WithinAbs(measured.y, 1e-2));
+	CHECK_THAT(ball.z, WithinAbs(measured.z, 1e-2));
+
+	// The body origin is not where the ball is.
+	float dx = rel.pose.position.x - measured.x;
+	float dy = rel.pose.position.y - measured.y;
+	float dz = rel.pose.position.z - measured.z;
+	CHECK(std::sqrt(dx * dx + dy * dy + dz * dz) > 0.05f);
+}
@@ -0,0 +1,186 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Fan-out sink tests.
+ * @author Collabora, Ltd.
+ */
+
+#include "catch/catch.hpp"
+
+#include <util/u_sink.h>
+#include <util/u_frame.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+using namespace std::chrono_literals;
+
+/*!
+ * Records the sequence numbers of the frames pushed to it, and can be made to
+ * block inside of push_frame to act like a slow sink.
+ */
+struct recording_state
+{
+	std::mutex mutex;
+	std::condition_variable cond;
+
+	std::vector<uint64_t> sequences;
+
+	//! Number of times push_frame has been entered.
+	uint32_t entered = 0;
+
+	bool blocked = false;
+
+	template <typename Pred>
+	bool
+	wait_for(Pred pred)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return cond.wait_for(lock, 5s, pred);
+	}
+
+	void
+	unblock()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		blocked = false;
+		cond.notify_all();
+	}
+};
+
+struct recording_sink
+{
+	xrt_frame_sink base;
+	recording_state *state;
+};
+
+static void
+recording_push_frame(xrt_frame_sink *xfs, xrt_frame *xf)
+{
+	recording_state *state = ((recording_sink *)xfs)->state;
+	std::unique_lock<std::mutex> lock(state->mutex);
+
+	state->entered++;
+	state->cond.notify_all();
+
+	state->cond.wait(lock, [&] { return !state->blocked; });
+
+	state->sequences.push_back(xf->source_sequence);
+	state->cond.notify_all();
+}
+
+static void
+push_sequence(xrt_frame_sink *xfs, uint64_t sequence)
+{
+	xrt_frame *xf = NULL;
+	u_frame_create_one_off(XRT_FORMAT_R8G8B8, 4, 4, &xf);
+	xf->source_sequence = sequence;
+
+	xfs->push_frame(xfs, xf);
+
+	xrt_frame_reference(&xf, NULL);
+}
+
+/*!
+ * The slow branch is stuck on frame 0 while frames 1 to 9 are pushed, the
+ * fast branch must get all of them in the meantime.
+ */
+static std::vector<uint64_t>
+run_slow_branch(enum u_sink_queue_policy slow_policy)
+{
+	recording_state fast_state;
+	recording_state slow_state;
+	recording_sink fast = {{recording_push_frame}, &fast_state};
+	recording_sink slow = {{recording_push_frame}, &slow_state};
+	slow_state.blocked = true;
+
+	u_sink_fanout_branch_params branches[2] = {
+	    {&fast.base, U_SINK_QUEUE_POLICY_BLOCK_PRODUCER},
+	    {&slow.base, slow_policy},
+	};
+
+	xrt_frame_context xfctx = {};
+	xrt_frame_sink *xfs = NULL;
+	REQUIRE(u_sink_fanout_create(&xfctx, branches, 2, 2, &xfs));
+
+	// Make sure the slow branch is busy with the first frame.
+	push_sequence(xfs, 0);
+	REQUIRE(slow_state.wait_for([&] { return slow_state.entered == 1; }));
+
+	for (uint64_t i = 1; i < 10; i++) {
+		push_sequence(xfs, i);
+	}
+
+	CHECK(fast_state.wait_for([&] { return fast_state.sequences.size() == 10; }));
+	CHECK(slow_state.sequences.empty());
+
+	slow_state.unblock();
+	CHECK(slow_state.wait_for([&] { return slow_state.sequences.size() == 2; }));
+
+	xrt_frame_context_destroy_nodes(&xfctx);
+
+	for (uint64_t i = 0; i < fast_state.sequences.size(); i++) {
+		CHECK(fast_state.sequences[i] == i);
+	}
+
+	return slow_state.sequences;
+}
+
+
+TEST_CASE("u_sink_fanout")
+{
+	SECTION("Drop oldest keeps the newest frame for a slow branch")
+	{
+		std::vector<uint64_t> slow = run_slow_branch(U_SINK_QUEUE_POLICY_DROP_OLDEST);
+		CHECK(slow == std::vector<uint64_t>{0, 9});
+	}
+
+	SECTION("Drop newest keeps the first waiting frame for a slow branch")
+	{
+		std::vector<uint64_t> slow = run_slow_branch(U_SINK_QUEUE_POLICY_DROP_NEWEST);
+		CHECK(slow == std::vector<uint64_t>{0, 1});
+	}
+
+	SECTION("Block producer waits for the branch")
+	{
+		recording_state state;
+		recording_sink sink = {{recording_push_frame}, &state};
+		state.blocked = true;
+
+		u_sink_fanout_branch_params branch = {&sink.base, U_SINK_QUEUE_POLICY_BLOCK_PRODUCER};
+
+		xrt_frame_context xfctx = {};
+		xrt_frame_sink *xfs = NULL;
+		REQUIRE(u_sink_fanout_create(&xfctx, &branch, 1, 1, &xfs));
+
+		push_sequence(xfs, 0);
+		REQUIRE(state.wait_for([&] { return state.entered == 1; }));
+
+		// Takes the waiting slot.
+		push_sequence(xfs, 1);
+
+		// The slot is taken, this has to wait for the branch.
+		std::atomic<bool> pushed{false};
+		std::thread producer([&] {
+			push_sequence(xfs, 2);
+			pushed = true;
+		});
+
+		std::this_thread::sleep_for(50ms);
+		CHECK_FALSE(pushed);
+
+		state.unblock();
+		producer.join();
+
+		CHECK(state.wait_for([&] { return state.sequences.size() == 3; }));
+		CHECK(state.sequences == std::vector<uint64_t>{0, 1, 2});
+
+		xrt_frame_context_destroy_nodes(&xfctx);
+	}
+}
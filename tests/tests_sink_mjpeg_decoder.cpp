@@ -0,0 +1,248 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Threaded MJPEG decoder sink tests.
+ * @author Collabora, Ltd.
+ */
+
+#include "catch/catch.hpp"
+
+#include <util/u_sink.h>
+
+#include <cstdio>
+#include <jpeglib.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+using namespace std::chrono_literals;
+
+struct decoded
+{
+	uint64_t sequence;
+	uint32_t width;
+	uint32_t height;
+	xrt_format format;
+};
+
+/*!
+ * Records the frames pushed to it, and can be made to block inside of
+ * push_frame to act like a slow downstream sink.
+ */
+struct recording_state
+{
+	std::mutex mutex;
+	std::condition_variable cond;
+
+	std::vector<decoded> frames;
+
+	//! Number of times push_frame has been entered.
+	uint32_t entered = 0;
+
+	bool blocked = false;
+
+	template <typename Pred>
+	bool
+	wait_for(Pred pred)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return cond.wait_for(lock, 10s, pred);
+	}
+
+	void
+	unblock()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		blocked = false;
+		cond.notify_all();
+	}
+};
+
+struct recording_sink
+{
+	xrt_frame_sink base;
+	recording_state *state;
+};
+
+static void
+recording_push_frame(xrt_frame_sink *xfs, xrt_frame *xf)
+{
+	recording_state *state = ((recording_sink *)xfs)->state;
+	std::unique_lock<std::mutex> lock(state->mutex);
+
+	state->entered++;
+	state->cond.notify_all();
+
+	state->cond.wait(lock, [&] { return !state->blocked; });
+
+	state->frames.push_back({xf->source_sequence, xf->width, xf->height, xf->format});
+	state->cond.notify_all();
+}
+
+/*!
+ * A MJPEG frame that owns its compressed data.
+ */
+struct mjpeg_frame
+{
+	xrt_frame base;
+	std::vector<uint8_t> data;
+};
+
+static void
+mjpeg_frame_destroy(xrt_frame *xf)
+{
+	delete (mjpeg_frame *)xf;
+}
+
+static std::vector<uint8_t>
+encode_jpeg(uint32_t width, uint32_t height)
+{
+	std::vector<uint8_t> rgb(width * height * 3);
+	uint32_t state = 1;
+	for (uint8_t &v : rgb) {
+		// Noise makes the big frames slow to decode.
+		state = state * 1664525u + 1013904223u;
+		v = (uint8_t)(state >> 24);
+	}
+
+	jpeg_compress_struct cinfo = {};
+	jpeg_error_mgr jerr = {};
+	cinfo.err = jpeg_std_error(&jerr);
+	jpeg_create_compress(&cinfo);
+
+	unsigned char *out = NULL;
+	unsigned long out_size = 0;
+	jpeg_mem_dest(&cinfo, &out, &out_size);
+
+	cinfo.image_width = width;
+	cinfo.image_height = height;
+	cinfo.input_components = 3;
+	cinfo.in_color_space = JCS_RGB;
+	jpeg_set_defaults(&cinfo);
+	jpeg_set_quality(&cinfo, 95, TRUE);
+	jpeg_start_compress(&cinfo, TRUE);
+
+	while (cinfo.next_scanline < cinfo.image_height) {
+		JSAMPROW row = &rgb[cinfo.next_scanline * width * 3];
+		jpeg_write_scanlines(&cinfo, &row, 1);
+	}
+
+	jpeg_finish_compress(&cinfo);
+	jpeg_destroy_compress(&cinfo);
+
+	std::vector<uint8_t> ret(out, out + out_size);
+	free(out);
+
+	return ret;
+}
+
+static void
+push_mjpeg(xrt_frame_sink *xfs, const std::vector<uint8_t> &data, uint32_t width, uint32_t height, uint64_t sequence)
+{
+	mjpeg_frame *mf = new mjpeg_frame();
+	mf->data = data;
+	mf->base.destroy = mjpeg_frame_destroy;
+	mf->base.format = XRT_FORMAT_MJPEG;
+	mf->base.width = width;
+	mf->base.height = height;
+	mf->base.data = mf->data.data();
+	mf->base.size = mf->data.size();
+	mf->base.source_sequence = sequence;
+
+	xrt_frame *xf = NULL;
+	xrt_frame_reference(&xf, &mf->base);
+
+	xfs->push_frame(xfs, xf);
+
+	xrt_frame_reference(&xf, NULL);
+}
+
+
+TEST_CASE("u_sink_mjpeg_decoder")
+{
+	recording_state state;
+	recording_sink sink = {{recording_push_frame}, &state};
+
+	xrt_frame_context xfctx = {};
+	xrt_frame_sink *xfs = NULL;
+
+	SECTION("Frames finishing out of order are delivered in order")
+	{
+		// Four threads, so the pipeline holds eight frames.
+		REQUIRE(u_sink_mjpeg_decoder_create(&xfctx, XRT_FORMAT_R8G8B8, 4, &sink.base, &xfs));
+
+		std::vector<uint8_t> big = encode_jpeg(1280, 960);
+		std::vector<uint8_t> small = encode_jpeg(16, 16);
+
+		// The small frames are done long before the first big one.
+		push_mjpeg(xfs, big, 1280, 960, 0);
+		for (uint64_t i = 1; i < 8; i++) {
+			push_mjpeg(xfs, small, 16, 16, i);
+		}
+
+		REQUIRE(state.wait_for([&] { return state.frames.size() == 8; }));
+
+		for (uint64_t i = 0; i < 8; i++) {
+			CHECK(state.frames[i].sequence == i);
+			CHECK(state.frames[i].format == XRT_FORMAT_R8G8B8);
+			CHECK(state.frames[i].width == (i == 0 ? 1280u : 16u));
+		}
+	}
+
+	SECTION("Broken frames are skipped without stalling the order")
+	{
+		REQUIRE(u_sink_mjpeg_decoder_create(&xfctx, XRT_FORMAT_YUV888, 2, &sink.base, &xfs));
+
+		std::vector<uint8_t> good = encode_jpeg(32, 32);
+
+		// Has the start of image marker, but nothing else that is valid.
+		std::vector<uint8_t> broken(good.size(), 0x55);
+		broken[0] = 0xFF;
+		broken[1] = 0xD8;
+
+		push_mjpeg(xfs, good, 32, 32, 0);
+		push_mjpeg(xfs, broken, 32, 32, 1);
+		push_mjpeg(xfs, good, 32, 32, 2);
+
+		REQUIRE(state.wait_for([&] { return state.frames.size() == 2; }));
+		CHECK(state.frames[0].sequence == 0);
+		CHECK(state.frames[1].sequence == 2);
+		CHECK(state.frames[1].format == XRT_FORMAT_YUV888);
+	}
+
+	SECTION("New frames are dropped when the pipeline is full")
+	{
+		// One thread, so the pipeline holds two frames.
+		REQUIRE(u_sink_mjpeg_decoder_create(&xfctx, XRT_FORMAT_R8G8B8, 1, &sink.base, &xfs));
+
+		std::vector<uint8_t> good = encode_jpeg(32, 32);
+		state.blocked = true;
+
+		// The only thread gets stuck delivering the first frame.
+		push_mjpeg(xfs, good, 32, 32, 0);
+		REQUIRE(state.wait_for([&] { return state.entered == 1; }));
+
+		push_mjpeg(xfs, good, 32, 32, 1);
+		push_mjpeg(xfs, good, 32, 32, 2);
+		push_mjpeg(xfs, good, 32, 32, 3);
+
+		state.unblock();
+
+		REQUIRE(state.wait_for([&] { return state.frames.size() == 3; }));
+		CHECK(state.frames[0].sequence == 0);
+		CHECK(state.frames[1].sequence == 1);
+		CHECK(state.frames[2].sequence == 2);
+
+		// Nothing else shows up.
+		std::this_thread::sleep_for(50ms);
+		std::unique_lock<std::mutex> lock(state.mutex);
+		CHECK(state.frames.size() == 3);
+	}
+
+	xrt_frame_context_destroy_nodes(&xfctx);
+}
@@ -0,0 +1,210 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Zero-copy stereo split sink and region of interest frame tests.
+ * @author Collabora, Ltd.
+ */
+
+#include "catch/catch.hpp"
+
+#include <util/u_sink.h>
+#include <util/u_frame.h>
+#include <util/u_format.h>
+
+#include <vector>
+
+
+/*!
+ * A frame that tells when it has been destroyed.
+ */
+struct tracked_frame
+{
+	xrt_frame base;
+	std::vector<uint8_t> data;
+	bool *destroyed;
+};
+
+static void
+tracked_frame_destroy(xrt_frame *xf)
+{
+	tracked_frame *tf = (tracked_frame *)xf;
+	*tf->destroyed = true;
+	delete tf;
+}
+
+static xrt_frame *
+create_tracked(xrt_format f, uint32_t width, uint32_t height, bool *destroyed)
+{
+	tracked_frame *tf = new tracked_frame();
+	tf->destroyed = destroyed;
+	tf->base.destroy = tracked_frame_destroy;
+	tf->base.format = f;
+	tf->base.width = width;
+	tf->base.height = height;
+	u_format_size_for_dimensions(f, width, height, &tf->base.stride, &tf->base.size);
+	tf->data.resize(tf->base.size);
+	tf->base.data = tf->data.data();
+
+	xrt_frame *xf = NULL;
+	xrt_frame_reference(&xf, &tf->base);
+	return xf;
+}
+
+/*!
+ * Holds on to the last frame pushed to it, like a queue would.
+ */
+struct holding_sink
+{
+	xrt_frame_sink base;
+	xrt_frame *frame;
+};
+
+static void
+holding_push_frame(xrt_frame_sink *xfs, xrt_frame *xf)
+{
+	holding_sink *hs = (holding_sink *)xfs;
+	xrt_frame_reference(&hs->frame, xf);
+}
+
+
+TEST_CASE("u_frame_create_roi")
+{
+	bool destroyed = false;
+
+	SECTION("Pixel format")
+	{
+		xrt_frame *original = create_tracked(XRT_FORMAT_R8G8B8, 8, 4, &destroyed);
+
+		xrt_frame *roi = NULL;
+		u_frame_create_roi(original, 2, 1, 4, 2, &roi);
+
+		CHECK(roi->width == 4);
+		CHECK(roi->height == 2);
+		CHECK(roi->stride == original->stride);
+		CHECK(roi->data == original->data + original->stride + 2 * 3);
+		CHECK(roi->size == original->stride + 4 * 3);
+
+		xrt_frame_reference(&original, NULL);
+		CHECK_FALSE(destroyed);
+
+		xrt_frame_reference(&roi, NULL);
+		CHECK(destroyed);
+	}
+
+	SECTION("Block format")
+	{
+		// Two pixels per four byte block.
+		xrt_frame *original = create_tracked(XRT_FORMAT_YUYV422, 8, 4, &destroyed);
+		REQUIRE(u_format_block_width(XRT_FORMAT_YUYV422) == 2);
+		REQUIRE(u_format_block_size(XRT_FORMAT_YUYV422) == 4);
+
+		xrt_frame *roi = NULL;
+		u_frame_create_roi(original, 2, 3, 6, 1, &roi);
+
+		CHECK(roi->width == 6);
+		CHECK(roi->height == 1);
+		CHECK(roi->stride == original->stride);
+		CHECK(roi->data == original->data + 3 * original->stride + 1 * 4);
+		CHECK(roi->size == 3 * 4);
+
+		// The last row ends where the original does.
+		CHECK(roi->data + roi->size == original->data + original->size);
+
+		xrt_frame_reference(&roi, NULL);
+		CHECK_FALSE(destroyed);
+
+		xrt_frame_reference(&original, NULL);
+		CHECK(destroyed);
+	}
+}
+
+TEST_CASE("u_sink_stereo_sbs_split")
+{
+	holding_sink left = {{holding_push_frame}, NULL};
+	holding_sink right = {{holding_push_frame}, NULL};
+	bool destroyed = false;
+
+	xrt_frame_context xfctx = {};
+	xrt_frame_sink *xfs = NULL;
+	u_sink_stereo_sbs_split_create(&xfctx, &left.base, &right.base, &xfs);
+
+	SECTION("Side by side")
+	{
+		xrt_frame *xf = create_tracked(XRT_FORMAT_L8, 16, 4, &destroyed);
+		xf->stereo_format = XRT_STEREO_FORMAT_SBS;
+		xf->source_sequence = 42;
+
+		xfs->push_frame(xfs, xf);
+
+		REQUIRE(left.frame != NULL);
+		REQUIRE(right.frame != NULL);
+		CHECK(left.frame->width == 8);
+		CHECK(left.frame->height == 4);
+		CHECK(left.frame->data == xf->data);
+		CHECK(right.frame->data == xf->data + 8);
+		CHECK(right.frame->stride == xf->stride);
+		CHECK(left.frame->stereo_format == XRT_STEREO_FORMAT_NONE);
+		CHECK(right.frame->source_sequence == 42);
+
+		// The views keep the original alive.
+		xrt_frame_reference(&xf, NULL);
+		CHECK_FALSE(destroyed);
+
+		xrt_frame_reference(&left.frame, NULL);
+		CHECK_FALSE(destroyed);
+
+		xrt_frame_reference(&right.frame, NULL);
+		CHECK(destroyed);
+	}
+
+	SECTION("Over and under")
+	{
+		xrt_frame *xf = create_tracked(XRT_FORMAT_R8G8B8, 4, 8, &destroyed);
+		xf->stereo_format = XRT_STEREO_FORMAT_OAU;
+
+		xfs->push_frame(xfs, xf);
+
+		REQUIRE(left.frame != NULL);
+		REQUIRE(right.frame != NULL);
+		CHECK(left.frame->width == 4);
+		CHECK(left.frame->height == 4);
+		CHECK(left.frame->data == xf->data);
+		CHECK(right.frame->data == xf->data + 4 * xf->stride);
+
+		xrt_frame_reference(&xf, NULL);
+		xrt_frame_reference(&left.frame, NULL);
+		xrt_frame_reference(&right.frame, NULL);
+		CHECK(destroyed);
+	}
+
+	SECTION("Not a stereo frame")
+	{
+		xrt_frame *xf = create_tracked(XRT_FORMAT_L8, 16, 4, &destroyed);
+		xf->stereo_format = XRT_STEREO_FORMAT_NONE;
+
+		xfs->push_frame(xfs, xf);
+
+		CHECK(left.frame == NULL);
+		CHECK(right.frame == NULL);
+
+		xrt_frame_reference(&xf, NULL);
+		CHECK(destroyed);
+	}
+
+	SECTION("Views not on block boundaries")
+	{
+		// Each view would be three pixels wide, not a whole block.
+		xrt_frame *xf = create_tracked(XRT_FORMAT_YUYV422, 6, 2, &destroyed);
+		xf->stereo_format = XRT_STEREO_FORMAT_SBS;
+
+		xfs->push_frame(xfs, xf);
+
+		CHECK(left.frame == NULL);
+		CHECK(right.frame == NULL);
+
+		xrt_frame_reference(&xf, NULL);
+	}
+
+	xrt_frame_context_destroy_nodes(&xfctx);
+}
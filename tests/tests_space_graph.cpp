@@ -0,0 +1,180 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Compiled space graph tests and microbenchmark.
+ * @author Collabora, Ltd.
+ */
+
+#include "catch/catch.hpp"
+
+#include <math/m_api.h>
+#include <math/m_space.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+
+static const xrt_space_relation_flags pose_flags =
+    (xrt_space_relation_flags)(XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_POSITION_VALID_BIT);
+
+static const xrt_space_relation_flags tracked_flags = (xrt_space_relation_flags)(
+    pose_flags | XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT | XRT_SPACE_RELATION_POSITION_TRACKED_BIT |
+    XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT | XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT);
+
+static xrt_pose
+make_pose(float t)
+{
+	xrt_pose pose = {};
+	pose.orientation = {std::sin(t), std::cos(t * 0.7f), 0.3f, 0.5f * std::sin(t * 1.3f)};
+	math_quat_normalize(&pose.orientation);
+	pose.position = {0.1f * t, 1.6f - 0.01f * t, std::cos(t)};
+	return pose;
+}
+
+static xrt_space_relation
+make_dynamic(int n)
+{
+	float t = (float)n;
+
+	xrt_space_relation rel = {};
+	rel.relation_flags = tracked_flags;
+	rel.pose = make_pose(t * 0.37f);
+	rel.linear_velocity = {0.5f * std::cos(t), 0.1f, -0.3f};
+	rel.angular_velocity = {std::sin(t * 0.5f), 0.3f, std::cos(t * 2.1f)};
+	return rel;
+}
+
+//! Static steps around a dynamic one at @p dynamic_step, like a space relative to a tracked device.
+static void
+make_graph(xrt_space_graph *xsg, uint32_t num_steps, uint32_t dynamic_step)
+{
+	*xsg = {};
+	for (uint32_t i = 0; i < num_steps; i++) {
+		if (i == dynamic_step) {
+			m_space_graph_reserve(xsg);
+			continue;
+		}
+
+		xrt_pose pose = make_pose(1.0f + (float)i);
+		m_space_graph_add_pose(xsg, &pose);
+	}
+}
+
+static void
+check_same_relation(const xrt_space_relation &a, const xrt_space_relation &b)
+{
+	CHECK(a.relation_flags == b.relation_flags);
+
+	float dot = a.pose.orientation.x * b.pose.orientation.x + a.pose.orientation.y * b.pose.orientation.y +
+	            a.pose.orientation.z * b.pose.orientation.z + a.pose.orientation.w * b.pose.orientation.w;
+	CHECK(std::fabs(dot) == Approx(1.0f).margin(1e-5f));
+
+	CHECK(a.pose.position.x == Approx(b.pose.position.x).margin(1e-4f));
+	CHECK(a.pose.position.y == Approx(b.pose.position.y).margin(1e-4f));
+	CHECK(a.pose.position.z == Approx(b.pose.position.z).margin(1e-4f));
+	CHECK(a.linear_velocity.x == Approx(b.linear_velocity.x).margin(1e-4f));
+	CHECK(a.linear_velocity.y == Approx(b.linear_velocity.y).margin(1e-4f));
+	CHECK(a.linear_velocity.z == Approx(b.linear_velocity.z).margin(1e-4f));
+	CHECK(a.angular_velocity.x == Approx(b.angular_velocity.x).margin(1e-4f));
+	CHECK(a.angular_velocity.y == Approx(b.angular_velocity.y).margin(1e-4f));
+	CHECK(a.angular_velocity.z == Approx(b.angular_velocity.z).margin(1e-4f));
+}
+
+TEST_CASE("m_space_graph_compiled")
+{
+	SECTION("Same result as resolving the full graph")
+	{
+		for (uint32_t num_steps = 1; num_steps <= 6; num_steps++) {
+			for (uint32_t dynamic_step = 0; dynamic_step < num_steps; dynamic_step++) {
+				xrt_space_graph xsg;
+				make_graph(&xsg, num_steps, dynamic_step);
+
+				m_space_graph_compiled compiled;
+				m_space_graph_compile(&xsg, dynamic_step, &compiled);
+				CHECK(compiled.valid);
+
+				for (int n = 0; n < 20; n++) {
+					xsg.steps[dynamic_step] = make_dynamic(n);
+
+					xrt_space_relation expected;
+					xrt_space_relation result;
+					m_space_graph_resolve(&xsg, &expected);
+					m_space_graph_compiled_resolve(&compiled, &xsg.steps[dynamic_step], &result);
+					check_same_relation(result, expected);
+				}
+			}
+		}
+	}
+
+	SECTION("Steps without a pose fail")
+	{
+		xrt_space_graph xsg;
+		make_graph(&xsg, 3, 1);
+		m_space_graph_compiled compiled;
+
+		xrt_space_relation dynamic = make_dynamic(1);
+		dynamic.relation_flags = XRT_SPACE_RELATION_BITMASK_NONE;
+		m_space_graph_compile(&xsg, 1, &compiled);
+
+		xrt_space_relation result;
+		m_space_graph_compiled_resolve(&compiled, &dynamic, &result);
+		CHECK(result.relation_flags == XRT_SPACE_RELATION_BITMASK_NONE);
+
+		xsg.steps[2].relation_flags = XRT_SPACE_RELATION_BITMASK_NONE;
+		m_space_graph_compile(&xsg, 1, &compiled);
+		CHECK_FALSE(compiled.valid);
+
+		dynamic = make_dynamic(1);
+		m_space_graph_compiled_resolve(&compiled, &dynamic, &result);
+		CHECK(result.relation_flags == XRT_SPACE_RELATION_BITMASK_NONE);
+
+		m_space_graph_compile(&xsg, 3, &compiled);
+		CHECK_FALSE(compiled.valid);
+	}
+}
+
+/*!
+ * Run with `tests_space_graph "[benchmark]"`, hidden so it isn't part of the
+ * normal test run.
+ */
+TEST_CASE("m_space_graph_compiled benchmark", "[.][benchmark]")
+{
+	using clock = std::chrono::steady_clock;
+	const int iterations = 1000000;
+
+	for (uint32_t num_steps : {2u, 4u, 6u}) {
+		xrt_space_graph xsg;
+		make_graph(&xsg, num_steps, 1);
+
+		m_space_graph_compiled compiled;
+		m_space_graph_compile(&xsg, 1, &compiled);
+
+		xrt_space_relation dynamic = make_dynamic(3);
+		xrt_space_relation result;
+		float sink = 0.0f;
+
+		// The graph is rebuilt every time in real use, but copying it is cheap compared to resolving.
+		auto start = clock::now();
+		for (int i = 0; i < iterations; i++) {
+			dynamic.pose.position.x = (float)i * 1e-6f;
+			xsg.steps[1] = dynamic;
+			m_space_graph_resolve(&xsg, &result);
+			sink += result.pose.position.x;
+		}
+		auto resolve = std::chrono::duration<double, std::nano>(clock::now() - start).count() / iterations;
+
+		start = clock::now();
+		for (int i = 0; i < iterations; i++) {
+			dynamic.pose.position.x = (float)i * 1e-6f;
+			m_space_graph_compiled_resolve(&compiled, &dynamic, &result);
+			sink += result.pose.position.x;
+		}
+		auto compiled_resolve = std::chrono::duration<double, std::nano>(clock::now() - start).count() / iterations;
+
+		printf("%u steps: resolve %.1fns, compiled %.1fns (%.2fx) [%f]\n", num_steps, resolve, compiled_resolve,
+		       resolve / compiled_resolve, sink);
+		CHECK(compiled_resolve > 0.0);
+	}
+}
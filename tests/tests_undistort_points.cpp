@@ -0,0 +1,303 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Sparse keypoint undistortion accuracy tests, compared to remapping
+ *        the full image before blob detection.
+ * @author Collabora, Ltd.
+ */
+
+#include "catch/catch.hpp"
+
+#include <tracking/t_calibration_opencv.hpp>
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <limits>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+
+static constexpr int kWidth = 640;
+static constexpr int kHeight = 480;
+
+static t_camera_calibration
+make_calibration(bool fisheye)
+{
+	t_camera_calibration calib = {};
+	calib.image_size_pixels.w = kWidth;
+	calib.image_size_pixels.h = kHeight;
+	calib.intrinsics[0][0] = 420.0;
+	calib.intrinsics[0][2] = 322.5;
+	calib.intrinsics[1][1] = 418.0;
+	calib.intrinsics[1][2] = 236.0;
+	calib.intrinsics[2][2] = 1.0;
+	calib.use_fisheye = fisheye;
+
+	if (fisheye) {
+		calib.distortion_fisheye[0] = 0.05;
+		calib.distortion_fisheye[1] = -0.01;
+		calib.distortion_fisheye[2] = 0.002;
+	} else {
+		calib.distortion[0] = -0.12;  // k1
+		calib.distortion[1] = 0.03;   // k2
+		calib.distortion[2] = 0.001;  // p1
+		calib.distortion[3] = -0.002; // p2
+	}
+
+	return calib;
+}
+
+/*!
+ * Points XDG_CACHE_HOME at a new empty directory for as long as it lives, so
+ * the tests never read or write the user's cache.
+ */
+struct TempCacheDir
+{
+	std::string path;
+	std::string old_value;
+	bool had_old_value = false;
+
+	TempCacheDir()
+	{
+		char tmpl[] = "/tmp/monado-tests-XXXXXX";
+		REQUIRE(mkdtemp(tmpl) != nullptr);
+		path = tmpl;
+
+		const char *old = getenv("XDG_CACHE_HOME");
+		if (old != nullptr) {
+			old_value = old;
+			had_old_value = true;
+		}
+		setenv("XDG_CACHE_HOME", path.c_str(), 1);
+	}
+
+	~TempCacheDir()
+	{
+		clear();
+		rmdir(monado_dir().c_str());
+		rmdir(path.c_str());
+
+		if (had_old_value) {
+			setenv("XDG_CACHE_HOME", old_value.c_str(), 1);
+		} else {
+			unsetenv("XDG_CACHE_HOME");
+		}
+	}
+
+	//! Where the cache files end up, see u_file_get_cache_dir.
+	std::string
+	monado_dir() const
+	{
+		return path + "/monado";
+	}
+
+	std::vector<std::string>
+	files() const
+	{
+		std::vector<std::string> ret;
+		DIR *dir = opendir(monado_dir().c_str());
+		if (dir == nullptr) {
+			return ret;
+		}
+
+		while (struct dirent *entry = readdir(dir)) {
+			std::string name = entry->d_name;
+			if (name != "." && name != "..") {
+				ret.push_back(name);
+			}
+		}
+		closedir(dir);
+
+		return ret;
+	}
+
+	void
+	clear() const
+	{
+		for (const std::string &name : files()) {
+			remove((monado_dir() + "/" + name).c_str());
+		}
+	}
+};
+
+static cv::Mat
+make_rotation()
+{
+	cv::Mat rvec = (cv::Mat_<double>(3, 1) << 0.02, -0.01, 0.005);
+	cv::Mat rotation;
+	cv::Rodrigues(rvec, rotation);
+	return rotation;
+}
+
+static cv::Mat
+make_projection()
+{
+	return (cv::Mat_<double>(3, 4) << 400.0, 0.0, 318.0, 0.0, //
+	        0.0, 400.0, 242.0, 0.0,                           //
+	        0.0, 0.0, 1.0, 0.0);
+}
+
+static cv::Ptr<cv::SimpleBlobDetector>
+make_blob_detector()
+{
+	// Same parameters as the PSMV tracker.
+	cv::SimpleBlobDetector::Params blob_params;
+	blob_params.filterByArea = false;
+	blob_params.filterByConvexity = true;
+	blob_params.minConvexity = 0.8;
+	blob_params.filterByInertia = false;
+	blob_params.filterByColor = true;
+	blob_params.blobColor = 255;
+	blob_params.minArea = 1;
+	blob_params.maxArea = 1000;
+	blob_params.maxThreshold = 51;
+	blob_params.minThreshold = 50;
+	blob_params.thresholdStep = 1;
+	blob_params.minDistBetweenBlobs = 5;
+	blob_params.minRepeatability = 1;
+
+	return cv::SimpleBlobDetector::create(blob_params);
+}
+
+static std::vector<cv::Point2f>
+detect(cv::Ptr<cv::SimpleBlobDetector> &sbd, const cv::Mat &grey)
+{
+	cv::Mat thresholded;
+	cv::threshold(grey, thresholded, 32.0, 255.0, 0);
+
+	std::vector<cv::KeyPoint> keypoints;
+	sbd->detect(thresholded, keypoints, cv::noArray());
+
+	std::vector<cv::Point2f> points;
+	cv::KeyPoint::convert(keypoints, points);
+	return points;
+}
+
+TEST_CASE("undistort_points")
+{
+	TempCacheDir cache;
+
+	for (bool fisheye : {false, true}) {
+		t_camera_calibration calib = make_calibration(fisheye);
+		cv::Mat rotation = make_rotation();
+		cv::Mat projection = make_projection();
+		RemapPair maps = calibration_get_undistort_map(calib, rotation, projection);
+
+		DYNAMIC_SECTION("Cached maps are the same " << (fisheye ? "fisheye" : "rectilinear"))
+		{
+			// Computed and written to the empty cache.
+			cache.clear();
+			RemapPair computed = calibration_get_undistort_map(calib, rotation, projection);
+
+			std::vector<std::string> files = cache.files();
+			REQUIRE(files.size() == 1);
+			CHECK(files[0].find("rectify_") == 0);
+			std::string file_path = cache.monado_dir() + "/" + files[0];
+
+			// Flip a bit of the last remap_y entry on disk, so that only
+			// a map loaded from the file can have it.
+			FILE *file = fopen(file_path.c_str(), "r+b");
+			REQUIRE(file != nullptr);
+			uint16_t last = 0;
+			REQUIRE(fseek(file, -(long)sizeof(last), SEEK_END) == 0);
+			REQUIRE(fread(&last, sizeof(last), 1, file) == 1);
+			uint16_t poked = last ^ 1;
+			REQUIRE(fseek(file, -(long)sizeof(poked), SEEK_END) == 0);
+			REQUIRE(fwrite(&poked, sizeof(poked), 1, file) == 1);
+			fclose(file);
+
+			RemapPair loaded = calibration_get_undistort_map(calib, rotation, projection);
+			REQUIRE(loaded.remap_x.type() == CV_16SC2);
+			REQUIRE(loaded.remap_y.type() == CV_16UC1);
+
+			uint16_t &loaded_last = loaded.remap_y.at<uint16_t>(kHeight - 1, kWidth - 1);
+			CHECK(computed.remap_y.at<uint16_t>(kHeight - 1, kWidth - 1) == last);
+			CHECK(loaded_last == poked);
+
+			// Everything else is what was computed.
+			loaded_last = last;
+			CHECK(cv::norm(computed.remap_x, loaded.remap_x, cv::NORM_INF) == 0.0);
+			CHECK(cv::norm(computed.remap_y, loaded.remap_y, cv::NORM_INF) == 0.0);
+			CHECK(cv::norm(maps.remap_x, computed.remap_x, cv::NORM_INF) == 0.0);
+			CHECK(cv::norm(maps.remap_y, computed.remap_y, cv::NORM_INF) == 0.0);
+		}
+
+		DYNAMIC_SECTION("Inverse of remap maps " << (fisheye ? "fisheye" : "rectilinear"))
+		{
+			std::vector<cv::Point2f> rectified;
+			std::vector<cv::Point2f> raw;
+
+			// Stay away from the edges, where strong distortion folds over.
+			for (int y = 48; y < kHeight - 48; y += 16) {
+				for (int x = 64; x < kWidth - 64; x += 16) {
+					// Fixed point, whole pixels plus a fraction from the table index.
+					cv::Vec2s xy = maps.remap_x.at<cv::Vec2s>(y, x);
+					int frac = maps.remap_y.at<uint16_t>(y, x);
+					float raw_x = xy[0] + (float)(frac % cv::INTER_TAB_SIZE) / cv::INTER_TAB_SIZE;
+					float raw_y = xy[1] + (float)(frac / cv::INTER_TAB_SIZE) / cv::INTER_TAB_SIZE;
+					if (raw_x < 0 || raw_y < 0 || raw_x >= kWidth || raw_y >= kHeight) {
+						continue;
+					}
+					rectified.emplace_back((float)x, (float)y);
+					raw.emplace_back(raw_x, raw_y);
+				}
+			}
+			REQUIRE(!raw.empty());
+
+			std::vector<cv::Point2f> undistorted;
+			calibration_undistort_points(calib, raw, undistorted, rotation, projection);
+			REQUIRE(undistorted.size() == rectified.size());
+
+			double max_error = 0.0;
+			for (size_t i = 0; i < rectified.size(); i++) {
+				max_error = std::max(max_error, cv::norm(undistorted[i] - rectified[i]));
+			}
+
+			INFO("Max error: " << max_error << " px");
+			CHECK(max_error < 0.25);
+		}
+
+		DYNAMIC_SECTION("Blobs match full remap " << (fisheye ? "fisheye" : "rectilinear"))
+		{
+			cv::Ptr<cv::SimpleBlobDetector> sbd = make_blob_detector();
+
+			// Bright balls spread over the raw frame.
+			cv::Mat raw = cv::Mat::zeros(kHeight, kWidth, CV_8UC1);
+			for (int y = 80; y < kHeight - 40; y += 110) {
+				for (int x = 90; x < kWidth - 40; x += 140) {
+					cv::circle(raw, cv::Point(x, y), 7, cv::Scalar(200), cv::FILLED);
+				}
+			}
+
+			// What the tracker does by default, remap then detect.
+			cv::Mat rectified;
+			cv::remap(raw, rectified, calibration_get_nearest_map(maps), cv::noArray(), cv::INTER_NEAREST,
+			          cv::BORDER_CONSTANT, cv::Scalar(0));
+			std::vector<cv::Point2f> full = detect(sbd, rectified);
+
+			// Detect on the raw frame, then undistort only the keypoints.
+			std::vector<cv::Point2f> sparse;
+			calibration_undistort_points(calib, detect(sbd, raw), sparse, rotation, projection);
+
+			REQUIRE(!full.empty());
+			REQUIRE(full.size() == sparse.size());
+
+			double max_error = 0.0;
+			for (const cv::Point2f &f : full) {
+				double best = std::numeric_limits<double>::max();
+				for (const cv::Point2f &s : sparse) {
+					best = std::min(best, cv::norm(f - s));
+				}
+				max_error = std::max(max_error, best);
+			}
+
+			INFO("Max error: " << max_error << " px");
+			CHECK(max_error < 1.0);
+		}
+	}
+}
@@ -0,0 +1,125 @@
+// Copyright 2021, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief YUV to RGB conversion kernel tests.
+ * @author Collabora, Ltd.
+ */
+
+#include "catch/catch.hpp"
+
+#include <util/u_yuv_convert.h>
+
+#include <random>
+#include <vector>
+#include <string>
+
+
+//! Bytes after the row that must not be touched.
+static constexpr size_t kGuard = 32;
+static constexpr uint8_t kGuardValue = 0xa5;
+
+static std::vector<const u_yuv_convert_funcs *>
+get_simd_funcs()
+{
+	std::vector<const u_yuv_convert_funcs *> ret;
+
+	if (u_yuv_convert_get_sse41() != nullptr) {
+		ret.push_back(u_yuv_convert_get_sse41());
+	}
+	if (u_yuv_convert_get_avx2() != nullptr) {
+		ret.push_back(u_yuv_convert_get_avx2());
+	}
+
+	return ret;
+}
+
+static void
+check_row(u_yuv_convert_row_func ref_func,
+          u_yuv_convert_row_func test_func,
+          const std::vector<uint8_t> &src,
+          uint32_t width)
+{
+	std::vector<uint8_t> ref(width * 3 + kGuard, kGuardValue);
+	std::vector<uint8_t> out(width * 3 + kGuard, kGuardValue);
+
+	ref_func(src.data(), ref.data(), width);
+	test_func(src.data(), out.data(), width);
+
+	CHECK(ref == out);
+}
+
+TEST_CASE("yuv_convert")
+{
+	const u_yuv_convert_funcs *scalar = u_yuv_convert_get_scalar();
+	REQUIRE(scalar != nullptr);
+
+	SECTION("Scalar known values")
+	{
+		// Black, white and saturated red in BT.601 studio range.
+		std::vector<uint8_t> src = {16, 128, 128, 235, 128, 128, 81, 90, 240};
+		std::vector<uint8_t> dst(9);
+
+		scalar->yuv888_to_r8g8b8(src.data(), dst.data(), 3);
+
+		CHECK(dst == std::vector<uint8_t>{0, 0, 0, 255, 255, 255, 255, 0, 0});
+	}
+
+	SECTION("Best is one of the implementations")
+	{
+		const u_yuv_convert_funcs *best = u_yuv_convert_get_best();
+		REQUIRE(best != nullptr);
+		INFO("Best implementation: " << best->name);
+
+		bool found = best == scalar;
+		for (const u_yuv_convert_funcs *funcs : get_simd_funcs()) {
+			found = found || best == funcs;
+		}
+		CHECK(found);
+	}
+
+	for (const u_yuv_convert_funcs *funcs : get_simd_funcs()) {
+		DYNAMIC_SECTION("Bit exact " << funcs->name)
+		{
+			std::mt19937 rng(1337);
+			std::uniform_int_distribution<int> dist(0, 255);
+
+			// All widths around the vector sizes, to hit the tails.
+			for (uint32_t width = 2; width <= 66; width += 2) {
+				INFO("Width: " << width);
+
+				// Extra source bytes so stride is larger then the row.
+				std::vector<uint8_t> src(width * 3 + kGuard);
+				for (uint8_t &b : src) {
+					b = (uint8_t)dist(rng);
+				}
+
+				check_row(scalar->yuyv422_to_r8g8b8, funcs->yuyv422_to_r8g8b8, src, width);
+				check_row(scalar->uyvy422_to_r8g8b8, funcs->uyvy422_to_r8g8b8, src, width);
+				check_row(scalar->yuv888_to_r8g8b8, funcs->yuv888_to_r8g8b8, src, width);
+				check_row(scalar->yuv888_to_r8g8b8, funcs->yuv888_to_r8g8b8, src, width - 1);
+			}
+
+			// Every possible YUV triplet, one row per Y value.
+			const uint32_t width = 256 * 256;
+			std::vector<uint8_t> src(width * 3);
+			std::vector<uint8_t> ref(width * 3);
+			std::vector<uint8_t> out(width * 3);
+
+			bool all_equal = true;
+			for (uint32_t y = 0; y < 256; y++) {
+				for (uint32_t i = 0; i < width; i++) {
+					src[i * 3 + 0] = (uint8_t)y;
+					src[i * 3 + 1] = (uint8_t)(i >> 8);
+					src[i * 3 + 2] = (uint8_t)(i & 0xff);
+				}
+
+				scalar->yuv888_to_r8g8b8(src.data(), ref.data(), width);
+				funcs->yuv888_to_r8g8b8(src.data(), out.data(), width);
+
+				all_equal = all_equal && ref == out;
+			}
+			CHECK(all_equal);
+		}
+	}
+}